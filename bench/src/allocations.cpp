@@ -0,0 +1,74 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+//
+// Replaces the global operator new to count heap allocations, so each
+// benchmark can report how many it makes per operation. Counting is one
+// relaxed atomic increment; the memory itself still comes from malloc.
+
+#include "bench.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    std::atomic<uint64_t> s_allocationCount(0);
+
+    void* allocate(size_t size)
+    {
+        s_allocationCount.fetch_add(1, std::memory_order_relaxed);
+        return malloc(size > 0 ? size : 1);
+    }
+}
+
+namespace bench
+{
+    uint64_t getAllocationCount()
+    {
+        return s_allocationCount.load(std::memory_order_relaxed);
+    }
+}
+
+void* operator new(size_t size)
+{
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
@@ -0,0 +1,114 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <brainclouds2s.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+using namespace BrainCloud;
+
+namespace bench
+{
+    using Clock = std::chrono::steady_clock;
+
+    /** Heap allocations made by the process so far, every thread included. */
+    uint64_t getAllocationCount();
+
+    /**
+     * Handed to a benchmark for one timed run. The benchmark runs its
+     * operation getIterations() times; setup and teardown go outside
+     * start() and stop(), or the whole call is timed.
+     */
+    class State
+    {
+    public:
+        explicit State(uint64_t iterations) : m_iterations(iterations) {}
+
+        uint64_t getIterations() const { return m_iterations; }
+
+        void start()
+        {
+            m_started = true;
+            m_startAllocations = getAllocationCount();
+            m_start = Clock::now();
+        }
+
+        void stop()
+        {
+            m_end = Clock::now();
+            m_endAllocations = getAllocationCount();
+            m_stopped = true;
+        }
+
+        /** Bytes one operation processes, to report a throughput with. */
+        void setBytesPerOperation(uint64_t bytes) { m_bytesPerOperation = bytes; }
+
+        bool isStarted() const { return m_started; }
+        bool isStopped() const { return m_stopped; }
+        Clock::time_point getStart() const { return m_start; }
+        Clock::time_point getEnd() const { return m_end; }
+        uint64_t getBytesPerOperation() const { return m_bytesPerOperation; }
+        uint64_t getStartAllocations() const { return m_startAllocations; }
+        uint64_t getEndAllocations() const { return m_endAllocations; }
+
+    private:
+        uint64_t m_iterations;
+        bool m_started = false;
+        bool m_stopped = false;
+        Clock::time_point m_start;
+        Clock::time_point m_end;
+        uint64_t m_bytesPerOperation = 0;
+        uint64_t m_startAllocations = 0;
+        uint64_t m_endAllocations = 0;
+    };
+
+    using Function = std::function<void(State&)>;
+
+    struct Case
+    {
+        std::string name;
+        Function function;
+    };
+
+    std::vector<Case>& getCases();
+
+    struct Registrar
+    {
+        Registrar(const char* name, const Function& function)
+        {
+            getCases().push_back({name, function});
+        }
+    };
+
+    /** Keeps the compiler from optimizing away a result nobody reads. */
+    template<class T>
+    inline void doNotOptimize(const T& value)
+    {
+#if defined(_MSC_VER)
+        static volatile const void* s_sink;
+        s_sink = &value;
+#else
+        asm volatile("" : : "r"(&value) : "memory");
+#endif
+    }
+};
+
+#define BENCH_CONCAT_IMPL(a, b) a##b
+#define BENCH_CONCAT(a, b) BENCH_CONCAT_IMPL(a, b)
+
+/**
+ * Registers a benchmark:
+ *
+ *     BENCHMARK("log.redact")(bench::State& state)
+ *     {
+ *         for (uint64_t i = 0; i < state.getIterations(); ++i) ...
+ *     }
+ */
+#define BENCHMARK(name) \
+    static void BENCH_CONCAT(benchFunction, __LINE__)(bench::State&); \
+    static bench::Registrar BENCH_CONCAT(benchRegistrar, __LINE__)(name, BENCH_CONCAT(benchFunction, __LINE__)); \
+    static void BENCH_CONCAT(benchFunction, __LINE__)
@@ -0,0 +1,114 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "bench.h"
+#include "S2SJsonScanner.h"
+
+#include <json/json.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Packet json
+//
+// Message responses are found in the packet by S2SJsonScanner and parsed
+// one at a time; messages are written one at a time into the envelope.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    const int MESSAGE_COUNT = 32;
+
+    std::string makeResponsePacket()
+    {
+        std::string packet = "{\"packetId\":12,\"messageResponses\":[";
+        for (int i = 0; i < MESSAGE_COUNT; ++i)
+        {
+            if (i > 0) packet += ",";
+            packet += "{\"status\":200,\"data\":{\"entityId\":\"8f2a6c1e-4b0d-4e4f-9a53-" + std::to_string(100000 + i) +
+                      "\",\"entityType\":\"player\",\"version\":" + std::to_string(i) +
+                      ",\"data\":{\"name\":\"Player \\\"" + std::to_string(i) + "\\\"\",\"scores\":[1,2,3,4,5],"
+                      "\"flags\":{\"active\":true,\"banned\":false}},\"createdAt\":1700000000000}}";
+        }
+        packet += "]}";
+        return packet;
+    }
+
+    Json::Value makeMessage()
+    {
+        Json::Value message(Json::objectValue);
+        message["service"] = "globalEntity";
+        message["operation"] = "UPDATE";
+        Json::Value& data = message["data"];
+        data["entityId"] = "8f2a6c1e-4b0d-4e4f-9a53-2d6f0b7e1c9a";
+        data["version"] = 3;
+        data["data"]["name"] = "Player";
+        for (int i = 0; i < 5; ++i) data["data"]["scores"].append(i);
+        return message;
+    }
+}
+
+BENCHMARK("json.scanResponses.32")(bench::State& state)
+{
+    auto packet = makeResponsePacket();
+    state.setBytesPerOperation(packet.size());
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        S2SJsonScanner scanner("messageResponses");
+        scanner.feed(packet);
+        bench::doNotOptimize(scanner.getElements().size());
+    }
+    state.stop();
+}
+
+// Scanned as the body comes in, in 1400 byte chunks like TCP segments
+BENCHMARK("json.scanResponses.32.chunked")(bench::State& state)
+{
+    auto packet = makeResponsePacket();
+    state.setBytesPerOperation(packet.size());
+    std::string received;
+    received.reserve(packet.size());
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        S2SJsonScanner scanner("messageResponses");
+        received.clear();
+        for (size_t offset = 0; offset < packet.size(); offset += 1400)
+        {
+            received.append(packet, offset, 1400);
+            scanner.feed(received);
+        }
+        bench::doNotOptimize(scanner.getElements().size());
+    }
+    state.stop();
+}
+
+BENCHMARK("json.unpackResponses.32")(bench::State& state)
+{
+    auto packet = makeResponsePacket();
+    state.setBytesPerOperation(packet.size());
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        S2SJsonScanner scanner("messageResponses");
+        scanner.feed(packet);
+        for (const auto& range : scanner.getElements())
+        {
+            Json::Value message;
+            Json::Reader reader;
+            reader.parse(packet.c_str() + range.first, packet.c_str() + range.second, message);
+            bench::doNotOptimize(message);
+        }
+    }
+    state.stop();
+}
+
+BENCHMARK("json.writeMessage")(bench::State& state)
+{
+    auto message = makeMessage();
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        Json::FastWriter writer;
+        auto text = writer.write(message);
+        bench::doNotOptimize(text);
+    }
+    state.stop();
+}
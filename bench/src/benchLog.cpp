@@ -0,0 +1,230 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "bench.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+
+///////////////////////////////////////////////////////////////////////////////
+// Logging
+//
+// Every packet sent and received goes through buildLogMessage when logging
+// is on, which redacts it in a single pass. s2s_log then hands the line to
+// the logger thread. The .legacy benchmarks are the find pass per sensitive
+// key that redaction used to make.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    const std::string PACKET =
+        "{\"messages\":[{\"service\":\"leaderboard\",\"operation\":\"GET_GLOBAL_LEADERBOARD_PAGE\","
+        "\"data\":{\"leaderboardId\":\"weekly\",\"sort\":\"HIGH_TO_LOW\",\"startIndex\":0,\"endIndex\":49}},"
+        "{\"service\":\"globalEntity\",\"operation\":\"READ\",\"data\":{\"entityId\":"
+        "\"8f2a6c1e-4b0d-4e4f-9a53-2d6f0b7e1c9a\"}},{\"service\":\"time\",\"operation\":\"READ\",\"data\":{}}],"
+        "\"packetId\":12,\"sessionId\":\"v3grtg4ksr93kvhgjhmhl42vd6\"}";
+
+    const std::string AUTH_PACKET =
+        "{\"messages\":[{\"service\":\"authenticationV2\",\"operation\":\"AUTHENTICATE\","
+        "\"data\":{\"appId\":\"20001\",\"serverName\":\"GameServer\","
+        "\"serverSecret\":\"b52fe3a1-6c3e-4e5a-8b6d-1f2c3d4e5f60\"}}],\"packetId\":0}";
+}
+
+BENCHMARK("log.redactSecretKeys.plain")(bench::State& state)
+{
+    state.setBytesPerOperation(PACKET.size());
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        auto redacted = redactSecretKeys(PACKET);
+        bench::doNotOptimize(redacted);
+    }
+    state.stop();
+}
+
+BENCHMARK("log.redactSecretKeys.secret")(bench::State& state)
+{
+    state.setBytesPerOperation(AUTH_PACKET.size());
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        auto redacted = redactSecretKeys(AUTH_PACKET);
+        bench::doNotOptimize(redacted);
+    }
+    state.stop();
+}
+
+namespace
+{
+    // redactSecretKeys before the single-pass scanner: a find pass per
+    // sensitive key, and a replace per value
+    std::string legacyRedactSecretKeys(const std::string& input)
+    {
+        std::string out = input;
+        for (auto& key : sensitiveKeys)
+        {
+            size_t pos = 0;
+            std::string needle = "\"" + key + "\"";
+            while ((pos = out.find(needle, pos)) != std::string::npos)
+            {
+                size_t colon = out.find(':', pos + needle.size());
+                if (colon == std::string::npos) break;
+                size_t quoteStart = out.find('"', colon);
+                if (quoteStart == std::string::npos) break;
+                size_t quoteEnd = out.find('"', quoteStart + 1);
+                if (quoteEnd == std::string::npos) break;
+
+                std::string value = out.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
+                out.replace(quoteStart + 1, value.size(), obfuscateString(value));
+                pos = quoteEnd + 1;
+            }
+        }
+        return out;
+    }
+
+    // A packet of entity updates, with a token about every kilobyte
+    std::string makePayload(size_t size)
+    {
+        std::string payload = "{\"messages\":[";
+        for (int i = 0; payload.size() < size; ++i)
+        {
+            payload += "{\"service\":\"globalEntity\",\"operation\":\"UPDATE\",\"data\":{\"entityId\":"
+                       "\"8f2a6c1e-4b0d-4e4f-9a53-2d6f0b7e1c9a\",\"version\":" + std::to_string(i) + ","
+                       "\"data\":{\"name\":\"player\",\"score\":1234,\"tags\":[\"a\",\"b\",\"c\"]}";
+            if (i % 4 == 0) payload += ",\"token\":\"c2VjcmV0LXRva2VuLXZhbHVl\"";
+            payload += "}},";
+        }
+        payload += "{}]}";
+        return payload;
+    }
+
+    void benchmarkRedaction(bench::State& state, size_t size, std::string (*redact)(const std::string&))
+    {
+        const std::string payload = makePayload(size);
+        state.setBytesPerOperation(payload.size());
+        state.start();
+        for (uint64_t i = 0; i < state.getIterations(); ++i)
+        {
+            auto redacted = redact(payload);
+            bench::doNotOptimize(redacted);
+        }
+        state.stop();
+    }
+}
+
+BENCHMARK("log.redactSecretKeys.1KB")(bench::State& state)
+{
+    benchmarkRedaction(state, 1024, redactSecretKeys);
+}
+
+BENCHMARK("log.redactSecretKeys.64KB")(bench::State& state)
+{
+    benchmarkRedaction(state, 64 * 1024, redactSecretKeys);
+}
+
+BENCHMARK("log.redactSecretKeys.1MB")(bench::State& state)
+{
+    benchmarkRedaction(state, 1024 * 1024, redactSecretKeys);
+}
+
+BENCHMARK("log.redactSecretKeys.legacy.1KB")(bench::State& state)
+{
+    benchmarkRedaction(state, 1024, legacyRedactSecretKeys);
+}
+
+BENCHMARK("log.redactSecretKeys.legacy.64KB")(bench::State& state)
+{
+    benchmarkRedaction(state, 64 * 1024, legacyRedactSecretKeys);
+}
+
+BENCHMARK("log.redactSecretKeys.legacy.1MB")(bench::State& state)
+{
+    benchmarkRedaction(state, 1024 * 1024, legacyRedactSecretKeys);
+}
+
+BENCHMARK("log.buildLogMessage")(bench::State& state)
+{
+    const std::string prefix = "[S2S SEND ";
+    const std::string appId = "20001";
+    const std::string suffix = "] ";
+
+    state.setBytesPerOperation(PACKET.size());
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        auto message = buildLogMessage(prefix, appId, suffix, PACKET);
+        bench::doNotOptimize(message);
+    }
+    state.stop();
+}
+
+namespace
+{
+    std::string getLogPath()
+    {
+        return (std::getenv("TMPDIR") ? std::string(std::getenv("TMPDIR")) : std::string("/tmp")) +
+               "/bcs2s_bench.log";
+    }
+}
+
+// What s2s_log did before the background logger, for comparison: format and
+// open the file on the logging thread, for every line
+BENCHMARK("log.ofstreamPerLine")(bench::State& state)
+{
+    const std::string path = getLogPath();
+    state.setBytesPerOperation(PACKET.size());
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        std::ofstream out(path.c_str(), std::ios::app);
+        out << buildLogMessage("[S2S SEND ", std::string("20001"), "] ", PACKET) << "\n";
+    }
+    state.stop();
+    std::remove(path.c_str());
+}
+
+// Through the logger thread to an open file, flushed before the clock stops
+BENCHMARK("log.s2s_log.file")(bench::State& state)
+{
+    const std::string path = getLogPath();
+    logToFile(path);
+
+    state.setBytesPerOperation(PACKET.size());
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        s2s_log("[S2S SEND ", std::string("20001"), "] ", PACKET);
+    }
+    flushLogs();
+    state.stop();
+
+    logToFile("");
+    std::remove(path.c_str());
+}
+
+// A packet log on a channel logging 1 in 100: the other 99 stop at
+// s2s_should_log, before anything is formatted
+BENCHMARK("log.s2s_log.sampled100")(bench::State& state)
+{
+    const std::string path = getLogPath();
+    logToFile(path);
+    auto previous = getLogChannelOptions(S2SLogChannel::S2SSend);
+    S2SLogChannelOptions options;
+    options.sampleEvery = 100;
+    setLogChannelOptions(S2SLogChannel::S2SSend, options);
+
+    state.setBytesPerOperation(PACKET.size());
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        if (s2s_should_log(S2SLogChannel::S2SSend, S2SLogLevel::Info))
+        {
+            s2s_log("[S2S SEND ", std::string("20001"), "] ", S2SLogPayload(S2SLogChannel::S2SSend, PACKET));
+        }
+    }
+    flushLogs();
+    state.stop();
+
+    setLogChannelOptions(S2SLogChannel::S2SSend, previous);
+    logToFile("");
+    std::remove(path.c_str());
+}
@@ -0,0 +1,159 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "bench.h"
+#include "S2SLoopbackTransport.h"
+#include "brainclouds2s-rtt.h"
+#include "IRTTCallback.h"
+#include "IRTTConnectCallback.h"
+
+#include <atomic>
+
+///////////////////////////////////////////////////////////////////////////////
+// Loopback
+//
+// Requests and RTT events answered in process by S2SLoopbackTransport and
+// S2SLoopbackSocket: no sockets, no curl. What's left is the library's own
+// cost (json, locks, queues, std::function copies, the I/O thread handoff)
+// plus the loopback's small packet scan. Compare with .mock for what the
+// network adds.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    const char* REQUEST = "{\"service\":\"globalEntity\",\"operation\":\"READ\","
+                          "\"data\":{\"entityId\":\"8f2a6c1e-4b0d-4e4f-9a53-2d6f0b7e1c9a\"}}";
+
+    // The factories are read when a context is created
+    S2SContextRef createLoopbackContext(const S2SRTTSocketFactory& socketFactory = nullptr)
+    {
+        setTransportFactory(S2SLoopbackTransport::factory());
+        setRTTSocketFactory(socketFactory);
+        auto context = S2SContext::create("00000", "bench", "bench", "http://loopback/s2sdispatcher", false);
+        setTransportFactory(nullptr);
+        setRTTSocketFactory(nullptr);
+        return context;
+    }
+
+    void waitFor(const S2SContextRef& context, const int& done, int count)
+    {
+        while (done < count)
+        {
+            context->runCallbacks(1);
+        }
+    }
+}
+
+BENCHMARK("s2s.request.loopback")(bench::State& state)
+{
+    auto context = createLoopbackContext();
+    context->authenticateSync();
+    int done = 0;
+    auto callback = [&done](const std::string&) { done++; };
+
+    context->request(REQUEST, callback);
+    waitFor(context, done, 1);
+
+    done = 0;
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        context->request(REQUEST, callback);
+        waitFor(context, done, (int)i + 1);
+    }
+    state.stop();
+}
+
+BENCHMARK("s2s.requestRaw.loopback")(bench::State& state)
+{
+    auto context = createLoopbackContext();
+    context->authenticateSync();
+    int done = 0;
+    auto callback = [&done](const std::string&) { done++; };
+
+    context->requestRaw(REQUEST, callback);
+    waitFor(context, done, 1);
+
+    done = 0;
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        context->requestRaw(REQUEST, callback);
+        waitFor(context, done, (int)i + 1);
+    }
+    state.stop();
+}
+
+namespace
+{
+    class ConnectCallback final : public IRTTConnectCallback
+    {
+    public:
+        bool processed = false;
+        void rttConnectSuccess() override { processed = true; }
+        void rttConnectFailure(const std::string&) override { processed = true; }
+    };
+
+    class EventCounter final : public IRTTCallback
+    {
+    public:
+        uint64_t count = 0;
+        void rttCallback(const std::string& jsonData) override
+        {
+            bench::doNotOptimize(jsonData);
+            count++;
+        }
+    };
+}
+
+// An RTT event from the socket to its callback: the receive thread's
+// parsing, the event queue and runCallbacks
+BENCHMARK("rtt.event.loopback")(bench::State& state)
+{
+    std::atomic<S2SLoopbackSocket*> socket(nullptr);
+    auto context = createLoopbackContext(S2SLoopbackSocket::factory(nullptr, [&socket](S2SLoopbackSocket* opened)
+    {
+        socket = opened;
+    }));
+    context->authenticateSync();
+
+    ConnectCallback connectCallback;
+    EventCounter counter;
+    BrainCloudRTT* rttService = context->getRTTService();
+    rttService->registerRTTCallback(ServiceName::Chat, &counter);
+    rttService->enableRTT(&connectCallback, false);
+    while (!connectCallback.processed)
+    {
+        context->runCallbacks(1);
+    }
+    if (!rttService->getRTTEnabled()) return;
+
+    const std::string event = "{\"service\":\"chat\",\"operation\":\"INCOMING\","
+                              "\"data\":{\"message\":\"" + std::string(64, 'x') + "\"}}";
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        socket.load()->push(event);
+        while (counter.count < i + 1)
+        {
+            context->runCallbacks(0);
+        }
+    }
+    state.stop();
+
+    rttService->disableRTT();
+}
+
+// runCallbacks with nothing pending, as called every tick by a server
+// between bursts
+BENCHMARK("s2s.runCallbacks.idle")(bench::State& state)
+{
+    auto context = createLoopbackContext();
+    context->authenticateSync();
+    context->runCallbacks(0);
+
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        context->runCallbacks(0);
+    }
+    state.stop();
+}
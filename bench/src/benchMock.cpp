@@ -0,0 +1,109 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "bench.h"
+#include "S2SMockServer.h"
+#include "brainclouds2s-rtt.h"
+#include "IRTTCallback.h"
+#include "IRTTConnectCallback.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Round trips to the mock server
+//
+// Requests and RTT events through a real loopback connection to an
+// in-process S2SMockServer, so the numbers include curl, the sockets and the
+// mock's own parsing. Compare the .refused benchmarks for the client side
+// alone.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    const char* ECHO_REQUEST = "{\"service\":\"mock\",\"operation\":\"ECHO\","
+                               "\"data\":{\"entityId\":\"8f2a6c1e-4b0d-4e4f-9a53-2d6f0b7e1c9a\"}}";
+
+    void waitFor(const S2SContextRef& context, const int& done, int count)
+    {
+        while (done < count)
+        {
+            context->runCallbacks(1);
+        }
+    }
+}
+
+BENCHMARK("s2s.request.mock")(bench::State& state)
+{
+    S2SMockServer server;
+    if (!server.start()) return;
+    auto context = S2SContext::create("mockapp", "mockserver", "mocksecret", server.getDispatcherUrl(), true);
+    int done = 0;
+    auto callback = [&done](const std::string&) { done++; };
+
+    // Authenticates and opens the connection
+    context->request(ECHO_REQUEST, callback);
+    waitFor(context, done, 1);
+
+    done = 0;
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        context->request(ECHO_REQUEST, callback);
+        waitFor(context, done, (int)i + 1);
+    }
+    state.stop();
+}
+
+#if defined(USE_TCP)
+namespace
+{
+    class ConnectCallback final : public IRTTConnectCallback
+    {
+    public:
+        bool processed = false;
+        void rttConnectSuccess() override { processed = true; }
+        void rttConnectFailure(const std::string&) override { processed = true; }
+    };
+
+    class EventCounter final : public IRTTCallback
+    {
+    public:
+        uint64_t count = 0;
+        void rttCallback(const std::string& jsonData) override
+        {
+            bench::doNotOptimize(jsonData);
+            count++;
+        }
+    };
+}
+
+// An RTT event pushed by the server to its callback, over TCP
+BENCHMARK("rtt.event.mock")(bench::State& state)
+{
+    S2SMockServer server;
+    if (!server.start()) return;
+    auto context = S2SContext::create("mockapp", "mockserver", "mocksecret", server.getDispatcherUrl(), false);
+    context->authenticateSync();
+
+    ConnectCallback connectCallback;
+    EventCounter counter;
+    BrainCloudRTT* rttService = context->getRTTService();
+    rttService->registerRTTCallback(ServiceName::Chat, &counter);
+    rttService->enableRTT(&connectCallback, false);
+    while (!connectCallback.processed)
+    {
+        context->runCallbacks(1);
+    }
+    if (!rttService->getRTTEnabled()) return;
+
+    const std::string data = "{\"message\":\"" + std::string(64, 'x') + "\"}";
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        server.pushRttEvent("chat", "MOCK", data);
+        while (counter.count < i + 1)
+        {
+            context->runCallbacks(0);
+        }
+    }
+    state.stop();
+
+    rttService->disableRTT();
+}
+#endif
@@ -0,0 +1,116 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "bench.h"
+#include "brainclouds2s-globalfilev3.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// Requests
+//
+// The whole client side of a request: parsing and queueing it, building the
+// packet envelope, handing it to the I/O thread, unpacking the (error)
+// response and calling back from runCallbacks. Requests go to a local port
+// that refuses connections, so the transfer itself is one failed connect.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    const char* REQUEST = "{\"service\":\"globalEntity\",\"operation\":\"READ\","
+                          "\"data\":{\"entityId\":\"8f2a6c1e-4b0d-4e4f-9a53-2d6f0b7e1c9a\"}}";
+
+    S2SContextRef createContext()
+    {
+        return S2SContext::create("00000", "bench", "bench", "http://127.0.0.1:1/s2sdispatcher", false);
+    }
+
+    void waitFor(const S2SContextRef& context, const int& done, int count)
+    {
+        while (done < count)
+        {
+            context->runCallbacks(1);
+        }
+    }
+}
+
+BENCHMARK("s2s.request.refused")(bench::State& state)
+{
+    auto context = createContext();
+    int done = 0;
+    auto callback = [&done](const std::string&) { done++; };
+
+    // Starts the I/O thread and pools a curl handle
+    context->request(REQUEST, callback);
+    waitFor(context, done, 1);
+
+    done = 0;
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        context->request(REQUEST, callback);
+        waitFor(context, done, (int)i + 1);
+    }
+    state.stop();
+}
+
+BENCHMARK("s2s.requestRaw.refused")(bench::State& state)
+{
+    auto context = createContext();
+    int done = 0;
+    auto callback = [&done](const std::string&) { done++; };
+
+    context->requestRaw(REQUEST, callback);
+    waitFor(context, done, 1);
+
+    done = 0;
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        context->requestRaw(REQUEST, callback);
+        waitFor(context, done, (int)i + 1);
+    }
+    state.stop();
+}
+
+// 32 requests queued at once: the first goes alone, the other 31 are
+// batched into one packet behind it
+BENCHMARK("s2s.request.batch32.refused")(bench::State& state)
+{
+    const int BATCH = 32;
+    auto context = createContext();
+    context->setBatching(BATCH, 0);
+    int done = 0;
+    auto callback = [&done](const std::string&) { done++; };
+
+    context->request(REQUEST, callback);
+    waitFor(context, done, 1);
+
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        done = 0;
+        for (int j = 0; j < BATCH; ++j)
+        {
+            context->request(REQUEST, callback);
+        }
+        waitFor(context, done, BATCH);
+    }
+    state.stop();
+}
+
+BENCHMARK("gfv3.sysGetFileInfo.refused")(bench::State& state)
+{
+    auto context = createContext();
+    auto globalFile = context->getGlobalFileV3();
+    int done = 0;
+    auto callback = [&done](const std::string&) { done++; };
+
+    globalFile->sysGetFileInfo("8f2a6c1e-4b0d-4e4f-9a53-2d6f0b7e1c9a", callback);
+    waitFor(context, done, 1);
+
+    done = 0;
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        globalFile->sysGetFileInfo("8f2a6c1e-4b0d-4e4f-9a53-2d6f0b7e1c9a", callback);
+        waitFor(context, done, (int)i + 1);
+    }
+    state.stop();
+}
@@ -0,0 +1,42 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "bench.h"
+#include "ServiceName.h"
+
+#include <map>
+
+///////////////////////////////////////////////////////////////////////////////
+// ServiceName
+//
+// RTT messages are routed by comparing service names and looking up the
+// registered callback by name.
+///////////////////////////////////////////////////////////////////////////////
+
+BENCHMARK("serviceName.equals")(bench::State& state)
+{
+    const ServiceName* names[] = {&ServiceName::RTTRegistration, &ServiceName::RTT, &ServiceName::Chat,
+                                  &ServiceName::Messaging, &ServiceName::Lobby, &ServiceName::Relay};
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        bool equal = *names[i % 6] == ServiceName::Lobby;
+        bench::doNotOptimize(equal);
+    }
+    state.stop();
+}
+
+BENCHMARK("serviceName.callbackLookup")(bench::State& state)
+{
+    std::map<std::string, int> callbacks;
+    callbacks[ServiceName::Chat.getValue()] = 1;
+    callbacks[ServiceName::Lobby.getValue()] = 2;
+    callbacks[ServiceName::Messaging.getValue()] = 3;
+    const std::string services[] = {"chat", "lobby", "messaging", "event"};
+
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        auto it = callbacks.find(services[i % 4]);
+        bench::doNotOptimize(it);
+    }
+    state.stop();
+}
@@ -0,0 +1,142 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "bench.h"
+
+///////////////////////////////////////////////////////////////////////////////
+// TCP RTT framing
+//
+// Length-prefixed messages through DefaultTCPSocket, over a loopback
+// connection to a plain socket.
+///////////////////////////////////////////////////////////////////////////////
+
+#if defined(USE_TCP)
+
+#include "ITCPSocket.h"
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include <memory>
+#include <thread>
+
+namespace
+{
+    const size_t MESSAGE_SIZE = 256;
+
+    struct Loopback
+    {
+        std::unique_ptr<ITCPSocket> client;
+        int peer = -1;
+
+        Loopback()
+        {
+            int listener = ::socket(AF_INET, SOCK_STREAM, 0);
+            sockaddr_in address;
+            memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = 0;
+            socklen_t length = sizeof(address);
+            if (listener < 0 ||
+                ::bind(listener, (sockaddr*)&address, sizeof(address)) != 0 ||
+                ::listen(listener, 1) != 0 ||
+                ::getsockname(listener, (sockaddr*)&address, &length) != 0)
+            {
+                if (listener >= 0) ::close(listener);
+                return;
+            }
+
+            // The connect completes in the listen backlog
+            client.reset(ITCPSocket::create("127.0.0.1", ntohs(address.sin_port)));
+            peer = ::accept(listener, NULL, NULL);
+            ::close(listener);
+        }
+
+        ~Loopback()
+        {
+            client.reset();
+            if (peer >= 0) ::close(peer);
+        }
+
+        bool isValid() const { return client && client->isValid() && peer >= 0; }
+    };
+
+    std::string frame(const std::string& message)
+    {
+        uint32_t length = htonl((uint32_t)message.size());
+        return std::string((const char*)&length, 4) + message;
+    }
+}
+
+BENCHMARK("tcp.send.256")(bench::State& state)
+{
+    Loopback loopback;
+    if (!loopback.isValid()) return;
+
+    std::string message(MESSAGE_SIZE, 'x');
+    size_t total = (size_t)state.getIterations() * (MESSAGE_SIZE + 4);
+    int peer = loopback.peer;
+    std::thread drain([peer, total]()
+    {
+        char buffer[65536];
+        size_t received = 0;
+        while (received < total)
+        {
+            ssize_t count = ::recv(peer, buffer, sizeof(buffer), 0);
+            if (count <= 0) break;
+            received += (size_t)count;
+        }
+    });
+
+    state.setBytesPerOperation(MESSAGE_SIZE);
+    state.start();
+    for (uint64_t i = 0; i < state.getIterations(); ++i)
+    {
+        loopback.client->send(message);
+    }
+    drain.join();
+    state.stop();
+}
+
+BENCHMARK("tcp.recv.256")(bench::State& state)
+{
+    Loopback loopback;
+    if (!loopback.isValid()) return;
+
+    // Written in big chunks, so recv sees several frames per read
+    std::string framed = frame(std::string(MESSAGE_SIZE, 'x'));
+    std::string chunk;
+    for (int i = 0; i < 64; ++i) chunk += framed;
+
+    uint64_t iterations = state.getIterations();
+    int peer = loopback.peer;
+    std::thread feed([peer, iterations, chunk, framed]()
+    {
+        uint64_t sent = 0;
+        while (sent < iterations)
+        {
+            const std::string& data = iterations - sent >= 64 ? chunk : framed;
+            size_t offset = 0;
+            while (offset < data.size())
+            {
+                ssize_t count = ::send(peer, data.data() + offset, data.size() - offset, 0);
+                if (count <= 0) return;
+                offset += (size_t)count;
+            }
+            sent += data.size() / framed.size();
+        }
+    });
+
+    state.setBytesPerOperation(MESSAGE_SIZE);
+    state.start();
+    for (uint64_t i = 0; i < iterations; ++i)
+    {
+        auto message = loopback.client->recv();
+        bench::doNotOptimize(message);
+    }
+    state.stop();
+    feed.join();
+}
+
+#endif
@@ -0,0 +1,226 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+//
+// Microbenchmarks for the library's hot paths. None of them need a network:
+// requests go to a local port that refuses connections, and sockets talk
+// over loopback.
+//
+// Usage: bcs2s_bench [--filter <text>] [--min-time-ms <ms>]
+//                    [--repetitions <n>] [--json <path or ->]
+//
+// Each benchmark is run with growing iteration counts until one run takes
+// min-time-ms, then that count is repeated. The table goes to stdout; the
+// json report, if asked for, to a file or to stdout with "-". Allocations
+// are counted over the timed part of the run, on every thread.
+
+#include "bench.h"
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+
+namespace bench
+{
+    std::vector<Case>& getCases()
+    {
+        static std::vector<Case> s_cases;
+        return s_cases;
+    }
+}
+
+namespace
+{
+    struct Options
+    {
+        std::string filter;
+        uint64_t minTimeMS = 200;
+        int repetitions = 5;
+        std::string jsonPath;
+    };
+
+    struct Result
+    {
+        std::string name;
+        uint64_t iterations = 0;
+        std::vector<double> nsPerOperation;
+        uint64_t bytesPerOperation = 0;
+        double allocationsPerOperation = 0;
+    };
+
+    // Nanoseconds one run took
+    double runOnce(const bench::Case& benchCase, uint64_t iterations, Result& result)
+    {
+        bench::State state(iterations);
+        uint64_t startAllocations = bench::getAllocationCount();
+        auto start = bench::Clock::now();
+        benchCase.function(state);
+        auto end = bench::Clock::now();
+        uint64_t endAllocations = bench::getAllocationCount();
+
+        if (state.isStarted())
+        {
+            start = state.getStart();
+            startAllocations = state.getStartAllocations();
+        }
+        if (state.isStopped())
+        {
+            end = state.getEnd();
+            endAllocations = state.getEndAllocations();
+        }
+        result.bytesPerOperation = state.getBytesPerOperation();
+        result.allocationsPerOperation = (double)(endAllocations - startAllocations) / (double)iterations;
+        return (double)std::chrono::duration_cast<std::chrono::nanoseconds>(end - start).count();
+    }
+
+    Result run(const bench::Case& benchCase, const Options& options)
+    {
+        Result result;
+        result.name = benchCase.name;
+
+        // Grow the iteration count until a run is long enough to time
+        double minTimeNS = (double)options.minTimeMS * 1e6;
+        uint64_t iterations = 1;
+        while (true)
+        {
+            double elapsed = runOnce(benchCase, iterations, result);
+            if (elapsed >= minTimeNS || iterations >= (1ull << 40)) break;
+
+            double scale = elapsed > 0 ? minTimeNS * 1.2 / elapsed : 100.0;
+            scale = std::max(2.0, std::min(100.0, scale));
+            iterations = (uint64_t)((double)iterations * scale);
+        }
+
+        result.iterations = iterations;
+        for (int i = 0; i < options.repetitions; ++i)
+        {
+            double elapsed = runOnce(benchCase, iterations, result);
+            result.nsPerOperation.push_back(elapsed / (double)iterations);
+        }
+        std::sort(result.nsPerOperation.begin(), result.nsPerOperation.end());
+        return result;
+    }
+
+    double median(const std::vector<double>& sorted)
+    {
+        size_t middle = sorted.size() / 2;
+        return sorted.size() % 2 ? sorted[middle] : (sorted[middle - 1] + sorted[middle]) / 2.0;
+    }
+
+    Json::Value toJson(const std::vector<Result>& results, const Options& options)
+    {
+        Json::Value report(Json::objectValue);
+
+        char date[32];
+        time_t now = time(NULL);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+        Json::Value& context = report["context"];
+        context["date"] = date;
+        context["libraryVersion"] = s_brainCloudS2SVersion;
+#if defined(NDEBUG)
+        context["buildType"] = "release";
+#else
+        context["buildType"] = "debug";
+#endif
+#if defined(__clang__)
+        context["compiler"] = "clang " __clang_version__;
+#elif defined(__GNUC__)
+        context["compiler"] = "gcc " __VERSION__;
+#elif defined(_MSC_VER)
+        context["compiler"] = "msvc " + std::to_string(_MSC_VER);
+#endif
+        context["minTimeMS"] = (Json::UInt64)options.minTimeMS;
+        context["repetitions"] = options.repetitions;
+
+        Json::Value& benchmarks = report["benchmarks"];
+        benchmarks = Json::Value(Json::arrayValue);
+        for (const auto& result : results)
+        {
+            Json::Value entry(Json::objectValue);
+            entry["name"] = result.name;
+            entry["iterations"] = (Json::UInt64)result.iterations;
+            entry["nsPerOp"] = median(result.nsPerOperation);
+            entry["nsPerOpMin"] = result.nsPerOperation.front();
+            entry["nsPerOpMax"] = result.nsPerOperation.back();
+            entry["allocationsPerOp"] = result.allocationsPerOperation;
+            if (result.bytesPerOperation > 0)
+            {
+                entry["bytesPerSecond"] = (double)result.bytesPerOperation * 1e9 / median(result.nsPerOperation);
+            }
+            benchmarks.append(entry);
+        }
+        return report;
+    }
+
+    void usage()
+    {
+        fprintf(stderr, "Usage: bcs2s_bench [--filter <text>] [--min-time-ms <ms>] "
+                        "[--repetitions <n>] [--json <path or ->]\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--filter" && hasValue) options.filter = argv[++i];
+        else if (arg == "--min-time-ms" && hasValue) options.minTimeMS = strtoull(argv[++i], NULL, 10);
+        else if (arg == "--repetitions" && hasValue) options.repetitions = std::max(1, atoi(argv[++i]));
+        else if (arg == "--json" && hasValue) options.jsonPath = argv[++i];
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    // The table goes to stderr when the json report takes stdout
+    FILE* table = options.jsonPath == "-" ? stderr : stdout;
+
+    std::vector<Result> results;
+    for (const auto& benchCase : bench::getCases())
+    {
+        if (!options.filter.empty() && benchCase.name.find(options.filter) == std::string::npos) continue;
+
+        auto result = run(benchCase, options);
+        double nsPerOperation = median(result.nsPerOperation);
+        fprintf(table, "%-40s %14.1f ns/op %10.1f allocs/op %12llu iterations", result.name.c_str(),
+                nsPerOperation, result.allocationsPerOperation, (unsigned long long)result.iterations);
+        if (result.bytesPerOperation > 0)
+        {
+            fprintf(table, " %10.1f MB/s", (double)result.bytesPerOperation * 1e3 / nsPerOperation);
+        }
+        fprintf(table, "\n");
+        fflush(table);
+        results.push_back(result);
+    }
+
+    if (!options.jsonPath.empty())
+    {
+        Json::StyledWriter writer;
+        std::string json = writer.write(toJson(results, options));
+        if (options.jsonPath == "-")
+        {
+            std::cout << json;
+        }
+        else
+        {
+            std::ofstream file(options.jsonPath, std::ios::binary | std::ios::trunc);
+            file << json;
+            if (!file)
+            {
+                fprintf(stderr, "Failed to write %s\n", options.jsonPath.c_str());
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
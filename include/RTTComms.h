@@ -12,11 +12,16 @@
 #include "ServiceOperation.h"
 #include "IWebSocket.h"
 #include "ITCPSocket.h"
+#include "S2SCompletionQueue.h"
+#include "S2SLogger.h"
+#include "S2STransport.h"
 
 #include "json/json.h"
 
 #include <atomic>
+#include <cstdint>
 #include <map>
+#include <memory>
 #include <mutex>
 #include <string>
 #include <vector>
@@ -33,6 +38,7 @@ namespace BrainCloud
     class IWebSocket;
 
     class S2SContext;
+    class S2SHttpReactor;
 
     class RTTComms : public IServerCallback
     {
@@ -40,7 +46,10 @@ namespace BrainCloud
         RTTComms(S2SContext* c);
         virtual ~RTTComms();
 
-        void initialize();
+        // Heartbeats are sent from the reactor's I/O thread. Sockets are
+        // opened by socketFactory if there is one, see setRTTSocketFactory.
+        void initialize(const std::shared_ptr<S2SHttpReactor>& reactor,
+                        const S2SRTTSocketFactory& socketFactory = nullptr);
         bool isInitialized() const;
         void shutdown();
         void resetCommunication();
@@ -53,7 +62,12 @@ namespace BrainCloud
         void enableLogging(bool isEnabled);
         const std::string& getConnectionId();
 
-        void runCallbacks();
+        // Dispatches the oldest event received, if any. False if there was none
+        bool runCallback();
+        // Events received and not dispatched yet. Doesn't lock
+        bool hasPendingCallbacks() const;
+        size_t getPendingCallbackCount() const;
+        void setCallbackSignal(const std::shared_ptr<S2SCallbackSignal>& signal);
         void registerRTTCallback(const ServiceName& serviceName, IRTTCallback* in_callback);
         void deregisterRTTCallback(const ServiceName& serviceName);
         void deregisterAllRTTCallbacks();
@@ -94,9 +108,12 @@ namespace BrainCloud
         void onSocketConnected();
         void startReceiving();
         void startHeartbeat();
+        void stopHeartbeat();
+        void stopHeartbeatLocked();
         Json::Value buildConnectionRequest(const std::string& protocol);
-        bool send(const Json::Value& jsonData);
+        bool send(const Json::Value& jsonData, S2SLogLevel logLevel = S2SLogLevel::Info);
         void onRecv(const std::string& message);
+        static S2SLogLevel getRecvLogLevel(bool parsed, const Json::Value& json);
         void processRttMessage(const Json::Value& json, const std::string& message);
 
         bool _isInitialized;
@@ -120,20 +137,34 @@ namespace BrainCloud
         BrainCloudRTT::RTTConnectionStatus _rttConnectionStatus;
         std::mutex _socketMutex;
         std::condition_variable _threadsCondition;
-        std::mutex _heartBeatMutex;
-        std::condition_variable _heartbeatCondition;
         std::atomic<bool> _receivingRunning;
-        std::atomic<bool> _heartbeatRunning;
 
         bool _useWebSocket;
 
-        int _heartbeatSeconds;
-        int64_t _lastHeartbeatTime;
+        // The heartbeat timer holds the state rather than this object, so a
+        // timer running late finds the owner cleared instead of deleted
+        struct HeartbeatState
+        {
+            std::mutex mutex;
+            RTTComms* owner = NULL;
+            uint64_t timer = 0;
+        };
+
+        void scheduleHeartbeat(const std::shared_ptr<HeartbeatState>& state, int64_t delayMS);
+        void onHeartbeatTimer(const std::shared_ptr<HeartbeatState>& state);
+
+        std::shared_ptr<S2SHttpReactor> _reactor;
+        S2SRTTSocketFactory _socketFactory;
+        // Started on the receive thread, stopped on the user's
+        std::mutex _heartbeatMutex;
+        std::shared_ptr<HeartbeatState> _heartbeatState;
+        std::atomic<int> _heartbeatSeconds;
+        // Written on the connection and I/O threads
+        std::atomic<int64_t> _lastHeartbeatTime;
         bool _disconnectedWithReason = false;
         int _disconnectReasonCode;
     
-        std::mutex _eventQueueMutex;
-        std::vector<RTTCallback> _callbackEventQueue;
+        S2SCompletionQueue<RTTCallback> _callbackEventQueue;
         std::map<std::string, IRTTCallback*> _callbacks;
     };
 };
@@ -0,0 +1,168 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace BrainCloud
+{
+    /**
+     * Wakes a thread waiting on several completion queues at once, e.g. the
+     * contexts of a session pool. Every queue it's set on notifies it on
+     * push.
+     */
+    class S2SCallbackSignal
+    {
+    public:
+        void notify()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_count.fetch_add(1, std::memory_order_release);
+            m_cond.notify_all();
+        }
+
+        /** Notifications so far. */
+        uint64_t getCount() const
+        {
+            return m_count.load(std::memory_order_acquire);
+        }
+
+        /**
+         * Waits until the count is past seen, at most timeout.
+         * @return false on timeout
+         */
+        bool wait(uint64_t seen, std::chrono::milliseconds timeout)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_cond.wait_for(lock, timeout, [this, seen]() {
+                return m_count.load(std::memory_order_relaxed) != seen;
+            });
+        }
+
+    private:
+        std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::atomic<uint64_t> m_count{0};
+    };
+
+    /**
+     * Hands completions from the threads producing them (the I/O thread,
+     * the RTT receive thread) to the thread calling runCallbacks.
+     *
+     * Producers move their records into a vector under the lock. The
+     * consumer swaps that whole vector out once it has nothing left of the
+     * previous one, and pops from it without locking. Both vectors keep
+     * their capacity, so once they have grown to the usual burst nothing is
+     * allocated: the records are moved in and moved out, never copied.
+     *
+     * push, clear, setSignal, size and getHighWater can be called from any
+     * thread; pop and empty only from the consumer's.
+     */
+    template <typename T>
+    class S2SCompletionQueue
+    {
+    public:
+        /** @return How many are queued, this one included. */
+        size_t push(T&& completion)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_queued.push_back(std::move(completion));
+            size_t size = m_size.fetch_add(1, std::memory_order_release) + 1;
+            m_highWater = std::max(m_highWater, size);
+            m_cond.notify_all();
+            if (m_signal) m_signal->notify();
+            return size;
+        }
+
+        /** Also notifies signal on push from now on. nullptr to stop. */
+        void setSignal(const std::shared_ptr<S2SCallbackSignal>& signal)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_signal = signal;
+        }
+
+        /**
+         * Moves the oldest completion into completion, in the order they were
+         * pushed. Completions pushed by the one just popped come after the
+         * ones already queued.
+         * @return false if there are none.
+         */
+        bool pop(T& completion)
+        {
+            if (m_next == m_ready.size())
+            {
+                if (m_size.load(std::memory_order_acquire) == 0) return false;
+
+                m_ready.clear();
+                m_next = 0;
+                std::unique_lock<std::mutex> lock(m_mutex);
+                m_ready.swap(m_queued);
+                if (m_ready.empty()) return false;
+            }
+
+            // Taken out before it's called: it can pop again itself
+            completion = std::move(m_ready[m_next++]);
+            m_size.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+
+        /**
+         * Drops the completions the consumer didn't take yet. Can be called
+         * from any thread; the ones it took are still popped.
+         */
+        void clear()
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_size.fetch_sub(m_queued.size(), std::memory_order_relaxed);
+            m_queued.clear();
+        }
+
+        /** Without taking the lock. */
+        bool empty() const
+        {
+            return m_size.load(std::memory_order_acquire) == 0;
+        }
+
+        /** Waits until a completion is queued, at most timeout. */
+        void wait(std::chrono::milliseconds timeout)
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_cond.wait_for(lock, timeout, [this]() {
+                return m_size.load(std::memory_order_relaxed) != 0;
+            });
+        }
+
+        /** Queued and not popped yet. */
+        size_t size() const
+        {
+            return m_size.load(std::memory_order_relaxed);
+        }
+
+        /** Most completions queued at once so far. */
+        size_t getHighWater() const
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            return m_highWater;
+        }
+
+    private:
+        mutable std::mutex m_mutex;
+        std::condition_variable m_cond;
+        std::vector<T> m_queued;
+        size_t m_highWater = 0;
+        std::shared_ptr<S2SCallbackSignal> m_signal;
+
+        // Counts both vectors
+        std::atomic<size_t> m_size{0};
+
+        // The consumer's, popped from m_next on
+        std::vector<T> m_ready;
+        size_t m_next = 0;
+    };
+};
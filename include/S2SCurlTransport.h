@@ -0,0 +1,53 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include "S2STransport.h"
+
+#include <curl/curl.h>
+
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace BrainCloud
+{
+    /**
+     * The default transport: posts packets with curl, through the reactor's
+     * multi handle, which keeps the connection to the dispatcher alive
+     * between requests. Easy handles are pooled, and a share handle lets
+     * every handle of the transport reuse resolved addresses and TLS
+     * sessions.
+     */
+    class S2SCurlTransport final : public IS2STransport, public std::enable_shared_from_this<S2SCurlTransport>
+    {
+    public:
+        static std::shared_ptr<S2SCurlTransport> create(const std::string& url,
+                                                        const std::shared_ptr<S2SHttpReactor>& reactor);
+
+        ~S2SCurlTransport();
+
+        TransferId post(const std::string& body, uint64_t timeoutMS,
+                        const DataCallback& onData, const Completion& completion) override;
+
+        void abort(TransferId id) override;
+
+    private:
+        S2SCurlTransport(const std::string& url, const std::shared_ptr<S2SHttpReactor>& reactor);
+
+        CURL* acquireHandle();
+
+        void releaseHandle(CURL* curl);
+
+        static void lockShare(CURL* curl, curl_lock_data data, curl_lock_access access, void* userptr);
+
+        static void unlockShare(CURL* curl, curl_lock_data data, void* userptr);
+
+        std::string m_url;
+        std::shared_ptr<S2SHttpReactor> m_reactor;
+        CURLSH* m_share;
+        std::mutex m_shareMutexes[CURL_LOCK_DATA_LAST];
+        std::mutex m_poolMutex;
+        std::vector<CURL*> m_pool;
+    };
+};
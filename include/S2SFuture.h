@@ -0,0 +1,34 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <chrono>
+#include <future>
+#include <string>
+
+namespace BrainCloud
+{
+    /**
+     * Waits for the result of an async call (authenticateAsync,
+     * requestAsync) until deadline, for the sync calls built on them.
+     * @return timeoutResult past the deadline, or a status 900 if the call
+     *         was dropped without an answer, by a disconnect
+     */
+    inline std::string s2sWaitForResult(std::future<std::string>& future,
+                                        std::chrono::steady_clock::time_point deadline,
+                                        const std::string& timeoutResult)
+    {
+        if (future.wait_until(deadline) != std::future_status::ready)
+        {
+            return timeoutResult;
+        }
+
+        try
+        {
+            return future.get();
+        }
+        catch (const std::future_error&)
+        {
+            return "{\"status\":900,\"message\":\"Request dropped on disconnect\"}";
+        }
+    }
+};
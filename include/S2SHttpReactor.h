@@ -0,0 +1,97 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <curl/curl.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <thread>
+
+namespace BrainCloud
+{
+    /**
+     * Drives every HTTP transfer of the S2S library from a single I/O thread
+     * through curl_multi, instead of one blocking thread per request.
+     *
+     * Transfers are handed over as configured curl easy handles. When a
+     * transfer finishes, its completion is called on the I/O thread with the
+     * handle (already removed from the multi handle) and the curl result.
+     * Completions must be short: they run on the thread serving every
+     * other transfer.
+     */
+    class S2SHttpReactor
+    {
+    public:
+        using Completion = std::function<void(CURL* curl, CURLcode result)>;
+        using TransferId = uint64_t;
+        using TimerId = uint64_t;
+
+        /** Reactor shared by every context of the process. Created on first use. */
+        static std::shared_ptr<S2SHttpReactor> getShared();
+
+        /**
+         * New reactor with its own I/O thread. Reactors still alive when the
+         * process exits are stopped before its statics are destroyed.
+         */
+        static std::shared_ptr<S2SHttpReactor> create();
+
+        /**
+         * Stops the I/O thread. Transfers still running are aborted and their
+         * completion is called with CURLE_ABORTED_BY_CALLBACK.
+         */
+        ~S2SHttpReactor();
+
+        /**
+         * Starts a transfer. Can be called from any thread. Once the reactor
+         * stopped, the completion is called with CURLE_ABORTED_BY_CALLBACK
+         * from a thread of its own.
+         * @return Id to abort the transfer with. Never 0.
+         */
+        TransferId add(CURL* curl, const Completion& completion);
+
+        /**
+         * Stops a transfer early. Its completion is called on the I/O thread
+         * with CURLE_ABORTED_BY_CALLBACK, unless it already finished. Can be
+         * called from any thread.
+         */
+        void abort(TransferId id);
+
+        /**
+         * Runs a function on the I/O thread once the time is reached. Can be
+         * called from any thread. Timers still waiting when the reactor
+         * stops, or scheduled after, are dropped without running.
+         * @return Id to cancel the timer with. Never 0.
+         */
+        TimerId schedule(std::chrono::steady_clock::time_point when,
+                         const std::function<void()>& function);
+
+        /**
+         * Drops a timer that didn't run yet. Can be called from any thread.
+         * @return Whether the timer was still waiting. False when it already
+         *         ran, or is running on the I/O thread.
+         */
+        bool cancel(TimerId id);
+
+        /**
+         * Runs a function on the I/O thread, after the completions of the
+         * current iteration. Can be called from any thread. If the reactor
+         * stops first, it still runs, from the stopping I/O thread, or from
+         * a thread of its own once the reactor stopped.
+         */
+        void post(const std::function<void()>& function);
+
+    private:
+        struct Loop;
+
+        S2SHttpReactor();
+
+        void stop();
+
+        static void stopAll();
+
+        std::shared_ptr<Loop> m_loop;
+        std::thread m_thread;
+    };
+};
@@ -0,0 +1,90 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace BrainCloud
+{
+    /**
+     * Finds the elements of one array member of a json object by byte
+     * range, without building a DOM. The document can be fed as it arrives:
+     * each element is reported as soon as its last byte is in.
+     *
+     * Only validates as much structure as it needs to skip over values; use
+     * it on documents that come from the server, not to validate input.
+     */
+    class S2SJsonScanner
+    {
+    public:
+        using Range = std::pair<size_t, size_t>; // [begin, end) byte offsets
+
+        enum class Result
+        {
+            Found,
+            NotFound,   // The document is an object without that array member
+            Invalid     // Not a json object, or not complete yet
+        };
+
+        /**
+         * @param arrayKey Top-level member to find, e.g. "messageResponses"
+         */
+        explicit S2SJsonScanner(const std::string& arrayKey);
+
+        /**
+         * Scan the bytes added to buffer since the last call. buffer is the
+         * whole document received so far; it must only ever grow.
+         */
+        void feed(const std::string& buffer);
+
+        /** Elements of the array closed so far. */
+        const std::vector<Range>& getElements() const { return m_elements; }
+
+        /** Value of another top-level member, once it closed. */
+        bool getMember(const std::string& buffer, const std::string& key, Range& value) const;
+
+        Result getResult() const;
+
+    private:
+        enum class State
+        {
+            Start,
+            Key,            // Expecting a member name
+            KeyOrEnd,       // Same, or the end of an empty object
+            InKey,
+            Colon,
+            Value,
+            InValue,
+            AfterValue,
+            ElementOrEnd,
+            Element,
+            InElement,
+            AfterElement,
+            Done,
+            Invalid
+        };
+
+        // Skips one value, one byte at a time. Returns whether the value
+        // ended. A scalar ends on the byte after it, which isn't consumed.
+        bool skipValueByte(char c, size_t pos, bool& consumed);
+
+        std::string m_arrayKey;
+        State m_state = State::Start;
+        size_t m_pos = 0;
+
+        // Value being skipped
+        size_t m_valueBegin = 0;
+        size_t m_valueEnd = 0;
+        int m_depth = 0;
+        bool m_inString = false;
+        bool m_escape = false;
+        bool m_scalar = false;
+
+        Range m_key;
+        bool m_found = false;
+        std::vector<Range> m_elements;
+        std::vector<std::pair<Range, Range>> m_members;
+    };
+};
@@ -0,0 +1,176 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+namespace BrainCloud
+{
+    /*
+    * What s2s_log does when the log writer falls behind and its buffer is full.
+    */
+    enum class S2SLogOverflow {
+        Block,  // Wait for the writer to make room, nothing is lost (default)
+        Drop    // Drop the record; the writer logs how many were dropped
+    };
+
+    /*
+    * Kinds of records a context logs, each configured on its own.
+    */
+    enum class S2SLogChannel {
+        S2SSend,        // Packets sent to the S2S dispatcher
+        S2SRecv,        // Packets received from it, and transfer errors
+        RTTSend,        // Messages sent on the RTT connection
+        RTTRecv,        // Messages received on it, and disconnects
+        GlobalFileV3,   // File uploads
+        LWS             // libwebsockets
+    };
+
+    /*
+    * Records a channel logs: each level includes the ones before it.
+    */
+    enum class S2SLogLevel {
+        Off,
+        Error,      // Failures only
+        Info,       // Plus the traffic: packets, messages, uploads
+        Verbose     // Plus heartbeats and the request queue (default)
+    };
+
+    struct S2SLogChannelOptions {
+        S2SLogLevel level = S2SLogLevel::Verbose;
+        // Logs one Info or Verbose record out of sampleEvery. Errors are
+        // never sampled out.
+        uint32_t sampleEvery = 1;
+        // Payloads longer than this are cut, 0 logs them whole
+        size_t maxPayloadBytes = 0;
+    };
+
+    /**
+     * Writes log records from a background thread, so the threads logging
+     * (the caller, the I/O thread, the RTT receive thread) never open or
+     * write files themselves.
+     *
+     * Records are formatted by their producer and pushed into a bounded
+     * lock-free ring. The writer thread takes them out in batches, every few
+     * milliseconds or once the ring fills up, and writes each batch with a
+     * single call to a file it keeps open, or to stdout when no file is set.
+     */
+    class S2SLogger
+    {
+    public:
+        /** Logger s2s_log writes to. Created on first use, flushed at exit. */
+        static S2SLogger& getDefault();
+
+        /**
+         * Appends the local time as "YYYY/MM/DD HH:MM:SS". Formatted once per
+         * second per thread.
+         */
+        static void appendTimestamp(std::string& out);
+
+        /**
+         * Appends text with the string value of each member named in
+         * sensitiveKeys replaced by obfuscateString's. One pass over the
+         * text, which is copied as is between the values replaced.
+         */
+        static void appendRedacted(std::string& out, const char* text, size_t size);
+
+        /** @param capacity records the ring holds, rounded up to a power of two, at least 8 */
+        explicit S2SLogger(size_t capacity = 8192);
+
+        /** Writes the records still in the ring, then stops the writer. */
+        ~S2SLogger();
+
+        /** Queues one line, without its line ending. Can be called from any thread. */
+        void write(std::string&& record);
+
+        /**
+         * Waits until the records queued before the call are written. Records
+         * queued after the writer stopped are written by their producer.
+         */
+        void flush();
+
+        /**
+         * Sends the records queued from now on to a file, appended to and kept
+         * open. An empty path goes back to stdout.
+         */
+        void setFilePath(const std::string& path);
+
+        void setOverflowPolicy(S2SLogOverflow policy);
+
+        /** Records dropped so far by the Drop policy. */
+        uint64_t getDroppedCount() const;
+
+        void setChannelOptions(S2SLogChannel channel, const S2SLogChannelOptions& options);
+        S2SLogChannelOptions getChannelOptions(S2SLogChannel channel) const;
+
+        /**
+         * Whether a record of this level is logged on the channel, counting
+         * it for sampling. Check it before formatting anything for the
+         * record, so records not logged cost nothing else.
+         */
+        bool shouldLog(S2SLogChannel channel, S2SLogLevel level);
+
+        size_t getMaxPayloadBytes(S2SLogChannel channel) const;
+
+    private:
+        struct Slot;
+        struct Output;
+
+        struct Channel
+        {
+            std::atomic<S2SLogLevel> level{S2SLogLevel::Verbose};
+            std::atomic<uint32_t> sampleEvery{1};
+            std::atomic<size_t> maxPayloadBytes{0};
+            std::atomic<uint64_t> sampled{0};
+        };
+
+        static const size_t CHANNEL_COUNT = 6;
+
+        bool tryPush(std::string& record, size_t& pos);
+        bool tryPop(std::string& record);
+        bool hasRecord() const;
+        void wakeWriter();
+        void run();
+        void writeBatch(std::string& batch);
+        void drainStopped();
+        void stop();
+
+        static void stopDefault();
+
+        size_t m_mask;
+        size_t m_wakeMask;
+        std::unique_ptr<Slot[]> m_slots;
+        std::atomic<size_t> m_enqueuePos{0};
+        size_t m_dequeuePos = 0;
+
+        Channel m_channels[CHANNEL_COUNT];
+
+        std::atomic<S2SLogOverflow> m_policy{S2SLogOverflow::Block};
+        std::atomic<uint64_t> m_dropped{0};
+        uint64_t m_droppedReported = 0;
+
+        std::mutex m_mutex;
+        std::condition_variable m_wakeup;
+        std::condition_variable m_written;
+        bool m_wakeRequested = false;
+        size_t m_writtenPos = 0;
+        bool m_stopping = false;
+        std::atomic<bool> m_stopped{false};
+        // Pops from the ring once the writer stopped, for stop and the
+        // producers that pushed after it
+        std::mutex m_drainMutex;
+
+        // Only used by the writer, or under m_outputMutex once it stopped
+        std::mutex m_outputMutex;
+        std::unique_ptr<Output> m_output;
+        std::string m_pendingPath;
+        bool m_pathChanged = false;
+
+        std::thread m_thread;
+    };
+};
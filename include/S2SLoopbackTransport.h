@@ -0,0 +1,120 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include "ISocket.h"
+#include "S2STransport.h"
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace BrainCloud
+{
+    /**
+     * Transport that answers a context's packets in process, from a
+     * handler, without sockets. Answers are handed back on the reactor's
+     * I/O thread like curl's, so a request still goes through the same
+     * queues, locks, parsing and callbacks: what a request costs over it is
+     * what the library adds.
+     *
+     *   setTransportFactory(S2SLoopbackTransport::factory());
+     *   auto context = S2SContext::create(appId, serverName, secret, url, true);
+     */
+    class S2SLoopbackTransport final : public IS2STransport, public std::enable_shared_from_this<S2SLoopbackTransport>
+    {
+    public:
+        /**
+         * Answers one packet with the response body. Called on the reactor's
+         * I/O thread. An empty answer fails the post like a connection the
+         * server refused.
+         */
+        using Handler = std::function<std::string(const std::string& body)>;
+
+        /** @param handler nullptr for answerPacket */
+        static std::shared_ptr<S2SLoopbackTransport> create(const std::shared_ptr<S2SHttpReactor>& reactor,
+                                                            const Handler& handler = nullptr);
+
+        /** For setTransportFactory: every context gets its own, with the same handler. */
+        static S2STransportFactory factory(const Handler& handler = nullptr);
+
+        /**
+         * Answers a packet like a dispatcher would. Authentications get a
+         * session, RTT registrations a loopback endpoint (see
+         * S2SLoopbackSocket), and every other message status 200 with its
+         * own data back.
+         */
+        static std::string answerPacket(const std::string& body);
+
+        /** Answers right away: timeoutMS is ignored. */
+        TransferId post(const std::string& body, uint64_t timeoutMS,
+                        const DataCallback& onData, const Completion& completion) override;
+
+        void abort(TransferId id) override;
+
+        /** Packets posted so far. */
+        uint64_t getPostCount() const { return m_postCount; }
+
+    private:
+        S2SLoopbackTransport(const std::shared_ptr<S2SHttpReactor>& reactor, const Handler& handler);
+
+        void answer(TransferId id, const std::string& body, const DataCallback& onData,
+                    const Completion& completion, std::chrono::steady_clock::time_point posted);
+
+        std::shared_ptr<S2SHttpReactor> m_reactor;
+        Handler m_handler;
+        std::atomic<TransferId> m_nextId{1};
+        std::atomic<uint64_t> m_postCount{0};
+
+        // Aborted posts not answered yet. Only locked once something was aborted.
+        std::atomic<bool> m_hasAborted{false};
+        std::mutex m_abortedMutex;
+        std::vector<TransferId> m_aborted;
+    };
+
+    /**
+     * RTT connection to a handler instead of a server. Messages the client
+     * sends go to the handler, which answers with push(); recv() waits on a
+     * condition variable instead of a socket.
+     *
+     *   setRTTSocketFactory(S2SLoopbackSocket::factory());
+     */
+    class S2SLoopbackSocket final : public ISocket
+    {
+    public:
+        /** Called on the sending thread with each message the client sends. */
+        using Handler = std::function<void(S2SLoopbackSocket& socket, const std::string& message)>;
+
+        /** @param handler nullptr for answerMessage */
+        explicit S2SLoopbackSocket(const Handler& handler = nullptr);
+
+        /**
+         * For setRTTSocketFactory. onOpen, if any, gets each socket opened;
+         * it belongs to the context and is deleted once RTT is disabled.
+         */
+        static S2SRTTSocketFactory factory(const Handler& handler = nullptr,
+                                           const std::function<void(S2SLoopbackSocket*)>& onOpen = nullptr);
+
+        /** Accepts the client's CONNECT like the RTT server, ignores everything else. */
+        static void answerMessage(S2SLoopbackSocket& socket, const std::string& message);
+
+        /** Queues a message for the client, from any thread. */
+        void push(const std::string& message);
+
+        bool isValid() override;
+        void send(const std::string& message) override;
+        std::string recv() override;
+        void close() override;
+
+    private:
+        Handler m_handler;
+        std::mutex m_mutex;
+        std::condition_variable m_condition;
+        std::deque<std::string> m_messages;
+        bool m_closed = false;
+    };
+};
@@ -0,0 +1,104 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace BrainCloud
+{
+    /**
+     * Latency histogram with HDR-style log-linear buckets, in microseconds.
+     *
+     * Values under 16 us have a bucket each; above that, every power of two
+     * is split into 16 buckets, so a percentile is off by at most 1/16 of
+     * its value. Recording is a couple of shifts and an increment.
+     */
+    class S2SLatencyHistogram
+    {
+    public:
+        S2SLatencyHistogram();
+
+        void record(uint64_t valueUS);
+
+        uint64_t getCount() const { return m_count; }
+        uint64_t getSum() const { return m_sum; }
+        uint64_t getMin() const { return m_count ? m_min : 0; }
+        uint64_t getMax() const { return m_max; }
+        double getMean() const { return m_count ? (double)m_sum / (double)m_count : 0.0; }
+
+        /**
+         * Value under which the given share of the values fall.
+         * @param percentile 0 to 100
+         * @return Upper bound of the bucket holding it, at most getMax()
+         */
+        uint64_t getValueAtPercentile(double percentile) const;
+
+    private:
+        static const int SUB_BUCKET_BITS = 4;
+        static const int SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+        // Values of 2^40 us (about 12 days) and up share the last bucket
+        static const int MAX_BITS = 40;
+        static const int BUCKETS = SUB_BUCKETS * (MAX_BITS - SUB_BUCKET_BITS + 1);
+
+        static size_t bucketIndex(uint64_t value);
+        static uint64_t bucketUpperBound(size_t index);
+
+        std::vector<uint64_t> m_buckets;
+        uint64_t m_count = 0;
+        uint64_t m_sum = 0;
+        uint64_t m_min = 0;
+        uint64_t m_max = 0;
+    };
+
+    /**
+     * Snapshot of a context's client side metrics. See S2SContext::getStats.
+     */
+    struct S2SStats
+    {
+        // Time from queueing a request to handing its response to the
+        // callback, by "service.operation". Only requests the server
+        // answered are counted.
+        std::map<std::string, S2SLatencyHistogram> latency;
+
+        // Requests waiting to be sent, and callbacks waiting for runCallbacks.
+        // The callback depth counts RTT events and upload completions too.
+        size_t requestQueueDepth = 0;
+        size_t requestQueueHighWater = 0;
+        size_t callbackQueueDepth = 0;
+        size_t callbackQueueHighWater = 0;
+
+        // Callbacks a runCallbacks budget left for later, counted by each
+        // call that left them
+        uint64_t callbacksDeferred = 0;
+
+        // HTTP bytes to and from the dispatcher, headers included
+        uint64_t bytesSent = 0;
+        uint64_t bytesReceived = 0;
+
+        uint64_t authentications = 0;
+        uint64_t authenticationFailures = 0;
+
+        // Heartbeats sent, and heartbeats skipped because other responses
+        // kept the session alive
+        uint64_t heartbeats = 0;
+        uint64_t heartbeatsSkipped = 0;
+    };
+
+    /**
+     * Formats stats in the Prometheus text exposition format. Latencies are
+     * summaries in seconds, labelled by operation.
+     * @param prefix Prepended to every metric name
+     */
+    std::string formatPrometheus(const S2SStats& stats, const std::string& prefix = "brainclouds2s");
+
+    /**
+     * Writes formatPrometheus to a file, e.g. for the node exporter textfile
+     * collector. The file is replaced at once, never seen half written.
+     * @return false if the file can't be written
+     */
+    bool writePrometheus(const S2SStats& stats, const std::string& path,
+                         const std::string& prefix = "brainclouds2s");
+};
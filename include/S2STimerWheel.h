@@ -0,0 +1,93 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <vector>
+
+namespace BrainCloud
+{
+    /**
+     * Hierarchical timer wheel with a 1 ms tick.
+     *
+     * Four levels of 64 slots: level 0 holds the timers due in the next
+     * 64 ms, each level above covers 64 times the span of the one below.
+     * Timers further out than the top level wait in its last slot and are
+     * placed again when it comes around. Adding and cancelling are O(1);
+     * advancing only visits the slots that hold timers.
+     *
+     * Not thread safe: the owner serializes calls, and runs the functions
+     * advance() hands back.
+     */
+    class S2STimerWheel
+    {
+    public:
+        using Clock = std::chrono::steady_clock;
+        using TimerId = uint64_t;
+
+        explicit S2STimerWheel(Clock::time_point start = Clock::now());
+
+        /**
+         * Adds a timer. A time in the past is due on the next advance.
+         * @return Id to cancel it with. Never 0.
+         */
+        TimerId add(Clock::time_point when, std::function<void()> function);
+
+        /** @return Whether the timer was still waiting. */
+        bool cancel(TimerId id);
+
+        /** Moves the functions of the timers due at now to the back of due. */
+        void advance(Clock::time_point now, std::vector<std::function<void()>>& due);
+
+        /**
+         * How long the owner can wait before calling advance again, at most
+         * maxWait. Can be earlier than the next timer: timers of the upper
+         * levels are moved down on the way.
+         */
+        Clock::duration getWaitTime(Clock::time_point now, Clock::duration maxWait) const;
+
+        size_t size() const { return m_count; }
+
+        void clear();
+
+    private:
+        static const int LEVELS = 4;
+        static const int SLOT_BITS = 6;
+        static const int SLOTS = 1 << SLOT_BITS;
+        static const int32_t NONE = -1;
+
+        struct Node
+        {
+            uint64_t expires = 0;
+            uint32_t generation = 0;
+            int32_t prev = NONE;
+            int32_t next = NONE;
+            int level = -1; // -1 while free
+            int slot = 0;
+            std::function<void()> function;
+        };
+
+        uint64_t toTick(Clock::time_point time, bool roundUp) const;
+
+        void place(int32_t index);
+        void unlink(int32_t index);
+        void release(int32_t index);
+
+        // First tick at or after m_current where a slot holds timers, or
+        // false if the wheel is empty
+        bool nextEventTick(uint64_t& tick) const;
+
+        Clock::time_point m_start;
+
+        // Tick up to which timers were handed out. Its slots are empty
+        // once processed, so it can be processed again.
+        uint64_t m_current = 0;
+
+        std::vector<Node> m_nodes;
+        std::vector<int32_t> m_free;
+        int32_t m_heads[LEVELS][SLOTS];
+        uint64_t m_occupied[LEVELS] = {};
+        size_t m_count = 0;
+    };
+};
@@ -0,0 +1,74 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <vector>
+
+namespace BrainCloud
+{
+    /**
+     * Timeline of one request, from queueing to its callback. Times the
+     * request didn't go through (no DNS lookup on a reused connection, no
+     * callback queued for requestSync) are left at the clock's epoch.
+     *
+     * The network phases come from curl and are those of the last attempt
+     * when the packet was retried.
+     */
+    struct S2SRequestTrace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        // Queue order within the context
+        uint64_t id = 0;
+        // "service.operation"
+        std::string operation;
+        int packetId = -1;
+        // Messages in the packet it was sent in
+        size_t batchSize = 0;
+        int retries = 0;
+
+        Clock::time_point enqueued;
+        // Taken out of the queue and handed to the I/O thread
+        Clock::time_point sent;
+        // The transfer started on the I/O thread
+        Clock::time_point transferStarted;
+        Clock::time_point dnsDone;
+        Clock::time_point connectDone;
+        Clock::time_point tlsDone;
+        Clock::time_point firstByte;
+        Clock::time_point completed;
+        // The response was handed to the request's callback on the I/O
+        // thread, and for request() queued for runCallbacks
+        Clock::time_point delivered;
+        Clock::time_point callbackQueued;
+        Clock::time_point callbackInvoked;
+
+        /** Time from queueing to the end of its callback, or its delivery. */
+        Clock::duration getTotalTime() const;
+    };
+
+    struct S2STraceOptions
+    {
+        bool enabled = false;
+        // Finished traces kept for getTraces, oldest dropped first
+        size_t maxTraces = 1000;
+        // Called from runCallbacks with the traces of requests that took at
+        // least slowThresholdMS in total. 0 calls it for every request.
+        uint64_t slowThresholdMS = 0;
+        std::function<void(const S2SRequestTrace&)> onSlowRequest;
+    };
+
+    /**
+     * Formats traces as Chrome trace-event json, for chrome://tracing or
+     * Perfetto. Each request gets its own row, with a span per phase, so a
+     * request waiting behind others in the queue stands out.
+     */
+    std::string formatChromeTrace(const std::vector<S2SRequestTrace>& traces);
+
+    /** @return false if the file can't be written */
+    bool writeChromeTrace(const std::vector<S2SRequestTrace>& traces, const std::string& path);
+};
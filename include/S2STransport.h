@@ -0,0 +1,109 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <curl/curl.h>
+
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <map>
+#include <memory>
+#include <string>
+
+namespace BrainCloud
+{
+    class ISocket;
+    class S2SHttpReactor;
+
+    /**
+     * Carries a context's packets to the dispatcher and brings the answers
+     * back. Contexts post with curl by default (S2SCurlTransport);
+     * S2SLoopbackTransport answers in process instead, to see what the
+     * library itself costs without the network in the way.
+     *
+     * Callbacks are called on the context's reactor I/O thread, never from
+     * within post(): the caller may be holding locks they need.
+     */
+    class IS2STransport
+    {
+    public:
+        using TransferId = uint64_t;
+
+        struct Response
+        {
+            // CURLE_OK when body is the server's answer
+            CURLcode code = CURLE_OK;
+            // What went wrong, when code isn't CURLE_OK
+            std::string error;
+            std::string body;
+            // Whether any of the request went out, so the server may have run it
+            bool requestSent = false;
+            // HTTP bytes, headers included
+            uint64_t bytesSent = 0;
+            uint64_t bytesReceived = 0;
+            // Connections opened for this post
+            uint64_t newConnections = 0;
+            // Phases from the start of the transfer. Zero when skipped or
+            // unknown; totalTime is always set.
+            std::chrono::microseconds dnsTime{0};
+            std::chrono::microseconds connectTime{0};
+            std::chrono::microseconds tlsTime{0};
+            std::chrono::microseconds firstByteTime{0};
+            std::chrono::microseconds totalTime{0};
+        };
+
+        // Called with the whole body received so far, as it comes in
+        using DataCallback = std::function<void(const std::string& body)>;
+        using Completion = std::function<void(const Response& response)>;
+
+        virtual ~IS2STransport() {}
+
+        /**
+         * Posts a json packet. Can be called from any thread.
+         * @param timeoutMS Longest the post can take, after which it fails.
+         *                  0 for no limit: it can still be aborted.
+         * @param onData Optional
+         * @return Id to abort the post with, or 0 if it failed right away.
+         *         The completion is called either way.
+         */
+        virtual TransferId post(const std::string& body, uint64_t timeoutMS,
+                                const DataCallback& onData, const Completion& completion) = 0;
+
+        /**
+         * Stops a post early. Its completion is called with
+         * CURLE_ABORTED_BY_CALLBACK, unless it already finished. Can be
+         * called from any thread.
+         */
+        virtual void abort(TransferId id) = 0;
+    };
+
+    using IS2STransportRef = std::shared_ptr<IS2STransport>;
+
+    /*
+    * Makes the transport of a new context, from its dispatcher url and the
+    * reactor it runs on
+    */
+    using S2STransportFactory = std::function<IS2STransportRef(const std::string& url,
+                                                               const std::shared_ptr<S2SHttpReactor>& reactor)>;
+
+    /*
+    * Set the transport of contexts created after this call
+    * @param factory Makes each context's transport. nullptr for curl, the default
+    */
+    void setTransportFactory(const S2STransportFactory& factory);
+
+    /*
+    * Opens an RTT connection to host:port, a websocket or a TCP socket. The
+    * headers are the RTT server's auth. Returns nullptr, or a socket that
+    * isn't valid, when it can't connect.
+    */
+    using S2SRTTSocketFactory = std::function<ISocket*(const std::string& host, int port,
+                                                       const std::map<std::string, std::string>& headers,
+                                                       bool webSocket)>;
+
+    /*
+    * Set how contexts created after this call open their RTT connections
+    * @param factory nullptr for libwebsockets and TCP sockets, the default
+    */
+    void setRTTSocketFactory(const S2SRTTSocketFactory& factory);
+};
@@ -0,0 +1,179 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <cstddef>
+#include <new>
+#include <type_traits>
+#include <utility>
+
+namespace BrainCloud
+{
+    template <typename Signature>
+    class S2SUniqueFunction;
+
+    /**
+     * Move-only callable wrapper, for functions called once and handed
+     * between threads (completions, queued work).
+     *
+     * Unlike std::function it never copies what it holds, so it can hold
+     * move-only state, and callables up to INLINE_SIZE bytes are stored in
+     * the object itself: wrapping a callback and its response string, or
+     * moving the wrapper around, doesn't allocate. Larger callables, or ones
+     * that could throw while moved, are put on the heap.
+     */
+    template <typename R, typename... Args>
+    class S2SUniqueFunction<R(Args...)>
+    {
+    public:
+        static const size_t INLINE_SIZE = 12 * sizeof(void*);
+
+        S2SUniqueFunction() noexcept = default;
+
+        S2SUniqueFunction(std::nullptr_t) noexcept {}
+
+        template <typename F,
+                  typename Function = typename std::decay<F>::type,
+                  typename = typename std::enable_if<!std::is_same<Function, S2SUniqueFunction>::value>::type>
+        S2SUniqueFunction(F&& function)
+        {
+            construct<Function>(std::forward<F>(function), IsInline<Function>());
+        }
+
+        S2SUniqueFunction(S2SUniqueFunction&& other) noexcept
+        {
+            moveFrom(other);
+        }
+
+        S2SUniqueFunction& operator=(S2SUniqueFunction&& other) noexcept
+        {
+            if (this != &other)
+            {
+                reset();
+                moveFrom(other);
+            }
+            return *this;
+        }
+
+        S2SUniqueFunction& operator=(std::nullptr_t) noexcept
+        {
+            reset();
+            return *this;
+        }
+
+        S2SUniqueFunction(const S2SUniqueFunction&) = delete;
+        S2SUniqueFunction& operator=(const S2SUniqueFunction&) = delete;
+
+        ~S2SUniqueFunction()
+        {
+            reset();
+        }
+
+        explicit operator bool() const noexcept
+        {
+            return m_ops != nullptr;
+        }
+
+        /** Must not be empty. */
+        R operator()(Args... args)
+        {
+            return m_ops->invoke(&m_storage, std::forward<Args>(args)...);
+        }
+
+        /** Whether the callable is on the heap, for tests. */
+        bool isOnHeap() const noexcept
+        {
+            return m_ops != nullptr && m_ops->onHeap;
+        }
+
+    private:
+        using Storage = typename std::aligned_storage<INLINE_SIZE, alignof(std::max_align_t)>::type;
+
+        // What the wrapper does with what it holds, one table per type held
+        struct Ops
+        {
+            R (*invoke)(void* storage, Args&&... args);
+            // Move constructs into to, then destroys from
+            void (*relocate)(void* from, void* to);
+            void (*destroy)(void* storage);
+            bool onHeap;
+        };
+
+        template <typename F>
+        using IsInline = std::integral_constant<bool,
+                sizeof(F) <= INLINE_SIZE &&
+                alignof(std::max_align_t) % alignof(F) == 0 &&
+                std::is_nothrow_move_constructible<F>::value>;
+
+        template <typename F, typename Arg>
+        void construct(Arg&& function, std::true_type)
+        {
+            static const Ops ops = {&invokeInline<F>, &relocateInline<F>, &destroyInline<F>, false};
+            new (&m_storage) F(std::forward<Arg>(function));
+            m_ops = &ops;
+        }
+
+        template <typename F, typename Arg>
+        void construct(Arg&& function, std::false_type)
+        {
+            static const Ops ops = {&invokeHeap<F>, &relocateHeap, &destroyHeap<F>, true};
+            *reinterpret_cast<F**>(&m_storage) = new F(std::forward<Arg>(function));
+            m_ops = &ops;
+        }
+
+        template <typename F>
+        static R invokeInline(void* storage, Args&&... args)
+        {
+            return (*static_cast<F*>(storage))(std::forward<Args>(args)...);
+        }
+
+        template <typename F>
+        static void relocateInline(void* from, void* to)
+        {
+            F* function = static_cast<F*>(from);
+            new (to) F(std::move(*function));
+            function->~F();
+        }
+
+        template <typename F>
+        static void destroyInline(void* storage)
+        {
+            static_cast<F*>(storage)->~F();
+        }
+
+        template <typename F>
+        static R invokeHeap(void* storage, Args&&... args)
+        {
+            return (**static_cast<F**>(storage))(std::forward<Args>(args)...);
+        }
+
+        static void relocateHeap(void* from, void* to)
+        {
+            *static_cast<void**>(to) = *static_cast<void**>(from);
+        }
+
+        template <typename F>
+        static void destroyHeap(void* storage)
+        {
+            delete *static_cast<F**>(storage);
+        }
+
+        void moveFrom(S2SUniqueFunction& other) noexcept
+        {
+            if (!other.m_ops) return;
+            other.m_ops->relocate(&other.m_storage, &m_storage);
+            m_ops = other.m_ops;
+            other.m_ops = nullptr;
+        }
+
+        void reset() noexcept
+        {
+            if (!m_ops) return;
+            const Ops* ops = m_ops;
+            m_ops = nullptr;
+            ops->destroy(&m_storage);
+        }
+
+        Storage m_storage;
+        const Ops* m_ops = nullptr;
+    };
+};
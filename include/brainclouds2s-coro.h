@@ -0,0 +1,633 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+
+#pragma once
+
+/**
+ * C++20 coroutine helpers for the S2S library.
+ *
+ * Header only and optional: the library itself stays C++11. This header is
+ * empty unless it is compiled with coroutine support.
+ *
+ * Usage:
+ *   using namespace BrainCloud::Coro;
+ *
+ *   Task<void> startRoom(S2SContextRef s2s, std::string lobbyId)
+ *   {
+ *       Json::Value lobby = co_await requestCo(s2s, getLobbyJson);
+ *       if (lobby["status"].asInt() != 200) co_return;
+ *
+ *       // Both requests are in flight at the same time
+ *       auto [a, b] = co_await whenAll(requestCo(s2s, jsonA), requestCo(s2sOther, jsonB));
+ *   }
+ *
+ *   spawn(startRoom(s2s, lobbyId));
+ *   while (running) s2s->runCallbacks(10);
+ *
+ * By default a coroutine resumes on the thread that runs the callback it was
+ * waiting for, which is the thread calling S2SContext::runCallbacks(). Pass
+ * an Executor, or set one with setDefaultExecutor(), to resume somewhere
+ * else, like a thread pool.
+ *
+ * A coroutine waiting on a request that never gets an answer (the request
+ * was dropped by a disconnect) stays suspended.
+ */
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+#include "brainclouds2s.h"
+#include "brainclouds2s-globalfilev3.h"
+#include "brainclouds2s-rtt.h"
+#include "IRTTCallback.h"
+#include "IRTTConnectCallback.h"
+#include "ServiceName.h"
+#include "json/json.h"
+
+#include <atomic>
+#include <coroutine>
+#include <cstdint>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+
+namespace BrainCloud
+{
+namespace Coro
+{
+    /** Resumes a suspended coroutine. An empty executor resumes it inline. */
+    using Executor = std::function<void(std::coroutine_handle<>)>;
+
+    inline Executor& defaultExecutor()
+    {
+        static Executor s_executor;
+        return s_executor;
+    }
+
+    /** Executor used by awaitables created without one. Empty resumes inline. */
+    inline void setDefaultExecutor(Executor executor)
+    {
+        defaultExecutor() = std::move(executor);
+    }
+
+    namespace detail
+    {
+        inline void resumeOn(const Executor& executor, std::coroutine_handle<> handle)
+        {
+            if (executor) executor(handle);
+            else handle.resume();
+        }
+
+        inline Json::Value parseResult(const std::string& result)
+        {
+            Json::Value json;
+            Json::Reader reader;
+            if (!reader.parse(result, json))
+            {
+                json = Json::Value(Json::objectValue);
+                json["status"] = 900;
+                json["message"] = "Failed to parse json";
+            }
+            return json;
+        }
+
+        inline std::string serialize(const Json::Value& json)
+        {
+            Json::FastWriter writer;
+            std::string result = writer.write(json);
+            rtrim(result);
+            return result;
+        }
+
+        template <typename T>
+        struct TaskPromiseBase
+        {
+            std::coroutine_handle<> continuation;
+            std::exception_ptr error;
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+
+            struct FinalAwaiter
+            {
+                bool await_ready() noexcept { return false; }
+
+                template <typename Promise>
+                std::coroutine_handle<> await_suspend(std::coroutine_handle<Promise> handle) noexcept
+                {
+                    auto continuation = handle.promise().continuation;
+                    return continuation ? continuation : std::noop_coroutine();
+                }
+
+                void await_resume() noexcept {}
+            };
+
+            FinalAwaiter final_suspend() noexcept { return {}; }
+
+            void unhandled_exception() { error = std::current_exception(); }
+        };
+    }
+
+    /**
+     * Lazily started coroutine returning a T. Starts when awaited, or when
+     * handed to spawn() or whenAll().
+     */
+    template <typename T = void>
+    class [[nodiscard]] Task
+    {
+    public:
+        struct promise_type : detail::TaskPromiseBase<T>
+        {
+            std::optional<T> value;
+
+            Task get_return_object()
+            {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            void return_value(T result) { value = std::move(result); }
+        };
+
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        ~Task() { if (m_handle) m_handle.destroy(); }
+
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+        {
+            m_handle.promise().continuation = continuation;
+            return m_handle;
+        }
+
+        T await_resume()
+        {
+            auto& promise = m_handle.promise();
+            if (promise.error) std::rethrow_exception(promise.error);
+            return std::move(*promise.value);
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    template <>
+    class [[nodiscard]] Task<void>
+    {
+    public:
+        struct promise_type : detail::TaskPromiseBase<void>
+        {
+            Task get_return_object()
+            {
+                return Task(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            void return_void() {}
+        };
+
+        Task(Task&& other) noexcept : m_handle(std::exchange(other.m_handle, nullptr)) {}
+        Task(const Task&) = delete;
+        Task& operator=(const Task&) = delete;
+        ~Task() { if (m_handle) m_handle.destroy(); }
+
+        bool await_ready() const noexcept { return false; }
+
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> continuation) noexcept
+        {
+            m_handle.promise().continuation = continuation;
+            return m_handle;
+        }
+
+        void await_resume()
+        {
+            auto& promise = m_handle.promise();
+            if (promise.error) std::rethrow_exception(promise.error);
+        }
+
+    private:
+        explicit Task(std::coroutine_handle<promise_type> handle) : m_handle(handle) {}
+
+        std::coroutine_handle<promise_type> m_handle;
+    };
+
+    namespace detail
+    {
+        // Eagerly started coroutine that frees itself when done
+        struct Detached
+        {
+            struct promise_type
+            {
+                Detached get_return_object() { return {}; }
+                std::suspend_never initial_suspend() noexcept { return {}; }
+                std::suspend_never final_suspend() noexcept { return {}; }
+                void return_void() {}
+                void unhandled_exception() { std::terminate(); }
+            };
+        };
+
+        template <typename T>
+        Detached runDetached(Task<T> task)
+        {
+            co_await std::move(task);
+        }
+
+        // Counts down the tasks of a whenAll, plus one for the awaiting
+        // coroutine itself so it can't be resumed before it has suspended
+        struct WhenAllLatch
+        {
+            std::atomic<size_t> count;
+            std::coroutine_handle<> continuation;
+            // Tasks can fail on different threads: the first to set failed
+            // keeps its exception
+            std::atomic<bool> failed{false};
+            std::exception_ptr error;
+
+            explicit WhenAllLatch(size_t tasks) : count(tasks + 1) {}
+
+            void arrive()
+            {
+                if (--count == 0) continuation.resume();
+            }
+        };
+
+        template <typename T>
+        Detached runWhenAllTask(Task<T>& task, std::optional<T>& result, WhenAllLatch& latch)
+        {
+            try
+            {
+                result.emplace(co_await std::move(task));
+            }
+            catch (...)
+            {
+                if (!latch.failed.exchange(true)) latch.error = std::current_exception();
+            }
+            latch.arrive();
+        }
+
+        template <typename Start>
+        struct WhenAllAwaiter
+        {
+            WhenAllLatch& latch;
+            Start start;
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> continuation)
+            {
+                latch.continuation = continuation;
+                start();
+                return --latch.count != 0;
+            }
+
+            void await_resume()
+            {
+                if (latch.error) std::rethrow_exception(latch.error);
+            }
+        };
+
+        template <typename... T, size_t... I>
+        Task<std::tuple<T...>> whenAllImpl(std::index_sequence<I...>, Task<T>... tasks)
+        {
+            WhenAllLatch latch(sizeof...(T));
+            std::tuple<std::optional<T>...> results;
+            std::tuple<Task<T>...> owned(std::move(tasks)...);
+
+            auto start = [&]()
+            {
+                (runWhenAllTask(std::get<I>(owned), std::get<I>(results), latch), ...);
+            };
+            // Named, not a temporary in the co_await expression: some
+            // compilers destroy such temporaries twice
+            WhenAllAwaiter<decltype(start)> awaiter{latch, start};
+            co_await awaiter;
+
+            co_return std::tuple<T...>(std::move(*std::get<I>(results))...);
+        }
+    }
+
+    /**
+     * Starts a task without waiting for it. The task frees itself when it
+     * finishes. An exception escaping it terminates the program.
+     */
+    template <typename T>
+    void spawn(Task<T> task)
+    {
+        detail::runDetached(std::move(task));
+    }
+
+    /**
+     * Runs the tasks concurrently and resumes once all of them are done,
+     * with all their results. If some of them throw, the first exception is
+     * rethrown after all of them are done.
+     */
+    template <typename... T>
+    Task<std::tuple<T...>> whenAll(Task<T>... tasks)
+    {
+        return detail::whenAllImpl(std::index_sequence_for<T...>(), std::move(tasks)...);
+    }
+
+    /** Same as whenAll, for any number of tasks of the same type. */
+    template <typename T>
+    Task<std::vector<T>> whenAll(std::vector<Task<T>> tasks)
+    {
+        detail::WhenAllLatch latch(tasks.size());
+        std::vector<std::optional<T>> results(tasks.size());
+
+        auto start = [&]()
+        {
+            for (size_t i = 0; i < tasks.size(); ++i)
+            {
+                detail::runWhenAllTask(tasks[i], results[i], latch);
+            }
+        };
+        detail::WhenAllAwaiter<decltype(start)> awaiter{latch, start};
+        co_await awaiter;
+
+        std::vector<T> values;
+        values.reserve(results.size());
+        for (auto& result : results)
+        {
+            values.push_back(std::move(*result));
+        }
+        co_return values;
+    }
+
+    // -----------------------------------------------------------------------
+    // S2S requests
+    // -----------------------------------------------------------------------
+
+    namespace detail
+    {
+        class RequestAwaiter
+        {
+        public:
+            RequestAwaiter(S2SContextRef s2s, std::string json, Executor executor)
+                : m_s2s(std::move(s2s)), m_json(std::move(json)), m_executor(std::move(executor)) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                m_s2s->request(m_json, [this, handle](const std::string& result)
+                {
+                    m_result = result;
+                    detail::resumeOn(m_executor, handle);
+                });
+            }
+
+            Json::Value await_resume() { return detail::parseResult(m_result); }
+
+        private:
+            S2SContextRef m_s2s;
+            std::string m_json;
+            Executor m_executor;
+            std::string m_result;
+        };
+    }
+
+    /**
+     * Sends an S2S request when awaited. See S2SContext::request
+     * @return The parsed response
+     */
+    inline Task<Json::Value> requestCo(S2SContextRef s2s, std::string json,
+                                       Executor executor = defaultExecutor())
+    {
+        co_return co_await detail::RequestAwaiter(std::move(s2s), std::move(json), std::move(executor));
+    }
+
+    inline Task<Json::Value> requestCo(S2SContextRef s2s, const Json::Value& json,
+                                       Executor executor = defaultExecutor())
+    {
+        return requestCo(std::move(s2s), detail::serialize(json), std::move(executor));
+    }
+
+    // String literals would be ambiguous between the two overloads above
+    inline Task<Json::Value> requestCo(S2SContextRef s2s, const char* json,
+                                       Executor executor = defaultExecutor())
+    {
+        return requestCo(std::move(s2s), std::string(json), std::move(executor));
+    }
+
+    // -----------------------------------------------------------------------
+    // Global File V3 uploads
+    // -----------------------------------------------------------------------
+
+    namespace detail
+    {
+        class UploadAwaiter
+        {
+        public:
+            UploadAwaiter(BrainCloudS2SGlobalFileV3* globalFile, std::string treeId, std::string filename,
+                          bool overwriteIfPresent, std::vector<uint8_t> fileData, Executor executor)
+                : m_globalFile(globalFile), m_treeId(std::move(treeId)), m_filename(std::move(filename)),
+                  m_overwriteIfPresent(overwriteIfPresent), m_fileData(std::move(fileData)),
+                  m_executor(std::move(executor)) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                m_globalFile->uploadGlobalFile(m_treeId, m_filename, m_overwriteIfPresent, m_fileData,
+                    [this, handle](const std::string& result)
+                    {
+                        m_result = result;
+                        detail::resumeOn(m_executor, handle);
+                    });
+            }
+
+            Json::Value await_resume() { return detail::parseResult(m_result); }
+
+        private:
+            BrainCloudS2SGlobalFileV3* m_globalFile;
+            std::string m_treeId;
+            std::string m_filename;
+            bool m_overwriteIfPresent;
+            std::vector<uint8_t> m_fileData;
+            Executor m_executor;
+            std::string m_result;
+        };
+    }
+
+    /**
+     * Uploads a file when awaited. See BrainCloudS2SGlobalFileV3::uploadGlobalFile
+     * @return The parsed upload result
+     */
+    inline Task<Json::Value> uploadCo(BrainCloudS2SGlobalFileV3* globalFile, std::string treeId,
+                                      std::string filename, bool overwriteIfPresent,
+                                      std::vector<uint8_t> fileData,
+                                      Executor executor = defaultExecutor())
+    {
+        co_return co_await detail::UploadAwaiter(globalFile, std::move(treeId), std::move(filename),
+                                                 overwriteIfPresent, std::move(fileData),
+                                                 std::move(executor));
+    }
+
+    // -----------------------------------------------------------------------
+    // RTT
+    // -----------------------------------------------------------------------
+
+    struct RTTConnectResult
+    {
+        bool connected = false;
+        std::string errorMessage;
+    };
+
+    namespace detail
+    {
+        // Kept by the context after the coroutine resumed, RTTComms reports
+        // later failures to it too: only the first call resumes.
+        class RTTConnectState : public IRTTConnectCallback
+        {
+        public:
+            RTTConnectState(std::coroutine_handle<> handle, Executor executor)
+                : m_handle(handle), m_executor(std::move(executor)) {}
+
+            void rttConnectSuccess() override
+            {
+                complete(true, std::string());
+            }
+
+            void rttConnectFailure(const std::string& errorMessage) override
+            {
+                complete(false, errorMessage);
+            }
+
+            RTTConnectResult result;
+
+        private:
+            void complete(bool connected, const std::string& errorMessage)
+            {
+                if (m_done.exchange(true)) return;
+                result.connected = connected;
+                result.errorMessage = errorMessage;
+                auto handle = m_handle;
+                m_handle = nullptr;
+                detail::resumeOn(m_executor, handle);
+            }
+
+            std::atomic<bool> m_done{false};
+            std::coroutine_handle<> m_handle;
+            Executor m_executor;
+        };
+
+        class RTTConnectAwaiter
+        {
+        public:
+            RTTConnectAwaiter(S2SContextRef s2s, Executor executor)
+                : m_s2s(std::move(s2s)), m_executor(std::move(executor)) {}
+
+            bool await_ready() const noexcept { return false; }
+
+            bool await_suspend(std::coroutine_handle<> handle)
+            {
+                m_state = std::make_shared<RTTConnectState>(handle, m_executor);
+                if (m_s2s->enableRTT(m_state)) return true;
+
+                // Already enabled or connecting: nothing would resume us
+                auto status = m_s2s->getRTTService()->getConnectionStatus();
+                m_state->result.connected = status == BrainCloudRTT::RTTConnectionStatus::Connected;
+                if (!m_state->result.connected)
+                {
+                    m_state->result.errorMessage = "RTT is already connecting";
+                }
+                return false;
+            }
+
+            RTTConnectResult await_resume() { return m_state->result; }
+
+        private:
+            S2SContextRef m_s2s;
+            Executor m_executor;
+            std::shared_ptr<RTTConnectState> m_state;
+        };
+    }
+
+    /** Enables RTT on a context when awaited. See S2SContext::enableRTT */
+    inline Task<RTTConnectResult> enableRTTCo(S2SContextRef s2s, Executor executor = defaultExecutor())
+    {
+        co_return co_await detail::RTTConnectAwaiter(std::move(s2s), std::move(executor));
+    }
+
+    /**
+     * RTT events of one service, to be awaited one at a time.
+     *
+     * Registers itself as the RTT callback of the service for its lifetime,
+     * replacing any callback registered before. Events that arrive while
+     * nobody is waiting are kept until the next call to next().
+     */
+    class RTTEventStream : public IRTTCallback
+    {
+    public:
+        RTTEventStream(BrainCloudRTT* rtt, const ServiceName& service)
+            : m_rtt(rtt), m_service(service)
+        {
+            m_rtt->registerRTTCallback(m_service, this);
+        }
+
+        ~RTTEventStream() override
+        {
+            m_rtt->deregisterRTTCallback(m_service);
+        }
+
+        RTTEventStream(const RTTEventStream&) = delete;
+        RTTEventStream& operator=(const RTTEventStream&) = delete;
+
+        class EventAwaiter
+        {
+        public:
+            EventAwaiter(RTTEventStream& stream, Executor executor)
+                : m_stream(stream), m_executor(std::move(executor)) {}
+
+            bool await_ready() const noexcept { return !m_stream.m_events.empty(); }
+
+            void await_suspend(std::coroutine_handle<> handle)
+            {
+                m_stream.m_waiting = handle;
+                m_stream.m_executor = m_executor;
+            }
+
+            Json::Value await_resume()
+            {
+                std::string event = std::move(m_stream.m_events.front());
+                m_stream.m_events.pop_front();
+                return detail::parseResult(event);
+            }
+
+        private:
+            RTTEventStream& m_stream;
+            Executor m_executor;
+        };
+
+        /** Waits for the next event of the service, as parsed json. */
+        Task<Json::Value> next(Executor executor = defaultExecutor())
+        {
+            co_return co_await EventAwaiter(*this, std::move(executor));
+        }
+
+        void rttCallback(const std::string& jsonData) override
+        {
+            m_events.push_back(jsonData);
+            if (m_waiting)
+            {
+                auto handle = std::exchange(m_waiting, nullptr);
+                detail::resumeOn(m_executor, handle);
+            }
+        }
+
+    private:
+        BrainCloudRTT* m_rtt;
+        ServiceName m_service;
+        std::deque<std::string> m_events;
+        std::coroutine_handle<> m_waiting;
+        Executor m_executor;
+    };
+}
+}
+
+#endif
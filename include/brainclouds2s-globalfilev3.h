@@ -2,17 +2,23 @@
 
 #pragma once
 
+#include "S2SCompletionQueue.h"
+
 #include <atomic>
+#include <chrono>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
-#include <queue>
 #include <string>
 #include <vector>
 
 namespace BrainCloud
 {
     class S2SContext;
+    class S2SHttpReactor;
+    class S2SCancelToken;
+    struct S2SRequestOptions;
     using S2SCallback = std::function<void(const std::string &)>;
 
     /**
@@ -33,8 +39,11 @@ namespace BrainCloud
         BrainCloudS2SGlobalFileV3(S2SContext* s2s);
         ~BrainCloudS2SGlobalFileV3() = default;
 
-        /** Derives the upload URL from the S2S dispatcher URL. Called by S2SContext automatically. */
-        void init(const std::string& serverUrl);
+        /**
+         * Derives the upload URL from the S2S dispatcher URL and sets the I/O
+         * thread uploads run on. Called by S2SContext automatically.
+         */
+        void init(const std::string& serverUrl, const std::shared_ptr<S2SHttpReactor>& reactor);
 
         // -----------------------------------------------------------------------
         // File Info / Query
@@ -159,20 +168,44 @@ namespace BrainCloud
             bool overwriteIfPresent, const std::vector<uint8_t>& fileData,
             const S2SCallback& callback);
 
+        /**
+         * Same as above, with a deadline or a cancel token covering both
+         * steps. The callback is called exactly once; a timed out or
+         * cancelled upload gets status 900 with the reason_code
+         * S2S_REASON_REQUEST_TIMEOUT or S2S_REASON_REQUEST_CANCELLED.
+         */
+        void uploadGlobalFile(const std::string& treeId, const std::string& filename,
+            bool overwriteIfPresent, const std::vector<uint8_t>& fileData,
+            const S2SRequestOptions& options, const S2SCallback& callback);
+
         // -----------------------------------------------------------------------
         // Lifecycle (called internally by S2SContext)
         // -----------------------------------------------------------------------
 
-        /** Dispatches completed upload callbacks. Called by S2SContext::runCallbacks(). */
+        /** Dispatches completed upload callbacks. */
         void runCallbacks();
 
+        /**
+         * Dispatches the oldest completed upload callback, if any. Called by
+         * S2SContext::runCallbacks().
+         * @return false if there was none
+         */
+        bool runCallback();
+
+        /** Completed uploads not dispatched yet. Doesn't lock. */
+        bool hasPendingCallbacks() const;
+        size_t getPendingCallbackCount() const;
+
+        /** Notified when an upload completes. Called by S2SContext::setCallbackSignal(). */
+        void setCallbackSignal(const std::shared_ptr<S2SCallbackSignal>& signal);
+
         /** Cancels pending upload callbacks. Called by S2SContext::disconnect(). */
         void disconnect();
 
     private:
         S2SContext* _s2s;
         std::string _uploadUrl;
-        std::atomic<int> _generation;
+        std::shared_ptr<S2SHttpReactor> _reactor;
 
         struct UploadCompletion
         {
@@ -180,13 +213,40 @@ namespace BrainCloud
             std::string result;
         };
 
-        std::mutex _uploadMutex;
-        std::queue<UploadCompletion> _completedUploads;
+        // Shared with the transfers running on the I/O thread, so a
+        // completion never touches this object after it is destroyed.
+        struct UploadQueue
+        {
+            // Guards generation against completions being queued
+            std::mutex mutex;
+            std::atomic<int> generation{0};
+            S2SCompletionQueue<UploadCompletion> completed;
+        };
+
+        std::shared_ptr<UploadQueue> _uploads;
+
+        // One upload, from SYS_PREPARE_UPLOAD to the end of the transfer.
+        // The transfer, the deadline and the cancel token race to finish it.
+        struct Upload
+        {
+            std::atomic<bool> done{false};
+            S2SCallback callback;
+            int generation = 0;
+            bool hasDeadline = false;
+            std::chrono::steady_clock::time_point deadline;
+            std::shared_ptr<S2SCancelToken> cancelToken;
+            std::atomic<uint64_t> listenerId{0};
+            std::atomic<uint64_t> transferId{0};
+        };
+
+        static void finishUpload(const std::shared_ptr<UploadQueue>& uploads,
+            const std::shared_ptr<Upload>& upload, const std::string& result);
 
         void sendFileUpload(const std::string& uploadUrl, const std::string& filename,
-            const std::vector<uint8_t>& fileData, const S2SCallback& callback);
+            const std::vector<uint8_t>& fileData, const std::shared_ptr<Upload>& upload);
 
-        void log(const std::string& message);
+        // Check s2s_should_log first, the message is built before the call
+        static void log(const std::string& message, const std::string& payload = std::string());
     };
 
 } // namespace BrainCloud
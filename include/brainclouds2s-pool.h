@@ -0,0 +1,122 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+
+#pragma once
+
+#include "brainclouds2s.h"
+#include "S2SCompletionQueue.h"
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace BrainCloud
+{
+    class S2SSessionPool;
+    using S2SSessionPoolRef = std::shared_ptr<S2SSessionPool>;
+
+    /**
+     * Spreads S2S requests over several brainCloud sessions.
+     *
+     * The server runs the packets of one session in order, so a single
+     * S2SContext never goes faster than one round trip at a time. The pool
+     * authenticates N sessions with the same credentials and sends each
+     * request to the session with the fewest requests waiting on it.
+     *
+     * Requests that must run in order relative to each other can share an
+     * affinity key: every request with the same key goes to the same session.
+     *
+     * Usage:
+     *   auto pool = S2SSessionPool::create(appId, serverName, secret, DEFAULT_S2S_URL, 4);
+     *   pool->authenticateSync();
+     *   pool->request(json, callback);
+     *   pool->request(json, lobbyId, callback); // ordered with other requests for lobbyId
+     *   while (running) pool->runCallbacks(10);
+     */
+    class S2SSessionPool
+    {
+    public:
+        /**
+         * Create a pool of S2S contexts. See S2SContext::create
+         * @param sessionCount Number of sessions, at least 1
+         * @return A new pool, or nullptr if a context couldn't be created.
+         */
+        static S2SSessionPoolRef create(const std::string& appId,
+                                        const std::string& serverName,
+                                        const std::string& serverSecret,
+                                        const std::string& url,
+                                        size_t sessionCount,
+                                        bool autoAuth = false);
+
+        /** Set whether S2S messages and errors are logged, on every session. */
+        void setLogEnabled(bool enabled);
+
+        /**
+         * Authenticate every session. The callback is called once, after all
+         * of them answered, with the first failed result if any, otherwise
+         * with the result of the last session.
+         */
+        void authenticate(const S2SCallback& callback);
+
+        /** Same as authenticate, but waits for result. This call is blocking. */
+        std::string authenticateSync();
+
+        /** Send an S2S request on the least busy session. */
+        void request(const std::string& json, const S2SCallback& callback);
+
+        /**
+         * Send an S2S request on the session picked by affinityKey. Requests
+         * with the same key always go to the same session, in order.
+         */
+        void request(const std::string& json, const std::string& affinityKey,
+                     const S2SCallback& callback);
+
+        /** Send an S2S request, and wait for result. This call is blocking. */
+        std::string requestSync(const std::string& json);
+
+        /**
+         * Perform callbacks of every session on the calling thread: S2S
+         * responses, RTT events and upload completions, of requests sent
+         * through the pool or on getContext directly.
+         * @param timeoutMS Time to wait for a callback in milliseconds when
+         *                  none is pending. Pass 0 to return immediately.
+         */
+        void runCallbacks(uint64_t timeoutMS = 0);
+
+        size_t getSessionCount() const { return m_sessions.size(); }
+
+        /** Context of one session, to configure it or use its other services. */
+        S2SContextRef getContext(size_t index) const { return m_sessions[index]->context; }
+
+        /**
+         * Requests sent through the pool whose callback hasn't run yet, over
+         * all sessions. Responses waiting for runCallbacks still count: a
+         * session whose callbacks fall behind gets fewer new requests.
+         */
+        int getOutstandingCount() const;
+
+    private:
+        struct Session
+        {
+            S2SContextRef context;
+            std::atomic<int> outstanding{0};
+        };
+
+        S2SSessionPool() = default;
+
+        std::shared_ptr<Session> leastOutstanding();
+
+        void dispatch(const std::shared_ptr<Session>& session, const std::string& json,
+                      const S2SCallback& callback);
+
+        std::vector<std::shared_ptr<Session>> m_sessions;
+        std::atomic<size_t> m_nextSession{0};
+
+        // Notified by every session when a callback is queued, so
+        // runCallbacks can wait on all of them at once
+        std::shared_ptr<S2SCallbackSignal> m_signal = std::make_shared<S2SCallbackSignal>();
+        // Signal count when runCallbacks last ran the sessions' callbacks
+        uint64_t m_runCount = 0;
+    };
+};
@@ -31,7 +31,8 @@ namespace BrainCloud
      *       }
      *   }
      *
-     * Note: The BrainCloudS2SPRL object must remain alive until isComplete() returns true.
+     * The timeout is kept by the S2S context and reported from runCallbacks.
+     * Destroying the object before isComplete() returns true abandons the flow.
      */
     class BrainCloudS2SPRL : public IRTTConnectCallback, public IRTTCallback
     {
@@ -39,7 +40,7 @@ namespace BrainCloud
         using PRLCompleteCallback = std::function<void(bool proceedWithLaunch)>;
 
         BrainCloudS2SPRL() = default;
-        ~BrainCloudS2SPRL() = default;
+        ~BrainCloudS2SPRL();
 
         /** Returns true if the PRE_READY_LAUNCH env var is set to "true". */
         bool isPreReadyLaunch() const;
@@ -109,6 +110,7 @@ namespace BrainCloud
         PRLCompleteCallback _callback;
         PrlState _state = PrlState::Idle;
         std::atomic<bool> _complete{false};
+        uint64_t _timeoutId = 0;
 
         void complete(bool proceed);
         std::string buildChannelId() const;
@@ -4,9 +4,16 @@
 #define BRAINCLOUDS2S_H_INCLUDED
 
 #include <functional>
+#include <future>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <set>
 #include <string>
 #include "brainclouds2s-rtt.h"
+#include "S2SLogger.h"
+#include "S2SMetrics.h"
+#include "S2STrace.h"
 #include <IRTTConnectCallback.h>
 #include <iostream>
 #include <sstream>
@@ -15,6 +22,7 @@
 #include <TimeUtil.h>
 
 #include <regex>
+#include <type_traits>
 #include <vector>
 
 #if defined(_WIN32)
@@ -23,6 +31,10 @@
 #include <fstream>
 #endif
 
+namespace Json {
+    class Value;
+}
+
 namespace BrainCloud {
     static const std::string DEFAULT_S2S_URL =
             "https://api.braincloudservers.com/s2sdispatcher";
@@ -34,8 +46,18 @@ namespace BrainCloud {
     class BrainCloudS2SGlobalFileV3;
     class IRTTConnectCallback;
     using S2SCallback = std::function<void(const std::string &)>;
+    using S2SJsonCallback = std::function<void(const Json::Value &)>;
     using S2SContextRef = std::shared_ptr<S2SContext>;
 
+    class S2SCallbackSignal;
+    class S2SCancelToken;
+    using S2SCancelTokenRef = std::shared_ptr<S2SCancelToken>;
+
+    // reason_code of the status 900 result of a request that ran out of
+    // time or was cancelled
+    static const int S2S_REASON_REQUEST_TIMEOUT = 90001;
+    static const int S2S_REASON_REQUEST_CANCELLED = 90002;
+
     static const std::vector<std::string> sensitiveKeys = 
     {
             "secretKey", "serverSecret", "ApiKey", "secret", "token", "X-RTT-SECRET"
@@ -52,131 +74,173 @@ namespace BrainCloud {
 
     static std::string redactSecretKeys(const std::string& input) 
     {
-        std::string out = input;
-
-        for (auto& key : sensitiveKeys) {
-            size_t pos = 0;
-            std::string needle = "\"" + key + "\"";
-            while ((pos = out.find(needle, pos)) != std::string::npos) {
-                // find the colon after the key
-                size_t colon = out.find(':', pos + needle.size());
-                if (colon == std::string::npos) break;
-
-                // find the first quote after colon
-                size_t quoteStart = out.find('"', colon);
-                if (quoteStart == std::string::npos) break;
-
-                // find the closing quote
-                size_t quoteEnd = out.find('"', quoteStart + 1);
-                if (quoteEnd == std::string::npos) break;
-
-                // replace value
-                std::string value = out.substr(quoteStart + 1, quoteEnd - quoteStart - 1);
-                std::string replacement = obfuscateString(value);
-                out.replace(quoteStart + 1, value.size(), replacement);
-
-                pos = quoteEnd + 1;
-            }
+        std::string out;
+        out.reserve(input.size());
+        S2SLogger::appendRedacted(out, input.data(), input.size());
+        return out;
+    }
+
+    // Appends one argument of a log line. Only std::string arguments, the
+    // json going in and out, are redacted.
+    inline void appendLogArgument(std::string& out, const std::string& arg, bool redact)
+    {
+        if (redact)
+        {
+            S2SLogger::appendRedacted(out, arg.data(), arg.size());
+        }
+        else
+        {
+            out += arg;
         }
+    }
 
-        return out;
+    inline void appendLogArgument(std::string& out, const char* arg, bool)
+    {
+        out += arg ? arg : "(null)";
     }
 
-    template<typename ...Args>
-    std::string buildLogMessage(Args && ...args)
+    inline void appendLogArgument(std::string& out, char arg, bool)
     {
-        std::string timeStamp = TimeUtil::currentTimestamp();
-        std::ostringstream oss;
-        oss << "[" << timeStamp << "] ";
-        using expander = int[];
+        out += arg;
+    }
 
-        if (g_showSecretLogs) {
-            (void)expander {
-                0, (
-                    void( oss << std::forward<Args>(args)), 0) ...
-            };
+    template<typename T>
+    typename std::enable_if<std::is_integral<T>::value>::type
+    appendLogArgument(std::string& out, T arg, bool)
+    {
+        out += std::to_string(arg);
+    }
+
+    /*
+    * A payload argument of s2s_log, cut to its channel's maxPayloadBytes
+    */
+    struct S2SLogPayload {
+        S2SLogPayload(S2SLogChannel channel, const std::string& text)
+            : text(text)
+            , maxBytes(S2SLogger::getDefault().getMaxPayloadBytes(channel))
+        {
         }
-        else {
-            (void)expander {
-                0, (
-                    void(
-                        // For std::string arguments, redact secrets
-                        (std::is_same<typename std::decay<Args>::type, std::string>::value
-                            ? oss << redactSecretKeys(std::forward<Args>(args))
-                            : oss << args)
-                        ), 0)...
-            };
+
+        const std::string& text;
+        size_t maxBytes;
+    };
+
+    inline void appendLogArgument(std::string& out, const S2SLogPayload& payload, bool redact)
+    {
+        bool cut = payload.maxBytes > 0 && payload.text.size() > payload.maxBytes;
+        size_t size = cut ? payload.maxBytes : payload.text.size();
+        if (redact)
+        {
+            S2SLogger::appendRedacted(out, payload.text.data(), size);
+        }
+        else
+        {
+            out.append(payload.text.data(), size);
+        }
+        if (cut)
+        {
+            out += "... (" + std::to_string(payload.text.size()) + " bytes)";
         }
+    }
+
+    template<typename T>
+    typename std::enable_if<!std::is_integral<typename std::decay<T>::type>::value &&
+                            !std::is_convertible<T, const char*>::value &&
+                            !std::is_convertible<T, const std::string&>::value &&
+                            !std::is_same<typename std::decay<T>::type, S2SLogPayload>::value>::type
+    appendLogArgument(std::string& out, T&& arg, bool)
+    {
+        std::ostringstream oss;
+        oss << std::forward<T>(arg);
+        out += oss.str();
+    }
+
+    template<typename ...Args>
+    std::string buildLogMessage(Args && ...args)
+    {
+        std::string text;
+        text += '[';
+        S2SLogger::appendTimestamp(text);
+        text += "] ";
+
+        bool redact = !g_showSecretLogs;
+        using expander = int[];
+        (void)expander {
+            0, (
+                void(appendLogArgument(text, std::forward<Args>(args), redact)), 0) ...
+        };
         
-        return oss.str();
+        return text;
     }
 
+    /*
+    * Logs a line to the file set with logToFile, or to the console. The line
+    * is formatted on the calling thread and written by the logger's thread.
+    */
     template <typename... Args>
     void s2s_log(Args&&... args)
     {
-        std::string text = buildLogMessage(std::forward<Args>(args)...);
-
-        if (!g_logFilePath.empty()) {
-#if defined(_WIN32)
-            // Windows needs this implementation to be able to share the ability to write to this file with another program
-            HANDLE hFile = CreateFileA(
-                g_logFilePath.c_str(),
-                FILE_APPEND_DATA,
-                FILE_SHARE_WRITE | FILE_SHARE_READ,
-                NULL,
-                OPEN_ALWAYS,
-                FILE_ATTRIBUTE_NORMAL,
-                NULL
-            );
-
-            if (hFile == INVALID_HANDLE_VALUE) {
-                std::cerr << "Failed to open log file: " << g_logFilePath << std::endl;
-                return;
-            }
-
-            std::string line = text + "\r\n";
-            DWORD written;
-            BOOL ok = WriteFile(
-                hFile,
-                line.c_str(),
-                static_cast<DWORD>(line.size()),
-                &written,
-                NULL
-            );
-
-            CloseHandle(hFile);
-
-            if (!ok || written != line.size()) {
-                std::cerr << "Failed to write to log file: " << g_logFilePath << std::endl;
-                //print to console if failed to write log to file
-                std::cout << text << "\n";
-            }
-
-#else
-            // --- Linux / macOS implementation ---
-            std::ofstream out(g_logFilePath.c_str(), std::ios::app);
-            if (!out) {
-                std::cerr << "Failed to open log file: " << g_logFilePath << std::endl;
-                //print to console if failed to write log to file
-                std::cout << text << std::endl << std::flush;
-                return;
-            }
-            out << text << "\n";
-#endif
-        }
-        else {
-            //Print to console if no file output was set
-            std::cout << text << "\n";
-        }
+        S2SLogger::getDefault().write(buildLogMessage(std::forward<Args>(args)...));
     }
 
     
+    /*
+    * Whether a record of this level is logged on a channel, see
+    * S2SLogger::shouldLog. Formatting of the record belongs behind it.
+    */
+    inline bool s2s_should_log(S2SLogChannel channel, S2SLogLevel level)
+    {
+        return S2SLogger::getDefault().shouldLog(channel, level);
+    }
+
     /*
     * Set a log file path - if set then logs will be written to this file
     * @param path the file path for the log file
     */
     void logToFile(const std::string& path);
 
+    /*
+    * Set what s2s_log does when the log writer falls behind and its buffer
+    * is full. Block by default.
+    * @param policy the overflow policy
+    */
+    void setLogOverflowPolicy(S2SLogOverflow policy);
+
+    /*
+    * Set the level, sampling and payload size of a log channel, for every
+    * context. Contexts only log with setLogEnabled(true), except for
+    * GlobalFileV3, LWS and RTT disconnects.
+    * @param channel the channel to configure
+    * @param options its options
+    */
+    void setLogChannelOptions(S2SLogChannel channel, const S2SLogChannelOptions& options);
+
+    S2SLogChannelOptions getLogChannelOptions(S2SLogChannel channel);
+
+    /*
+    * Wait until every line logged so far has been written
+    */
+    void flushLogs();
+
+    /*
+    * Number of log lines dropped so far by S2SLogOverflow::Drop
+    */
+    uint64_t getDroppedLogCount();
+
+    /*
+    * Which I/O thread drives the HTTP requests and uploads of a context.
+    */
+    enum class S2SIOThreadMode {
+        SharedPerProcess,   // One I/O thread shared by every context (default)
+        PerContext          // Each context gets its own I/O thread
+    };
+
+    /*
+    * Set the I/O thread mode used by contexts created after this call
+    * @param mode the I/O thread mode
+    */
+    void setIOThreadMode(S2SIOThreadMode mode);
+
     inline void rtrim(std::string& s) {
         s.erase(
         std::find_if(s.rbegin(), s.rend(), [](unsigned char ch) {
@@ -194,6 +258,129 @@ namespace BrainCloud {
         g_showSecretLogs = enabled;
     }
 
+    /*
+    * HTTP connection counters for a context. A request that reuses a pooled
+    * keep-alive connection does not count as a new connection.
+    */
+    struct S2SConnectionStats {
+        uint64_t requests = 0;
+        uint64_t newConnections = 0;
+    };
+
+    /*
+    * Cancels every request it was passed to. A cancelled request is dropped
+    * from the queue, its transfer is stopped if no other request shares it,
+    * and its callback gets status 900 with S2S_REASON_REQUEST_CANCELLED.
+    * A token stays cancelled: requests passed to it later fail right away.
+    */
+    class S2SCancelToken {
+    public:
+        static S2SCancelTokenRef create();
+
+        /*
+         * Cancel the requests. Can be called from any thread. Callbacks still
+         * come from runCallbacks.
+         */
+        void cancel();
+
+        bool isCancelled() const;
+
+        /*
+         * Called once, on the thread calling cancel, or right away if the
+         * token is already cancelled. Used by the requests.
+         * @return Id to remove the listener with
+         */
+        uint64_t addListener(const std::function<void()> &listener);
+
+        void removeListener(uint64_t id);
+
+    private:
+        S2SCancelToken() {}
+
+        mutable std::mutex m_mutex;
+        bool m_cancelled = false;
+        uint64_t m_nextListenerId = 1;
+        std::map<uint64_t, std::function<void()>> m_listeners;
+    };
+
+    /*
+    * Per request options.
+    */
+    struct S2SRequestOptions {
+        // Time the request has to complete, from the call, time spent in the
+        // queue included. The callback then gets status 900 with
+        // S2S_REASON_REQUEST_TIMEOUT. 0 for no deadline.
+        uint64_t timeoutMS = 0;
+
+        // Optional, see S2SCancelToken
+        S2SCancelTokenRef cancelToken;
+
+        // The request is safe to run twice, so the retry policy can resend it
+        // even after it reached the server. See S2SRetryPolicy
+        bool idempotent = false;
+    };
+
+    /*
+    * Resends packets that failed at the transport level (connection refused
+    * or reset, timed out...) after an exponential backoff with jitter.
+    * Responses from the server, errors included, are never retried.
+    * A packet is only resent when the server can't end up running it twice:
+    * either none of it went out, or every message in it is idempotent. It is
+    * resent as is, with the same packetId.
+    */
+    struct S2SRetryPolicy {
+        // Resends after the first attempt. 0 turns retries off
+        int maxRetries = 0;
+
+        // Wait before the first resend, multiplied by backoffMultiplier for
+        // each one after it, up to maxBackoffMS
+        uint64_t initialBackoffMS = 100;
+        uint64_t maxBackoffMS = 5000;
+        double backoffMultiplier = 2.0;
+
+        // Up to this fraction of each wait, 0 to 1, is taken off at random so
+        // servers that failed together don't all retry together
+        double jitter = 0.5;
+
+        // Retry budget. Each resend spends a token and each packet answered
+        // by the server gives back budgetRatio of one, up to budgetMaxTokens.
+        // Once the budget is spent failures go straight to the callbacks, so
+        // an outage doesn't multiply the load on the server.
+        double budgetMaxTokens = 10;
+        double budgetRatio = 0.1;
+
+        // "service.operation" of the messages that are safe to run twice,
+        // e.g. "time.READ". Requests sent with S2SRequestOptions::idempotent
+        // count as well.
+        std::set<std::string> idempotentOperations;
+    };
+
+    struct S2SRetryStats {
+        // Packets resent
+        uint64_t retries = 0;
+        // Transport failures handed to the callbacks with retries on: not
+        // safe to resend, out of retries or out of budget
+        uint64_t giveUps = 0;
+        // Those of giveUps that the retry budget stopped
+        uint64_t budgetExhausted = 0;
+    };
+
+    /*
+    * Limits how much one runCallbacks call does, e.g. to stay within a
+    * server tick. What's left is called by the next calls, in order. S2S
+    * responses, RTT events and upload completions take turns one callback
+    * at a time, so a burst of one doesn't hold back the others.
+    */
+    struct S2SCallbackBudget {
+        // Callbacks to call at most, 0 for no limit
+        size_t maxCallbacks = 0;
+
+        // Time to spend calling them, in microseconds, 0 for no limit. It's
+        // checked between callbacks: a slow callback isn't cut short, and
+        // the first one is always called.
+        uint64_t maxMicroseconds = 0;
+    };
+
     class S2SContext {
     public:
         /*
@@ -232,10 +419,25 @@ namespace BrainCloud {
          * Authenticate with brainCloud. If autoAuth is set to false, which is
          * the default, this must be called successfully before doing other
          * requests. See S2SContext::create
+         *
+         * Once authenticated, the context keeps the session: it sends a
+         * heartbeat from its I/O thread when no other response came back for
+         * a whole heartbeat interval. When the session expires anyway, or
+         * after two intervals without hearing from the server, it
+         * authenticates again once and sends the requests that didn't go
+         * through again, in order.
          * @param callback Callback function
          */
         virtual void authenticate(const S2SCallback &callback) = 0;
 
+        /*
+         * Same as authenticate, but the result is delivered through the
+         * returned future instead of a callback. The future is ready as soon
+         * as the response arrives, without calling runCallbacks.
+         * @return Future authenticate result
+         */
+        virtual std::future<std::string> authenticateAsync() = 0;
+
         /*
          * Same as authenticate, but waits for result. This call is blocking.
          * @return Authenticate result
@@ -247,6 +449,15 @@ namespace BrainCloud {
          */
         virtual void enableRTT(IRTTConnectCallback* callback) = 0;
 
+        /*
+         * Same as enableRTT, with a callback the context keeps alive until
+         * RTT is enabled again or the context is destroyed: connection
+         * failures are reported to it after the connect too.
+         * @return false if RTT was already enabled or connecting, the call
+         *         is then ignored and callback never called
+         */
+        virtual bool enableRTT(const std::shared_ptr<IRTTConnectCallback> &callback) = 0;
+
         /*
          * Send an S2S request.
          * @param json Content to be sent
@@ -256,6 +467,53 @@ namespace BrainCloud {
                 const std::string &json,
                 const S2SCallback &callback) = 0;
 
+        /*
+         * Send an S2S request. The result is delivered through the returned
+         * future instead of a callback. The future is ready as soon as the
+         * response arrives, without calling runCallbacks, and can be waited
+         * on from any thread. If the request is dropped by a disconnect, the
+         * future holds a std::future_error (broken_promise).
+         * @param json Content to be sent
+         * @return Future request result
+         */
+        virtual std::future<std::string> requestAsync(const std::string &json) = 0;
+
+        /*
+         * Send an S2S request given as json. Same as request, without the
+         * string parsing and serializing on both ends: the message is
+         * serialized once into the packet and the response is handed over as
+         * the parsed message. Move the json in to avoid copying it.
+         * @param json Message to be sent
+         * @param callback Callback function, with the response message
+         */
+        virtual void requestJson(Json::Value json, const S2SJsonCallback &callback) = 0;
+
+        /*
+         * Send an S2S request without parsing it. The json is put in the
+         * packet byte for byte and the response message is handed back as
+         * the server wrote it, so neither side goes through a json DOM.
+         * The json is not validated: invalid json fails every request sent
+         * in the same packet. Use it for trusted, pre-built requests.
+         * Unlike request, error responses from the server are passed
+         * through as is instead of being reported as "Malformed json".
+         * @param json Content to be sent, a single json object
+         * @param callback Callback function, with the response message
+         */
+        virtual void requestRaw(const std::string &json, const S2SCallback &callback) = 0;
+
+        /*
+         * Send an S2S request with a deadline or a cancel token. The callback
+         * is called exactly once: with the response, or with status 900 and
+         * the reason_code S2S_REASON_REQUEST_TIMEOUT or
+         * S2S_REASON_REQUEST_CANCELLED.
+         * @param json Content to be sent
+         * @param options Deadline and cancel token
+         * @param callback Callback function
+         */
+        virtual void request(const std::string &json,
+                             const S2SRequestOptions &options,
+                             const S2SCallback &callback) = 0;
+
         /*
          * Send an S2S request, and wait for result. This call is blocking.
          * @param json Content to be sent
@@ -263,6 +521,54 @@ namespace BrainCloud {
          */
         virtual std::string requestSync(const std::string &json) = 0;
 
+        /*
+         * Same as above, with a deadline or a cancel token instead of the
+         * default 60 seconds timeout. This call is blocking.
+         * @param json Content to be sent
+         * @param options Deadline and cancel token. Without a deadline, waits
+         *                until the request completes or is cancelled.
+         * @return Request result
+         */
+        virtual std::string requestSync(const std::string &json,
+                                        const S2SRequestOptions &options) = 0;
+
+        /*
+         * Coalesce requests that queue up while a packet is in flight into
+         * the next packet. Each request still gets its own callback with its
+         * own response. Disabled by default (one message per packet).
+         * @param maxMessages Maximum messages per packet. 1 disables batching
+         * @param maxBytes Maximum size in bytes of the request json sent in
+         *                 one packet. 0 means no size limit. A request bigger
+         *                 than this is still sent, alone. Requests sent with
+         *                 requestJson don't count toward it.
+         */
+        virtual void setBatching(size_t maxMessages, size_t maxBytes = 0) = 0;
+
+        /*
+         * How many packets can wait for their response at the same time.
+         * With more than 1, a slow request no longer holds back the packets
+         * queued behind it; callbacks fire in the order responses arrive.
+         * Packets only overlap once authenticated. If the server refuses a
+         * packet sent while others were in flight, the context goes back to
+         * one packet at a time and resends it. Default 1.
+         * @param maxPackets Maximum packets in flight
+         */
+        virtual void setMaxPacketsInFlight(size_t maxPackets) = 0;
+
+        /*
+         * Resend packets that failed at the transport level. Off by default.
+         * @param policy See S2SRetryPolicy. Resets the retry budget
+         */
+        virtual void setRetryPolicy(const S2SRetryPolicy &policy) = 0;
+
+        /*
+         * Record the timeline of each request: queue wait, DNS, connect,
+         * TLS, server time, download and callback wait. Off by default.
+         * Applies to requests queued from now on.
+         * @param options See S2STraceOptions
+         */
+        virtual void setTracing(const S2STraceOptions &options) = 0;
+
         /*
          * Update requests and perform callbacks on the calling thread.
          * @param timeoutMS Time to block on the call in milliseconds.
@@ -270,10 +576,69 @@ namespace BrainCloud {
          */
         virtual void runCallbacks(uint64_t timeoutMS = 0) = 0;
 
+        /*
+         * Same as above, stopping once the budget is spent. Nothing pending
+         * costs no lock.
+         * @param budget See S2SCallbackBudget
+         * @param timeoutMS Time to block on the call in milliseconds when
+         *                  nothing is pending. Pass 0 to return immediately.
+         * @return Callbacks left for the next calls
+         */
+        virtual size_t runCallbacks(const S2SCallbackBudget &budget, uint64_t timeoutMS = 0) = 0;
+
+        /*
+         * Notify a signal whenever something is queued for runCallbacks: S2S
+         * responses, RTT events and upload completions. Lets one thread
+         * wait on several contexts at once.
+         * @param signal See S2SCallbackSignal, nullptr to stop
+         */
+        virtual void setCallbackSignal(const std::shared_ptr<S2SCallbackSignal> &signal) = 0;
+
+        /*
+         * Call a function from runCallbacks once a delay has passed. The
+         * delay is kept by the I/O thread, without a thread of its own.
+         * @param delayMS Delay in milliseconds
+         * @param callback Function to call
+         * @return Id to cancel the call with. Never 0
+         */
+        virtual uint64_t scheduleCallback(uint64_t delayMS, const std::function<void()> &callback) = 0;
+
+        /*
+         * Drop a call of scheduleCallback that wasn't made yet. Once this
+         * returns, the function won't be called from runCallbacks.
+         * @param id Id returned by scheduleCallback
+         * @return False if the function was already called, or cancelled
+         */
+        virtual bool cancelScheduledCallback(uint64_t id) = 0;
+
         virtual BrainCloudRTT* getRTTService() {return nullptr;}
 
         virtual BrainCloudS2SGlobalFileV3* getGlobalFileV3() {return nullptr;}
 
+        /*
+         * HTTP requests sent so far and how many of them had to open a new
+         * connection (TCP connect + TLS handshake) to the dispatcher.
+         */
+        virtual S2SConnectionStats getConnectionStats() const {return S2SConnectionStats();}
+
+        /*
+         * Packets resent by the retry policy, and failures it gave up on.
+         */
+        virtual S2SRetryStats getRetryStats() const {return S2SRetryStats();}
+
+        /*
+         * Latency by operation, queue depths, traffic, authentications and
+         * heartbeats since the context was created. Cheap enough to leave
+         * on; see formatPrometheus to export it.
+         */
+        virtual S2SStats getStats() const {return S2SStats();}
+
+        /*
+         * Traces of the last requests that finished while tracing was on,
+         * oldest first. See formatChromeTrace to look at them.
+         */
+        virtual std::vector<S2SRequestTrace> getTraces() const {return std::vector<S2SRequestTrace>();}
+
         const std::string& getAppId() const {return m_appId;}
         const std::string& getServerName() const {return m_serverName;}
         const std::string& getServerSecret() const {return m_serverSecret;}
@@ -0,0 +1,894 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+//
+// Load generator: drives many S2S contexts at a fixed request rate against
+// a dispatcher, or against an in-process mock server, and reports the
+// throughput, latency percentiles and process cost it took.
+//
+// Usage: bcs2s_loadgen [--url <dispatcher url> | --mock] [--ids <path>]
+//                      [--app-id <id>] [--server-name <name>] [--server-secret <secret>]
+//                      [--contexts <n>] [--pool] [--threads <n>]
+//                      [--rate <per second>] [--duration <s>] [--warmup <s>]
+//                      [--request <json>] [--mix request=<w>,raw=<w>,upload=<w>]
+//                      [--upload-size <bytes>] [--upload-tree <treeId>]
+//                      [--rtt ws|tcp] [--batch <n>] [--max-packets-in-flight <n>]
+//                      [--max-outstanding <n>] [--drain-timeout <s>]
+//                      [--mock-latency-ms <ms>] [--mock-error-rate <0-1>]
+//                      [--mock-rtt-events-per-second <n>]
+//                      [--report-interval <s>] [--json <path or ->]
+//
+// The load is open loop: requests are issued on a fixed schedule whether or
+// not earlier ones were answered, and each latency is measured from the
+// time its request was due, not when the loaded client got around to it.
+// A run that can't keep up shows it in its latencies and "behind" time
+// instead of quietly lowering the rate.
+//
+// The contexts are split over the threads, each sending its share of the
+// rate and running its contexts' callbacks. With --pool each thread's
+// contexts are the sessions of one S2SSessionPool instead.
+
+#include <brainclouds2s.h>
+#include <brainclouds2s-globalfilev3.h>
+#include <brainclouds2s-pool.h>
+#include <brainclouds2s-rtt.h>
+#include <IRTTCallback.h>
+#include <IRTTConnectCallback.h>
+#include <S2SJsonScanner.h>
+#include <S2SMetrics.h>
+#include "S2SMockServer.h"
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+using namespace BrainCloud;
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    enum Operation
+    {
+        OPERATION_REQUEST,
+        OPERATION_RAW,
+        OPERATION_UPLOAD,
+        OPERATION_COUNT
+    };
+
+    const char* OPERATION_NAMES[OPERATION_COUNT] = {"request", "raw", "upload"};
+
+    struct Options
+    {
+        std::string url;
+        bool mock = false;
+        std::string appId;
+        std::string serverName;
+        std::string serverSecret;
+
+        int contexts = 1;
+        bool pool = false;
+        int threads = 1;
+
+        double rate = 100;
+        double durationSeconds = 10;
+        double warmupSeconds = 1;
+
+        std::string request = "{\"service\":\"time\",\"operation\":\"READ\",\"data\":{}}";
+        double weights[OPERATION_COUNT] = {1, 0, 0};
+        size_t uploadSize = 64 * 1024;
+        std::string uploadTree;
+
+        std::string rtt;
+        size_t batch = 0;
+        size_t maxPacketsInFlight = 0;
+        uint64_t maxOutstanding = 100000;
+        double drainTimeoutSeconds = 5;
+
+        uint64_t mockLatencyMS = 0;
+        double mockErrorRate = 0;
+        double mockRttEventsPerSecond = 0;
+
+        double reportIntervalSeconds = 1;
+        std::string jsonPath;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Process cost
+    ///////////////////////////////////////////////////////////////////////////
+
+    struct ProcessSample
+    {
+        double cpuSeconds = 0;
+        uint64_t rssBytes = 0;
+        uint64_t peakRssBytes = 0;
+        int threads = -1;
+    };
+
+    ProcessSample sampleProcess()
+    {
+        ProcessSample sample;
+#if defined(_WIN32)
+        FILETIME creation, exit, kernel, user;
+        if (GetProcessTimes(GetCurrentProcess(), &creation, &exit, &kernel, &user))
+        {
+            auto seconds = [](const FILETIME& time)
+            {
+                return (double)(((uint64_t)time.dwHighDateTime << 32) | time.dwLowDateTime) / 1e7;
+            };
+            sample.cpuSeconds = seconds(kernel) + seconds(user);
+        }
+        PROCESS_MEMORY_COUNTERS memory;
+        if (GetProcessMemoryInfo(GetCurrentProcess(), &memory, sizeof(memory)))
+        {
+            sample.rssBytes = memory.WorkingSetSize;
+            sample.peakRssBytes = memory.PeakWorkingSetSize;
+        }
+#else
+        rusage usage;
+        if (getrusage(RUSAGE_SELF, &usage) == 0)
+        {
+            sample.cpuSeconds = (double)usage.ru_utime.tv_sec + (double)usage.ru_utime.tv_usec / 1e6 +
+                                (double)usage.ru_stime.tv_sec + (double)usage.ru_stime.tv_usec / 1e6;
+#if defined(__APPLE__)
+            sample.peakRssBytes = (uint64_t)usage.ru_maxrss;
+#else
+            sample.peakRssBytes = (uint64_t)usage.ru_maxrss * 1024;
+#endif
+        }
+
+        // Current RSS and thread count, where /proc has them
+        std::ifstream status("/proc/self/status");
+        std::string line;
+        while (std::getline(status, line))
+        {
+            if (line.compare(0, 6, "VmRSS:") == 0) sample.rssBytes = strtoull(line.c_str() + 6, NULL, 10) * 1024;
+            else if (line.compare(0, 8, "Threads:") == 0) sample.threads = atoi(line.c_str() + 8);
+        }
+        if (sample.rssBytes == 0) sample.rssBytes = sample.peakRssBytes;
+#endif
+        return sample;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Results
+    ///////////////////////////////////////////////////////////////////////////
+
+    // Shared by the threads, behind one mutex: recording is a few
+    // increments, next to a request's cost it doesn't show.
+    struct Results
+    {
+        std::mutex mutex;
+        S2SLatencyHistogram latency[OPERATION_COUNT];
+        S2SLatencyHistogram intervalLatency;
+        uint64_t completed[OPERATION_COUNT] = {};
+        uint64_t errors[OPERATION_COUNT] = {};
+    };
+
+    // Per thread, read by the reporter without a lock
+    struct Counters
+    {
+        std::atomic<uint64_t> sent{0};
+        std::atomic<uint64_t> completed{0};
+        std::atomic<uint64_t> completedInWindow{0};
+        std::atomic<uint64_t> errors{0};
+        std::atomic<uint64_t> skipped{0};
+        std::atomic<uint64_t> rttEvents{0};
+        std::atomic<int64_t> outstanding{0};
+        std::atomic<int64_t> maxBehindUS{0};
+    };
+
+    bool isSuccess(const std::string& result)
+    {
+        S2SJsonScanner scanner("");
+        scanner.feed(result);
+        S2SJsonScanner::Range range;
+        return scanner.getMember(result, "status", range) &&
+               result.compare(range.first, range.second - range.first, "200") == 0;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Load
+    ///////////////////////////////////////////////////////////////////////////
+
+    class RttConnectCallback final : public IRTTConnectCallback
+    {
+    public:
+        std::atomic<bool> processed{false};
+        std::atomic<bool> connected{false};
+        void rttConnectSuccess() override { connected = true; processed = true; }
+        void rttConnectFailure(const std::string& errorMessage) override
+        {
+            fprintf(stderr, "RTT connect failed: %s\n", errorMessage.c_str());
+            processed = true;
+        }
+    };
+
+    class RttEventCounter final : public IRTTCallback
+    {
+    public:
+        explicit RttEventCounter(std::atomic<uint64_t>& count) : m_count(count) {}
+        void rttCallback(const std::string&) override { m_count++; }
+
+    private:
+        std::atomic<uint64_t>& m_count;
+    };
+
+    // One thread's share of the contexts and of the rate
+    class Worker
+    {
+    public:
+        Worker(const Options& options, int index, Results& results)
+            : m_options(options)
+            , m_index(index)
+            , m_results(results)
+            , m_random((uint32_t)index + 1)
+            , m_rttCounter(m_counters.rttEvents)
+        {
+        }
+
+        Counters& getCounters() { return m_counters; }
+
+        std::vector<S2SContextRef>& getContexts() { return m_contexts; }
+
+        bool setUp(int contextCount)
+        {
+            if (m_options.pool)
+            {
+                m_pool = S2SSessionPool::create(m_options.appId, m_options.serverName, m_options.serverSecret,
+                                                m_options.url, (size_t)contextCount);
+                if (!m_pool) return false;
+                for (size_t i = 0; i < m_pool->getSessionCount(); ++i) m_contexts.push_back(m_pool->getContext(i));
+            }
+            else
+            {
+                for (int i = 0; i < contextCount; ++i)
+                {
+                    auto context = S2SContext::create(m_options.appId, m_options.serverName,
+                                                      m_options.serverSecret, m_options.url, false);
+                    if (!context) return false;
+                    m_contexts.push_back(context);
+                }
+            }
+
+            for (auto& context : m_contexts)
+            {
+                if (m_options.batch > 0) context->setBatching(m_options.batch);
+                if (m_options.maxPacketsInFlight > 0) context->setMaxPacketsInFlight(m_options.maxPacketsInFlight);
+            }
+
+            // Every session authenticates at once
+            std::atomic<int> authenticated(0);
+            std::atomic<int> failed(0);
+            for (auto& context : m_contexts)
+            {
+                context->authenticate([&authenticated, &failed](const std::string& result)
+                {
+                    if (isSuccess(result)) authenticated++;
+                    else
+                    {
+                        fprintf(stderr, "Authentication failed: %s\n", result.c_str());
+                        failed++;
+                    }
+                });
+            }
+            auto deadline = Clock::now() + std::chrono::seconds(30);
+            while (authenticated + failed < (int)m_contexts.size() && Clock::now() < deadline)
+            {
+                runCallbacks(1);
+            }
+            if (authenticated < (int)m_contexts.size()) return false;
+
+            if (!m_options.rtt.empty())
+            {
+                m_rttCallbacks.resize(m_contexts.size());
+                for (size_t i = 0; i < m_contexts.size(); ++i)
+                {
+                    m_rttCallbacks[i].reset(new RttConnectCallback());
+                    BrainCloudRTT* rttService = m_contexts[i]->getRTTService();
+                    rttService->registerRTTCallback(ServiceName::Chat, &m_rttCounter);
+                    rttService->enableRTT(m_rttCallbacks[i].get(), m_options.rtt == "ws");
+                }
+                deadline = Clock::now() + std::chrono::seconds(30);
+                while (Clock::now() < deadline &&
+                       std::any_of(m_rttCallbacks.begin(), m_rttCallbacks.end(),
+                                   [](const std::unique_ptr<RttConnectCallback>& callback) { return !callback->processed; }))
+                {
+                    runCallbacks(1);
+                }
+                for (auto& callback : m_rttCallbacks)
+                {
+                    if (!callback->connected) return false;
+                }
+            }
+
+            if (m_options.weights[OPERATION_UPLOAD] > 0)
+            {
+                m_uploadData.resize(m_options.uploadSize);
+                for (size_t i = 0; i < m_uploadData.size(); ++i) m_uploadData[i] = (uint8_t)m_random();
+            }
+            return true;
+        }
+
+        // Sends on schedule from start until end, then waits for the
+        // stragglers until drainEnd
+        void run(Clock::time_point start, Clock::time_point warmupEnd, Clock::time_point end,
+                 Clock::time_point drainEnd)
+        {
+            m_warmupEnd = warmupEnd;
+            m_end = end;
+
+            auto interval = std::chrono::duration_cast<Clock::duration>(
+                std::chrono::duration<double>((double)m_options.threads / m_options.rate));
+            // Threads take turns, evenly spread over each interval
+            auto next = start + interval * m_index / m_options.threads;
+
+            double totalWeight = 0;
+            for (double weight : m_options.weights) totalWeight += weight;
+            std::uniform_real_distribution<double> pick(0.0, totalWeight);
+
+            while (true)
+            {
+                auto now = Clock::now();
+                if (now >= end) break;
+
+                while (next <= now && next < end)
+                {
+                    auto behindUS = std::chrono::duration_cast<std::chrono::microseconds>(now - next).count();
+                    if (behindUS > m_counters.maxBehindUS) m_counters.maxBehindUS = behindUS;
+
+                    if (m_counters.outstanding >= (int64_t)m_options.maxOutstanding)
+                    {
+                        m_counters.skipped++;
+                    }
+                    else
+                    {
+                        double roll = pick(m_random);
+                        int operation = 0;
+                        while (operation < OPERATION_COUNT - 1 && roll >= m_options.weights[operation])
+                        {
+                            roll -= m_options.weights[operation];
+                            operation++;
+                        }
+                        send((Operation)operation, next);
+                    }
+                    next += interval;
+                }
+
+                auto waitUS = std::chrono::duration_cast<std::chrono::microseconds>(std::min(next, end) - now).count();
+                if (m_pool && waitUS >= 1000)
+                {
+                    // Wakes up as soon as a callback is queued
+                    m_pool->runCallbacks((uint64_t)waitUS / 1000);
+                }
+                else if (m_contexts.size() == 1 && waitUS >= 1000)
+                {
+                    m_contexts[0]->runCallbacks((uint64_t)waitUS / 1000);
+                }
+                else
+                {
+                    runCallbacks(0);
+                    if (waitUS > 0) std::this_thread::sleep_for(std::chrono::microseconds(std::min<int64_t>(waitUS, 100)));
+                }
+            }
+
+            while (m_counters.outstanding > 0 && Clock::now() < drainEnd)
+            {
+                runCallbacks(1);
+            }
+        }
+
+        void tearDown()
+        {
+            for (auto& context : m_contexts)
+            {
+                if (!m_options.rtt.empty()) context->getRTTService()->disableRTT();
+            }
+        }
+
+    private:
+        void runCallbacks(uint64_t timeoutMS)
+        {
+            if (m_pool)
+            {
+                m_pool->runCallbacks(timeoutMS);
+                return;
+            }
+            for (auto& context : m_contexts) context->runCallbacks(0);
+            if (timeoutMS > 0) std::this_thread::sleep_for(std::chrono::microseconds(100));
+        }
+
+        S2SContextRef nextContext()
+        {
+            auto& context = m_contexts[m_nextContext];
+            m_nextContext = (m_nextContext + 1) % m_contexts.size();
+            return context;
+        }
+
+        void send(Operation operation, Clock::time_point due)
+        {
+            m_counters.sent++;
+            m_counters.outstanding++;
+            auto callback = [this, operation, due](const std::string& result)
+            {
+                complete(operation, due, isSuccess(result));
+            };
+
+            switch (operation)
+            {
+                case OPERATION_REQUEST:
+                    if (m_pool) m_pool->request(m_options.request, callback);
+                    else nextContext()->request(m_options.request, callback);
+                    break;
+                case OPERATION_RAW:
+                    nextContext()->requestRaw(m_options.request, callback);
+                    break;
+                case OPERATION_UPLOAD:
+                    nextContext()->getGlobalFileV3()->uploadGlobalFile(
+                        m_options.uploadTree, "loadgen-" + std::to_string(m_index) + "-" +
+                        std::to_string(m_uploadCount++) + ".bin", true, m_uploadData, callback);
+                    break;
+                default:
+                    break;
+            }
+        }
+
+        void complete(Operation operation, Clock::time_point due, bool success)
+        {
+            auto now = Clock::now();
+            m_counters.outstanding--;
+            m_counters.completed++;
+            if (!success) m_counters.errors++;
+
+            if (now >= m_warmupEnd && now <= m_end) m_counters.completedInWindow++;
+
+            uint64_t latencyUS = (uint64_t)std::chrono::duration_cast<std::chrono::microseconds>(now - due).count();
+            std::unique_lock<std::mutex> lock(m_results.mutex);
+            m_results.intervalLatency.record(latencyUS);
+
+            // Latencies of requests sent during warmup only show in progress
+            if (due < m_warmupEnd) return;
+            m_results.latency[operation].record(latencyUS);
+            m_results.completed[operation]++;
+            if (!success) m_results.errors[operation]++;
+        }
+
+        const Options& m_options;
+        int m_index;
+        Results& m_results;
+        Counters m_counters;
+        std::mt19937 m_random;
+
+        S2SSessionPoolRef m_pool;
+        std::vector<S2SContextRef> m_contexts;
+        size_t m_nextContext = 0;
+
+        RttEventCounter m_rttCounter;
+        std::vector<std::unique_ptr<RttConnectCallback>> m_rttCallbacks;
+
+        std::vector<uint8_t> m_uploadData;
+        uint64_t m_uploadCount = 0;
+
+        Clock::time_point m_warmupEnd;
+        Clock::time_point m_end;
+    };
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Options
+    ///////////////////////////////////////////////////////////////////////////
+
+    // ids.txt, as the tests read it
+    bool loadIds(const std::string& path, Options& options)
+    {
+        std::ifstream file(path);
+        if (!file) return false;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (!line.empty() && line.back() == '\r') line.pop_back();
+            size_t equal = line.find('=');
+            if (equal == std::string::npos) continue;
+            std::string key = line.substr(0, equal);
+            std::string value = line.substr(equal + 1);
+            if (key == "appId") options.appId = value;
+            else if (key == "serverName") options.serverName = value;
+            else if (key == "serverSecret") options.serverSecret = value;
+            else if (key == "s2sUrl") options.url = value;
+        }
+        return true;
+    }
+
+    // "request=90,upload=10"
+    bool parseMix(const std::string& mix, Options& options)
+    {
+        for (double& weight : options.weights) weight = 0;
+        std::stringstream stream(mix);
+        std::string entry;
+        while (std::getline(stream, entry, ','))
+        {
+            size_t equal = entry.find('=');
+            if (equal == std::string::npos) return false;
+            std::string name = entry.substr(0, equal);
+            auto it = std::find_if(std::begin(OPERATION_NAMES), std::end(OPERATION_NAMES),
+                                   [&name](const char* operation) { return name == operation; });
+            if (it == std::end(OPERATION_NAMES)) return false;
+            options.weights[it - std::begin(OPERATION_NAMES)] = std::max(0.0, atof(entry.c_str() + equal + 1));
+        }
+        double total = 0;
+        for (double weight : options.weights) total += weight;
+        return total > 0;
+    }
+
+    void usage()
+    {
+        fprintf(stderr,
+                "Usage: bcs2s_loadgen [--url <dispatcher url> | --mock] [--ids <path>]\n"
+                "                     [--app-id <id>] [--server-name <name>] [--server-secret <secret>]\n"
+                "                     [--contexts <n>] [--pool] [--threads <n>]\n"
+                "                     [--rate <per second>] [--duration <s>] [--warmup <s>]\n"
+                "                     [--request <json>] [--mix request=<w>,raw=<w>,upload=<w>]\n"
+                "                     [--upload-size <bytes>] [--upload-tree <treeId>]\n"
+                "                     [--rtt ws|tcp] [--batch <n>] [--max-packets-in-flight <n>]\n"
+                "                     [--max-outstanding <n>] [--drain-timeout <s>]\n"
+                "                     [--mock-latency-ms <ms>] [--mock-error-rate <0-1>]\n"
+                "                     [--mock-rtt-events-per-second <n>]\n"
+                "                     [--report-interval <s>] [--json <path or ->]\n");
+    }
+
+    bool parseOptions(int argc, char** argv, Options& options)
+    {
+        for (int i = 1; i < argc; ++i)
+        {
+            std::string arg = argv[i];
+            if (arg == "--mock") { options.mock = true; continue; }
+            if (arg == "--pool") { options.pool = true; continue; }
+
+            if (i + 1 >= argc) return false;
+            const char* value = argv[++i];
+            if (arg == "--url") options.url = value;
+            else if (arg == "--ids") { if (!loadIds(value, options)) { fprintf(stderr, "Failed to read %s\n", value); return false; } }
+            else if (arg == "--app-id") options.appId = value;
+            else if (arg == "--server-name") options.serverName = value;
+            else if (arg == "--server-secret") options.serverSecret = value;
+            else if (arg == "--contexts") options.contexts = std::max(1, atoi(value));
+            else if (arg == "--threads") options.threads = std::max(1, atoi(value));
+            else if (arg == "--rate") options.rate = atof(value);
+            else if (arg == "--duration") options.durationSeconds = atof(value);
+            else if (arg == "--warmup") options.warmupSeconds = std::max(0.0, atof(value));
+            else if (arg == "--request") options.request = value;
+            else if (arg == "--mix") { if (!parseMix(value, options)) return false; }
+            else if (arg == "--upload-size") options.uploadSize = (size_t)strtoull(value, NULL, 10);
+            else if (arg == "--upload-tree") options.uploadTree = value;
+            else if (arg == "--rtt") options.rtt = value;
+            else if (arg == "--batch") options.batch = (size_t)strtoull(value, NULL, 10);
+            else if (arg == "--max-packets-in-flight") options.maxPacketsInFlight = (size_t)strtoull(value, NULL, 10);
+            else if (arg == "--max-outstanding") options.maxOutstanding = strtoull(value, NULL, 10);
+            else if (arg == "--drain-timeout") options.drainTimeoutSeconds = std::max(0.0, atof(value));
+            else if (arg == "--mock-latency-ms") options.mockLatencyMS = strtoull(value, NULL, 10);
+            else if (arg == "--mock-error-rate") options.mockErrorRate = atof(value);
+            else if (arg == "--mock-rtt-events-per-second") options.mockRttEventsPerSecond = atof(value);
+            else if (arg == "--report-interval") options.reportIntervalSeconds = std::max(0.1, atof(value));
+            else if (arg == "--json") options.jsonPath = value;
+            else return false;
+        }
+
+        if (options.rate <= 0 || options.durationSeconds <= 0) return false;
+        if (!options.rtt.empty() && options.rtt != "ws" && options.rtt != "tcp") return false;
+        if (options.pool && (options.weights[OPERATION_RAW] > 0 || options.weights[OPERATION_UPLOAD] > 0))
+        {
+            fprintf(stderr, "--pool only sends requests\n");
+            return false;
+        }
+        options.threads = std::min(options.threads, options.contexts);
+        return true;
+    }
+
+    ///////////////////////////////////////////////////////////////////////////
+    // Report
+    ///////////////////////////////////////////////////////////////////////////
+
+    const double PERCENTILES[] = {50, 90, 99, 99.9};
+
+    std::string formatMS(uint64_t us)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.2f", (double)us / 1000.0);
+        return buffer;
+    }
+
+    Json::Value latencyToJson(const S2SLatencyHistogram& histogram)
+    {
+        Json::Value json(Json::objectValue);
+        json["count"] = (Json::UInt64)histogram.getCount();
+        json["meanMS"] = histogram.getMean() / 1000.0;
+        json["minMS"] = (double)histogram.getMin() / 1000.0;
+        json["maxMS"] = (double)histogram.getMax() / 1000.0;
+        for (double percentile : PERCENTILES)
+        {
+            char name[16];
+            snprintf(name, sizeof(name), "p%gMS", percentile);
+            json[name] = (double)histogram.getValueAtPercentile(percentile) / 1000.0;
+        }
+        return json;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseOptions(argc, argv, options))
+    {
+        usage();
+        return 1;
+    }
+
+    std::unique_ptr<S2SMockServer> mock;
+    if (options.mock)
+    {
+        S2SMockServer::Config config;
+        config.latencyMS = options.mockLatencyMS;
+        config.errorRate = options.mockErrorRate;
+        config.rttEventsPerSecond = options.mockRttEventsPerSecond;
+        mock.reset(new S2SMockServer(config));
+        if (!mock->start())
+        {
+            fprintf(stderr, "Failed to start the mock server\n");
+            return 1;
+        }
+        options.url = mock->getDispatcherUrl();
+        options.appId = config.appId;
+        options.serverName = config.serverName;
+        options.serverSecret = config.serverSecret;
+        if (options.request.find("\"time\"") != std::string::npos)
+        {
+            options.request = "{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{}}";
+        }
+    }
+    if (options.url.empty() || options.appId.empty() || options.serverName.empty())
+    {
+        fprintf(stderr, "No dispatcher: pass --url and the app's credentials, --ids or --mock\n");
+        return 1;
+    }
+
+    // Set up every worker's contexts before any load starts
+    Results results;
+    std::vector<std::unique_ptr<Worker>> workers;
+    for (int i = 0; i < options.threads; ++i)
+    {
+        int contextCount = options.contexts / options.threads + (i < options.contexts % options.threads ? 1 : 0);
+        workers.emplace_back(new Worker(options, i, results));
+        if (!workers.back()->setUp(contextCount))
+        {
+            fprintf(stderr, "Failed to set up the contexts\n");
+            return 1;
+        }
+    }
+    fprintf(stderr, "%d contexts%s on %d threads, %.0f/s for %gs after %gs of warmup, against %s\n",
+            options.contexts, options.pool ? " (pooled)" : "", options.threads, options.rate,
+            options.durationSeconds, options.warmupSeconds, options.url.c_str());
+
+    auto start = Clock::now() + std::chrono::milliseconds(100);
+    auto warmupEnd = start + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.warmupSeconds));
+    auto end = warmupEnd + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.durationSeconds));
+    auto drainEnd = end + std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.drainTimeoutSeconds));
+
+    std::vector<std::thread> threads;
+    for (auto& worker : workers)
+    {
+        Worker* pWorker = worker.get();
+        threads.emplace_back([pWorker, start, warmupEnd, end, drainEnd]() { pWorker->run(start, warmupEnd, end, drainEnd); });
+    }
+
+    // Progress, and the process's cost over the measured window
+    auto sumCounters = [&workers](std::atomic<uint64_t> Counters::*counter)
+    {
+        uint64_t sum = 0;
+        for (auto& worker : workers) sum += worker->getCounters().*counter;
+        return sum;
+    };
+    auto outstanding = [&workers]()
+    {
+        int64_t sum = 0;
+        for (auto& worker : workers) sum += worker->getCounters().outstanding;
+        return sum;
+    };
+
+    ProcessSample windowStart;
+    bool windowStarted = false;
+    ProcessSample windowEnd;
+    bool windowEnded = false;
+    ProcessSample peak;
+    auto reportInterval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(options.reportIntervalSeconds));
+    auto nextReport = start + reportInterval;
+    uint64_t lastSent = 0, lastCompleted = 0;
+    while (true)
+    {
+        auto now = Clock::now();
+        if (!windowStarted && now >= warmupEnd)
+        {
+            windowStart = sampleProcess();
+            windowStarted = true;
+        }
+        if (!windowEnded && now >= end)
+        {
+            windowEnd = sampleProcess();
+            windowEnded = true;
+        }
+        if (now >= end && (outstanding() <= 0 || now >= drainEnd)) break;
+
+        if (now >= nextReport)
+        {
+            auto sample = sampleProcess();
+            peak.rssBytes = std::max(peak.rssBytes, sample.rssBytes);
+            peak.threads = std::max(peak.threads, sample.threads);
+
+            uint64_t sent = sumCounters(&Counters::sent);
+            uint64_t completed = sumCounters(&Counters::completed);
+            S2SLatencyHistogram interval;
+            {
+                std::unique_lock<std::mutex> lock(results.mutex);
+                std::swap(interval, results.intervalLatency);
+            }
+            double seconds = options.reportIntervalSeconds;
+            fprintf(stderr, "%6.1fs %s sent %8.1f/s  done %8.1f/s  outstanding %6lld  errors %llu  p50 %s ms  p99 %s ms  rss %.1f MB\n",
+                    std::chrono::duration<double>(now - start).count(), now < warmupEnd ? "warmup" : "      ",
+                    (double)(sent - lastSent) / seconds, (double)(completed - lastCompleted) / seconds,
+                    (long long)outstanding(), (unsigned long long)sumCounters(&Counters::errors),
+                    formatMS(interval.getValueAtPercentile(50)).c_str(),
+                    formatMS(interval.getValueAtPercentile(99)).c_str(), (double)sample.rssBytes / 1e6);
+            lastSent = sent;
+            lastCompleted = completed;
+            nextReport += reportInterval;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    }
+    for (auto& thread : threads) thread.join();
+
+    // The library's own view, summed over the contexts
+    S2SStats libraryStats;
+    for (auto& worker : workers)
+    {
+        for (auto& context : worker->getContexts())
+        {
+            auto stats = context->getStats();
+            libraryStats.bytesSent += stats.bytesSent;
+            libraryStats.bytesReceived += stats.bytesReceived;
+            libraryStats.authentications += stats.authentications;
+            libraryStats.requestQueueHighWater = std::max(libraryStats.requestQueueHighWater, stats.requestQueueHighWater);
+            libraryStats.callbackQueueHighWater = std::max(libraryStats.callbackQueueHighWater, stats.callbackQueueHighWater);
+        }
+        worker->tearDown();
+    }
+
+    double windowSeconds = options.durationSeconds;
+    uint64_t completedInWindow = sumCounters(&Counters::completedInWindow);
+    uint64_t measured = 0;
+    uint64_t errors = 0;
+    for (int operation = 0; operation < OPERATION_COUNT; ++operation)
+    {
+        measured += results.completed[operation];
+        errors += results.errors[operation];
+    }
+    double cpuSeconds = windowEnd.cpuSeconds - windowStart.cpuSeconds;
+    int64_t maxBehindUS = 0;
+    for (auto& worker : workers) maxBehindUS = std::max<int64_t>(maxBehindUS, worker->getCounters().maxBehindUS);
+    peak.rssBytes = std::max(peak.rssBytes, windowEnd.rssBytes);
+    peak.threads = std::max(peak.threads, windowEnd.threads);
+    uint64_t rttEvents = sumCounters(&Counters::rttEvents);
+
+    printf("\nOffered          %.1f/s\n", options.rate);
+    printf("Throughput       %.1f/s (%llu answered in %gs)\n", (double)completedInWindow / windowSeconds,
+           (unsigned long long)completedInWindow, windowSeconds);
+    printf("Errors           %llu of %llu measured\n", (unsigned long long)errors, (unsigned long long)measured);
+    printf("Unanswered       %lld, skipped %llu over --max-outstanding\n", (long long)outstanding(),
+           (unsigned long long)sumCounters(&Counters::skipped));
+    printf("Most behind      %s ms\n", formatMS((uint64_t)maxBehindUS).c_str());
+    printf("Latency (ms)     %10s %10s %10s %10s %10s %10s\n", "count", "p50", "p90", "p99", "p99.9", "max");
+    for (int operation = 0; operation < OPERATION_COUNT; ++operation)
+    {
+        const auto& histogram = results.latency[operation];
+        if (histogram.getCount() == 0) continue;
+        printf("  %-14s %10llu", OPERATION_NAMES[operation], (unsigned long long)histogram.getCount());
+        for (double percentile : PERCENTILES) printf(" %10s", formatMS(histogram.getValueAtPercentile(percentile)).c_str());
+        printf(" %10s\n", formatMS(histogram.getMax()).c_str());
+    }
+    if (!options.rtt.empty())
+    {
+        printf("RTT events       %llu (%.1f/s)\n", (unsigned long long)rttEvents,
+               (double)rttEvents / (options.warmupSeconds + options.durationSeconds));
+    }
+    printf("CPU              %.3f s, %.1f us per answered request%s\n", cpuSeconds,
+           completedInWindow ? cpuSeconds * 1e6 / (double)completedInWindow : 0.0,
+           options.mock ? " (the mock's included)" : "");
+    printf("RSS              %.1f MB, peak %.1f MB\n", (double)windowEnd.rssBytes / 1e6,
+           (double)std::max(peak.rssBytes, windowEnd.peakRssBytes) / 1e6);
+    if (peak.threads >= 0) printf("Threads          %d\n", peak.threads);
+    printf("Library          %llu bytes sent, %llu received, request queue high water %zu, callback queue high water %zu\n",
+           (unsigned long long)libraryStats.bytesSent, (unsigned long long)libraryStats.bytesReceived,
+           libraryStats.requestQueueHighWater, libraryStats.callbackQueueHighWater);
+
+    if (!options.jsonPath.empty())
+    {
+        Json::Value report(Json::objectValue);
+        char date[32];
+        time_t now = time(NULL);
+        strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%SZ", gmtime(&now));
+
+        Json::Value& context = report["context"];
+        context["date"] = date;
+        context["libraryVersion"] = s_brainCloudS2SVersion;
+        context["url"] = options.url;
+        context["mock"] = options.mock;
+        context["contexts"] = options.contexts;
+        context["pool"] = options.pool;
+        context["threads"] = options.threads;
+        context["offeredRate"] = options.rate;
+        context["durationSeconds"] = options.durationSeconds;
+        context["warmupSeconds"] = options.warmupSeconds;
+        for (int operation = 0; operation < OPERATION_COUNT; ++operation)
+        {
+            context["mix"][OPERATION_NAMES[operation]] = options.weights[operation];
+        }
+
+        Json::Value& result = report["results"];
+        result["throughput"] = (double)completedInWindow / windowSeconds;
+        result["measured"] = (Json::UInt64)measured;
+        result["errors"] = (Json::UInt64)errors;
+        result["unanswered"] = (Json::Int64)outstanding();
+        result["skipped"] = (Json::UInt64)sumCounters(&Counters::skipped);
+        result["maxBehindMS"] = (double)maxBehindUS / 1000.0;
+        for (int operation = 0; operation < OPERATION_COUNT; ++operation)
+        {
+            if (results.latency[operation].getCount() == 0) continue;
+            result["latency"][OPERATION_NAMES[operation]] = latencyToJson(results.latency[operation]);
+            result["latency"][OPERATION_NAMES[operation]]["errors"] = (Json::UInt64)results.errors[operation];
+        }
+        result["rttEvents"] = (Json::UInt64)rttEvents;
+        result["cpuSeconds"] = cpuSeconds;
+        result["cpuUSPerRequest"] = completedInWindow ? cpuSeconds * 1e6 / (double)completedInWindow : 0.0;
+        result["rssBytes"] = (Json::UInt64)windowEnd.rssBytes;
+        result["peakRssBytes"] = (Json::UInt64)std::max(peak.rssBytes, windowEnd.peakRssBytes);
+        result["threads"] = peak.threads;
+        result["bytesSent"] = (Json::UInt64)libraryStats.bytesSent;
+        result["bytesReceived"] = (Json::UInt64)libraryStats.bytesReceived;
+        result["requestQueueHighWater"] = (Json::UInt64)libraryStats.requestQueueHighWater;
+        result["callbackQueueHighWater"] = (Json::UInt64)libraryStats.callbackQueueHighWater;
+
+        Json::StyledWriter writer;
+        std::string json = writer.write(report);
+        if (options.jsonPath == "-")
+        {
+            std::cout << json;
+        }
+        else
+        {
+            std::ofstream file(options.jsonPath, std::ios::binary | std::ios::trunc);
+            file << json;
+            if (!file)
+            {
+                fprintf(stderr, "Failed to write %s\n", options.jsonPath.c_str());
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
@@ -44,6 +44,10 @@ namespace BrainCloud
     };
 
     void lwsLogCb(int level, const char* line) {
+        if (!s2s_should_log(S2SLogChannel::LWS, level == LLL_ERR ? S2SLogLevel::Error : S2SLogLevel::Info)) {
+            return;
+        }
+
         std::string msg(line);
         // Remove LWS timestamp because we have our own
         if (!msg.empty() && msg[0] == '[') {
@@ -84,9 +88,9 @@ namespace BrainCloud
     {
 #if defined(LWS_OPENSSL_SUPPORT)
 #if defined(LWS_WITH_MBEDTLS)
-        s2s_log("Using MbedTLS");
+        if (s2s_should_log(S2SLogChannel::LWS, S2SLogLevel::Info)) s2s_log("Using MbedTLS");
 #else
-        s2s_log("Using OpenSSL");
+        if (s2s_should_log(S2SLogChannel::LWS, S2SLogLevel::Info)) s2s_log("Using OpenSSL");
 #endif
 #endif
 
@@ -115,7 +119,7 @@ namespace BrainCloud
         std::transform(protocol.begin(), protocol.end(), protocolCaps.begin(), [](unsigned char c){ return std::toupper(c); });
         if (protocolCaps != "WS" && protocolCaps != "WSS")
         {
-            s2s_log("Invalid websocket protocol: ", protocol);
+            if (s2s_should_log(S2SLogChannel::LWS, S2SLogLevel::Error)) s2s_log("Invalid websocket protocol: ", protocol);
             return;
         }
         bool useSSL = protocolCaps == "WSS";
@@ -148,7 +152,7 @@ namespace BrainCloud
             _pLwsContext = lws_create_context(&info);
             if (!_pLwsContext)
             {
-                s2s_log("Failed to create websocket context");
+                if (s2s_should_log(S2SLogChannel::LWS, S2SLogLevel::Error)) s2s_log("Failed to create websocket context");
                 return;
             }
         }
@@ -187,7 +191,7 @@ namespace BrainCloud
 
             if (!_pLws)
             {
-                s2s_log("Failed to create websocket client");
+                if (s2s_should_log(S2SLogChannel::LWS, S2SLogLevel::Error)) s2s_log("Failed to create websocket client");
                 return;
             }
 
@@ -438,7 +442,7 @@ namespace BrainCloud
 
     void DefaultWebSocket::onClose()
     {
-        s2s_log("WebSocket closed");
+        if (s2s_should_log(S2SLogChannel::LWS, S2SLogLevel::Info)) s2s_log("WebSocket closed");
 
         std::unique_lock<std::mutex> lock(_mutex);
         _isValid = false;
@@ -449,7 +453,7 @@ namespace BrainCloud
 
     void DefaultWebSocket::onError(const char* msg)
     {
-        s2s_log("WebSocket error: ", msg);
+        if (s2s_should_log(S2SLogChannel::LWS, S2SLogLevel::Error)) s2s_log("WebSocket error: ", msg);
 
         std::unique_lock<std::mutex> lock(_mutex);
         _isValid = false;
@@ -460,7 +464,7 @@ namespace BrainCloud
 
     void DefaultWebSocket::onConnect()
     {
-        s2s_log("WebSocket Connected!");
+        if (s2s_should_log(S2SLogChannel::LWS, S2SLogLevel::Info)) s2s_log("WebSocket Connected!");
 
         std::unique_lock<std::mutex> lock(_mutex);
         _isValid = true;
@@ -3,8 +3,10 @@
 #include "brainclouds2s.h"
 #include "IRTTCallback.h"
 #include "IRTTConnectCallback.h"
+#include "S2SHttpReactor.h"
 #include "TimeUtil.h"
 
+#include <algorithm>
 #include <fstream>
 #include <iostream>
 #include <thread>
@@ -46,7 +48,6 @@ namespace BrainCloud
         , _socket(NULL)
         , _rttConnectionStatus(BrainCloudRTT::RTTConnectionStatus::Disconnected)
         , _receivingRunning(false)
-        , _heartbeatRunning(false)
         , _useWebSocket(true)
         , _heartbeatSeconds(30)
         , _lastHeartbeatTime(0)
@@ -64,11 +65,14 @@ namespace BrainCloud
         shutdown();
     }
 
-    void RTTComms::initialize()
+    void RTTComms::initialize(const std::shared_ptr<S2SHttpReactor>& reactor,
+                              const S2SRTTSocketFactory& socketFactory)
     {
 #if RTTCOMMS_LOG_EVERY_METHODS
         s2s_log("VERBOSE: RTTComms::initialize");
 #endif
+        _reactor = reactor;
+        _socketFactory = socketFactory;
         _isInitialized = true;
     }
 
@@ -98,11 +102,12 @@ namespace BrainCloud
         {
             _rttConnectionStatus = BrainCloudRTT::RTTConnectionStatus::Disconnecting;
             closeSocket();
-            _eventQueueMutex.lock();
             _callbackEventQueue.clear();
-            _eventQueueMutex.unlock();
             _rttConnectionStatus = BrainCloudRTT::RTTConnectionStatus::Disconnected;
         }
+
+        // Once the receive thread is done, so a CONNECT can't start it again
+        stopHeartbeat();
     }
 
     void RTTComms::closeSocket()
@@ -116,25 +121,23 @@ namespace BrainCloud
         {
             _socket->close();
 
-            // We wait for the recv/send threads to shutdown
-            _heartBeatMutex.lock();
-            _heartbeatCondition.notify_one();
-            _heartBeatMutex.unlock();
-            if (_receivingRunning || _heartbeatRunning)
+            // We wait for the recv thread to shutdown
+            if (_receivingRunning)
             {
                 _threadsCondition.wait(lock, [this]()
                 {
-                    return !(_receivingRunning || _heartbeatRunning);
+                    return !_receivingRunning;
                 });
             }
 
             delete _socket;
             _socket = NULL;
-            if (_disconnectedWithReason == true)
+            if (_disconnectedWithReason == true && s2s_should_log(S2SLogChannel::RTTRecv, S2SLogLevel::Error))
             {
                 Json::FastWriter myWriter;
-                std::string output ="\n" + myWriter.write(_msg);
-                printf("%s",output.c_str());
+                std::string reason = myWriter.write(_msg);
+                rtrim(reason);
+                s2s_log("[RTT] Disconnected: ", reason);
             }
         }
     }
@@ -200,51 +203,64 @@ namespace BrainCloud
         return _connectionId;
     }
 
-    void RTTComms::runCallbacks()
+    bool RTTComms::runCallback()
     {
 #if RTTCOMMS_LOG_EVERY_METHODS
         // removing this from logging every method BECAUSE it prints out too often and wipes out other useful logs
         // keeping in code though since we may want to print this sometimes
-        //s2s_log("VERBOSE: RTTComms::runCallbacks");
+        //s2s_log("VERBOSE: RTTComms::runCallback");
 #endif
-        _eventQueueMutex.lock();
-        auto eventsCopy = _callbackEventQueue;
-        _callbackEventQueue.clear();
-        _eventQueueMutex.unlock();
+        RTTCallback callback(RTTCallbackType::Event);
+        if (!_callbackEventQueue.pop(callback))
+        {
+            return false;
+        }
 
-        for (int i = 0; i < (int)eventsCopy.size(); ++i)
+        switch (callback._type)
         {
-            const RTTCallback& callback = eventsCopy[i];
-            switch (callback._type)
+            case RTTCallbackType::ConnectSuccess:
             {
-                case RTTCallbackType::ConnectSuccess:
+                if (_connectCallback)
                 {
-                    if (_connectCallback)
-                    {
-                        _connectCallback->rttConnectSuccess();
-                    }
-                    break;
+                    _connectCallback->rttConnectSuccess();
                 }
-                case RTTCallbackType::ConnectFailure:
+                break;
+            }
+            case RTTCallbackType::ConnectFailure:
+            {
+                if (_connectCallback)
                 {
-                    if (_connectCallback)
-                    {
-                        _connectCallback->rttConnectFailure(callback._message);
-                    }
-                    break;
+                    _connectCallback->rttConnectFailure(callback._message);
                 }
-                case RTTCallbackType::Event:
+                break;
+            }
+            case RTTCallbackType::Event:
+            {
+                std::string serviceName = callback._json["service"].asString();
+                std::map<std::string, IRTTCallback*>::iterator it = _callbacks.find(serviceName);
+                if (it != _callbacks.end())
                 {
-                    std::string serviceName = callback._json["service"].asString();
-                    std::map<std::string, IRTTCallback*>::iterator it = _callbacks.find(serviceName);
-                    if (it != _callbacks.end())
-                    {
-                        it->second->rttCallback(callback._message);
-                    }
-                    break;
+                    it->second->rttCallback(callback._message);
                 }
+                break;
             }
         }
+        return true;
+    }
+
+    bool RTTComms::hasPendingCallbacks() const
+    {
+        return !_callbackEventQueue.empty();
+    }
+
+    size_t RTTComms::getPendingCallbackCount() const
+    {
+        return _callbackEventQueue.size();
+    }
+
+    void RTTComms::setCallbackSignal(const std::shared_ptr<S2SCallbackSignal>& signal)
+    {
+        _callbackEventQueue.setSignal(signal);
     }
 
     void RTTComms::registerRTTCallback(const ServiceName& serviceName, IRTTCallback* in_callback)
@@ -408,7 +424,11 @@ namespace BrainCloud
             {
                 {
                     std::unique_lock<std::mutex> lock(_socketMutex);
-                    if (_useWebSocket)
+                    if (_socketFactory)
+                    {
+                        _socket = _socketFactory(host, port, headers, _useWebSocket);
+                    }
+                    else if (_useWebSocket)
                     {
                         if (_endpoint["ssl"].asBool())
                         {
@@ -462,7 +482,7 @@ namespace BrainCloud
 
             _lastHeartbeatTime = TimeUtil::getCurrentTimeMillis();
 
-            if (_loggingEnabled)
+            if (_loggingEnabled && s2s_should_log(S2SLogChannel::RTTRecv, S2SLogLevel::Info))
             {
                 s2s_log("RTT: connected");
             }
@@ -489,9 +509,7 @@ namespace BrainCloud
             port = _endpoint["port"].asInt();
         }
 
-        _eventQueueMutex.lock();
-        _callbackEventQueue.push_back(RTTCallback(RTTCallbackType::ConnectFailure, "Failed to connect to RTT Event server: " + host + ":" + std::to_string(port)));
-        _eventQueueMutex.unlock();
+        _callbackEventQueue.push(RTTCallback(RTTCallbackType::ConnectFailure, "Failed to connect to RTT Event server: " + host + ":" + std::to_string(port)));
     }
 
     Json::Value RTTComms::buildConnectionRequest(const std::string& protocol)
@@ -530,22 +548,22 @@ namespace BrainCloud
         }
     }
 
-    bool RTTComms::send(const Json::Value& jsonData)
+    bool RTTComms::send(const Json::Value& jsonData, S2SLogLevel logLevel)
     {
-        if (_loggingEnabled)
+        Json::FastWriter writer;
+        std::string message = writer.write(jsonData);
+
+        // The message as sent, without its line ending
+        if (_loggingEnabled && s2s_should_log(S2SLogChannel::RTTSend, logLevel))
         {
-            Json::StyledWriter writer;
-            std::string message = writer.write(jsonData);
-            rtrim(message);
-            s2s_log("[RTT SEND] ", message);
+            std::string logged = message;
+            rtrim(logged);
+            s2s_log("[RTT SEND] ", S2SLogPayload(S2SLogChannel::RTTSend, logged));
         }
 
         std::unique_lock<std::mutex> lock(_socketMutex);
         if (isRTTEnabled())
         {
-            Json::FastWriter writer;
-            std::string message = writer.write(jsonData);
-
             _socket->send(message);
         }
 
@@ -582,45 +600,103 @@ namespace BrainCloud
 #if RTTCOMMS_LOG_EVERY_METHODS
         s2s_log("VERBOSE: RTTComms::startHeartbeat");
 #endif
-        _heartbeatRunning = true;
-        std::thread heartbeatThread([this]
+        std::unique_lock<std::mutex> heartbeatLock(_heartbeatMutex);
+        stopHeartbeatLocked();
+        if (!_reactor)
         {
-            Json::Value jsonHeartbeat;
-            jsonHeartbeat["operation"] = "HEARTBEAT";
-            jsonHeartbeat["service"] = "rtt";
+            return;
+        }
 
-            std::unique_lock<std::mutex> lock(_heartBeatMutex);
+        _heartbeatState = std::make_shared<HeartbeatState>();
+        std::unique_lock<std::mutex> lock(_heartbeatState->mutex);
+        _heartbeatState->owner = this;
+        scheduleHeartbeat(_heartbeatState, ((int64_t)_heartbeatSeconds * 1000) - (TimeUtil::getCurrentTimeMillis() - _lastHeartbeatTime));
+    }
 
-            while (isRTTEnabled())
+    void RTTComms::stopHeartbeat()
+    {
+        std::unique_lock<std::mutex> heartbeatLock(_heartbeatMutex);
+        stopHeartbeatLocked();
+    }
+
+    // _heartbeatMutex must be held
+    void RTTComms::stopHeartbeatLocked()
+    {
+        if (!_heartbeatState)
+        {
+            return;
+        }
+
+        // Waits for a heartbeat being sent from the I/O thread
+        {
+            std::unique_lock<std::mutex> lock(_heartbeatState->mutex);
+            _heartbeatState->owner = NULL;
+            _reactor->cancel(_heartbeatState->timer);
+        }
+        _heartbeatState.reset();
+    }
+
+    // The heartbeat state must be locked
+    void RTTComms::scheduleHeartbeat(const std::shared_ptr<HeartbeatState>& state, int64_t delayMS)
+    {
+        state->timer = _reactor->schedule(
+            std::chrono::steady_clock::now() + std::chrono::milliseconds(std::max<int64_t>(delayMS, 0)),
+            [state]()
             {
-                int64_t sleepTime = ((int64_t)_heartbeatSeconds * 1000) - (TimeUtil::getCurrentTimeMillis() - _lastHeartbeatTime);
-                if (sleepTime > 0)
+                std::unique_lock<std::mutex> lock(state->mutex);
+                if (state->owner)
                 {
-                    _heartbeatCondition.wait_for(lock, std::chrono::milliseconds(sleepTime));
+                    state->owner->onHeartbeatTimer(state);
                 }
-                else
-                {
-                    send(jsonHeartbeat);
-                    _lastHeartbeatTime = TimeUtil::getCurrentTimeMillis();
-                }
-            }
-
-            _heartbeatRunning = false;
-            _threadsCondition.notify_one();
-        });
-        heartbeatThread.detach();
+            });
     }
 
-    void RTTComms::onRecv(const std::string& message)
+    // Called on the I/O thread, with the heartbeat state locked
+    void RTTComms::onHeartbeatTimer(const std::shared_ptr<HeartbeatState>& state)
     {
-        if (_loggingEnabled)
+        if (!isRTTEnabled())
+        {
+            return;
+        }
+
+        int64_t sleepTime = ((int64_t)_heartbeatSeconds * 1000) - (TimeUtil::getCurrentTimeMillis() - _lastHeartbeatTime);
+        if (sleepTime <= 0)
         {
-            s2s_log("[RTT RECV] ", message);
+            Json::Value jsonHeartbeat;
+            jsonHeartbeat["operation"] = "HEARTBEAT";
+            jsonHeartbeat["service"] = "rtt";
+
+            send(jsonHeartbeat, S2SLogLevel::Verbose);
+            _lastHeartbeatTime = TimeUtil::getCurrentTimeMillis();
+            sleepTime = (int64_t)_heartbeatSeconds * 1000;
         }
+        scheduleHeartbeat(state, sleepTime);
+    }
+
+    // Disconnects and messages that aren't json are errors, heartbeats verbose
+    S2SLogLevel RTTComms::getRecvLogLevel(bool parsed, const Json::Value& json)
+    {
+        if (!parsed) return S2SLogLevel::Error;
+        if (json["service"].asString() != "rtt") return S2SLogLevel::Info;
 
+        std::string operation = json["operation"].asString();
+        if (operation == "DISCONNECT") return S2SLogLevel::Error;
+        if (operation == "HEARTBEAT") return S2SLogLevel::Verbose;
+        return S2SLogLevel::Info;
+    }
+
+    void RTTComms::onRecv(const std::string& message)
+    {
         Json::Reader reader;
         Json::Value jsonData;
-        if (!reader.parse(message, jsonData))
+        bool parsed = reader.parse(message, jsonData);
+
+        if (_loggingEnabled && s2s_should_log(S2SLogChannel::RTTRecv, getRecvLogLevel(parsed, jsonData)))
+        {
+            s2s_log("[RTT RECV] ", S2SLogPayload(S2SLogChannel::RTTRecv, message));
+        }
+
+        if (!parsed)
         {
             failedToConnect();
             return;
@@ -647,9 +723,7 @@ namespace BrainCloud
 
                 startHeartbeat();
 
-                _eventQueueMutex.lock();
-                _callbackEventQueue.push_back(RTTCallback(RTTCallbackType::ConnectSuccess));
-                _eventQueueMutex.unlock();
+                _callbackEventQueue.push(RTTCallback(RTTCallbackType::ConnectSuccess));
             }
             else if (operation == "DISCONNECT")
             {
@@ -663,9 +737,7 @@ namespace BrainCloud
         }
         else
         {
-            _eventQueueMutex.lock();
-            _callbackEventQueue.push_back(RTTCallback(RTTCallbackType::Event, json, message));
-            _eventQueueMutex.unlock();
+            _callbackEventQueue.push(RTTCallback(RTTCallbackType::Event, json, message));
         }
     }
 }
\ No newline at end of file
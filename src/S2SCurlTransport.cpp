@@ -0,0 +1,257 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "S2SCurlTransport.h"
+#include "S2SHttpReactor.h"
+
+#include <algorithm>
+
+namespace BrainCloud
+{
+    // Longest wait for the connection to the dispatcher, so hosts that don't
+    // answer fail fast. Posts with less time left wait less.
+    static const uint64_t CONNECT_TIMEOUT_MS = 10 * 1000;
+
+    // Idle curl handles kept per transport. Requests are sent a few packets
+    // at a time, so a couple of handles is enough.
+    static const size_t MAX_POOLED_CURL_HANDLES = 4;
+
+    // Largest Content-Length the response buffer is sized for up front
+    static const size_t MAX_RESERVED_RESPONSE_SIZE = 64 * 1024 * 1024;
+
+    namespace
+    {
+        // Everything curl writes into while the transfer runs on the I/O thread
+        struct Transfer
+        {
+            CURL* curl = NULL;
+            std::string result;
+            char curlError[CURL_ERROR_SIZE];
+            struct curl_slist* headers = NULL;
+            IS2STransport::DataCallback dataCallback;
+        };
+
+        // Curl's write callback: appends what came in to the transfer's body
+        size_t writeData(char* toWrite, size_t size, size_t nmemb, void* data)
+        {
+            auto* pTransfer = (Transfer*)data;
+            if (pTransfer == NULL) return 0;
+
+            // Size the buffer once from the response headers instead of
+            // growing it chunk by chunk
+            if (pTransfer->result.empty())
+            {
+                curl_off_t contentLength = -1;
+                curl_easy_getinfo(pTransfer->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T, &contentLength);
+                if (contentLength > 0 && contentLength <= (curl_off_t)MAX_RESERVED_RESPONSE_SIZE)
+                {
+                    pTransfer->result.reserve((size_t)contentLength);
+                }
+            }
+
+            pTransfer->result.append(toWrite, size * nmemb);
+
+            if (pTransfer->dataCallback)
+            {
+                pTransfer->dataCallback(pTransfer->result);
+            }
+
+            return size * nmemb;
+        }
+    }
+
+    std::shared_ptr<S2SCurlTransport> S2SCurlTransport::create(const std::string& url,
+                                                               const std::shared_ptr<S2SHttpReactor>& reactor)
+    {
+        return std::shared_ptr<S2SCurlTransport>(new S2SCurlTransport(url, reactor));
+    }
+
+    S2SCurlTransport::S2SCurlTransport(const std::string& url, const std::shared_ptr<S2SHttpReactor>& reactor)
+        : m_url(url)
+        , m_reactor(reactor)
+        , m_share(curl_share_init())
+    {
+        if (m_share)
+        {
+            curl_share_setopt(m_share, CURLSHOPT_LOCKFUNC, lockShare);
+            curl_share_setopt(m_share, CURLSHOPT_UNLOCKFUNC, unlockShare);
+            curl_share_setopt(m_share, CURLSHOPT_USERDATA, this);
+            curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_DNS);
+            curl_share_setopt(m_share, CURLSHOPT_SHARE, CURL_LOCK_DATA_SSL_SESSION);
+        }
+    }
+
+    S2SCurlTransport::~S2SCurlTransport()
+    {
+        // Easy handles must go before the share handle they are attached to
+        for (auto curl : m_pool)
+        {
+            curl_easy_cleanup(curl);
+        }
+        m_pool.clear();
+        if (m_share)
+        {
+            curl_share_cleanup(m_share);
+        }
+    }
+
+    IS2STransport::TransferId S2SCurlTransport::post(const std::string& body, uint64_t timeoutMS,
+                                                     const DataCallback& onData, const Completion& completion)
+    {
+        CURL* curl = acquireHandle();
+        if (!curl)
+        {
+            // Report from the I/O thread like any other result
+            m_reactor->post([completion]()
+            {
+                Response response;
+                response.code = CURLE_OUT_OF_MEMORY;
+                response.error = "cURL Out of Memory";
+                completion(response);
+            });
+            return 0;
+        }
+
+        auto transfer = std::make_shared<Transfer>();
+        transfer->curl = curl;
+        transfer->curlError[0] = '\0';
+        transfer->dataCallback = onData;
+
+        // Use an error buffer to store the description of any errors.
+        curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, transfer->curlError);
+
+        transfer->headers = curl_slist_append(transfer->headers, "Content-Type: application/json");
+        std::string contentLength = "Content-Length: " + std::to_string(body.size());
+        transfer->headers = curl_slist_append(transfer->headers, contentLength.c_str());
+        curl_easy_setopt(curl, CURLOPT_HTTPHEADER, transfer->headers);
+
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, transfer.get());
+
+        curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, (long)timeoutMS);
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT_MS,
+                         (long)(timeoutMS > 0 ? std::min(timeoutMS, CONNECT_TIMEOUT_MS) : CONNECT_TIMEOUT_MS));
+
+        curl_easy_setopt(curl, CURLOPT_POST, 1);
+        curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, body.size());
+        curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, body.c_str());
+
+        auto pThis = shared_from_this();
+        return m_reactor->add(curl, [pThis, transfer, completion](CURL* curl, CURLcode rc)
+        {
+            Response response;
+            response.code = rc;
+
+            long newConnections = 0;
+            curl_easy_getinfo(curl, CURLINFO_NUM_CONNECTS, &newConnections);
+            response.newConnections = (uint64_t)newConnections;
+
+            // Header bytes sent: 0 if the request never went out
+            long requestSize = 0;
+            curl_easy_getinfo(curl, CURLINFO_REQUEST_SIZE, &requestSize);
+            response.requestSent = requestSize > 0;
+
+            curl_off_t bodySent = 0;
+            curl_off_t bodyReceived = 0;
+            long headerReceived = 0;
+            curl_easy_getinfo(curl, CURLINFO_SIZE_UPLOAD_T, &bodySent);
+            curl_easy_getinfo(curl, CURLINFO_SIZE_DOWNLOAD_T, &bodyReceived);
+            curl_easy_getinfo(curl, CURLINFO_HEADER_SIZE, &headerReceived);
+            response.bytesSent = (uint64_t)requestSize + (uint64_t)bodySent;
+            response.bytesReceived = (uint64_t)headerReceived + (uint64_t)bodyReceived;
+
+            // Curl times the phases from the start of the transfer, in
+            // microseconds. Skipped phases (DNS and connect on a reused
+            // connection) take no time, and there is no TLS over http.
+            curl_off_t dns = 0, connect = 0, tls = 0, firstByte = 0, total = 0;
+            curl_easy_getinfo(curl, CURLINFO_NAMELOOKUP_TIME_T, &dns);
+            curl_easy_getinfo(curl, CURLINFO_CONNECT_TIME_T, &connect);
+            curl_easy_getinfo(curl, CURLINFO_APPCONNECT_TIME_T, &tls);
+            curl_easy_getinfo(curl, CURLINFO_STARTTRANSFER_TIME_T, &firstByte);
+            curl_easy_getinfo(curl, CURLINFO_TOTAL_TIME_T, &total);
+            response.dnsTime = std::chrono::microseconds(dns);
+            response.connectTime = std::chrono::microseconds(connect);
+            response.tlsTime = std::chrono::microseconds(tls);
+            response.firstByteTime = std::chrono::microseconds(firstByte);
+            response.totalTime = std::chrono::microseconds(total);
+
+            // Don't leave pointers to this transfer in a pooled handle
+            curl_easy_setopt(curl, CURLOPT_HTTPHEADER, NULL);
+            curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, NULL);
+            curl_easy_setopt(curl, CURLOPT_WRITEDATA, NULL);
+            curl_slist_free_all(transfer->headers);
+            transfer->headers = NULL;
+            pThis->releaseHandle(curl);
+
+            if (rc == CURLE_OK)
+            {
+                response.body.swap(transfer->result);
+            }
+            else
+            {
+                response.error = transfer->curlError[0] != '\0' ? transfer->curlError : curl_easy_strerror(rc);
+            }
+            completion(response);
+        });
+    }
+
+    void S2SCurlTransport::abort(TransferId id)
+    {
+        m_reactor->abort(id);
+    }
+
+    CURL* S2SCurlTransport::acquireHandle()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_poolMutex);
+            if (!m_pool.empty())
+            {
+                CURL* curl = m_pool.back();
+                m_pool.pop_back();
+                return curl;
+            }
+        }
+
+        CURL* curl = curl_easy_init();
+        if (!curl) return nullptr;
+
+        // Options that don't change between requests are only set once per handle
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeData);
+
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, (long)0);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, (long)0);
+
+        // Keep the connection to the dispatcher alive between requests
+        curl_easy_setopt(curl, CURLOPT_TCP_KEEPALIVE, 1L);
+        if (m_share)
+        {
+            curl_easy_setopt(curl, CURLOPT_SHARE, m_share);
+        }
+
+        curl_easy_setopt(curl, CURLOPT_URL, m_url.c_str());
+
+        return curl;
+    }
+
+    void S2SCurlTransport::releaseHandle(CURL* curl)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_poolMutex);
+            if (m_pool.size() < MAX_POOLED_CURL_HANDLES)
+            {
+                m_pool.push_back(curl);
+                return;
+            }
+        }
+        curl_easy_cleanup(curl);
+    }
+
+    void S2SCurlTransport::lockShare(CURL* curl, curl_lock_data data, curl_lock_access access, void* userptr)
+    {
+        auto pThis = static_cast<S2SCurlTransport*>(userptr);
+        pThis->m_shareMutexes[data].lock();
+    }
+
+    void S2SCurlTransport::unlockShare(CURL* curl, curl_lock_data data, void* userptr)
+    {
+        auto pThis = static_cast<S2SCurlTransport*>(userptr);
+        pThis->m_shareMutexes[data].unlock();
+    }
+};
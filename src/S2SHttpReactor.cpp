@@ -0,0 +1,387 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "S2SHttpReactor.h"
+#include "S2STimerWheel.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+namespace BrainCloud
+{
+    // Upper bound on how long the I/O thread sleeps when nothing happens.
+    // Adding a transfer or stopping wakes it up immediately.
+    static const int REACTOR_POLL_TIMEOUT_MS = 1000;
+
+    struct S2SHttpReactor::Loop
+    {
+        struct Transfer
+        {
+            TransferId id;
+            CURL* curl;
+            Completion completion;
+        };
+
+        CURLM* multi = nullptr;
+
+        std::mutex mutex;
+        TransferId nextId = 1;
+        std::vector<Transfer> pending;
+        std::vector<TransferId> aborted;
+        std::vector<std::function<void()>> posted;
+        S2STimerWheel timers;
+        bool stopping = false;
+
+        // Only touched by the I/O thread
+        std::map<CURL*, Transfer> active;
+        std::map<TransferId, CURL*> activeIds;
+
+        void run();
+        void runAborted(std::vector<TransferId>& ids);
+        void runPosted();
+        int runTimers();
+        void abortAll();
+    };
+
+    void S2SHttpReactor::Loop::run()
+    {
+        std::vector<Transfer> added;
+        std::vector<TransferId> abortIds;
+
+        while (true)
+        {
+            {
+                std::unique_lock<std::mutex> lock(mutex);
+                if (stopping) break;
+                std::swap(added, pending);
+                std::swap(abortIds, aborted);
+            }
+
+            for (auto& transfer : added)
+            {
+                if (curl_multi_add_handle(multi, transfer.curl) != CURLM_OK)
+                {
+                    transfer.completion(transfer.curl, CURLE_FAILED_INIT);
+                    continue;
+                }
+                activeIds[transfer.id] = transfer.curl;
+                active[transfer.curl] = std::move(transfer);
+            }
+            added.clear();
+
+            runAborted(abortIds);
+
+            int running = 0;
+            curl_multi_perform(multi, &running);
+
+            CURLMsg* msg;
+            int msgsLeft = 0;
+            while ((msg = curl_multi_info_read(multi, &msgsLeft)))
+            {
+                if (msg->msg != CURLMSG_DONE) continue;
+
+                CURL* curl = msg->easy_handle;
+                CURLcode result = msg->data.result;
+                curl_multi_remove_handle(multi, curl);
+
+                auto it = active.find(curl);
+                if (it == active.end()) continue;
+                Completion completion = std::move(it->second.completion);
+                activeIds.erase(it->second.id);
+                active.erase(it);
+
+                completion(curl, result);
+            }
+
+            runPosted();
+            int timeoutMS = runTimers();
+
+            curl_multi_poll(multi, NULL, 0, timeoutMS, NULL);
+        }
+
+        abortAll();
+
+        // Under the lock: the reactor's functions wake us up through it
+        std::unique_lock<std::mutex> lock(mutex);
+        curl_multi_cleanup(multi);
+        multi = nullptr;
+    }
+
+    // For the completions and functions handed to a stopped reactor: there
+    // is no I/O thread left to run them, and the caller may hold locks they
+    // take.
+    static void runAfterStop(const std::function<void()>& function)
+    {
+        std::thread(function).detach();
+    }
+
+    void S2SHttpReactor::Loop::runAborted(std::vector<TransferId>& ids)
+    {
+        for (auto id : ids)
+        {
+            // Already finished, or aborted twice
+            auto it = activeIds.find(id);
+            if (it == activeIds.end()) continue;
+
+            CURL* curl = it->second;
+            activeIds.erase(it);
+            curl_multi_remove_handle(multi, curl);
+
+            auto transfer = active.find(curl);
+            Completion completion = std::move(transfer->second.completion);
+            active.erase(transfer);
+
+            completion(curl, CURLE_ABORTED_BY_CALLBACK);
+        }
+        ids.clear();
+    }
+
+    // Runs the timers that are due. Returns how long the loop can sleep.
+    int S2SHttpReactor::Loop::runTimers()
+    {
+        std::vector<std::function<void()>> due;
+        int timeoutMS = REACTOR_POLL_TIMEOUT_MS;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            auto now = std::chrono::steady_clock::now();
+            timers.advance(now, due);
+
+            // Round up, so we don't wake up just before the timer is due
+            auto wait = timers.getWaitTime(now, std::chrono::milliseconds(timeoutMS));
+            auto waitMS = std::chrono::duration_cast<std::chrono::milliseconds>(wait);
+            if (waitMS < wait) waitMS += std::chrono::milliseconds(1);
+            timeoutMS = (int)waitMS.count();
+        }
+        for (auto& function : due)
+        {
+            function();
+        }
+        return due.empty() ? timeoutMS : 0;
+    }
+
+    void S2SHttpReactor::Loop::runPosted()
+    {
+        std::vector<std::function<void()>> functions;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::swap(functions, posted);
+        }
+        for (auto& function : functions)
+        {
+            function();
+        }
+    }
+
+    void S2SHttpReactor::Loop::abortAll()
+    {
+        for (auto& transfer : active)
+        {
+            curl_multi_remove_handle(multi, transfer.first);
+            transfer.second.completion(transfer.first, CURLE_ABORTED_BY_CALLBACK);
+        }
+        active.clear();
+        activeIds.clear();
+
+        std::vector<Transfer> notStarted;
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            std::swap(notStarted, pending);
+            aborted.clear();
+            timers.clear();
+        }
+        for (auto& transfer : notStarted)
+        {
+            transfer.completion(transfer.curl, CURLE_ABORTED_BY_CALLBACK);
+        }
+
+        runPosted();
+    }
+
+    std::shared_ptr<S2SHttpReactor> S2SHttpReactor::getShared()
+    {
+        static std::mutex s_sharedMutex;
+        static std::weak_ptr<S2SHttpReactor> s_shared;
+
+        std::unique_lock<std::mutex> lock(s_sharedMutex);
+        auto reactor = s_shared.lock();
+        if (!reactor)
+        {
+            reactor = create();
+            s_shared = reactor;
+        }
+        return reactor;
+    }
+
+    namespace
+    {
+        // Reactors alive, for stopAll. Never destroyed, it's used at exit.
+        struct LiveReactors
+        {
+            std::mutex mutex;
+            std::vector<std::weak_ptr<S2SHttpReactor>> reactors;
+            bool stopAtExit = false;
+        };
+
+        LiveReactors& getLiveReactors()
+        {
+            static LiveReactors* s_live = new LiveReactors();
+            return *s_live;
+        }
+    }
+
+    std::shared_ptr<S2SHttpReactor> S2SHttpReactor::create()
+    {
+        std::shared_ptr<S2SHttpReactor> reactor(new S2SHttpReactor());
+
+        auto& live = getLiveReactors();
+        std::unique_lock<std::mutex> lock(live.mutex);
+
+        // A context can keep its reactor alive past main through the
+        // completions it has in flight. Stop the I/O threads from atexit,
+        // which runs before the statics built ahead of this call are
+        // destroyed, so no completion runs into a destroyed global.
+        if (!live.stopAtExit)
+        {
+            live.stopAtExit = std::atexit(stopAll) == 0;
+        }
+
+        live.reactors.erase(std::remove_if(live.reactors.begin(), live.reactors.end(),
+                                           [](const std::weak_ptr<S2SHttpReactor>& weak)
+                                           {
+                                               return weak.expired();
+                                           }),
+                            live.reactors.end());
+        live.reactors.push_back(reactor);
+        return reactor;
+    }
+
+    void S2SHttpReactor::stopAll()
+    {
+        std::vector<std::shared_ptr<S2SHttpReactor>> reactors;
+        {
+            auto& live = getLiveReactors();
+            std::unique_lock<std::mutex> lock(live.mutex);
+            for (auto& weak : live.reactors)
+            {
+                if (auto reactor = weak.lock()) reactors.push_back(reactor);
+            }
+        }
+
+        // Held here, so the last reference can't be dropped by a completion
+        // on the thread being stopped
+        for (auto& reactor : reactors)
+        {
+            reactor->stop();
+        }
+    }
+
+    S2SHttpReactor::S2SHttpReactor()
+        : m_loop(std::make_shared<Loop>())
+    {
+        m_loop->multi = curl_multi_init();
+
+        // The thread owns a reference to the loop, so it can outlive this
+        // object when the last reference is dropped from a completion.
+        auto loop = m_loop;
+        m_thread = std::thread([loop]()
+        {
+            loop->run();
+        });
+    }
+
+    S2SHttpReactor::~S2SHttpReactor()
+    {
+        stop();
+    }
+
+    void S2SHttpReactor::stop()
+    {
+        {
+            // Wake up under the lock: the loop can't get past its stop check
+            // and clean up the multi handle while we hold it.
+            std::unique_lock<std::mutex> lock(m_loop->mutex);
+            m_loop->stopping = true;
+            if (m_thread.joinable())
+            {
+                curl_multi_wakeup(m_loop->multi);
+            }
+        }
+
+        // Already stopped at exit
+        if (!m_thread.joinable()) return;
+
+        if (m_thread.get_id() == std::this_thread::get_id())
+        {
+            // Destroyed from one of our own completions
+            m_thread.detach();
+        }
+        else
+        {
+            m_thread.join();
+        }
+    }
+
+    S2SHttpReactor::TransferId S2SHttpReactor::add(CURL* curl, const Completion& completion)
+    {
+        std::unique_lock<std::mutex> lock(m_loop->mutex);
+        TransferId id = m_loop->nextId++;
+        if (m_loop->stopping)
+        {
+            lock.unlock();
+            runAfterStop([curl, completion]()
+            {
+                completion(curl, CURLE_ABORTED_BY_CALLBACK);
+            });
+            return id;
+        }
+
+        m_loop->pending.push_back({id, curl, completion});
+        curl_multi_wakeup(m_loop->multi);
+        return id;
+    }
+
+    void S2SHttpReactor::abort(TransferId id)
+    {
+        std::unique_lock<std::mutex> lock(m_loop->mutex);
+        if (m_loop->stopping) return;
+        m_loop->aborted.push_back(id);
+        curl_multi_wakeup(m_loop->multi);
+    }
+
+    S2SHttpReactor::TimerId S2SHttpReactor::schedule(std::chrono::steady_clock::time_point when,
+                                                     const std::function<void()>& function)
+    {
+        std::unique_lock<std::mutex> lock(m_loop->mutex);
+        // Dropped, like the timers waiting when it stopped. The wheel is
+        // empty from then on, so the id can't cancel another timer.
+        if (m_loop->stopping) return m_loop->nextId++;
+
+        TimerId id = m_loop->timers.add(when, function);
+        curl_multi_wakeup(m_loop->multi);
+        return id;
+    }
+
+    bool S2SHttpReactor::cancel(TimerId id)
+    {
+        // The I/O thread only sleeps longer: no need to wake it up
+        std::unique_lock<std::mutex> lock(m_loop->mutex);
+        return m_loop->timers.cancel(id);
+    }
+
+    void S2SHttpReactor::post(const std::function<void()>& function)
+    {
+        std::unique_lock<std::mutex> lock(m_loop->mutex);
+        if (m_loop->stopping)
+        {
+            lock.unlock();
+            runAfterStop(function);
+            return;
+        }
+
+        m_loop->posted.push_back(function);
+        curl_multi_wakeup(m_loop->multi);
+    }
+};
@@ -0,0 +1,214 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "S2SJsonScanner.h"
+
+#include <cstring>
+
+namespace BrainCloud
+{
+    static bool isSpace(char c)
+    {
+        return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+    }
+
+    S2SJsonScanner::S2SJsonScanner(const std::string& arrayKey)
+        : m_arrayKey(arrayKey)
+    {
+    }
+
+    bool S2SJsonScanner::skipValueByte(char c, size_t pos, bool& consumed)
+    {
+        consumed = true;
+
+        if (m_inString)
+        {
+            if (m_escape) m_escape = false;
+            else if (c == '\\') m_escape = true;
+            else if (c == '"')
+            {
+                m_inString = false;
+                if (m_depth == 0)
+                {
+                    m_valueEnd = pos + 1;
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        if (m_scalar)
+        {
+            // Number, true, false or null: ends on the next delimiter
+            if (isSpace(c) || c == ',' || c == '}' || c == ']')
+            {
+                consumed = false;
+                m_valueEnd = pos;
+                return true;
+            }
+            return false;
+        }
+
+        if (c == '"') m_inString = true;
+        else if (c == '{' || c == '[') m_depth++;
+        else if (c == '}' || c == ']')
+        {
+            if (--m_depth == 0)
+            {
+                m_valueEnd = pos + 1;
+                return true;
+            }
+        }
+        else if (m_depth == 0) m_scalar = true;
+        return false;
+    }
+
+    void S2SJsonScanner::feed(const std::string& buffer)
+    {
+        const char* data = buffer.data();
+        size_t size = buffer.size();
+
+        while (m_pos < size)
+        {
+            char c = data[m_pos];
+
+            switch (m_state)
+            {
+                case State::Start:
+                    if (isSpace(c)) break;
+                    m_state = c == '{' ? State::KeyOrEnd : State::Invalid;
+                    break;
+
+                case State::Key:
+                case State::KeyOrEnd:
+                    if (isSpace(c)) break;
+                    if (c == '"')
+                    {
+                        m_key.first = m_pos + 1;
+                        m_escape = false;
+                        m_state = State::InKey;
+                    }
+                    else if (c == '}' && m_state == State::KeyOrEnd) m_state = State::Done;
+                    else m_state = State::Invalid;
+                    break;
+
+                case State::InKey:
+                    if (m_escape) m_escape = false;
+                    else if (c == '\\') m_escape = true;
+                    else if (c == '"')
+                    {
+                        m_key.second = m_pos;
+                        m_state = State::Colon;
+                    }
+                    break;
+
+                case State::Colon:
+                    if (isSpace(c)) break;
+                    m_state = c == ':' ? State::Value : State::Invalid;
+                    break;
+
+                case State::Value:
+                    if (isSpace(c)) break;
+                    if (c == '[' && !m_found &&
+                        m_key.second - m_key.first == m_arrayKey.size() &&
+                        memcmp(data + m_key.first, m_arrayKey.data(), m_arrayKey.size()) == 0)
+                    {
+                        m_state = State::ElementOrEnd;
+                        break;
+                    }
+                    m_valueBegin = m_pos;
+                    m_depth = 0;
+                    m_inString = m_escape = m_scalar = false;
+                    m_state = State::InValue;
+                    continue; // Same byte starts the value
+
+                case State::InValue:
+                {
+                    bool consumed;
+                    if (skipValueByte(c, m_pos, consumed))
+                    {
+                        m_members.push_back(std::make_pair(m_key, Range(m_valueBegin, m_valueEnd)));
+                        m_state = State::AfterValue;
+                    }
+                    if (!consumed) continue;
+                    break;
+                }
+
+                case State::AfterValue:
+                    if (isSpace(c)) break;
+                    if (c == ',') m_state = State::Key;
+                    else if (c == '}') m_state = State::Done;
+                    else m_state = State::Invalid;
+                    break;
+
+                case State::ElementOrEnd:
+                case State::Element:
+                    if (isSpace(c)) break;
+                    if (c == ']' && m_state == State::ElementOrEnd)
+                    {
+                        m_found = true;
+                        m_state = State::AfterValue;
+                        break;
+                    }
+                    m_valueBegin = m_pos;
+                    m_depth = 0;
+                    m_inString = m_escape = m_scalar = false;
+                    m_state = State::InElement;
+                    continue;
+
+                case State::InElement:
+                {
+                    bool consumed;
+                    if (skipValueByte(c, m_pos, consumed))
+                    {
+                        m_elements.push_back(Range(m_valueBegin, m_valueEnd));
+                        m_state = State::AfterElement;
+                    }
+                    if (!consumed) continue;
+                    break;
+                }
+
+                case State::AfterElement:
+                    if (isSpace(c)) break;
+                    if (c == ',') m_state = State::Element;
+                    else if (c == ']')
+                    {
+                        m_found = true;
+                        m_state = State::AfterValue;
+                    }
+                    else m_state = State::Invalid;
+                    break;
+
+                case State::Done:
+                    if (!isSpace(c)) m_state = State::Invalid;
+                    break;
+
+                case State::Invalid:
+                    m_pos = size;
+                    return;
+            }
+
+            m_pos++;
+        }
+    }
+
+    bool S2SJsonScanner::getMember(const std::string& buffer, const std::string& key, Range& value) const
+    {
+        for (auto& member : m_members)
+        {
+            const Range& name = member.first;
+            if (name.second - name.first == key.size() &&
+                buffer.compare(name.first, key.size(), key) == 0)
+            {
+                value = member.second;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    S2SJsonScanner::Result S2SJsonScanner::getResult() const
+    {
+        if (m_state == State::Invalid) return Result::Invalid;
+        if (m_found) return Result::Found;
+        return m_state == State::Done ? Result::NotFound : Result::Invalid;
+    }
+};
@@ -0,0 +1,641 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "S2SLogger.h"
+#include "brainclouds2s.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define S2S_LOG_SSE2 1
+#endif
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+#if defined(_WIN32)
+#include <windows.h>
+#else
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+namespace BrainCloud
+{
+    namespace
+    {
+        // A batch stops growing past this, so a burst doesn't keep the
+        // writer from waking flushers and blocked producers
+        const size_t MAX_BATCH_BYTES = 256 * 1024;
+
+        // The writer drains the ring this often. Producers only wake it
+        // sooner once the ring is an eighth full, so records are written in
+        // batches instead of a wakeup and a write per line.
+        const std::chrono::milliseconds WRITER_INTERVAL(10);
+        const std::chrono::milliseconds BLOCKED_PRODUCER_WAIT(1);
+
+        void writeConsole(const std::string& data)
+        {
+            fwrite(data.data(), 1, data.size(), stdout);
+            fflush(stdout);
+        }
+    }
+
+    namespace
+    {
+        // Bit i set when text[i] is a quote, for up to 16 bytes
+        inline uint32_t getQuoteMask(const char* text, size_t size)
+        {
+#if S2S_LOG_SSE2
+            if (size >= 16)
+            {
+                __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text));
+                return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8('"')));
+            }
+#endif
+            uint32_t mask = 0;
+            size_t n = size < 16 ? size : 16;
+            for (size_t i = 0; i < n; ++i)
+            {
+                if (text[i] == '"') mask |= 1u << i;
+            }
+            return mask;
+        }
+
+        inline int countTrailingZeros(uint32_t mask)
+        {
+#if defined(_MSC_VER)
+            unsigned long index;
+            _BitScanForward(&index, mask);
+            return (int)index;
+#else
+            return __builtin_ctz(mask);
+#endif
+        }
+
+        // Walks the quotes of a text 16 bytes at a time
+        class QuoteFinder
+        {
+        public:
+            QuoteFinder(const char* text, const char* end)
+                : m_block(text), m_end(end), m_mask(getQuoteMask(text, end - text))
+            {
+            }
+
+            // Next quote, or end
+            const char* next()
+            {
+                while (m_mask == 0)
+                {
+                    m_block += 16;
+                    if (m_block >= m_end) return m_end;
+                    m_mask = getQuoteMask(m_block, m_end - m_block);
+                }
+                const char* quote = m_block + countTrailingZeros(m_mask);
+                m_mask &= m_mask - 1;
+                return quote;
+            }
+
+            // Continues from p
+            void seek(const char* p)
+            {
+                m_block = p;
+                m_mask = p < m_end ? getQuoteMask(p, m_end - p) : 0;
+            }
+
+        private:
+            const char* m_block;
+            const char* m_end;
+            uint32_t m_mask;
+        };
+
+        // sensitiveKeys in an open-addressed table, looked up by length and
+        // first and last characters
+        class SensitiveKeyTable
+        {
+        public:
+            SensitiveKeyTable()
+            {
+                for (const auto& key : sensitiveKeys)
+                {
+                    if (key.empty() || key.size() >= 64) continue;
+                    m_lengths |= 1ull << key.size();
+                    size_t i = hash(key.data(), key.size());
+                    while (!m_keys[i].empty()) i = (i + 1) & (SIZE - 1);
+                    m_keys[i] = key;
+                }
+            }
+
+            bool contains(const char* text, size_t size) const
+            {
+                if (size >= 64 || !(m_lengths & (1ull << size))) return false;
+                for (size_t i = hash(text, size); !m_keys[i].empty(); i = (i + 1) & (SIZE - 1))
+                {
+                    if (m_keys[i].size() == size && memcmp(m_keys[i].data(), text, size) == 0) return true;
+                }
+                return false;
+            }
+
+        private:
+            static const size_t SIZE = 32;
+
+            static size_t hash(const char* text, size_t size)
+            {
+                return (size * 7 + (unsigned char)text[0] * 3 + (unsigned char)text[size - 1]) & (SIZE - 1);
+            }
+
+            uint64_t m_lengths = 0;
+            std::string m_keys[SIZE];
+        };
+
+        inline bool isJsonSpace(char c)
+        {
+            return c == ' ' || c == '\t' || c == '\n' || c == '\r';
+        }
+
+        // Whether the quote at p is preceded by an odd number of backslashes
+        inline bool isEscaped(const char* begin, const char* p)
+        {
+            size_t backslashes = 0;
+            while (p > begin && *(p - 1) == '\\')
+            {
+                backslashes++;
+                p--;
+            }
+            return (backslashes & 1) != 0;
+        }
+    }
+
+    struct S2SLogger::Slot
+    {
+        std::atomic<size_t> sequence{0};
+        std::string record;
+    };
+
+    struct S2SLogger::Output
+    {
+#if defined(_WIN32)
+        HANDLE file = INVALID_HANDLE_VALUE;
+
+        // Shared, so another program can write to the same file
+        bool open(const std::string& path)
+        {
+            file = CreateFileA(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_WRITE | FILE_SHARE_READ,
+                               NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+            return file != INVALID_HANDLE_VALUE;
+        }
+
+        bool isOpen() const { return file != INVALID_HANDLE_VALUE; }
+
+        void close()
+        {
+            if (isOpen()) CloseHandle(file);
+            file = INVALID_HANDLE_VALUE;
+        }
+
+        bool write(const std::string& data)
+        {
+            // Log files get Windows line endings
+            std::string lines;
+            lines.reserve(data.size() + data.size() / 32);
+            for (char c : data)
+            {
+                if (c == '\n') lines += '\r';
+                lines += c;
+            }
+
+            DWORD written = 0;
+            return WriteFile(file, lines.data(), static_cast<DWORD>(lines.size()), &written, NULL) &&
+                   written == lines.size();
+        }
+#else
+        int fd = -1;
+
+        bool open(const std::string& path)
+        {
+            fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+            return fd >= 0;
+        }
+
+        bool isOpen() const { return fd >= 0; }
+
+        void close()
+        {
+            if (isOpen()) ::close(fd);
+            fd = -1;
+        }
+
+        bool write(const std::string& data)
+        {
+            const char* p = data.data();
+            size_t left = data.size();
+            while (left > 0)
+            {
+                ssize_t written = ::write(fd, p, left);
+                if (written < 0)
+                {
+                    if (errno == EINTR) continue;
+                    return false;
+                }
+                p += written;
+                left -= (size_t)written;
+            }
+            return true;
+        }
+#endif
+
+        ~Output() { close(); }
+
+        std::string path;
+    };
+
+    S2SLogger& S2SLogger::getDefault()
+    {
+        // Never destroyed: contexts can still log while the statics are
+        // destroyed. stopDefault writes what's queued at exit, what's logged
+        // after that is written by its producer.
+        static S2SLogger* s_logger = []()
+        {
+            auto logger = new S2SLogger();
+            std::atexit(stopDefault);
+            return logger;
+        }();
+        return *s_logger;
+    }
+
+    void S2SLogger::stopDefault()
+    {
+        getDefault().stop();
+    }
+
+    void S2SLogger::appendTimestamp(std::string& out)
+    {
+        struct Cache
+        {
+            time_t second = -1;
+            char text[32];
+            size_t size = 0;
+        };
+        static thread_local Cache t_cache;
+
+        time_t now = std::time(nullptr);
+        if (now != t_cache.second)
+        {
+            struct tm local;
+#if defined(_WIN32)
+            localtime_s(&local, &now);
+#else
+            localtime_r(&now, &local);
+#endif
+            t_cache.size = strftime(t_cache.text, sizeof(t_cache.text), "%Y/%m/%d %H:%M:%S", &local);
+            t_cache.second = now;
+        }
+        out.append(t_cache.text, t_cache.size);
+    }
+
+    // Every pair of consecutive quotes is a possible key, without tracking
+    // which strings are keys and which are values, so a payload cut short
+    // or starting mid-string is still redacted.
+    void S2SLogger::appendRedacted(std::string& out, const char* text, size_t size)
+    {
+        static const SensitiveKeyTable s_keys;
+
+        const char* end = text + size;
+        const char* copied = text;
+        const char* open = nullptr;
+        QuoteFinder quotes(text, end);
+        for (const char* quote = quotes.next(); quote != end; quote = quotes.next())
+        {
+            const char* key = open;
+            open = quote;
+            if (!key || !s_keys.contains(key + 1, quote - key - 1)) continue;
+
+            // "key" : "value"
+            const char* p = quote + 1;
+            while (p < end && isJsonSpace(*p)) p++;
+            if (p == end || *p != ':') continue;
+            p++;
+            while (p < end && isJsonSpace(*p)) p++;
+            if (p == end || *p != '"') continue;
+
+            const char* value = p + 1;
+            quotes.seek(value);
+            const char* close = quotes.next();
+            while (close != end && isEscaped(value, close))
+            {
+                close = quotes.next();
+            }
+
+            // An unterminated value is redacted to the end
+            out.append(copied, value - copied);
+            out += obfuscateString(std::string(value, close - value));
+            copied = close;
+            if (close == end) break;
+
+            open = close;
+            quotes.seek(close + 1);
+        }
+        out.append(copied, end - copied);
+    }
+
+    S2SLogger::S2SLogger(size_t capacity)
+        : m_output(new Output())
+    {
+        size_t size = 8;
+        while (size < capacity) size <<= 1;
+        m_mask = size - 1;
+        m_wakeMask = size / 8 - 1;
+        m_slots.reset(new Slot[size]);
+        for (size_t i = 0; i < size; ++i)
+        {
+            m_slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+
+        // Upload responses were always cut to their beginning
+        m_channels[(size_t)S2SLogChannel::GlobalFileV3].maxPayloadBytes = 200;
+
+        m_thread = std::thread([this]() { run(); });
+    }
+
+    S2SLogger::~S2SLogger()
+    {
+        stop();
+    }
+
+    void S2SLogger::write(std::string&& record)
+    {
+        while (!m_stopped)
+        {
+            size_t pos = 0;
+            if (tryPush(record, pos))
+            {
+                // Pushed while stop drained the ring: it may have missed
+                // this record. Either stop sees the record or this sees
+                // m_stopped.
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+                if (m_stopped)
+                {
+                    drainStopped();
+                }
+                else if ((pos & m_wakeMask) == 0)
+                {
+                    wakeWriter();
+                }
+                return;
+            }
+
+            if (m_policy == S2SLogOverflow::Drop)
+            {
+                m_dropped.fetch_add(1, std::memory_order_relaxed);
+                wakeWriter();
+                return;
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_wakeRequested = true;
+            m_wakeup.notify_one();
+            m_written.wait_for(lock, BLOCKED_PRODUCER_WAIT);
+        }
+
+        // The writer stopped, at exit
+        record += '\n';
+        writeBatch(record);
+    }
+
+    void S2SLogger::flush()
+    {
+        size_t target = m_enqueuePos.load();
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeRequested = true;
+        m_wakeup.notify_one();
+        m_written.wait(lock, [this, target]()
+        {
+            return m_writtenPos >= target || m_stopped;
+        });
+    }
+
+    void S2SLogger::setFilePath(const std::string& path)
+    {
+        flush();
+        std::unique_lock<std::mutex> lock(m_outputMutex);
+        m_pendingPath = path;
+        m_pathChanged = true;
+    }
+
+    void S2SLogger::setOverflowPolicy(S2SLogOverflow policy)
+    {
+        m_policy = policy;
+    }
+
+    uint64_t S2SLogger::getDroppedCount() const
+    {
+        return m_dropped.load(std::memory_order_relaxed);
+    }
+
+    void S2SLogger::setChannelOptions(S2SLogChannel channel, const S2SLogChannelOptions& options)
+    {
+        Channel& state = m_channels[(size_t)channel];
+        state.level = options.level;
+        state.sampleEvery = options.sampleEvery > 0 ? options.sampleEvery : 1;
+        state.maxPayloadBytes = options.maxPayloadBytes;
+    }
+
+    S2SLogChannelOptions S2SLogger::getChannelOptions(S2SLogChannel channel) const
+    {
+        const Channel& state = m_channels[(size_t)channel];
+        S2SLogChannelOptions options;
+        options.level = state.level;
+        options.sampleEvery = state.sampleEvery;
+        options.maxPayloadBytes = state.maxPayloadBytes;
+        return options;
+    }
+
+    bool S2SLogger::shouldLog(S2SLogChannel channel, S2SLogLevel level)
+    {
+        Channel& state = m_channels[(size_t)channel];
+        if (level > state.level.load(std::memory_order_relaxed)) return false;
+        if (level == S2SLogLevel::Error) return true;
+
+        uint32_t sampleEvery = state.sampleEvery.load(std::memory_order_relaxed);
+        return sampleEvery <= 1 || state.sampled.fetch_add(1, std::memory_order_relaxed) % sampleEvery == 0;
+    }
+
+    size_t S2SLogger::getMaxPayloadBytes(S2SLogChannel channel) const
+    {
+        return m_channels[(size_t)channel].maxPayloadBytes.load(std::memory_order_relaxed);
+    }
+
+    // Bounded MPMC ring of Dmitry Vyukov, with a single consumer: a slot's
+    // sequence tells whether it's free for the producer at a position or
+    // holds the record for the consumer at that position.
+    bool S2SLogger::tryPush(std::string& record, size_t& pos)
+    {
+        pos = m_enqueuePos.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;)
+        {
+            slot = &m_slots[pos & m_mask];
+            size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            intptr_t diff = (intptr_t)sequence - (intptr_t)pos;
+            if (diff == 0)
+            {
+                if (m_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            }
+            else if (diff < 0)
+            {
+                return false;
+            }
+            else
+            {
+                pos = m_enqueuePos.load(std::memory_order_relaxed);
+            }
+        }
+
+        slot->record = std::move(record);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool S2SLogger::tryPop(std::string& record)
+    {
+        if (!hasRecord()) return false;
+
+        Slot& slot = m_slots[m_dequeuePos & m_mask];
+        record = std::move(slot.record);
+        slot.record.clear();
+        slot.sequence.store(m_dequeuePos + m_mask + 1, std::memory_order_release);
+        m_dequeuePos++;
+        return true;
+    }
+
+    bool S2SLogger::hasRecord() const
+    {
+        return m_slots[m_dequeuePos & m_mask].sequence.load(std::memory_order_acquire) == m_dequeuePos + 1;
+    }
+
+    void S2SLogger::wakeWriter()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_wakeRequested = true;
+        m_wakeup.notify_one();
+    }
+
+    void S2SLogger::run()
+    {
+        std::string batch;
+        std::string record;
+        for (;;)
+        {
+            size_t taken = 0;
+            while (batch.size() < MAX_BATCH_BYTES && tryPop(record))
+            {
+                batch += record;
+                batch += '\n';
+                taken++;
+            }
+            bool full = batch.size() >= MAX_BATCH_BYTES;
+
+            uint64_t dropped = m_dropped.load(std::memory_order_relaxed);
+            if (dropped != m_droppedReported)
+            {
+                batch += '[';
+                appendTimestamp(batch);
+                batch += "] S2S log dropped " + std::to_string(dropped - m_droppedReported) + " records\n";
+                m_droppedReported = dropped;
+            }
+
+            if (!batch.empty())
+            {
+                writeBatch(batch);
+                batch.clear();
+            }
+
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (taken > 0)
+            {
+                m_writtenPos = m_dequeuePos;
+                m_written.notify_all();
+            }
+            if (full) continue;
+            if (m_stopping)
+            {
+                if (hasRecord()) continue;
+                break;
+            }
+
+            m_wakeup.wait_for(lock, WRITER_INTERVAL, [this]()
+            {
+                return m_wakeRequested || m_stopping;
+            });
+            m_wakeRequested = false;
+        }
+    }
+
+    void S2SLogger::writeBatch(std::string& batch)
+    {
+        std::unique_lock<std::mutex> lock(m_outputMutex);
+        Output& output = *m_output;
+        if (m_pathChanged)
+        {
+            m_pathChanged = false;
+            output.close();
+            output.path = m_pendingPath;
+            if (!output.path.empty() && !output.open(output.path))
+            {
+                fprintf(stderr, "Failed to open log file: %s\n", output.path.c_str());
+            }
+        }
+
+        if (!output.isOpen())
+        {
+            writeConsole(batch);
+        }
+        else if (!output.write(batch))
+        {
+            fprintf(stderr, "Failed to write to log file: %s\n", output.path.c_str());
+            //print to console if failed to write log to file
+            writeConsole(batch);
+        }
+    }
+
+    void S2SLogger::stop()
+    {
+        if (!m_thread.joinable()) return;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_stopping = true;
+            m_wakeup.notify_one();
+        }
+        m_thread.join();
+
+        // From now on, producers write their own records
+        m_stopped = true;
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        drainStopped();
+    }
+
+    void S2SLogger::drainStopped()
+    {
+        std::unique_lock<std::mutex> drainLock(m_drainMutex);
+        std::string batch;
+        std::string record;
+        while (tryPop(record))
+        {
+            batch += record;
+            batch += '\n';
+        }
+        if (!batch.empty())
+        {
+            writeBatch(batch);
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_writtenPos = m_dequeuePos;
+        m_written.notify_all();
+    }
+};
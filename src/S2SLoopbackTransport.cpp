@@ -0,0 +1,220 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "S2SLoopbackTransport.h"
+#include "S2SHttpReactor.h"
+#include "S2SJsonScanner.h"
+
+#include <algorithm>
+
+namespace BrainCloud
+{
+    namespace
+    {
+        // Text of a top-level member, or an empty string
+        std::string getMemberText(const S2SJsonScanner& scanner, const std::string& json, const std::string& key)
+        {
+            S2SJsonScanner::Range range;
+            if (!scanner.getMember(json, key, range)) return std::string();
+            return json.substr(range.first, range.second - range.first);
+        }
+
+        std::string answerDispatcherMessage(const std::string& message)
+        {
+            S2SJsonScanner scanner("");
+            scanner.feed(message);
+            std::string service = getMemberText(scanner, message, "service");
+
+            if (service == "\"authenticationV2\"")
+            {
+                return "{\"status\":200,\"data\":{\"sessionId\":\"loopbacksession\","
+                       "\"heartbeatSeconds\":1800,\"server_time\":0}}";
+            }
+            if (service == "\"rttRegistration\"")
+            {
+                return "{\"status\":200,\"data\":{\"endpoints\":["
+                       "{\"protocol\":\"ws\",\"host\":\"loopback\",\"port\":0,\"ssl\":false},"
+                       "{\"protocol\":\"tcp\",\"host\":\"loopback\",\"port\":0,\"ssl\":false}],"
+                       "\"auth\":{\"X-RTT-SECRET\":\"loopback\"}}}";
+            }
+
+            std::string data = getMemberText(scanner, message, "data");
+            return "{\"status\":200,\"data\":" + (data.empty() ? std::string("{}") : data) + "}";
+        }
+    }
+
+    std::shared_ptr<S2SLoopbackTransport> S2SLoopbackTransport::create(const std::shared_ptr<S2SHttpReactor>& reactor,
+                                                                       const Handler& handler)
+    {
+        return std::shared_ptr<S2SLoopbackTransport>(new S2SLoopbackTransport(reactor, handler));
+    }
+
+    S2STransportFactory S2SLoopbackTransport::factory(const Handler& handler)
+    {
+        return [handler](const std::string&, const std::shared_ptr<S2SHttpReactor>& reactor)
+        {
+            return create(reactor, handler);
+        };
+    }
+
+    std::string S2SLoopbackTransport::answerPacket(const std::string& body)
+    {
+        S2SJsonScanner scanner("messages");
+        scanner.feed(body);
+
+        std::string packetId = getMemberText(scanner, body, "packetId");
+        std::string answer = "{\"messageResponses\":[";
+        const auto& messages = scanner.getElements();
+        for (size_t i = 0; i < messages.size(); ++i)
+        {
+            if (i > 0) answer += ",";
+            answer += answerDispatcherMessage(body.substr(messages[i].first, messages[i].second - messages[i].first));
+        }
+        answer += "],\"packetId\":" + (packetId.empty() ? std::string("0") : packetId) + "}";
+        return answer;
+    }
+
+    S2SLoopbackTransport::S2SLoopbackTransport(const std::shared_ptr<S2SHttpReactor>& reactor,
+                                               const Handler& handler)
+        : m_reactor(reactor)
+        , m_handler(handler ? handler : Handler(answerPacket))
+    {
+    }
+
+    IS2STransport::TransferId S2SLoopbackTransport::post(const std::string& body, uint64_t timeoutMS,
+                                                         const DataCallback& onData, const Completion& completion)
+    {
+        TransferId id = m_nextId++;
+        m_postCount++;
+
+        auto pThis = shared_from_this();
+        auto posted = std::chrono::steady_clock::now();
+        m_reactor->post([pThis, id, body, onData, completion, posted]()
+        {
+            pThis->answer(id, body, onData, completion, posted);
+        });
+        return id;
+    }
+
+    void S2SLoopbackTransport::abort(TransferId id)
+    {
+        std::unique_lock<std::mutex> lock(m_abortedMutex);
+        m_aborted.push_back(id);
+        m_hasAborted = true;
+    }
+
+    void S2SLoopbackTransport::answer(TransferId id, const std::string& body, const DataCallback& onData,
+                                      const Completion& completion, std::chrono::steady_clock::time_point posted)
+    {
+        Response response;
+        if (m_hasAborted)
+        {
+            std::unique_lock<std::mutex> lock(m_abortedMutex);
+            auto it = std::find(m_aborted.begin(), m_aborted.end(), id);
+            if (it != m_aborted.end())
+            {
+                m_aborted.erase(it);
+                m_hasAborted = !m_aborted.empty();
+                response.code = CURLE_ABORTED_BY_CALLBACK;
+                response.error = "Aborted";
+            }
+        }
+
+        if (response.code == CURLE_OK)
+        {
+            response.body = m_handler(body);
+            if (response.body.empty())
+            {
+                response.code = CURLE_COULDNT_CONNECT;
+                response.error = "Loopback handler refused the packet";
+            }
+            else
+            {
+                response.requestSent = true;
+                response.bytesSent = body.size();
+                response.bytesReceived = response.body.size();
+                if (onData)
+                {
+                    onData(response.body);
+                }
+            }
+        }
+
+        response.totalTime = std::chrono::duration_cast<std::chrono::microseconds>(
+            std::chrono::steady_clock::now() - posted);
+        completion(response);
+    }
+
+    S2SLoopbackSocket::S2SLoopbackSocket(const Handler& handler)
+        : m_handler(handler ? handler : Handler(answerMessage))
+    {
+    }
+
+    S2SRTTSocketFactory S2SLoopbackSocket::factory(const Handler& handler,
+                                                   const std::function<void(S2SLoopbackSocket*)>& onOpen)
+    {
+        return [handler, onOpen](const std::string&, int, const std::map<std::string, std::string>&, bool) -> ISocket*
+        {
+            auto socket = new S2SLoopbackSocket(handler);
+            if (onOpen)
+            {
+                onOpen(socket);
+            }
+            return socket;
+        };
+    }
+
+    void S2SLoopbackSocket::answerMessage(S2SLoopbackSocket& socket, const std::string& message)
+    {
+        S2SJsonScanner scanner("");
+        scanner.feed(message);
+        if (getMemberText(scanner, message, "service") == "\"rtt\"" &&
+            getMemberText(scanner, message, "operation") == "\"CONNECT\"")
+        {
+            socket.push("{\"service\":\"rtt\",\"operation\":\"CONNECT\","
+                        "\"data\":{\"cxId\":\"loopbackcx\",\"heartbeatSeconds\":30}}");
+        }
+    }
+
+    void S2SLoopbackSocket::push(const std::string& message)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            if (m_closed) return;
+            m_messages.push_back(message);
+        }
+        m_condition.notify_one();
+    }
+
+    bool S2SLoopbackSocket::isValid()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        return !m_closed;
+    }
+
+    void S2SLoopbackSocket::send(const std::string& message)
+    {
+        if (!isValid()) return;
+        m_handler(*this, message);
+    }
+
+    std::string S2SLoopbackSocket::recv()
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_condition.wait(lock, [this]() { return m_closed || !m_messages.empty(); });
+
+        // Empty once closed, which ends the client's receive loop
+        if (m_messages.empty()) return std::string();
+        std::string message = std::move(m_messages.front());
+        m_messages.pop_front();
+        return message;
+    }
+
+    void S2SLoopbackSocket::close()
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_closed = true;
+            m_messages.clear();
+        }
+        m_condition.notify_all();
+    }
+};
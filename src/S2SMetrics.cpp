@@ -0,0 +1,185 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "S2SMetrics.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace BrainCloud
+{
+    const int S2SLatencyHistogram::SUB_BUCKET_BITS;
+    const int S2SLatencyHistogram::SUB_BUCKETS;
+    const int S2SLatencyHistogram::MAX_BITS;
+    const int S2SLatencyHistogram::BUCKETS;
+
+    S2SLatencyHistogram::S2SLatencyHistogram()
+        : m_buckets(BUCKETS, 0)
+    {
+    }
+
+    // Buckets 0 to 15 hold one value each. After that, bucket
+    // 16 * (e + 1) + m holds the values whose top 5 bits are 1m, shifted
+    // left by e.
+    size_t S2SLatencyHistogram::bucketIndex(uint64_t value)
+    {
+        if (value < (uint64_t)SUB_BUCKETS) return (size_t)value;
+
+        int msb = 63;
+        while (!(value >> msb)) msb--;
+        if (msb >= MAX_BITS) return BUCKETS - 1;
+
+        int shift = msb - SUB_BUCKET_BITS;
+        size_t mantissa = (size_t)(value >> shift) - SUB_BUCKETS;
+        return (size_t)SUB_BUCKETS * (shift + 1) + mantissa;
+    }
+
+    uint64_t S2SLatencyHistogram::bucketUpperBound(size_t index)
+    {
+        if (index < (size_t)SUB_BUCKETS) return index;
+        if (index == (size_t)BUCKETS - 1) return UINT64_MAX;
+
+        int shift = (int)(index / SUB_BUCKETS) - 1;
+        uint64_t mantissa = SUB_BUCKETS + index % SUB_BUCKETS;
+        return ((mantissa + 1) << shift) - 1;
+    }
+
+    void S2SLatencyHistogram::record(uint64_t valueUS)
+    {
+        m_buckets[bucketIndex(valueUS)]++;
+        if (m_count == 0 || valueUS < m_min) m_min = valueUS;
+        if (valueUS > m_max) m_max = valueUS;
+        m_count++;
+        m_sum += valueUS;
+    }
+
+    uint64_t S2SLatencyHistogram::getValueAtPercentile(double percentile) const
+    {
+        if (m_count == 0) return 0;
+
+        percentile = std::max(0.0, std::min(100.0, percentile));
+        uint64_t rank = (uint64_t)(percentile / 100.0 * (double)m_count + 0.5);
+        rank = std::max<uint64_t>(rank, 1);
+
+        uint64_t seen = 0;
+        for (size_t i = 0; i < m_buckets.size(); ++i)
+        {
+            seen += m_buckets[i];
+            if (seen >= rank)
+            {
+                return std::max(m_min, std::min(bucketUpperBound(i), m_max));
+            }
+        }
+        return m_max;
+    }
+
+    // Label values escape backslashes, quotes and line feeds
+    static std::string escapeLabel(const std::string& value)
+    {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value)
+        {
+            switch (c)
+            {
+                case '\\': escaped += "\\\\"; break;
+                case '"': escaped += "\\\""; break;
+                case '\n': escaped += "\\n"; break;
+                default: escaped += c; break;
+            }
+        }
+        return escaped;
+    }
+
+    static std::string formatSeconds(uint64_t microseconds)
+    {
+        char buffer[32];
+        snprintf(buffer, sizeof(buffer), "%.6f", (double)microseconds / 1000000.0);
+        return buffer;
+    }
+
+    static void writeMetric(std::string& out, const std::string& name, const char* type,
+                            const char* help, uint64_t value)
+    {
+        out += "# HELP " + name + " " + help + "\n";
+        out += "# TYPE " + name + " " + type + "\n";
+        out += name + " " + std::to_string(value) + "\n";
+    }
+
+    std::string formatPrometheus(const S2SStats& stats, const std::string& prefix)
+    {
+        std::string out;
+
+        if (!stats.latency.empty())
+        {
+            static const double QUANTILES[] = {0.5, 0.9, 0.99, 0.999};
+
+            std::string name = prefix + "_request_latency_seconds";
+            out += "# HELP " + name + " Time from queueing a request to its response\n";
+            out += "# TYPE " + name + " summary\n";
+            for (const auto& entry : stats.latency)
+            {
+                const auto& histogram = entry.second;
+                std::string label = "operation=\"" + escapeLabel(entry.first) + "\"";
+                for (double quantile : QUANTILES)
+                {
+                    char quantileText[16];
+                    snprintf(quantileText, sizeof(quantileText), "%g", quantile);
+                    out += name + "{" + label + ",quantile=\"" + quantileText + "\"} " +
+                           formatSeconds(histogram.getValueAtPercentile(quantile * 100.0)) + "\n";
+                }
+                out += name + "_sum{" + label + "} " + formatSeconds(histogram.getSum()) + "\n";
+                out += name + "_count{" + label + "} " + std::to_string(histogram.getCount()) + "\n";
+            }
+        }
+
+        writeMetric(out, prefix + "_request_queue_depth", "gauge",
+                    "Requests waiting to be sent", stats.requestQueueDepth);
+        writeMetric(out, prefix + "_request_queue_high_water", "gauge",
+                    "Most requests ever waiting to be sent", stats.requestQueueHighWater);
+        writeMetric(out, prefix + "_callback_queue_depth", "gauge",
+                    "Callbacks waiting for runCallbacks", stats.callbackQueueDepth);
+        writeMetric(out, prefix + "_callback_queue_high_water", "gauge",
+                    "Most callbacks ever waiting for runCallbacks", stats.callbackQueueHighWater);
+        writeMetric(out, prefix + "_callbacks_deferred_total", "counter",
+                    "Callbacks a runCallbacks budget left for a later call", stats.callbacksDeferred);
+        writeMetric(out, prefix + "_sent_bytes_total", "counter",
+                    "HTTP bytes sent to the dispatcher", stats.bytesSent);
+        writeMetric(out, prefix + "_received_bytes_total", "counter",
+                    "HTTP bytes received from the dispatcher", stats.bytesReceived);
+        writeMetric(out, prefix + "_authentications_total", "counter",
+                    "Successful authentications", stats.authentications);
+        writeMetric(out, prefix + "_authentication_failures_total", "counter",
+                    "Failed authentications", stats.authenticationFailures);
+        writeMetric(out, prefix + "_heartbeats_total", "counter",
+                    "Heartbeats sent", stats.heartbeats);
+        writeMetric(out, prefix + "_heartbeats_skipped_total", "counter",
+                    "Heartbeats skipped because other responses kept the session alive",
+                    stats.heartbeatsSkipped);
+
+        return out;
+    }
+
+    bool writePrometheus(const S2SStats& stats, const std::string& path, const std::string& prefix)
+    {
+        // Written next to the file then renamed over it, so a reader never
+        // sees it half written
+        std::string tempPath = path + ".tmp";
+        {
+            std::ofstream file(tempPath, std::ios::binary | std::ios::trunc);
+            if (!file) return false;
+            file << formatPrometheus(stats, prefix);
+            if (!file) return false;
+        }
+
+#if defined(_WIN32)
+        // rename doesn't replace an existing file on Windows
+        std::remove(path.c_str());
+#endif
+        if (std::rename(tempPath.c_str(), path.c_str()) != 0)
+        {
+            std::remove(tempPath.c_str());
+            return false;
+        }
+        return true;
+    }
+};
@@ -0,0 +1,250 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "S2STimerWheel.h"
+
+#include <algorithm>
+#include <utility>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace BrainCloud
+{
+    const int S2STimerWheel::LEVELS;
+    const int S2STimerWheel::SLOT_BITS;
+    const int S2STimerWheel::SLOTS;
+    const int32_t S2STimerWheel::NONE;
+
+    // Index of the lowest bit set. bits must not be 0.
+    static int lowestBit(uint64_t bits)
+    {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return (int)index;
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+
+    static uint64_t rotateRight(uint64_t bits, int count)
+    {
+        return count == 0 ? bits : (bits >> count) | (bits << (64 - count));
+    }
+
+    S2STimerWheel::S2STimerWheel(Clock::time_point start)
+        : m_start(start)
+    {
+        std::fill(&m_heads[0][0], &m_heads[0][0] + LEVELS * SLOTS, NONE);
+    }
+
+    uint64_t S2STimerWheel::toTick(Clock::time_point time, bool roundUp) const
+    {
+        if (time <= m_start) return 0;
+        auto elapsed = time - m_start;
+        auto ms = std::chrono::duration_cast<std::chrono::milliseconds>(elapsed);
+        uint64_t tick = (uint64_t)ms.count();
+        if (roundUp && ms < elapsed) tick++;
+        return tick;
+    }
+
+    S2STimerWheel::TimerId S2STimerWheel::add(Clock::time_point when, std::function<void()> function)
+    {
+        int32_t index;
+        if (!m_free.empty())
+        {
+            index = m_free.back();
+            m_free.pop_back();
+        }
+        else
+        {
+            index = (int32_t)m_nodes.size();
+            m_nodes.emplace_back();
+        }
+
+        Node& node = m_nodes[index];
+        node.generation++;
+        node.expires = toTick(when, true);
+        node.function = std::move(function);
+        place(index);
+        m_count++;
+
+        return ((uint64_t)node.generation << 32) | (uint32_t)index;
+    }
+
+    bool S2STimerWheel::cancel(TimerId id)
+    {
+        uint32_t index = (uint32_t)id;
+        if (index >= m_nodes.size()) return false;
+
+        Node& node = m_nodes[index];
+        if (node.level < 0 || node.generation != (uint32_t)(id >> 32)) return false;
+
+        unlink((int32_t)index);
+        release((int32_t)index);
+        return true;
+    }
+
+    // Puts a timer in the lowest level whose span reaches it
+    void S2STimerWheel::place(int32_t index)
+    {
+        Node& node = m_nodes[index];
+
+        uint64_t expires = std::max(node.expires, m_current);
+        uint64_t delta = expires - m_current;
+
+        // Keep clear of the top level slot being passed, so a far timer
+        // isn't mistaken for one due now
+        const uint64_t maxDelta = (1ull << (SLOT_BITS * LEVELS)) - (1ull << (SLOT_BITS * (LEVELS - 1)));
+        if (delta > maxDelta)
+        {
+            expires = m_current + maxDelta;
+            delta = maxDelta;
+        }
+
+        int level = 0;
+        while (level < LEVELS - 1 && delta >= (1ull << (SLOT_BITS * (level + 1))))
+        {
+            level++;
+        }
+        int slot = (int)((expires >> (SLOT_BITS * level)) & (SLOTS - 1));
+
+        node.level = level;
+        node.slot = slot;
+        node.prev = NONE;
+        node.next = m_heads[level][slot];
+        if (node.next != NONE)
+        {
+            m_nodes[node.next].prev = index;
+        }
+        m_heads[level][slot] = index;
+        m_occupied[level] |= 1ull << slot;
+    }
+
+    void S2STimerWheel::unlink(int32_t index)
+    {
+        Node& node = m_nodes[index];
+        if (node.prev != NONE)
+        {
+            m_nodes[node.prev].next = node.next;
+        }
+        else
+        {
+            m_heads[node.level][node.slot] = node.next;
+            if (node.next == NONE)
+            {
+                m_occupied[node.level] &= ~(1ull << node.slot);
+            }
+        }
+        if (node.next != NONE)
+        {
+            m_nodes[node.next].prev = node.prev;
+        }
+    }
+
+    void S2STimerWheel::release(int32_t index)
+    {
+        Node& node = m_nodes[index];
+        node.level = -1;
+        node.prev = NONE;
+        node.next = NONE;
+        node.function = nullptr;
+        m_free.push_back(index);
+        m_count--;
+    }
+
+    bool S2STimerWheel::nextEventTick(uint64_t& tick) const
+    {
+        bool found = false;
+        for (int level = 0; level < LEVELS; ++level)
+        {
+            if (!m_occupied[level]) continue;
+
+            // A slot of this level is handled at the start of its block,
+            // the first block not started before m_current
+            int shift = SLOT_BITS * level;
+            uint64_t block = (m_current + (1ull << shift) - 1) >> shift;
+            int start = (int)(block & (SLOTS - 1));
+            block += lowestBit(rotateRight(m_occupied[level], start));
+
+            uint64_t levelTick = block << shift;
+            if (!found || levelTick < tick)
+            {
+                tick = levelTick;
+                found = true;
+            }
+        }
+        return found;
+    }
+
+    void S2STimerWheel::advance(Clock::time_point now, std::vector<std::function<void()>>& due)
+    {
+        uint64_t nowTick = toTick(now, false);
+
+        uint64_t tick;
+        while (nextEventTick(tick) && tick <= nowTick)
+        {
+            m_current = tick;
+
+            // Upper levels first: what they move down to this tick's slot
+            // is due now
+            for (int level = LEVELS - 1; level >= 1; --level)
+            {
+                int shift = SLOT_BITS * level;
+                if (tick & ((1ull << shift) - 1)) continue;
+
+                int slot = (int)((tick >> shift) & (SLOTS - 1));
+                int32_t index = m_heads[level][slot];
+                m_heads[level][slot] = NONE;
+                m_occupied[level] &= ~(1ull << slot);
+                while (index != NONE)
+                {
+                    int32_t next = m_nodes[index].next;
+                    place(index);
+                    index = next;
+                }
+            }
+
+            int slot = (int)(tick & (SLOTS - 1));
+            int32_t index = m_heads[0][slot];
+            m_heads[0][slot] = NONE;
+            m_occupied[0] &= ~(1ull << slot);
+            while (index != NONE)
+            {
+                int32_t next = m_nodes[index].next;
+                due.push_back(std::move(m_nodes[index].function));
+                release(index);
+                index = next;
+            }
+        }
+
+        // Nothing waits on the ticks in between. The current tick stays
+        // open: timers added for it are due on the next call.
+        m_current = std::max(m_current, nowTick);
+    }
+
+    S2STimerWheel::Clock::duration S2STimerWheel::getWaitTime(Clock::time_point now,
+                                                              Clock::duration maxWait) const
+    {
+        uint64_t tick;
+        if (!nextEventTick(tick)) return maxWait;
+
+        auto when = m_start + std::chrono::milliseconds(tick);
+        if (when <= now) return Clock::duration::zero();
+        return std::min<Clock::duration>(when - now, maxWait);
+    }
+
+    void S2STimerWheel::clear()
+    {
+        // Nodes are kept, so ids handed out before can't match new timers
+        for (size_t i = 0; i < m_nodes.size(); ++i)
+        {
+            if (m_nodes[i].level >= 0)
+            {
+                release((int32_t)i);
+            }
+        }
+        std::fill(&m_heads[0][0], &m_heads[0][0] + LEVELS * SLOTS, NONE);
+        std::fill(m_occupied, m_occupied + LEVELS, 0);
+    }
+};
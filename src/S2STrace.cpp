@@ -0,0 +1,136 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "S2STrace.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+
+namespace BrainCloud
+{
+    S2SRequestTrace::Clock::duration S2SRequestTrace::getTotalTime() const
+    {
+        auto end = std::max(callbackInvoked, std::max(delivered, completed));
+        if (enqueued == Clock::time_point() || end < enqueued) return Clock::duration::zero();
+        return end - enqueued;
+    }
+
+    static std::string escapeJson(const std::string& value)
+    {
+        std::string escaped;
+        escaped.reserve(value.size());
+        for (char c : value)
+        {
+            switch (c)
+            {
+                case '\\': escaped += "\\\\"; break;
+                case '"': escaped += "\\\""; break;
+                case '\n': escaped += "\\n"; break;
+                case '\r': escaped += "\\r"; break;
+                case '\t': escaped += "\\t"; break;
+                default:
+                    if ((unsigned char)c < 0x20)
+                    {
+                        char buffer[8];
+                        snprintf(buffer, sizeof(buffer), "\\u%04x", (unsigned)(unsigned char)c);
+                        escaped += buffer;
+                    }
+                    else
+                    {
+                        escaped += c;
+                    }
+                    break;
+            }
+        }
+        return escaped;
+    }
+
+    namespace
+    {
+        using Clock = S2SRequestTrace::Clock;
+
+        struct EventWriter
+        {
+            EventWriter(std::string& out, Clock::time_point origin) : out(out), origin(origin) {}
+
+            std::string& out;
+            Clock::time_point origin;
+            bool first = true;
+
+            int64_t microseconds(Clock::time_point time) const
+            {
+                return std::chrono::duration_cast<std::chrono::microseconds>(time - origin).count();
+            }
+
+            // A complete ("X") event, skipped if either end is missing or it
+            // took no time
+            void span(const S2SRequestTrace& trace, const char* name, const char* category,
+                      Clock::time_point begin, Clock::time_point end, const std::string& args = "")
+            {
+                if (begin == Clock::time_point() || end == Clock::time_point() || end <= begin) return;
+
+                if (!first) out += ",\n";
+                first = false;
+
+                out += "{\"name\":\"";
+                out += name;
+                out += "\",\"cat\":\"";
+                out += category;
+                out += "\",\"ph\":\"X\",\"pid\":1,\"tid\":" + std::to_string(trace.id) +
+                       ",\"ts\":" + std::to_string(microseconds(begin)) +
+                       ",\"dur\":" + std::to_string(microseconds(end) - microseconds(begin));
+                if (!args.empty())
+                {
+                    out += ",\"args\":{" + args + "}";
+                }
+                out += "}";
+            }
+        };
+    }
+
+    std::string formatChromeTrace(const std::vector<S2SRequestTrace>& traces)
+    {
+        // Times are relative to the first request, steady_clock's epoch
+        // means nothing to the viewer
+        Clock::time_point origin;
+        for (const auto& trace : traces)
+        {
+            if (origin == Clock::time_point() || trace.enqueued < origin) origin = trace.enqueued;
+        }
+
+        std::string out = "{\"traceEvents\":[\n";
+        EventWriter writer(out, origin);
+        for (const auto& trace : traces)
+        {
+            auto end = trace.enqueued + trace.getTotalTime();
+            std::string name = escapeJson(trace.operation.empty() ? "request" : trace.operation);
+            std::string args = "\"packetId\":" + std::to_string(trace.packetId) +
+                               ",\"batchSize\":" + std::to_string(trace.batchSize) +
+                               ",\"retries\":" + std::to_string(trace.retries);
+            writer.span(trace, name.c_str(), "request", trace.enqueued, end, args);
+
+            writer.span(trace, "queued", "queue", trace.enqueued, trace.sent);
+            writer.span(trace, "dispatch", "queue", trace.sent, trace.transferStarted);
+
+            // Curl reports the phases it skipped, e.g. DNS and connect on a
+            // reused connection, as taking no time
+            writer.span(trace, "dns", "network", trace.transferStarted, trace.dnsDone);
+            writer.span(trace, "connect", "network", trace.dnsDone, trace.connectDone);
+            writer.span(trace, "tls", "network", trace.connectDone, trace.tlsDone);
+            auto waitStart = std::max(trace.connectDone, trace.tlsDone);
+            writer.span(trace, "server", "network", waitStart, trace.firstByte);
+            writer.span(trace, "download", "network", trace.firstByte, trace.completed);
+
+            writer.span(trace, "callback wait", "callback", trace.callbackQueued, trace.callbackInvoked);
+        }
+        out += "\n],\"displayTimeUnit\":\"ms\"}\n";
+        return out;
+    }
+
+    bool writeChromeTrace(const std::vector<S2SRequestTrace>& traces, const std::string& path)
+    {
+        std::ofstream file(path, std::ios::binary | std::ios::trunc);
+        if (!file) return false;
+        file << formatChromeTrace(traces);
+        return (bool)file;
+    }
+};
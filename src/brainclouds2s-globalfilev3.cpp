@@ -2,11 +2,11 @@
 
 #include "brainclouds2s-globalfilev3.h"
 #include "brainclouds2s.h"
+#include "S2SHttpReactor.h"
 #include "json/json.h"
 #include <curl/curl.h>
 
 #include <sstream>
-#include <thread>
 
 namespace BrainCloud
 {
@@ -41,12 +41,15 @@ namespace BrainCloud
 
     BrainCloudS2SGlobalFileV3::BrainCloudS2SGlobalFileV3(S2SContext* s2s)
         : _s2s(s2s)
-        , _generation(0)
+        , _uploads(std::make_shared<UploadQueue>())
     {
     }
 
-    void BrainCloudS2SGlobalFileV3::init(const std::string& serverUrl)
+    void BrainCloudS2SGlobalFileV3::init(const std::string& serverUrl,
+        const std::shared_ptr<S2SHttpReactor>& reactor)
     {
+        _reactor = reactor;
+
         const std::string needle = "s2sdispatcher";
         size_t pos = serverUrl.find(needle);
         if (pos != std::string::npos)
@@ -262,8 +265,43 @@ namespace BrainCloud
         bool overwriteIfPresent, const std::vector<uint8_t>& fileData,
         const S2SCallback& callback)
     {
-        log("[GlobalFileV3] Preparing upload: " + filename +
-            " (" + std::to_string(fileData.size()) + " bytes) treeId=" + treeId);
+        uploadGlobalFile(treeId, filename, overwriteIfPresent, fileData, S2SRequestOptions(), callback);
+    }
+
+    void BrainCloudS2SGlobalFileV3::uploadGlobalFile(
+        const std::string& treeId, const std::string& filename,
+        bool overwriteIfPresent, const std::vector<uint8_t>& fileData,
+        const S2SRequestOptions& options, const S2SCallback& callback)
+    {
+        std::shared_ptr<UploadQueue> uploads = _uploads;
+        auto upload = std::make_shared<Upload>();
+        upload->callback = callback;
+        upload->generation = uploads->generation.load();
+        upload->hasDeadline = options.timeoutMS > 0;
+        upload->deadline = std::chrono::steady_clock::now() +
+                           std::chrono::milliseconds(options.timeoutMS);
+        upload->cancelToken = options.cancelToken;
+
+        if (options.cancelToken)
+        {
+            std::weak_ptr<Upload> weakUpload = upload;
+            std::shared_ptr<S2SHttpReactor> reactor = _reactor;
+            upload->listenerId = options.cancelToken->addListener([uploads, weakUpload, reactor]()
+            {
+                auto upload = weakUpload.lock();
+                if (!upload) return;
+                finishUpload(uploads, upload, "{\"status\":900,\"reason_code\":" +
+                    std::to_string(S2S_REASON_REQUEST_CANCELLED) +
+                    ",\"status_message\":\"Upload cancelled\"}");
+                uint64_t transferId = upload->transferId;
+                if (transferId != 0 && reactor) reactor->abort(transferId);
+            });
+            if (upload->done) return;
+        }
+
+        if (s2s_should_log(S2SLogChannel::GlobalFileV3, S2SLogLevel::Info))
+            log("[GlobalFileV3] Preparing upload: " + filename +
+                " (" + std::to_string(fileData.size()) + " bytes) treeId=" + treeId);
 
         Json::Value data;
         data["treeId"] = treeId;
@@ -275,24 +313,30 @@ namespace BrainCloud
         std::string filenameCopy = filename;
         std::vector<uint8_t> dataCopy = fileData;
 
-        _s2s->request(buildGFV3Request("SYS_PREPARE_UPLOAD", data),
-            [this, uploadUrlCopy, filenameCopy, dataCopy, callback](const std::string& prepareResult)
+        // The prepare step shares the deadline and the cancel token. Its
+        // timeout or cancellation is reported as the upload's result.
+        _s2s->request(buildGFV3Request("SYS_PREPARE_UPLOAD", data), options,
+            [this, uploads, upload, uploadUrlCopy, filenameCopy, dataCopy](const std::string& prepareResult)
             {
+                if (upload->done) return;
+
                 Json::Value prepareData;
                 Json::Reader reader;
                 if (!reader.parse(prepareResult, prepareData) ||
                     prepareData["status"].asInt() != 200)
                 {
-                    log("[GlobalFileV3] SYS_PREPARE_UPLOAD failed: " + prepareResult);
-                    if (callback) callback(prepareResult);
+                    if (s2s_should_log(S2SLogChannel::GlobalFileV3, S2SLogLevel::Error))
+                        log("[GlobalFileV3] SYS_PREPARE_UPLOAD failed: ", prepareResult);
+                    finishUpload(uploads, upload, prepareResult);
                     return;
                 }
 
                 const Json::Value& fileDetails = prepareData["data"]["fileDetails"];
                 if (!fileDetails.isMember("uploadId") || fileDetails["uploadId"].asString().empty())
                 {
-                    log("[GlobalFileV3] SYS_PREPARE_UPLOAD missing uploadId: " + prepareResult);
-                    if (callback) callback(prepareResult);
+                    if (s2s_should_log(S2SLogChannel::GlobalFileV3, S2SLogLevel::Error))
+                        log("[GlobalFileV3] SYS_PREPARE_UPLOAD missing uploadId: ", prepareResult);
+                    finishUpload(uploads, upload, prepareResult);
                     return;
                 }
 
@@ -324,75 +368,115 @@ namespace BrainCloud
                     }
                 }
 
-                log("[GlobalFileV3] Uploading to: " + resolvedUrl);
-                sendFileUpload(resolvedUrl, filenameCopy, dataCopy, callback);
+                if (s2s_should_log(S2SLogChannel::GlobalFileV3, S2SLogLevel::Info))
+                    log("[GlobalFileV3] Uploading to: " + resolvedUrl);
+                sendFileUpload(resolvedUrl, filenameCopy, dataCopy, upload);
             });
     }
 
+    void BrainCloudS2SGlobalFileV3::finishUpload(const std::shared_ptr<UploadQueue>& uploads,
+        const std::shared_ptr<Upload>& upload, const std::string& result)
+    {
+        if (upload->done.exchange(true)) return;
+        if (upload->cancelToken) upload->cancelToken->removeListener(upload->listenerId);
+
+        std::unique_lock<std::mutex> lock(uploads->mutex);
+        if (uploads->generation.load() == upload->generation)
+            uploads->completed.push({upload->callback, result});
+    }
+
     void BrainCloudS2SGlobalFileV3::sendFileUpload(
         const std::string& uploadUrl, const std::string& filename,
-        const std::vector<uint8_t>& fileData, const S2SCallback& callback)
+        const std::vector<uint8_t>& fileData, const std::shared_ptr<Upload>& upload)
     {
-        int gen = _generation.load();
+        std::shared_ptr<UploadQueue> uploads = _uploads;
+
+        std::string timeoutResult = "{\"status\":900,\"reason_code\":" +
+            std::to_string(S2S_REASON_REQUEST_TIMEOUT) +
+            ",\"status_message\":\"Upload timeout\"}";
 
-        std::thread([this, gen, uploadUrl, filename, fileData, callback]()
+        // What the prepare step left of the deadline
+        long timeoutMS = 0;
+        if (upload->hasDeadline)
         {
-            CURL* curl = curl_easy_init();
-            if (!curl)
+            auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(
+                upload->deadline - std::chrono::steady_clock::now()).count();
+            if (remaining <= 0)
             {
-                std::unique_lock<std::mutex> lock(_uploadMutex);
-                if (_generation.load() == gen)
-                    _completedUploads.push({callback,
-                        "{\"status\":900,\"status_message\":\"cURL initialization failed\"}"});
+                finishUpload(uploads, upload, timeoutResult);
                 return;
             }
+            timeoutMS = (long)remaining;
+        }
 
-            // Build multipart/form-data body with curl_mime (curl >= 7.56)
-            curl_mime* mime = curl_mime_init(curl);
-            curl_mimepart* part = curl_mime_addpart(mime);
-            curl_mime_name(part, "file");
-            curl_mime_filename(part, filename.c_str());
-            curl_mime_type(part, "application/octet-stream");
-            curl_mime_data(part,
-                reinterpret_cast<const char*>(fileData.data()),
-                fileData.size());
-
-            char curlError[CURL_ERROR_SIZE] = "";
-            std::string result;
-
-            curl_easy_setopt(curl, CURLOPT_URL, uploadUrl.c_str());
-            curl_easy_setopt(curl, CURLOPT_MIMEPOST, mime);
-            curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, gfv3WriteData);
-            curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result);
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
-            curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
-            curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, curlError);
-
-            CURLcode rc = curl_easy_perform(curl);
+        CURL* curl = curl_easy_init();
+        if (!curl)
+        {
+            finishUpload(uploads, upload,
+                "{\"status\":900,\"status_message\":\"cURL initialization failed\"}");
+            return;
+        }
 
-            curl_mime_free(mime);
+        // Everything curl uses while the upload runs on the I/O thread
+        struct Transfer
+        {
+            curl_mime* mime = nullptr;
+            char curlError[CURL_ERROR_SIZE];
+            std::string result;
+        };
+        auto transfer = std::make_shared<Transfer>();
+        transfer->curlError[0] = '\0';
+
+        // Build multipart/form-data body with curl_mime (curl >= 7.56).
+        // curl_mime_data copies the bytes, fileData isn't needed afterwards.
+        transfer->mime = curl_mime_init(curl);
+        curl_mimepart* part = curl_mime_addpart(transfer->mime);
+        curl_mime_name(part, "file");
+        curl_mime_filename(part, filename.c_str());
+        curl_mime_type(part, "application/octet-stream");
+        curl_mime_data(part,
+            reinterpret_cast<const char*>(fileData.data()),
+            fileData.size());
+
+        curl_easy_setopt(curl, CURLOPT_URL, uploadUrl.c_str());
+        curl_easy_setopt(curl, CURLOPT_MIMEPOST, transfer->mime);
+        curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, gfv3WriteData);
+        curl_easy_setopt(curl, CURLOPT_WRITEDATA, &transfer->result);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, 0L);
+        curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, 0L);
+        curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, transfer->curlError);
+        if (timeoutMS > 0)
+            curl_easy_setopt(curl, CURLOPT_TIMEOUT_MS, timeoutMS);
+
+        upload->transferId = _reactor->add(curl, [uploads, upload, transfer, timeoutResult](CURL* curl, CURLcode rc)
+        {
+            curl_mime_free(transfer->mime);
             curl_easy_cleanup(curl);
 
             std::string response;
-            if (rc != CURLE_OK)
+            if (rc == CURLE_OPERATION_TIMEDOUT && upload->hasDeadline)
+            {
+                response = timeoutResult;
+            }
+            else if (rc != CURLE_OK)
             {
-                std::string errMsg = (curlError[0] != '\0') ? curlError : curl_easy_strerror(rc);
+                std::string errMsg = (transfer->curlError[0] != '\0') ?
+                    transfer->curlError : curl_easy_strerror(rc);
                 response = "{\"status\":900,\"status_message\":\"Upload error: " + errMsg + "\"}";
             }
             else
             {
-                response = result;
+                response = std::move(transfer->result);
             }
 
-            log("[GlobalFileV3] Upload complete: " +
-                (response.size() > 200 ? response.substr(0, 200) + "..." : response));
+            if (s2s_should_log(S2SLogChannel::GlobalFileV3, rc == CURLE_OK ? S2SLogLevel::Info : S2SLogLevel::Error))
+                log("[GlobalFileV3] Upload complete: ", response);
 
-            {
-                std::unique_lock<std::mutex> lock(_uploadMutex);
-                if (_generation.load() == gen)
-                    _completedUploads.push({callback, response});
-            }
-        }).detach();
+            finishUpload(uploads, upload, response);
+        });
+
+        // Cancelled while the transfer was being set up
+        if (upload->done) _reactor->abort(upload->transferId);
     }
 
     // --------------------------------------------------------------------------
@@ -401,37 +485,52 @@ namespace BrainCloud
 
     void BrainCloudS2SGlobalFileV3::runCallbacks()
     {
-        std::queue<UploadCompletion> pending;
+        while (runCallback())
         {
-            std::unique_lock<std::mutex> lock(_uploadMutex);
-            std::swap(pending, _completedUploads);
         }
+    }
 
-        while (!pending.empty())
-        {
-            auto& completion = pending.front();
-            if (completion.callback)
-                completion.callback(completion.result);
-            pending.pop();
-        }
+    bool BrainCloudS2SGlobalFileV3::runCallback()
+    {
+        UploadCompletion completion;
+        if (!_uploads->completed.pop(completion))
+            return false;
+
+        if (completion.callback)
+            completion.callback(completion.result);
+        return true;
+    }
+
+    bool BrainCloudS2SGlobalFileV3::hasPendingCallbacks() const
+    {
+        return !_uploads->completed.empty();
+    }
+
+    size_t BrainCloudS2SGlobalFileV3::getPendingCallbackCount() const
+    {
+        return _uploads->completed.size();
+    }
+
+    void BrainCloudS2SGlobalFileV3::setCallbackSignal(const std::shared_ptr<S2SCallbackSignal>& signal)
+    {
+        _uploads->completed.setSignal(signal);
     }
 
     void BrainCloudS2SGlobalFileV3::disconnect()
     {
-        std::unique_lock<std::mutex> lock(_uploadMutex);
-        ++_generation;
-        while (!_completedUploads.empty())
-            _completedUploads.pop();
+        std::unique_lock<std::mutex> lock(_uploads->mutex);
+        ++_uploads->generation;
+        _uploads->completed.clear();
     }
 
     // --------------------------------------------------------------------------
     // Private helpers
     // --------------------------------------------------------------------------
 
-    void BrainCloudS2SGlobalFileV3::log(const std::string& message)
+    void BrainCloudS2SGlobalFileV3::log(const std::string& message, const std::string& payload)
     {
         // Mirror the brainclouds2s s2s_log convention
-        s2s_log("[S2S] ", message);
+        s2s_log("[S2S] ", message, S2SLogPayload(S2SLogChannel::GlobalFileV3, payload));
     }
 
 } // namespace BrainCloud
@@ -0,0 +1,187 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "brainclouds2s-pool.h"
+#include "S2SFuture.h"
+
+#include "json/json.h"
+
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+namespace BrainCloud
+{
+    S2SSessionPoolRef S2SSessionPool::create(const std::string& appId,
+                                             const std::string& serverName,
+                                             const std::string& serverSecret,
+                                             const std::string& url,
+                                             size_t sessionCount,
+                                             bool autoAuth)
+    {
+        if (sessionCount == 0) return nullptr;
+
+        S2SSessionPoolRef pool(new S2SSessionPool());
+        for (size_t i = 0; i < sessionCount; ++i)
+        {
+            auto session = std::make_shared<Session>();
+            session->context = S2SContext::create(appId, serverName, serverSecret, url, autoAuth);
+            if (!session->context) return nullptr;
+            session->context->setCallbackSignal(pool->m_signal);
+            pool->m_sessions.push_back(session);
+        }
+        return pool;
+    }
+
+    void S2SSessionPool::setLogEnabled(bool enabled)
+    {
+        for (auto& session : m_sessions)
+        {
+            session->context->setLogEnabled(enabled);
+        }
+    }
+
+    void S2SSessionPool::authenticate(const S2SCallback& callback)
+    {
+        struct AuthState
+        {
+            std::mutex mutex;
+            size_t remaining;
+            std::string result;
+            bool failed = false;
+        };
+        auto state = std::make_shared<AuthState>();
+        state->remaining = m_sessions.size();
+
+        for (auto& session : m_sessions)
+        {
+            session->context->authenticate([state, callback](const std::string& result)
+            {
+                Json::Value data;
+                Json::Reader reader;
+                bool success = reader.parse(result, data) && data["status"].asInt() == 200;
+
+                bool done;
+                std::string ret;
+                {
+                    std::unique_lock<std::mutex> lock(state->mutex);
+                    if (!state->failed)
+                    {
+                        state->result = result;
+                        state->failed = !success;
+                    }
+                    done = --state->remaining == 0;
+                    ret = state->result;
+                }
+
+                if (done && callback) callback(ret);
+            });
+        }
+    }
+
+    std::string S2SSessionPool::authenticateSync()
+    {
+        std::vector<std::future<std::string>> futures;
+        for (auto& session : m_sessions)
+        {
+            futures.push_back(session->context->authenticateAsync());
+        }
+
+        // Same result as authenticate: first failure, otherwise the last result.
+        // Same 60 s as a context's authenticateSync, for all of them.
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(60);
+        std::string ret;
+        for (auto& future : futures)
+        {
+            auto result = s2sWaitForResult(future, deadline,
+                                           "{\"status\":900,\"message\":\"Authenticate timeout\"}");
+            Json::Value data;
+            Json::Reader reader;
+            if (!reader.parse(result, data) || data["status"].asInt() != 200)
+            {
+                return result;
+            }
+            ret = result;
+        }
+        return ret;
+    }
+
+    void S2SSessionPool::request(const std::string& json, const S2SCallback& callback)
+    {
+        dispatch(leastOutstanding(), json, callback);
+    }
+
+    std::shared_ptr<S2SSessionPool::Session> S2SSessionPool::leastOutstanding()
+    {
+        // Least outstanding first. Start the scan at a rotating index so idle
+        // sessions take turns instead of the first one getting everything.
+        size_t count = m_sessions.size();
+        size_t start = m_nextSession++ % count;
+        std::shared_ptr<Session> best = m_sessions[start];
+        for (size_t i = 1; i < count; ++i)
+        {
+            auto& session = m_sessions[(start + i) % count];
+            if (session->outstanding < best->outstanding)
+            {
+                best = session;
+            }
+        }
+        return best;
+    }
+
+    void S2SSessionPool::request(const std::string& json, const std::string& affinityKey,
+                                 const S2SCallback& callback)
+    {
+        size_t index = std::hash<std::string>()(affinityKey) % m_sessions.size();
+        dispatch(m_sessions[index], json, callback);
+    }
+
+    void S2SSessionPool::dispatch(const std::shared_ptr<Session>& session, const std::string& json,
+                                  const S2SCallback& callback)
+    {
+        session->outstanding++;
+
+        session->context->request(json, [session, callback](const std::string& result)
+        {
+            session->outstanding--;
+            if (callback) callback(result);
+        });
+    }
+
+    std::string S2SSessionPool::requestSync(const std::string& json)
+    {
+        auto session = leastOutstanding();
+        session->outstanding++;
+        auto ret = session->context->requestSync(json);
+        session->outstanding--;
+        return ret;
+    }
+
+    void S2SSessionPool::runCallbacks(uint64_t timeoutMS)
+    {
+        // Something was queued since the last run started. It may already
+        // have been run by it, which only skips one wait.
+        uint64_t count = m_signal->getCount();
+        bool queued = count != m_runCount;
+        m_runCount = count;
+
+        if (!queued && timeoutMS > 0 &&
+            m_signal->wait(count, std::chrono::milliseconds(timeoutMS)))
+        {
+            m_runCount = m_signal->getCount();
+        }
+
+        for (auto& session : m_sessions)
+        {
+            session->context->runCallbacks();
+        }
+    }
+
+    int S2SSessionPool::getOutstandingCount() const
+    {
+        int count = 0;
+        for (auto& session : m_sessions)
+        {
+            count += session->outstanding;
+        }
+        return count;
+    }
+};
@@ -5,9 +5,7 @@
 #include "ServiceName.h"
 #include "json/json.h"
 
-#include <chrono>
 #include <cstdlib>
-#include <thread>
 
 namespace BrainCloud
 {
@@ -67,6 +65,17 @@ namespace BrainCloud
         return out;
     }
 
+    BrainCloudS2SPRL::~BrainCloudS2SPRL()
+    {
+        if (_s2s && !_complete.exchange(true))
+        {
+            // Nothing may call back into this object anymore
+            if (_timeoutId != 0)
+                _s2s->cancelScheduledCallback(_timeoutId);
+            _s2s->getRTTService()->deregisterRTTCallback(ServiceName::Chat);
+        }
+    }
+
     bool BrainCloudS2SPRL::isComplete() const
     {
         return _complete.load();
@@ -118,18 +127,19 @@ namespace BrainCloud
         // Register for Chat RTT events to receive lobby state pushes
         s2s->getRTTService()->registerRTTCallback(ServiceName::Chat, this);
 
-        // Start timeout timer on a background thread
+        // Start timeout timer. It is cancelled when the flow completes or
+        // this object goes away, so it never outlives it.
         if (timeoutSecs > 0)
         {
-            std::thread([this, timeoutSecs]()
+            _timeoutId = s2s->scheduleCallback((uint64_t)timeoutSecs * 1000, [this]()
             {
-                std::this_thread::sleep_for(std::chrono::seconds(timeoutSecs));
+                _timeoutId = 0;
                 if (!_complete.load())
                 {
                     log("[PRL] Timeout elapsed — exiting.");
                     complete(false);
                 }
-            }).detach();
+            });
         }
 
         // Step 1: Enable RTT (this as IRTTConnectCallback)
@@ -264,6 +274,12 @@ namespace BrainCloud
         if (_complete.exchange(true)) return; // already completed
         _state = PrlState::Complete;
 
+        if (_s2s && _timeoutId != 0)
+        {
+            _s2s->cancelScheduledCallback(_timeoutId);
+            _timeoutId = 0;
+        }
+
         if (_s2s)
             _s2s->getRTTService()->deregisterRTTCallback(ServiceName::Chat);
 
@@ -25,9 +25,6 @@ void BrainCloudRTT::requestS2SConnection(IServerCallback* in_callback)
     json["service"] = "rttRegistration";
     json["operation"] = "REQUEST_SYSTEM_CONNECTION";
 
-    Json::StyledWriter writer;
-    printf("%s",writer.write(json).c_str());
-
     Json::FastWriter fw;
 
     m_S2SContext->request(fw.write(json), [this, in_callback](const std::string& result)
@@ -3,20 +3,31 @@
 #include "brainclouds2s-rtt.h"
 #include "brainclouds2s-globalfilev3.h"
 #include "RTTComms.h"
+#include "S2SCompletionQueue.h"
+#include "S2SCurlTransport.h"
+#include "S2SFuture.h"
+#include "S2SHttpReactor.h"
+#include "S2SJsonScanner.h"
+#include "S2STransport.h"
+#include "S2SUniqueFunction.h"
 #include <curl/curl.h>
 #include <json/json.h>
 
 
 #include <chrono>
+#include <cmath>
 #include <limits>
 #include <condition_variable>
+#include <deque>
+#include <future>
 #include <mutex>
-#include <queue>
+#include <random>
 #include <vector>
 #include <thread>
 #include <sstream>
 #include <iomanip>
 #include <cctype>
+#include <algorithm>
 #include "stdlib.h"
 
 
@@ -26,16 +37,95 @@ namespace BrainCloud {
 // Error code for expired session
     static const int SERVER_SESSION_EXPIRED = 40365;
 
+// Time a packet has when a request without a deadline or a cancel token
+// is in it
+    static const uint64_t DEFAULT_TRANSFER_TIMEOUT_MS = 30 * 1000;
+
 // 30 minutes heartbeat interval
     static const int HEARTBEAT_INTERVALE_MS = 60 * 30 * 1000;
 
+// The server drops a session it heard nothing from for about two heartbeat
+// intervals. It is renewed half an interval before that.
+    static const int SESSION_TIMEOUT_HEARTBEATS = 2;
+
     static std::string toString(const Json::Value &json) {
         Json::FastWriter writer;
         return writer.write(json);
     }
 
+    static bool isJsonSpace(char c) {
+        return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+    }
+
+    // Whether the json object at data[begin, end) has a top-level "status"
+    // member other than the number 200. Members of nested values are
+    // skipped, so user data carrying its own "status" doesn't count.
+    static bool hasErrorStatus(const std::string &data, size_t begin, size_t end) {
+        static const char STATUS[] = "status";
+        static const size_t STATUS_SIZE = sizeof(STATUS) - 1;
+
+        int depth = 0;
+        for (size_t i = begin; i < end; ++i) {
+            char c = data[i];
+            if (c == '{' || c == '[') {
+                depth++;
+            } else if (c == '}' || c == ']') {
+                if (--depth == 0) return false;
+            } else if (c == '"') {
+                // Skip the string, then see whether it was a member name
+                size_t stringBegin = i + 1;
+                for (++i; i < end && data[i] != '"'; ++i) {
+                    if (data[i] == '\\') ++i;
+                }
+                size_t stringEnd = i;
+                size_t p = i + 1;
+                while (p < end && isJsonSpace(data[p])) p++;
+                if (depth != 1 || p >= end || data[p] != ':') continue;
+                if (stringEnd - stringBegin != STATUS_SIZE ||
+                    data.compare(stringBegin, STATUS_SIZE, STATUS) != 0) continue;
+
+                // The whole value must be the number 200
+                p++;
+                while (p < end && isJsonSpace(data[p])) p++;
+                size_t valueBegin = p;
+                while (p < end && std::isdigit((unsigned char)data[p])) p++;
+                size_t valueEnd = p;
+                while (p < end && isJsonSpace(data[p])) p++;
+                bool is200 = valueEnd - valueBegin == 3 && data.compare(valueBegin, 3, "200") == 0 &&
+                             p < end && (data[p] == ',' || data[p] == '}');
+                if (!is200) return true;
+                i = valueEnd - 1;
+            }
+        }
+        return false;
+    }
+
+    // Whether a packet response, or one of its message responses, has a
+    // status other than 200, for logging it when its channel only logs
+    // errors. Scanned only, not parsed. scanner is the packet's response
+    // stream, if it was fed the whole body.
+    static bool hasErrorStatus(const std::string &data, const S2SJsonScanner *scanner) {
+        if (hasErrorStatus(data, 0, data.size())) return true;
+
+        S2SJsonScanner packetScanner("messageResponses");
+        if (!scanner) {
+            packetScanner.feed(data);
+            scanner = &packetScanner;
+        }
+        for (const auto &range : scanner->getElements()) {
+            if (hasErrorStatus(data, range.first, range.second)) return true;
+        }
+        return false;
+    }
+
     std::string g_logFilePath;
     bool g_showSecretLogs = false;
+    static std::atomic<S2SIOThreadMode> g_ioThreadMode(S2SIOThreadMode::SharedPerProcess);
+
+    // Read when a context is created, see setTransportFactory and setRTTSocketFactory
+    static std::mutex g_transportMutex;
+    static S2STransportFactory g_transportFactory;
+    static S2SRTTSocketFactory g_rttSocketFactory;
 
     class S2SContext_internal final
             : public S2SContext, public std::enable_shared_from_this<S2SContext_internal> {
@@ -55,56 +145,284 @@ namespace BrainCloud {
 
         void authenticate(const S2SCallback &callback) override;
 
+        std::future <std::string> authenticateAsync() override;
+
         std::string authenticateSync() override;
 
         void enableRTT(IRTTConnectCallback* callback) override;
 
+        bool enableRTT(const std::shared_ptr<IRTTConnectCallback> &callback) override;
+
         void request(
                 const std::string &json,
                 const S2SCallback &callback) override;
 
+        void request(const std::string &json,
+                     const S2SRequestOptions &options,
+                     const S2SCallback &callback) override;
+
+        std::future <std::string> requestAsync(const std::string &json) override;
+
+        void requestJson(Json::Value json, const S2SJsonCallback &callback) override;
+
+        void requestRaw(const std::string &json, const S2SCallback &callback) override;
+
         std::string requestSync(const std::string &json) override;
 
+        std::string requestSync(const std::string &json, const S2SRequestOptions &options) override;
+
         void runCallbacks(uint64_t timeoutMS = 0) override;
 
+        size_t runCallbacks(const S2SCallbackBudget &budget, uint64_t timeoutMS = 0) override;
+
+        void setCallbackSignal(const std::shared_ptr<S2SCallbackSignal> &signal) override;
+
+        S2SConnectionStats getConnectionStats() const override;
+
+        void setBatching(size_t maxMessages, size_t maxBytes) override;
+
+        void setMaxPacketsInFlight(size_t maxPackets) override;
+
+        void setRetryPolicy(const S2SRetryPolicy &policy) override;
+
+        S2SRetryStats getRetryStats() const override;
+
+        S2SStats getStats() const override;
+
+        void setTracing(const S2STraceOptions &options) override;
+
+        std::vector<S2SRequestTrace> getTraces() const override;
+
+        uint64_t scheduleCallback(uint64_t delayMS, const std::function<void()> &callback) override;
+
+        bool cancelScheduledCallback(uint64_t id) override;
+
     public: // "private" it's internal to this file only, so keep stuff visible
+        // The response can be swapped out of the reference instead of copied
+        using ResponseCallback = std::function<void(Json::Value &)>;
+        // Same for a response as text
+        using ResultCallback = std::function<void(std::string &)>;
+
+        // Queued for runCallbacks
+        using Completion = S2SUniqueFunction<void()>;
+
+        // A user callback and its response. Fits in a Completion without
+        // allocating.
         struct Callback {
             S2SCallback callback;
             std::string data;
+
+            void operator()() {
+                if (callback) {
+                    callback(data);
+                }
+            }
+        };
+
+        struct RequestState;
+
+        // A request's trace while it's under way. The end of its transfer
+        // and the end of its response's delivery both finish it, in either
+        // order: responses are handed out while the body is still coming in.
+        struct TraceRecord {
+            S2SRequestTrace trace;
+            std::atomic<int> pending{2};
+            // Set on the delivering thread once the response is queued for
+            // runCallbacks; delivery then ends when it's called
+            bool callbackQueued = false;
         };
 
         struct Request {
+            // The message, or the whole packet when isPacket is set
             Json::Value json;
-            S2SCallback callback;
+            // Called with the message's response, or with the whole packet
+            // response when isPacket is set
+            ResponseCallback callback;
+            // Raw messages are sent and answered as text, never parsed
+            std::string raw;
+            ResultCallback rawCallback;
+            bool isRaw;
+            bool isPacket;
+            size_t size;
+            // Queue order, kept when a refused packet is put back in the queue
+            uint64_t sequence;
+            // Only for requests with a deadline or a cancel token
+            std::shared_ptr<RequestState> state;
+            // Already sent again under a new session once
+            bool replayed = false;
+            // "service.operation", for the latency metrics
+            std::string operation;
+            std::chrono::steady_clock::time_point queuedAt;
+            // Only while tracing is on
+            std::shared_ptr<TraceRecord> trace;
+        };
+
+        using RequestBatch = std::vector <Request>;
+
+        // A request sent with a deadline or a cancel token. The response, the
+        // deadline and the cancel token race to claim it; only the first one
+        // calls the completion.
+        struct RequestState {
+            std::atomic<bool> done{false};
+            ResultCallback completion;
+            S2SCancelTokenRef cancelToken;
+            std::atomic<uint64_t> listenerId{0};
+            // Deadline timer, dropped once the request is claimed
+            std::shared_ptr<S2SHttpReactor> reactor;
+            std::atomic<uint64_t> deadlineTimer{0};
+            // Empty without a deadline
+            std::chrono::steady_clock::time_point deadline;
+            bool idempotent = false;
+            // Batch it was sent in, while in flight. Guarded by m_requestsMutex
+            const RequestBatch *batch = nullptr;
+
+            bool claim();
+        };
+
+        // Message responses of a packet, handed out as they arrive
+        struct ResponseStream {
+            S2SJsonScanner scanner{"messageResponses"};
+            size_t delivered = 0;
+            // The session expired: the rest of the packet is sent again
+            bool expired = false;
+        };
+
+        // Why a transfer failed, with the status 900 message for the callbacks
+        struct TransferError {
+            CURLcode code;
+            // Whether any of the request went out, so the server may have run it
+            bool requestSent;
+            std::string message;
         };
 
+        using TransferErrorCallback = std::function<void(const TransferError &)>;
+
+        // Phases of a transfer from the transport's timing, filled on the I/O
+        // thread before its callbacks are called
+        struct TransferTiming {
+            std::chrono::steady_clock::time_point started;
+            std::chrono::steady_clock::time_point dnsDone;
+            std::chrono::steady_clock::time_point connectDone;
+            std::chrono::steady_clock::time_point tlsDone;
+            std::chrono::steady_clock::time_point firstByte;
+            std::chrono::steady_clock::time_point completed;
+        };
+
+        // A packet in flight, kept as sent so it can be resent as is
+        struct Packet {
+            std::shared_ptr<RequestBatch> batch;
+            // Only for message packets
+            std::shared_ptr<ResponseStream> stream;
+            std::string data;
+            int generation;
+            // Session it was sent under, see m_sessionGeneration
+            uint64_t sessionGeneration;
+            int packetId;
+            // Send order, and whether other packets were in flight at the time
+            uint64_t sendIndex;
+            bool pipelined;
+            int retries = 0;
+            // Error to hand out if it ends up not being resent
+            std::string lastError;
+            // Only when some of its requests are traced
+            std::shared_ptr<TransferTiming> timing;
+        };
+
+        // Completions passed to the functions below are called on the I/O
+        // thread, or right away on the calling thread for early errors.
         void authenticateInternal(const AuthenticateCallback &callback);
 
-        void onAuthenticateResult(const Json::Value &json, const S2SCallback &callback);
+        Request makeAuthRequest(const AuthenticateCallback &callback);
+
+        void reauthenticate();
+
+        bool isSessionNearExpiry(std::chrono::steady_clock::time_point now) const;
+
+        RequestBatch disconnectAndTakeQueue();
+
+        static void failRequests(const RequestBatch &requests, size_t first, const Json::Value &error);
+
+        // completeOnSuccess: false when a request authenticates on auto auth,
+        // its completion then answers the request itself
+        void authenticateWithCompletion(const ResultCallback &completion, bool completeOnSuccess);
+
+        void onAuthenticateResult(const Json::Value &json, const ResultCallback &completion,
+                                  bool completeOnSuccess);
+
+        void requestWithCompletion(const std::string &json, const ResultCallback &completion);
+
+        void requestWithOptions(const std::string &json, const S2SRequestOptions &options,
+                                const ResultCallback &completion);
+
+        void giveUp(const std::shared_ptr<RequestState> &state, std::string result);
+
+        void queueRequest(const std::string &json, const ResultCallback &completion,
+                          const std::shared_ptr<RequestState> &state = nullptr);
+
+        void queueMessage(Json::Value &json, size_t size, const ResponseCallback &callback,
+                          const std::shared_ptr<RequestState> &state = nullptr);
 
-        void queueRequest(const std::string &json, const S2SCallback &callback);
+        void queueRawMessage(const std::string &json, const ResultCallback &callback);
 
-        void queueRequestPacket(const Json::Value &json, const S2SCallback &callback);
+        void recordLatency(const Request &request, std::chrono::steady_clock::time_point now);
 
-        void s2sRequest(const Json::Value &json, const S2SCallback &callback);
+        void beginDelivery(const Request &request);
 
-        void curlSend(const std::string &data,
-                      const S2SCallback &successCallback,
-                      const S2SCallback &errorCallback);
+        void endDelivery(const Request &request);
 
-        void queueCallback(const Callback &callback);
+        void finishTransferTraces(const Packet &packet);
+
+        void finishTrace(const std::shared_ptr<TraceRecord> &record);
+
+        void queueRequestInternal(Request &&request);
+
+        bool canSendPacket();
+
+        void sendQueuedPackets();
+
+        void s2sRequest();
+
+        void sendPacket(const std::shared_ptr<Packet> &packet);
+
+        void onPacketResponse(const std::shared_ptr<Packet> &packet, bool fromServer,
+                              const std::string &data);
+
+        bool retryPacket(const std::shared_ptr<Packet> &packet, const TransferError &error);
+
+        void resendPacket(const std::shared_ptr<Packet> &packet);
+
+        bool isIdempotent(const RequestBatch &batch) const;
+
+        static bool isAbandoned(const RequestBatch &batch);
+
+        void deliverResponses(RequestBatch &batch, ResponseStream &stream,
+                              const std::string &data);
+
+        IS2STransport::TransferId httpPost(const std::string &data, uint64_t timeoutMS,
+                                           const S2SCallback &successCallback,
+                                           const TransferErrorCallback &errorCallback,
+                                           const S2SCallback &dataCallback = nullptr,
+                                           const std::shared_ptr<TransferTiming> &timing = nullptr);
+
+        void queueCallback(Completion &&callback);
 
         void startHeartbeat();
 
+        void scheduleHeartbeat(std::chrono::steady_clock::time_point when);
+
+        void onHeartbeatTimer(uint64_t generation);
+
         void stopHeartbeat();
 
         void disconnect();
 
         void sendHeartbeat();
 
-        void processCallbacks();
+        bool runCallback();
 
-        void popRequest();
+        bool hasPendingCallbacks() const;
+
+        size_t getPendingCallbackCount() const;
 
         void doNextRequest();
 
@@ -120,27 +438,150 @@ namespace BrainCloud {
         std::atomic <State> m_state;
         int m_packetId = 0;
 
-        std::chrono::system_clock::time_point m_heartbeatStartTime;
-        std::chrono::milliseconds m_heartbeatInverval;
-
         // Callbacks queue
-        std::mutex m_callbacksMutex;
-        std::condition_variable m_callbacksCond;
-        std::queue <Callback> m_callbacks;
-
-        std::mutex m_requestsMutex;
+        S2SCompletionQueue<Completion> m_callbacks;
+
+        // runCallbacks' sources take turns: the S2S callbacks, the RTT
+        // events and the upload completions. The next call starts with the
+        // one after the last to go.
+        int m_nextCallbackSource = 0;
+        std::atomic <uint64_t> m_callbacksDeferred{0};
+
+        // Timers of scheduleCallback that weren't called yet, by id. A call
+        // already queued is dropped once its id is gone.
+        std::mutex m_scheduledCallbacksMutex;
+        std::map<uint64_t, S2SHttpReactor::TimerId> m_scheduledCallbacks;
+        uint64_t m_nextScheduledCallbackId = 1;
+
+        // Requests waiting to be sent. A batch being sent is moved out of
+        // the queue until its response comes back.
+        mutable std::mutex m_requestsMutex;
         std::vector <Request> m_requestQueue;
-
-
+        // Starts at 1: 0 keeps a renewed session's authentication in front
+        uint64_t m_nextSequence = 1;
+        size_t m_packetsInFlight = 0;
+        bool m_exclusiveInFlight = false;
+        int m_queueGeneration = 0;
+        uint64_t m_packetsSent = 0;
+
+        // Session expiry. Bumped when the session is renewed, so packets
+        // still in flight under the old one don't renew it again. The
+        // session is renewed when it nears expiry (isSessionNearExpiry),
+        // by the heartbeat timer or before sending.
+        uint64_t m_sessionGeneration = 0;
+        std::chrono::steady_clock::time_point m_lastServerResponse;
+
+        // Heartbeat timer on the I/O thread while authenticated. It is
+        // pushed back while other responses keep the session alive. The
+        // generation drops a timer already running when it was stopped.
+        std::chrono::milliseconds m_heartbeatInterval{HEARTBEAT_INTERVALE_MS};
+        S2SHttpReactor::TimerId m_heartbeatTimer = 0;
+        uint64_t m_heartbeatGeneration = 0;
+
+        // Transfers of the batches in flight that hold requests with a
+        // deadline or a cancel token, to abort them once nothing waits on them
+        std::map<const RequestBatch *, IS2STransport::TransferId> m_inFlightTransfers;
+
+        // Send window: how many packets can be waiting for a response at
+        // once. Falls back to 1 for good if the server refuses a packet sent
+        // while others were in flight.
+        size_t m_maxPacketsInFlight = 1;
+        bool m_windowFallback = false;
+
+        // Batching: how many queued messages can be coalesced into one packet
+        size_t m_batchMaxMessages = 1;
+        size_t m_batchMaxBytes = 0;
+
+        // Retries of packets that failed at the transport level
+        S2SRetryPolicy m_retryPolicy;
+        double m_retryTokens = 0;
+        std::minstd_rand m_retryRandom{std::random_device()()};
+        std::atomic <uint64_t> m_retryCount{0};
+        std::atomic <uint64_t> m_retryGiveUpCount{0};
+        std::atomic <uint64_t> m_retryBudgetExhaustedCount{0};
+
+        // Metrics. Latencies are recorded on the I/O thread as responses are
+        // handed out; the high-water marks are guarded by the mutex of their
+        // queue.
+        mutable std::mutex m_statsMutex;
+        std::map<std::string, S2SLatencyHistogram> m_latency;
+        size_t m_requestQueueHighWater = 0;
+        std::atomic <uint64_t> m_bytesSent{0};
+        std::atomic <uint64_t> m_bytesReceived{0};
+        std::atomic <uint64_t> m_authCount{0};
+        std::atomic <uint64_t> m_authFailureCount{0};
+        std::atomic <uint64_t> m_heartbeatCount{0};
+        std::atomic <uint64_t> m_heartbeatSkippedCount{0};
+
+        // Request tracing, see setTracing. The flag is read without the
+        // lock when requests are queued.
+        std::atomic <bool> m_traceEnabled{false};
+        mutable std::mutex m_traceMutex;
+        S2STraceOptions m_traceOptions;
+        std::deque<S2SRequestTrace> m_traces;
+
+        // Packets go through the transport, curl unless setTransportFactory
+        // says otherwise. Its callbacks and our timers run on the reactor's
+        // I/O thread.
+        std::shared_ptr <S2SHttpReactor> m_reactor;
+        IS2STransportRef m_transport;
+        std::atomic <uint64_t> m_httpRequestCount;
+        std::atomic <uint64_t> m_newConnectionCount;
 
         // RTT
         RTTComms * m_rttComms;
         BrainCloudRTT * m_rttService;
+        // Connect callback given to enableRTT by shared_ptr, kept while
+        // RTTComms may call it
+        std::shared_ptr<IRTTConnectCallback> m_rttConnectCallback;
 
         // GlobalFileV3
         BrainCloudS2SGlobalFileV3 * m_globalFileV3;
     };
 
+    S2SCancelTokenRef S2SCancelToken::create() {
+        return S2SCancelTokenRef(new S2SCancelToken());
+    }
+
+    void S2SCancelToken::cancel() {
+        std::map<uint64_t, std::function<void()>> listeners;
+        {
+            std::unique_lock <std::mutex> lock(m_mutex);
+            if (m_cancelled) return;
+            m_cancelled = true;
+            std::swap(listeners, m_listeners);
+        }
+
+        // Outside the lock: listeners remove themselves
+        for (auto &listener : listeners) {
+            listener.second();
+        }
+    }
+
+    bool S2SCancelToken::isCancelled() const {
+        std::unique_lock <std::mutex> lock(m_mutex);
+        return m_cancelled;
+    }
+
+    uint64_t S2SCancelToken::addListener(const std::function<void()> &listener) {
+        {
+            std::unique_lock <std::mutex> lock(m_mutex);
+            if (!m_cancelled) {
+                uint64_t id = m_nextListenerId++;
+                m_listeners[id] = listener;
+                return id;
+            }
+        }
+
+        listener();
+        return 0;
+    }
+
+    void S2SCancelToken::removeListener(uint64_t id) {
+        std::unique_lock <std::mutex> lock(m_mutex);
+        m_listeners.erase(id);
+    }
+
     S2SContextRef S2SContext::create(const std::string &appId,
                                      const std::string &serverName,
                                      const std::string &serverSecret,
@@ -158,7 +599,8 @@ namespace BrainCloud {
                                              const std::string &serverSecret,
                                              const std::string &url,
                                              bool autoAuth)
-            : m_state(State::Disconnected), m_heartbeatInverval(HEARTBEAT_INTERVALE_MS), m_autoAuth(autoAuth),
+            : m_state(State::Disconnected), m_autoAuth(autoAuth),
+              m_httpRequestCount(0), m_newConnectionCount(0),
               m_rttComms(new RTTComms(this))
 {
         m_appId = appId;
@@ -166,12 +608,29 @@ namespace BrainCloud {
         m_serverSecret = serverSecret;
         m_url = url;
         m_rttService = new BrainCloudRTT(m_rttComms, this);
+        m_reactor = g_ioThreadMode == S2SIOThreadMode::PerContext ?
+                    S2SHttpReactor::create() : S2SHttpReactor::getShared();
         m_globalFileV3 = new BrainCloudS2SGlobalFileV3(this);
-        m_globalFileV3->init(url);
+        m_globalFileV3->init(url, m_reactor);
+
+        S2STransportFactory transportFactory;
+        S2SRTTSocketFactory rttSocketFactory;
+        {
+            std::unique_lock <std::mutex> lock(g_transportMutex);
+            transportFactory = g_transportFactory;
+            rttSocketFactory = g_rttSocketFactory;
+        }
+        if (transportFactory) {
+            m_transport = transportFactory(url, m_reactor);
+        }
+        if (!m_transport) {
+            m_transport = S2SCurlTransport::create(url, m_reactor);
+        }
+
         if (m_rttComms)
         {
             m_rttComms->resetCommunication();
-            m_rttComms->initialize();
+            m_rttComms->initialize(m_reactor, rttSocketFactory);
         }
     }
 
@@ -196,6 +655,11 @@ namespace BrainCloud {
     }
 
     void S2SContext_internal::authenticateInternal(const AuthenticateCallback &callback) {
+        m_state = State::Authenticating;
+        queueRequestInternal(makeAuthRequest(callback));
+    }
+
+    S2SContext_internal::Request S2SContext_internal::makeAuthRequest(const AuthenticateCallback &callback) {
         // Build the authentication json
         Json::Value json(Json::ValueType::objectValue);
         json["packetId"] = 0;
@@ -211,40 +675,42 @@ namespace BrainCloud {
         messages.append(message);
         json["messages"] = messages;
 
-        m_state = State::Authenticating;
         auto pThis = shared_from_this();
-        queueRequestPacket(json, [pThis, callback](const std::string &dataStr) {
-            Json::Value data;
-            Json::Reader reader;
-            bool parsingSuccessful = reader.parse(dataStr.c_str(), data);
-            if (!parsingSuccessful) {
-                Json::Value json(Json::ValueType::objectValue);
-                json["status"] = 900;
-                json["message"] = "Failed to parse json";
-                callback(json);
-                return;
-            }
-
+        Request request;
+        request.json = json;
+        request.isRaw = false;
+        request.isPacket = true;
+        request.size = 0;
+        request.operation = "authenticationV2.AUTHENTICATE";
+        request.callback = [pThis, callback](const Json::Value &data) {
             const auto &messageResponses = data["messageResponses"];
             if (!messageResponses.isNull() &&
                 messageResponses.size() > 0 &&
                 messageResponses[0]["status"].isInt() &&
                 messageResponses[0]["status"].asInt() == 200) {
                 const auto &message = messageResponses[0];
-
-                pThis->m_state = State::Authenticated;
-                pThis->m_packetId = data["packetId"].asInt() + 1;
                 const auto &messageData = message["data"];
-                pThis->m_sessionId = messageData["sessionId"].asString();
+                pThis->m_authCount++;
+
                 const auto &heartbeatSeconds = messageData["heartbeatSeconds"];
-                if (heartbeatSeconds.isInt()) {
-                    pThis->m_heartbeatInverval =
-                            std::chrono::milliseconds(heartbeatSeconds.asInt() * 1000);
+                {
+                    std::unique_lock <std::mutex> lock(pThis->m_requestsMutex);
+                    pThis->m_packetId = data["packetId"].asInt() + 1;
+                    pThis->m_sessionId = messageData["sessionId"].asString();
+                    pThis->m_state = State::Authenticated;
+                    if (heartbeatSeconds.isInt()) {
+                        pThis->m_heartbeatInterval = std::chrono::milliseconds(heartbeatSeconds.asInt() * 1000);
+                    }
+                    pThis->startHeartbeat();
                 }
 
-                pThis->startHeartbeat();
                 callback(message);
+            } else if (data["status"].isInt() && data["status"].asInt() == 900) {
+                // Client side error (transport, parsing), already explained
+                pThis->m_authFailureCount++;
+                callback(data);
             } else {
+                pThis->m_authFailureCount++;
                 Json::Value json(Json::ValueType::objectValue);
                 json["status"] = 900;
                 json["message"] = "Malformed json";
@@ -252,320 +718,944 @@ namespace BrainCloud {
             }
 
             s2s_log("Session ID:", pThis->m_sessionId);
+        };
+        return request;
+    }
+
+    // Puts an authentication in front of the queue, so the session is
+    // renewed before anything else is sent. m_requestsMutex must be held.
+    void S2SContext_internal::reauthenticate() {
+        s2s_log("[S2S] Session expired, authenticating again");
+        m_sessionGeneration++;
+        m_state = State::Authenticating;
+        stopHeartbeat();
+
+        auto pThis = shared_from_this();
+        Request request = makeAuthRequest([pThis](const Json::Value &result) {
+            if (result["status"].asInt() == 200) return;
+
+            // Nothing can be sent without a session
+            auto queue = pThis->disconnectAndTakeQueue();
+            failRequests(queue, 0, result);
         });
+        // Ahead of the packets in flight, which are put back in the queue
+        // when they come back expired
+        request.sequence = 0;
+        m_requestQueue.insert(m_requestQueue.begin(), std::move(request));
     }
 
-    void S2SContext_internal::queueRequest(
-            const std::string &json, const S2SCallback &callback) {
-        // Build packet json
-        Json::Value packet(Json::ValueType::objectValue);
-        Json::Value messages(Json::ValueType::arrayValue);
+    // Whether the server may drop the session soon, having heard nothing
+    // for most of the time it keeps one. m_requestsMutex must be held.
+    bool S2SContext_internal::isSessionNearExpiry(std::chrono::steady_clock::time_point now) const {
+        return now - m_lastServerResponse >
+               SESSION_TIMEOUT_HEARTBEATS * m_heartbeatInterval - m_heartbeatInterval / 2;
+    }
 
+    void S2SContext_internal::queueRequest(
+            const std::string &json, const ResultCallback &completion,
+            const std::shared_ptr<RequestState> &state) {
         // Parse user json
+        Json::Value data;
         {
-            Json::Value data;
             Json::Reader reader;
             bool parsingSuccessful = reader.parse(json.c_str(), data);
             if (!parsingSuccessful) {
                 s2s_log("[S2S Error] Failed to parse user json");
-                if (callback) {
-                    callback("{\"status\":900,\"message\":\"Failed to parse user json\"}");
+                if (completion) {
+                    std::string error = "{\"status\":900,\"message\":\"Failed to parse user json\"}";
+                    completion(error);
                 }
                 return;
             }
-            messages.append(data);
         }
 
-        packet["messages"] = messages;
-
-        auto pThis = shared_from_this();
-        queueRequestPacket(packet, [pThis, callback](const std::string &dataStr) {
-            Json::Value data;
-            Json::Reader reader;
-            bool parsingSuccessful = reader.parse(dataStr.c_str(), data);
-            if (!parsingSuccessful) {
-                Json::Value json(Json::ValueType::objectValue);
-                json["status"] = 900;
-                json["message"] = "Failed to parse json";
-
-                if (callback) {
-                    std::string callback_message = toString(json);
-                    callback(callback_message);
-                }
-                return;
+        queueMessage(data, json.size(), [completion](Json::Value &message) {
+            if (completion) {
+                std::string result = toString(message);
+                completion(result);
             }
+        }, state);
+    }
 
-            const auto &messageResponses = data["messageResponses"];
-            if (!messageResponses.isNull() &&
-                messageResponses.size() > 0 &&
-                messageResponses[0]["status"].isInt() &&
-                messageResponses[0]["status"].asInt() == 200) {
-                const auto &message = messageResponses[0];
+    // A string member of the user's message, "" if it's missing or the
+    // message isn't an object. Reads without adding the member.
+    static std::string getMemberString(const Json::Value &json, const char *name) {
+        if (!json.isObject()) return "";
+        const Json::Value &value = json[name];
+        return value.isString() ? value.asString() : "";
+    }
 
-                if (callback) {
-                    std::string callback_message = toString(message);
-                    callback(callback_message);
-                }
+    // Queues one message. json is swapped into the queue. The callback gets
+    // the message's response, or a status 900 error.
+    void S2SContext_internal::queueMessage(Json::Value &json, size_t size,
+                                           const ResponseCallback &callback,
+                                           const std::shared_ptr<RequestState> &state) {
+        Request request;
+        request.operation = getMemberString(json, "service") + "." + getMemberString(json, "operation");
+        request.json.swap(json);
+        request.isRaw = false;
+        request.isPacket = false;
+        request.size = size;
+        request.state = state;
+        request.callback = [callback](Json::Value &message) {
+            if (!callback) return;
+
+            if (message["status"].isInt() &&
+                (message["status"].asInt() == 200 || message["status"].asInt() == 900)) {
+                // Success, or a client side error (transport, parsing) that
+                // already explains itself
+                callback(message);
             } else {
                 Json::Value json(Json::ValueType::objectValue);
                 json["status"] = 900;
                 json["message"] = "Malformed json";
-
-                if (callback) {
-                    std::string callback_message = toString(json);
-                    callback(callback_message);
-                }
+                callback(json);
             }
-        });
+        };
+        queueRequestInternal(std::move(request));
     }
 
-    void S2SContext_internal::queueRequestPacket(const Json::Value &json, const S2SCallback &callback) {
-        m_requestsMutex.lock();
-        m_requestQueue.push_back({json, callback});
-
-        if (m_requestQueue.size() == 1) {
-            s2sRequest(json, callback);
+    // "service.operation" of a raw message, found without parsing it
+    static std::string getOperationName(const std::string &json) {
+        S2SJsonScanner scanner("");
+        scanner.feed(json);
+
+        std::string name;
+        S2SJsonScanner::Range range;
+        for (const char *key : {"service", "operation"}) {
+            if (!name.empty()) name += ".";
+            // Strings come back with their quotes
+            if (scanner.getMember(json, key, range) && range.second - range.first >= 2) {
+                name.append(json, range.first + 1, range.second - range.first - 2);
+            }
         }
+        return name;
+    }
 
-        m_requestsMutex.unlock();
+    // Queues one message as is. The callback gets the message's response
+    // text as the server sent it, or a status 900 error.
+    void S2SContext_internal::queueRawMessage(const std::string &json, const ResultCallback &callback) {
+        Request request;
+        request.operation = getOperationName(json);
+        request.raw = json;
+        request.rawCallback = callback;
+        request.isRaw = true;
+        request.isPacket = false;
+        request.size = json.size();
+        queueRequestInternal(std::move(request));
     }
 
-    void S2SContext_internal::popRequest() {
+    void S2SContext_internal::queueRequestInternal(Request &&request) {
         std::unique_lock <std::mutex> lock(m_requestsMutex);
-        if (m_requestQueue.empty()) return;
-        m_requestQueue.erase(m_requestQueue.begin());
+
+        // Cancelled before it made it to the queue
+        if (request.state && request.state->done) return;
+
+        request.sequence = m_nextSequence++;
+        request.queuedAt = std::chrono::steady_clock::now();
+        if (m_traceEnabled) {
+            request.trace = std::make_shared<TraceRecord>();
+            request.trace->trace.id = request.sequence;
+            request.trace->trace.operation = request.operation;
+            request.trace->trace.enqueued = request.queuedAt;
+        }
+        m_requestQueue.push_back(std::move(request));
+        m_requestQueueHighWater = std::max(m_requestQueueHighWater, m_requestQueue.size());
+
+        sendQueuedPackets();
     }
 
     void S2SContext_internal::doNextRequest() {
-        Request request;
-
-        {
-            std::unique_lock <std::mutex> lock(m_requestsMutex);
-            if (m_requestQueue.empty()) {
-                if (m_logEnabled) {
-                    fprintf(stderr, "[S2S next] doNextRequest: queue empty, done\n");
-                    fflush(stderr);
-                }
-                return;
+        std::unique_lock <std::mutex> lock(m_requestsMutex);
+        if (m_requestQueue.empty()) {
+            if (m_logEnabled && s2s_should_log(S2SLogChannel::S2SSend, S2SLogLevel::Verbose)) {
+                fprintf(stderr, "[S2S next] doNextRequest: queue empty, done\n");
+                fflush(stderr);
             }
-            request = m_requestQueue.front();
+            return;
         }
 
-        if (m_logEnabled) {
+        if (m_logEnabled && s2s_should_log(S2SLogChannel::S2SSend, S2SLogLevel::Verbose) && canSendPacket()) {
             fprintf(stderr, "[S2S next] doNextRequest: sending next queued request\n");
             fflush(stderr);
         }
-        s2sRequest(request.json, request.callback);
+        sendQueuedPackets();
     }
 
-    void S2SContext_internal::s2sRequest(
-            const Json::Value &json, const S2SCallback &callback) {
-        auto packet = json;
-        if (m_state == State::Authenticated) {
-            packet["packetId"] = m_packetId++;
-            packet["sessionId"] = m_sessionId;
+    // Whether the front of the queue can be sent now. m_requestsMutex must be held.
+    bool S2SContext_internal::canSendPacket() {
+        if (m_requestQueue.empty() || m_exclusiveInFlight) return false;
+
+        // Authentication goes alone, once everything sent before it is back
+        if (m_requestQueue.front().isPacket) return m_packetsInFlight == 0;
+
+        // Messages wait for the session the authentication brings back
+        if (m_state == State::Authenticating) return false;
+
+        // Packets can only overlap once we have a session and packet ids
+        size_t window = (m_state == State::Authenticated && !m_windowFallback) ?
+                        m_maxPacketsInFlight : 1;
+        return m_packetsInFlight < window;
+    }
+
+    // Sends queued requests until the send window is full. m_requestsMutex must be held.
+    void S2SContext_internal::sendQueuedPackets() {
+        // The heartbeat timer renews the session before it expires, unless
+        // it couldn't run in time (the process was suspended): renew it
+        // rather than fail what's queued
+        if (m_state == State::Authenticated && m_packetsInFlight == 0 &&
+            !m_requestQueue.empty() && !m_requestQueue.front().isPacket &&
+            isSessionNearExpiry(std::chrono::steady_clock::now())) {
+            reauthenticate();
         }
 
-        std::string postData = toString(packet);
-        rtrim(postData);
+        while (canSendPacket()) {
+            s2sRequest();
+        }
+    }
 
-        if (m_logEnabled) {
-            s2s_log("[S2S SEND ", m_appId.c_str(), "] ", postData);
+    // Sends the requests at the front of the queue as one packet.
+    // m_requestsMutex must be held.
+    void S2SContext_internal::s2sRequest() {
+        auto batch = std::make_shared<RequestBatch>();
+
+        // A packet request (authentication) always goes alone. Otherwise
+        // coalesce as many queued messages as the batching limits allow.
+        if (m_requestQueue.front().isPacket) {
+            batch->push_back(std::move(m_requestQueue.front()));
+        } else {
+            size_t count = 0;
+            size_t bytes = 0;
+            for (auto &request : m_requestQueue) {
+                if (request.isPacket) break;
+                if (count > 0 &&
+                    (count >= m_batchMaxMessages ||
+                     (m_batchMaxBytes > 0 && bytes + request.size > m_batchMaxBytes))) {
+                    break;
+                }
+                count++;
+                bytes += request.size;
+                batch->push_back(std::move(request));
+            }
         }
+        m_requestQueue.erase(m_requestQueue.begin(), m_requestQueue.begin() + batch->size());
+        m_packetsInFlight++;
+        if (batch->front().isPacket) {
+            m_exclusiveInFlight = true;
+        }
+        bool pipelined = m_packetsInFlight > 1;
+        uint64_t sendIndex = m_packetsSent++;
 
-        auto pThis = shared_from_this();
+        int packetId = -1;
+        if (m_state == State::Authenticated) {
+            packetId = m_packetId++;
+        }
 
-        auto popAndDoNextRequest = [pThis, callback](const std::string &data) {
-            if (!pThis) {
-                std::cerr << "pThis is null" << std::endl;
-                return;
+        std::string postData;
+        if (batch->front().isPacket) {
+            Json::Value packet = batch->front().json;
+            if (packetId >= 0) {
+                packet["packetId"] = packetId;
+                packet["sessionId"] = m_sessionId;
             }
-            pThis->popRequest();
-            if (callback) {
-                callback(data);
+            postData = toString(packet);
+            rtrim(postData);
+        } else {
+            // The envelope is written around the messages' text, so raw
+            // messages go out byte for byte and big payloads aren't copied
+            // into a packet DOM first
+            postData = "{\"messages\":[";
+            for (size_t i = 0; i < batch->size(); ++i) {
+                const auto &request = (*batch)[i];
+                if (i > 0) postData += ",";
+                if (request.isRaw) {
+                    postData += request.raw;
+                } else {
+                    std::string message = toString(request.json);
+                    rtrim(message);
+                    postData += message;
+                }
             }
-            pThis->doNextRequest();
-        };
-
-        curlSend(postData, [pThis, popAndDoNextRequest](const std::string &data) {
-            if (pThis->m_logEnabled) {
-                s2s_log("[S2S RECV ", pThis->m_appId, "] ", data);
+            postData += "]";
+            if (packetId >= 0) {
+                postData += ",\"packetId\":" + std::to_string(packetId);
+                postData += ",\"sessionId\":" + Json::valueToQuotedString(m_sessionId.c_str());
             }
-            popAndDoNextRequest(data);
+            postData += "}";
+        }
 
-        }, [pThis, popAndDoNextRequest](const std::string &data) {
-            if (pThis->m_logEnabled) {
-                s2s_log("[S2S Error ", pThis->m_appId, "] ", data);
-            }
-            popAndDoNextRequest(data);
-        });
-    }
+        auto packet = std::make_shared<Packet>();
+        packet->batch = batch;
+        packet->data = std::move(postData);
+        packet->generation = m_queueGeneration;
+        packet->sessionGeneration = m_sessionGeneration;
+        packet->packetId = packetId;
+        packet->sendIndex = sendIndex;
+        packet->pipelined = pipelined;
+        if (!batch->front().isPacket) {
+            packet->stream = std::make_shared<ResponseStream>();
+        }
 
-/**
- * This is the writer call back function used by curl
- *
- * @param toWrite - data received from the remote server
- * @param size - size of a character (?)
- * @param nmemb - number of characters
- * @param data - pointer to the curlloader
- *
- * @return int - number of characters received (should equal size * nmemb)
- */
-    static size_t writeData(
-            char *toWrite,
-            size_t size,
-            size_t nmemb,
-            void *data) {
-        std::string *pOutData = (std::string *) data;
+        auto now = std::chrono::steady_clock::now();
+        for (auto &request : *batch) {
+            if (!request.trace) continue;
+            auto &trace = request.trace->trace;
+            trace.sent = now;
+            trace.packetId = packetId;
+            trace.batchSize = batch->size();
+            if (!packet->timing) {
+                packet->timing = std::make_shared<TransferTiming>();
+            }
+        }
 
-        // What we will return
-        size_t result = 0;
+        if (m_logEnabled && s2s_should_log(S2SLogChannel::S2SSend, S2SLogLevel::Info)) {
+            s2s_log("[S2S SEND ", m_appId, "] ", S2SLogPayload(S2SLogChannel::S2SSend, packet->data));
+        }
 
-        // Check for a valid response object.
-        if (pOutData != NULL) {
-            // Append the data to the buffer
-            pOutData->append(toWrite, size * nmemb);
+        sendPacket(packet);
+    }
 
-            // How much did we write?
-            result = size * nmemb;
+    // Time the transfer of a batch has: until the last of its requests'
+    // deadlines. Requests with only a cancel token set no limit, cancelling
+    // them aborts the transfer. Any other gets DEFAULT_TRANSFER_TIMEOUT_MS.
+    static uint64_t getTransferTimeoutMS(const S2SContext_internal::RequestBatch &batch) {
+        auto now = std::chrono::steady_clock::now();
+        auto last = now;
+        for (const auto &request : batch) {
+            if (!request.state || (!request.state->cancelToken &&
+                                   request.state->deadline == std::chrono::steady_clock::time_point())) {
+                last = std::max(last, now + std::chrono::milliseconds(DEFAULT_TRANSFER_TIMEOUT_MS));
+            } else if (request.state->deadline == std::chrono::steady_clock::time_point()) {
+                return 0;
+            } else {
+                last = std::max(last, request.state->deadline);
+            }
         }
-
-        return result;
+        // At least 1: 0 would mean no limit
+        auto timeout = std::chrono::duration_cast<std::chrono::milliseconds>(last - now);
+        return std::max<uint64_t>(1, (uint64_t)timeout.count());
     }
 
-    void S2SContext_internal::curlSend(const std::string &postData,
-                                       const S2SCallback &successCallback,
-                                       const S2SCallback &errorCallback) {
+    // Starts the transfer of a packet. m_requestsMutex must be held.
+    void S2SContext_internal::sendPacket(const std::shared_ptr<Packet> &packet) {
         auto pThis = shared_from_this();
-        auto sendThread = std::thread(
-                [pThis, postData, successCallback, errorCallback] {
-                    if (pThis->m_logEnabled) {
-                        fprintf(stderr, "[S2S curl] thread starting, posting to %s\n", pThis->m_url.c_str());
-                        fflush(stderr);
-                    }
 
-                    CURL *curl = curl_easy_init();
+        // Message responses are handed out while the body is still coming in
+        S2SCallback dataCallback;
+        if (packet->stream) {
+            dataCallback = [pThis, packet](const std::string &data) {
+                pThis->deliverResponses(*packet->batch, *packet->stream, data);
+            };
+        }
 
-                    if (!curl) {
-                        if (errorCallback) {
-                            pThis->queueCallback({
-                                                         errorCallback,
-                                                         "{\"status\":900,\"message\":\"cURL Out of Memory\"}"
-                                                 });
-                        }
-                        return;
-                    }
+        auto transferId = httpPost(packet->data, getTransferTimeoutMS(*packet->batch),
+                                   [pThis, packet](const std::string &data) {
+            if (pThis->m_logEnabled &&
+                (s2s_should_log(S2SLogChannel::S2SRecv, S2SLogLevel::Info) ||
+                 (s2s_should_log(S2SLogChannel::S2SRecv, S2SLogLevel::Error) &&
+                  hasErrorStatus(data, packet->stream && !packet->stream->expired
+                                        ? &packet->stream->scanner : nullptr)))) {
+                s2s_log("[S2S RECV ", pThis->m_appId, "] ", S2SLogPayload(S2SLogChannel::S2SRecv, data));
+            }
+            pThis->onPacketResponse(packet, true, data);
 
-                    char curlError[CURL_ERROR_SIZE];
-                    curlError[0] = '\0';
+        }, [pThis, packet](const TransferError &error) {
+            if (pThis->m_logEnabled && s2s_should_log(S2SLogChannel::S2SRecv, S2SLogLevel::Error)) {
+                s2s_log("[S2S Error ", pThis->m_appId, "] ", error.message);
+            }
+            if (!pThis->retryPacket(packet, error)) {
+                pThis->onPacketResponse(packet, false, error.message);
+            }
+        }, dataCallback, packet->timing);
+
+        // Keep track of the transfer, so giving up on every request of the
+        // batch can stop it
+        if (transferId != 0) {
+            for (auto &request : *packet->batch) {
+                if (!request.state) continue;
+                request.state->batch = packet->batch.get();
+                m_inFlightTransfers[packet->batch.get()] = transferId;
+            }
+        }
+    }
 
-                    // Use an error buffer to store the description of any errors.
-                    curl_easy_setopt(curl, CURLOPT_ERRORBUFFER, curlError);
+    // Whether a message response says the session expired. Only parsed if
+    // the reason code shows up in it.
+    static bool isSessionExpired(const std::string &data, const S2SJsonScanner::Range &range) {
+        static const std::string reasonCode = std::to_string(SERVER_SESSION_EXPIRED);
+        auto begin = data.begin() + range.first;
+        auto end = data.begin() + range.second;
+        if (std::search(begin, end, reasonCode.begin(), reasonCode.end()) == end) return false;
+
+        Json::Value message;
+        Json::Reader reader;
+        return reader.parse(data.c_str() + range.first, data.c_str() + range.second, message) &&
+               message["reason_code"].isInt() &&
+               message["reason_code"].asInt() == SERVER_SESSION_EXPIRED;
+    }
 
-                    // Set the headers.
-                    struct curl_slist *headers = NULL;
-                    headers = curl_slist_append(headers, "Content-Type: application/json");
-                    std::string contentLength =
-                            "Content-Length: " + std::to_string(postData.size());
-                    headers = curl_slist_append(headers, contentLength.c_str());
-                    curl_easy_setopt(curl, CURLOPT_HTTPHEADER, headers);
+    // Hands out the message responses that are complete in data, the body
+    // received so far. Called on the I/O thread.
+    void S2SContext_internal::deliverResponses(RequestBatch &batch, ResponseStream &stream,
+                                               const std::string &data) {
+        if (stream.expired) return;
+        stream.scanner.feed(data);
+
+        const auto &elements = stream.scanner.getElements();
+        auto now = std::chrono::steady_clock::now();
+        for (; stream.delivered < elements.size() && stream.delivered < batch.size(); ++stream.delivered) {
+            const auto &request = batch[stream.delivered];
+            const auto &range = elements[stream.delivered];
+
+            // Held back to be sent again once the session is renewed
+            if (!request.replayed && isSessionExpired(data, range)) {
+                stream.expired = true;
+                return;
+            }
 
-                    // Set up the object to store the content of the response.
-                    std::string result;
-                    curl_easy_setopt(curl, CURLOPT_WRITEDATA, &result);
-                    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, writeData);
+            recordLatency(request, now);
 
-                    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYPEER, (long) 0);
-                    curl_easy_setopt(curl, CURLOPT_SSL_VERIFYHOST, (long) 0);
+            beginDelivery(request);
+            if (request.isRaw) {
+                if (request.rawCallback) {
+                    std::string response = data.substr(range.first, range.second - range.first);
+                    request.rawCallback(response);
+                }
+            } else if (request.callback) {
+                // Each message is parsed on its own, never the whole packet
+                Json::Value message;
+                Json::Reader reader;
+                if (!reader.parse(data.c_str() + range.first, data.c_str() + range.second, message)) {
+                    message = Json::Value(Json::ValueType::objectValue);
+                    message["status"] = 900;
+                    message["message"] = "Failed to parse json";
+                }
+                request.callback(message);
+            }
+            endDelivery(request);
+        }
+    }
 
-                    // Timeouts: fail fast on hung connections rather than blocking forever
-                    curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, 10L);
-                    curl_easy_setopt(curl, CURLOPT_TIMEOUT, 30L);
+    void S2SContext_internal::onPacketResponse(const std::shared_ptr<Packet> &packet,
+                                               bool fromServer, const std::string &dataStr) {
+        const auto &batch = packet->batch;
+        const auto &stream = packet->stream;
+        int packetId = packet->packetId;
+        bool isPacket = batch->front().isPacket;
+        if (!isPacket && fromServer) {
+            // Picks up whatever the write callback didn't see yet
+            stream->scanner.feed(dataStr);
+        }
 
-                    // Set the base URL for the request.
-                    curl_easy_setopt(curl, CURLOPT_URL, pThis->m_url.c_str());
+        {
+            std::unique_lock <std::mutex> lock(m_requestsMutex);
 
-                    // Create all of the form data.
-                    curl_easy_setopt(curl, CURLOPT_POST, 1);
-                    curl_easy_setopt(curl, CURLOPT_POSTFIELDSIZE, postData.size());
-                    curl_easy_setopt(curl, CURLOPT_COPYPOSTFIELDS, postData.c_str());
+            if (m_inFlightTransfers.erase(batch.get()) > 0) {
+                for (auto &request : *batch) {
+                    if (request.state) request.state->batch = nullptr;
+                }
+            }
 
-                    if (pThis->m_logEnabled) {
-                        fprintf(stderr, "[S2S curl] calling curl_easy_perform...\n");
-                        fflush(stderr);
-                    }
+            // Every answer from the server pays back some of the retry budget
+            if (fromServer) {
+                m_lastServerResponse = std::chrono::steady_clock::now();
+                m_retryTokens = std::min(m_retryPolicy.budgetMaxTokens,
+                                         m_retryTokens + m_retryPolicy.budgetRatio);
+            }
 
-                    CURLcode rc = curl_easy_perform(curl);
+            // A disconnect since this packet was sent already reset the queue
+            if (packet->generation == m_queueGeneration) {
+                m_packetsInFlight--;
+                if (isPacket) {
+                    m_exclusiveInFlight = false;
+                }
 
-                    if (pThis->m_logEnabled) {
-                        fprintf(stderr, "[S2S curl] curl_easy_perform returned rc=%d (%s)\n",
-                                (int)rc, rc == CURLE_OK ? "OK" : curl_easy_strerror(rc));
-                        fflush(stderr);
+                // The server answered a packet that overlapped others (sent
+                // while they were in flight, or others sent while it was) with
+                // no message responses at all: it won't take overlapping
+                // packets. The packet wasn't run, so put it back in the queue
+                // and send one packet at a time from now on.
+                bool overlapped = packet->pipelined || m_packetsSent > packet->sendIndex + 1;
+                if (overlapped && fromServer && !isPacket &&
+                    stream->scanner.getResult() == S2SJsonScanner::Result::NotFound) {
+                    if (!m_windowFallback) {
+                        s2s_log("[S2S] Server refused overlapping packets, sending one packet at a time");
                     }
-
-                    curl_slist_free_all(headers);
-                    curl_easy_cleanup(curl);
-
-                    if (rc == CURLE_OPERATION_TIMEDOUT) {
-                        if (errorCallback) {
-                            pThis->queueCallback({
-                                                         errorCallback,
-                                                         "{\"status\":900,\"message\":\"Operation timed out\"}"
-                                                 });
-                        }
-                    } else if (rc != CURLE_OK) {
-                        if (errorCallback) {
-                            pThis->queueCallback({
-                                                         errorCallback,
-                                                         std::string("{\"status\":900,\"message\":\"") +
-                                                         curlError + "\"}"
-                                                 });
-                        }
-                    } else if (successCallback) {
-                        pThis->queueCallback({
-                                                     successCallback,
-                                                     result
-                                             });
+                    m_windowFallback = true;
+                    for (auto &request : *batch) {
+                        auto it = std::lower_bound(
+                                m_requestQueue.begin(), m_requestQueue.end(), request.sequence,
+                                [](const Request &queued, uint64_t sequence) {
+                                    return queued.sequence < sequence;
+                                });
+                        m_requestQueue.insert(it, std::move(request));
                     }
-                });
-        sendThread.detach();
-    }
-
-    void S2SContext_internal::onAuthenticateResult(const Json::Value &json,
-                                                   const S2SCallback &callback) {
-        std::string callback_message = toString(json);
+                    sendQueuedPackets();
+                    return;
+                }
 
-        if (json["status"].asInt() != 200) {
-            // Create a copy of our previous requests, we will callback
-            // then all on failed auth. The reasons are:
-            // 1. disconnect() clears the queue
-            // 2. A callback might create new requests and cause side
-            //    effects so it's better to be in a clean state.
-            decltype(m_requestQueue) requestQueueCopy;
-            {
-                m_requestsMutex.lock();
-                requestQueueCopy = m_requestQueue;
-                m_requestsMutex.unlock();
+                // The session expired: send what wasn't answered again,
+                // after authenticating once for all the packets that were
+                // in flight under the old session
+                if (fromServer && !isPacket && stream->expired) {
+                    for (size_t i = stream->delivered; i < batch->size(); ++i) {
+                        auto &request = (*batch)[i];
+                        if (request.state && request.state->done) continue;
+                        request.replayed = true;
+                        auto it = std::lower_bound(
+                                m_requestQueue.begin(), m_requestQueue.end(), request.sequence,
+                                [](const Request &queued, uint64_t sequence) {
+                                    return queued.sequence < sequence;
+                                });
+                        m_requestQueue.insert(it, std::move(request));
+                    }
+                    // Only the answered requests are done with their transfer
+                    finishTransferTraces(*packet);
+                    if (packet->sessionGeneration == m_sessionGeneration) {
+                        reauthenticate();
+                    }
+                    sendQueuedPackets();
+                    return;
+                }
             }
+        }
 
-            // Disconnect (Clear internal queued requests)
-            disconnect();
+        finishTransferTraces(*packet);
 
-            // Callback to everyone that were queued
-            if (callback) {
-                callback(callback_message);
+        if (isPacket) {
+            Json::Value data;
+            Json::Reader reader;
+            if (!reader.parse(dataStr.c_str(), data)) {
+                data = Json::Value(Json::ValueType::objectValue);
+                data["status"] = 900;
+                data["message"] = "Failed to parse json";
+            }
+            if (fromServer) {
+                recordLatency(batch->front(), std::chrono::steady_clock::now());
+            }
+            beginDelivery(batch->front());
+            if (batch->front().callback) {
+                batch->front().callback(data);
+            }
+            endDelivery(batch->front());
+            doNextRequest();
+            return;
+        }
+
+        S2SJsonScanner::Range packetIdRange;
+        if (fromServer && packetId >= 0 &&
+            stream->scanner.getMember(dataStr, "packetId", packetIdRange)) {
+            std::string responsePacketId = dataStr.substr(packetIdRange.first,
+                                                          packetIdRange.second - packetIdRange.first);
+            if (responsePacketId != std::to_string(packetId)) {
+                s2s_log("[S2S Error] Response for packet ", responsePacketId,
+                        " received for packet ", std::to_string(packetId));
+            }
+        }
+
+        if (fromServer) {
+            deliverResponses(*batch, *stream, dataStr);
+        }
+
+        // Requests left without a response share the packet's error
+        if (stream->delivered < batch->size()) {
+            std::string error;
+            if (!fromServer) {
+                // Transport errors are already a status 900 message
+                error = dataStr;
+            } else if (stream->expired) {
+                // Disconnected before it could be sent again
+                error = "{\"status\":900,\"reason_code\":" + std::to_string(SERVER_SESSION_EXPIRED) +
+                        ",\"message\":\"Session expired\"}";
+            } else if (stream->scanner.getResult() == S2SJsonScanner::Result::Invalid) {
+                error = "{\"status\":900,\"message\":\"Failed to parse json\"}";
+            } else {
+                error = "{\"status\":900,\"message\":\"Malformed json\"}";
             }
-            for (size_t i = m_autoAuth ? 1 : 0 /* On Auto auth, we skip first request, it's the auth itself */;
-                 i < requestQueueCopy.size(); i++) {
-                const auto &request = requestQueueCopy[i];
-                if (request.callback) {
-                    request.callback(callback_message);
+
+            for (size_t i = stream->delivered; i < batch->size(); ++i) {
+                const auto &request = (*batch)[i];
+                beginDelivery(request);
+                if (request.isRaw) {
+                    if (request.rawCallback) {
+                        std::string result = error;
+                        request.rawCallback(result);
+                    }
+                } else if (request.callback) {
+                    Json::Value errorJson;
+                    Json::Reader reader;
+                    reader.parse(error, errorJson);
+                    request.callback(errorJson);
                 }
+                endDelivery(request);
             }
-        } else if (!m_autoAuth) // If we are auto-auth, we don't callback for auth.
+        }
+
+        doNextRequest();
+    }
+
+    // Schedules a resend of a packet that failed at the transport level, if
+    // the retry policy allows it. Called on the I/O thread.
+    bool S2SContext_internal::retryPacket(const std::shared_ptr<Packet> &packet,
+                                          const TransferError &error) {
+        uint64_t delayMS;
         {
-            if (callback) {
-                callback(callback_message);
+            std::unique_lock <std::mutex> lock(m_requestsMutex);
+
+            // Aborted transfers were given up on, or the context is going away
+            if (m_retryPolicy.maxRetries <= 0 || error.code == CURLE_ABORTED_BY_CALLBACK ||
+                packet->generation != m_queueGeneration || isAbandoned(*packet->batch)) {
+                return false;
+            }
+
+            if ((error.requestSent && !isIdempotent(*packet->batch)) ||
+                packet->retries >= m_retryPolicy.maxRetries) {
+                m_retryGiveUpCount++;
+                return false;
+            }
+            if (m_retryTokens < 1.0) {
+                m_retryGiveUpCount++;
+                m_retryBudgetExhaustedCount++;
+                return false;
+            }
+            m_retryTokens -= 1.0;
+            m_retryCount++;
+
+            double backoff = (double)m_retryPolicy.initialBackoffMS *
+                             std::pow(m_retryPolicy.backoffMultiplier, packet->retries);
+            backoff = std::min(backoff, (double)m_retryPolicy.maxBackoffMS);
+            double jitter = std::max(0.0, std::min(1.0, m_retryPolicy.jitter));
+            backoff -= backoff * jitter * std::uniform_real_distribution<double>(0.0, 1.0)(m_retryRandom);
+            delayMS = (uint64_t)backoff;
+
+            packet->retries++;
+            packet->lastError = error.message;
+
+            // No transfer to abort while waiting
+            m_inFlightTransfers.erase(packet->batch.get());
+        }
+
+        if (m_logEnabled && s2s_should_log(S2SLogChannel::S2SSend, S2SLogLevel::Error)) {
+            s2s_log("[S2S] Resending packet ", std::to_string(packet->packetId), " in ",
+                    std::to_string(delayMS), " ms (retry ", std::to_string(packet->retries), ")");
+        }
+
+        std::weak_ptr<S2SContext_internal> weakThis = shared_from_this();
+        m_reactor->schedule(std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMS),
+                            [weakThis, packet]() {
+                                if (auto pThis = weakThis.lock()) {
+                                    pThis->resendPacket(packet);
+                                }
+                            });
+        return true;
+    }
+
+    void S2SContext_internal::resendPacket(const std::shared_ptr<Packet> &packet) {
+        {
+            std::unique_lock <std::mutex> lock(m_requestsMutex);
+            if (packet->generation == m_queueGeneration && !isAbandoned(*packet->batch)) {
+                // Responses already handed out aren't handed out again
+                if (packet->stream) {
+                    packet->stream->scanner = S2SJsonScanner("messageResponses");
+                }
+                sendPacket(packet);
+                return;
+            }
+        }
+
+        // Disconnected or given up on while waiting
+        onPacketResponse(packet, false, packet->lastError);
+    }
+
+    // Whether running the batch twice is harmless. m_requestsMutex must be held.
+    bool S2SContext_internal::isIdempotent(const RequestBatch &batch) const {
+        for (const auto &request : batch) {
+            // Authenticating again only opens another session
+            if (request.isPacket) continue;
+            if (request.state && request.state->idempotent) continue;
+            if (m_retryPolicy.idempotentOperations.empty()) return false;
+
+            std::string service;
+            std::string operation;
+            if (request.isRaw) {
+                S2SJsonScanner scanner("");
+                scanner.feed(request.raw);
+                S2SJsonScanner::Range range;
+                // String values, quotes included
+                if (scanner.getMember(request.raw, "service", range) && range.second - range.first >= 2) {
+                    service = request.raw.substr(range.first + 1, range.second - range.first - 2);
+                }
+                if (scanner.getMember(request.raw, "operation", range) && range.second - range.first >= 2) {
+                    operation = request.raw.substr(range.first + 1, range.second - range.first - 2);
+                }
+            } else {
+                service = getMemberString(request.json, "service");
+                operation = getMemberString(request.json, "operation");
+            }
+            if (m_retryPolicy.idempotentOperations.count(service + "." + operation) == 0) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    // Whether every request of the batch gave up on its response
+    bool S2SContext_internal::isAbandoned(const RequestBatch &batch) {
+        return std::all_of(batch.begin(), batch.end(), [](const Request &request) {
+            return request.state && request.state->done;
+        });
+    }
+
+    IS2STransport::TransferId S2SContext_internal::httpPost(const std::string &postData, uint64_t timeoutMS,
+                                                            const S2SCallback &successCallback,
+                                                            const TransferErrorCallback &errorCallback,
+                                                            const S2SCallback &dataCallback,
+                                                            const std::shared_ptr<TransferTiming> &timing) {
+        auto pThis = shared_from_this();
+        if (m_logEnabled && s2s_should_log(S2SLogChannel::S2SSend, S2SLogLevel::Verbose)) {
+            fprintf(stderr, "[S2S http] posting to %s\n", m_url.c_str());
+            fflush(stderr);
+        }
+
+        return m_transport->post(postData, timeoutMS, dataCallback, [pThis, successCallback, errorCallback, timing](
+                const IS2STransport::Response &response) {
+            if (pThis->m_logEnabled && s2s_should_log(S2SLogChannel::S2SRecv, S2SLogLevel::Verbose)) {
+                fprintf(stderr, "[S2S http] transfer done rc=%d (%s)\n",
+                        (int)response.code, response.code == CURLE_OK ? "OK" : response.error.c_str());
+                fflush(stderr);
+            }
+
+            pThis->m_httpRequestCount++;
+            pThis->m_newConnectionCount += response.newConnections;
+            pThis->m_bytesSent += response.bytesSent;
+            pThis->m_bytesReceived += response.bytesReceived;
+
+            // Skipped phases (DNS and connect on a reused connection) take
+            // no time, and there is no TLS over http
+            if (timing) {
+                timing->completed = std::chrono::steady_clock::now();
+                timing->started = timing->completed - response.totalTime;
+                timing->dnsDone = timing->started + response.dnsTime;
+                timing->connectDone = timing->started + response.connectTime;
+                timing->tlsDone = response.tlsTime.count() > 0 ? timing->started + response.tlsTime :
+                                  std::chrono::steady_clock::time_point();
+                timing->firstByte = response.firstByteTime.count() > 0 ? timing->started + response.firstByteTime :
+                                    std::chrono::steady_clock::time_point();
+            }
+
+            if (response.code == CURLE_OPERATION_TIMEDOUT) {
+                if (errorCallback) {
+                    errorCallback({response.code, response.requestSent,
+                                   "{\"status\":900,\"message\":\"Operation timed out\"}"});
+                }
+            } else if (response.code == CURLE_ABORTED_BY_CALLBACK) {
+                // Every request of the packet gave up on it, or the reactor stopped
+                if (errorCallback) {
+                    errorCallback({response.code, response.requestSent,
+                                   "{\"status\":900,\"message\":\"Request aborted\"}"});
+                }
+            } else if (response.code != CURLE_OK) {
+                if (errorCallback) {
+                    errorCallback({response.code, response.requestSent,
+                                   std::string("{\"status\":900,\"message\":\"") + response.error + "\"}"});
+                }
+            } else if (successCallback) {
+                successCallback(response.body);
+            }
+        });
+    }
+
+    void S2SContext_internal::setBatching(size_t maxMessages, size_t maxBytes) {
+        std::unique_lock <std::mutex> lock(m_requestsMutex);
+        m_batchMaxMessages = maxMessages > 0 ? maxMessages : 1;
+        m_batchMaxBytes = maxBytes;
+    }
+
+    void S2SContext_internal::setMaxPacketsInFlight(size_t maxPackets) {
+        std::unique_lock <std::mutex> lock(m_requestsMutex);
+        m_maxPacketsInFlight = maxPackets > 0 ? maxPackets : 1;
+        sendQueuedPackets();
+    }
+
+    void S2SContext_internal::setRetryPolicy(const S2SRetryPolicy &policy) {
+        std::unique_lock <std::mutex> lock(m_requestsMutex);
+        m_retryPolicy = policy;
+        m_retryTokens = policy.budgetMaxTokens;
+    }
+
+    S2SRetryStats S2SContext_internal::getRetryStats() const {
+        S2SRetryStats stats;
+        stats.retries = m_retryCount.load();
+        stats.giveUps = m_retryGiveUpCount.load();
+        stats.budgetExhausted = m_retryBudgetExhaustedCount.load();
+        return stats;
+    }
+
+    S2SStats S2SContext_internal::getStats() const {
+        S2SStats stats;
+        {
+            std::unique_lock <std::mutex> lock(m_statsMutex);
+            stats.latency = m_latency;
+        }
+        {
+            std::unique_lock <std::mutex> lock(m_requestsMutex);
+            stats.requestQueueDepth = m_requestQueue.size();
+            stats.requestQueueHighWater = m_requestQueueHighWater;
+        }
+        stats.callbackQueueDepth = getPendingCallbackCount();
+        stats.callbackQueueHighWater = m_callbacks.getHighWater();
+        stats.callbacksDeferred = m_callbacksDeferred.load();
+        stats.bytesSent = m_bytesSent.load();
+        stats.bytesReceived = m_bytesReceived.load();
+        stats.authentications = m_authCount.load();
+        stats.authenticationFailures = m_authFailureCount.load();
+        stats.heartbeats = m_heartbeatCount.load();
+        stats.heartbeatsSkipped = m_heartbeatSkippedCount.load();
+        return stats;
+    }
+
+    void S2SContext_internal::recordLatency(const Request &request,
+                                            std::chrono::steady_clock::time_point now) {
+        auto latency = std::chrono::duration_cast<std::chrono::microseconds>(now - request.queuedAt);
+        std::unique_lock <std::mutex> lock(m_statsMutex);
+        m_latency[request.operation].record((uint64_t)std::max<int64_t>(latency.count(), 0));
+    }
+
+    void S2SContext_internal::setTracing(const S2STraceOptions &options) {
+        std::unique_lock <std::mutex> lock(m_traceMutex);
+        m_traceOptions = options;
+        if (!options.enabled) {
+            m_traces.clear();
+        }
+        m_traceEnabled = options.enabled;
+    }
+
+    std::vector<S2SRequestTrace> S2SContext_internal::getTraces() const {
+        std::unique_lock <std::mutex> lock(m_traceMutex);
+        return std::vector<S2SRequestTrace>(m_traces.begin(), m_traces.end());
+    }
+
+    // Trace of the response being handed to a request's callback on this
+    // thread, so queueCallback can time the callback it queues for it
+    static thread_local S2SContext_internal *t_deliveringContext = nullptr;
+    static thread_local const std::shared_ptr<S2SContext_internal::TraceRecord> *t_deliveringTrace = nullptr;
+
+    void S2SContext_internal::beginDelivery(const Request &request) {
+        if (!request.trace) return;
+        request.trace->trace.delivered = std::chrono::steady_clock::now();
+        t_deliveringContext = this;
+        t_deliveringTrace = &request.trace;
+    }
+
+    void S2SContext_internal::endDelivery(const Request &request) {
+        if (!request.trace) return;
+        t_deliveringContext = nullptr;
+        t_deliveringTrace = nullptr;
+
+        // Otherwise done once runCallbacks calls it
+        if (!request.trace->callbackQueued) {
+            finishTrace(request.trace);
+        }
+    }
+
+    // Hands the packet's transfer timing to the traces of its requests. Not
+    // to the requests that were put back in the queue, they were moved out.
+    void S2SContext_internal::finishTransferTraces(const Packet &packet) {
+        if (!packet.timing) return;
+        const auto &timing = *packet.timing;
+        for (const auto &request : *packet.batch) {
+            if (!request.trace) continue;
+            auto &trace = request.trace->trace;
+            trace.transferStarted = timing.started;
+            trace.dnsDone = timing.dnsDone;
+            trace.connectDone = timing.connectDone;
+            trace.tlsDone = timing.tlsDone;
+            trace.firstByte = timing.firstByte;
+            trace.completed = timing.completed;
+            trace.retries = packet.retries;
+            finishTrace(request.trace);
+        }
+    }
+
+    void S2SContext_internal::finishTrace(const std::shared_ptr<TraceRecord> &record) {
+        if (record->pending.fetch_sub(1) != 1) return;
+
+        std::function<void(const S2SRequestTrace &)> onSlowRequest;
+        {
+            std::unique_lock <std::mutex> lock(m_traceMutex);
+            if (!m_traceOptions.enabled) return;
+
+            m_traces.push_back(record->trace);
+            while (m_traces.size() > m_traceOptions.maxTraces) {
+                m_traces.pop_front();
+            }
+            if (record->trace.getTotalTime() >= std::chrono::milliseconds(m_traceOptions.slowThresholdMS)) {
+                onSlowRequest = m_traceOptions.onSlowRequest;
+            }
+        }
+
+        if (onSlowRequest) {
+            queueCallback([onSlowRequest, record]() {
+                onSlowRequest(record->trace);
+            });
+        }
+    }
+
+    S2SConnectionStats S2SContext_internal::getConnectionStats() const {
+        S2SConnectionStats stats;
+        stats.requests = m_httpRequestCount.load();
+        stats.newConnections = m_newConnectionCount.load();
+        return stats;
+    }
+
+    void S2SContext_internal::onAuthenticateResult(const Json::Value &json,
+                                                   const ResultCallback &completion,
+                                                   bool completeOnSuccess) {
+        std::string callback_message = toString(json);
+
+        if (json["status"].asInt() != 200) {
+            auto requestQueue = disconnectAndTakeQueue();
+
+            // Callback to everyone that were queued
+            if (completion) {
+                completion(callback_message);
+            }
+            failRequests(requestQueue, m_autoAuth ? 1 : 0 /* On Auto auth, we skip first request, it's the auth itself */,
+                         json);
+        } else if (completeOnSuccess) {
+            if (completion) {
+                completion(callback_message);
+            }
+        }
+    }
+
+    // Takes the requests out of the queue and disconnects. We call them back
+    // on failed auth from a clean state: a callback might queue new requests.
+    S2SContext_internal::RequestBatch S2SContext_internal::disconnectAndTakeQueue() {
+        RequestBatch requestQueue;
+        {
+            std::unique_lock <std::mutex> lock(m_requestsMutex);
+            requestQueue.swap(m_requestQueue);
+        }
+
+        // Disconnect (Clear internal queued requests)
+        disconnect();
+        return requestQueue;
+    }
+
+    void S2SContext_internal::failRequests(const RequestBatch &requests, size_t first,
+                                           const Json::Value &error) {
+        std::string errorMessage = toString(error);
+        for (size_t i = first; i < requests.size(); i++) {
+            const auto &request = requests[i];
+            if (request.isRaw) {
+                if (request.rawCallback) {
+                    std::string result = errorMessage;
+                    request.rawCallback(result);
+                }
+            } else if (request.callback) {
+                Json::Value json = error;
+                request.callback(json);
             }
         }
     }
@@ -577,34 +1667,43 @@ namespace BrainCloud {
         }
 
         auto pThis = shared_from_this();
-        authenticateInternal([pThis, callback](const Json::Value &data) {
-            pThis->onAuthenticateResult(data, callback);
-        });
+        // If we are auto-auth, we don't callback for auth
+        authenticateWithCompletion([pThis, callback](std::string &result) {
+            if (callback) {
+                pThis->queueCallback(Callback{callback, std::move(result)});
+            }
+        }, !m_autoAuth);
     }
 
-    std::string S2SContext_internal::authenticateSync() {
-        std::string ret;
-        bool processed = false;
+    std::future <std::string> S2SContext_internal::authenticateAsync() {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        auto future = promise->get_future();
 
-        authenticate([&](const std::string &result) {
-            ret = result;
-            processed = true;
-        });
-
-        // Timeout after 60sec. This call shouldn't be that long
-        auto startTime = std::chrono::steady_clock::now();
-        while (!processed &&
-               std::chrono::steady_clock::now() <
-               startTime + std::chrono::seconds(60)) {
-            runCallbacks();
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        if (m_state != State::Disconnected) {
+            promise->set_value("{\"status\":400,\"message\":\"Already authenticated or authenticating\"}");
+            return future;
         }
 
-        if (!processed) {
-            ret = "{\"status\":900,\"message\":\"Authenticate timeout\"}";
-        }
+        // Always answered: the future would be broken otherwise
+        authenticateWithCompletion([promise](std::string &result) {
+            promise->set_value(std::move(result));
+        }, true);
+        return future;
+    }
+
+    void S2SContext_internal::authenticateWithCompletion(const ResultCallback &completion,
+                                                         bool completeOnSuccess) {
+        auto pThis = shared_from_this();
+        authenticateInternal([pThis, completion, completeOnSuccess](const Json::Value &data) {
+            pThis->onAuthenticateResult(data, completion, completeOnSuccess);
+        });
+    }
 
-        return std::move(ret);
+    std::string S2SContext_internal::authenticateSync() {
+        auto future = authenticateAsync();
+        // Timeout after 60sec. This call shouldn't be that long
+        return s2sWaitForResult(future, std::chrono::steady_clock::now() + std::chrono::seconds(60),
+                                "{\"status\":900,\"message\":\"Authenticate timeout\"}");
     }
 
 
@@ -613,79 +1712,341 @@ namespace BrainCloud {
         m_rttService->enableRTT(callback, true);
     }
 
+    bool S2SContext_internal::enableRTT(const std::shared_ptr<IRTTConnectCallback> &callback) {
+        // RTTComms ignores it then, and keeps calling the callback it has
+        auto status = m_rttService->getConnectionStatus();
+        if (status == BrainCloudRTT::RTTConnectionStatus::Connected ||
+            status == BrainCloudRTT::RTTConnectionStatus::Connecting) {
+            return false;
+        }
+
+        m_rttConnectCallback = callback;
+        m_rttService->enableRTT(callback.get(), true);
+        return true;
+    }
+
     void S2SContext_internal::request(
             const std::string &json,
             const S2SCallback &callback) {
+        auto pThis = shared_from_this();
+        requestWithCompletion(json, [pThis, callback](std::string &result) {
+            if (callback) {
+                pThis->queueCallback(Callback{callback, std::move(result)});
+            }
+        });
+    }
+
+    std::future <std::string> S2SContext_internal::requestAsync(const std::string &json) {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        auto future = promise->get_future();
+        requestWithCompletion(json, [promise](std::string &result) {
+            promise->set_value(std::move(result));
+        });
+        return future;
+    }
+
+    void S2SContext_internal::requestWithCompletion(const std::string &json,
+                                                    const ResultCallback &completion) {
         // Authenticate if we are disconnected (Not auth-ed or auth-ing)
         if (m_state == State::Disconnected && m_autoAuth) {
-            auto pThis = shared_from_this();
-            authenticateInternal([pThis, callback](const Json::Value &data) {
-                pThis->onAuthenticateResult(data, callback);
-            });
+            authenticateWithCompletion(completion, false);
         }
 
         // Queue request. This will also send the request if the
         // queue is empty
-        queueRequest(json, callback);
+        queueRequest(json, completion);
+    }
+
+    void S2SContext_internal::requestJson(Json::Value json, const S2SJsonCallback &callback) {
+        auto pThis = shared_from_this();
+
+        // Authenticate if we are disconnected (Not auth-ed or auth-ing)
+        if (m_state == State::Disconnected && m_autoAuth) {
+            // Only called for a failed authentication, which reports as a string
+            authenticateWithCompletion([pThis, callback](std::string &result) {
+                if (!callback) return;
+                auto data = std::make_shared<Json::Value>();
+                Json::Reader reader;
+                reader.parse(result, *data);
+                pThis->queueCallback([callback, data]() {
+                    callback(*data);
+                });
+            }, false);
+        }
+
+        queueMessage(json, 0, [pThis, callback](Json::Value &message) {
+            if (!callback) return;
+            auto data = std::make_shared<Json::Value>();
+            data->swap(message);
+            pThis->queueCallback([callback, data]() {
+                callback(*data);
+            });
+        });
+    }
+
+    void S2SContext_internal::requestRaw(const std::string &json, const S2SCallback &callback) {
+        auto pThis = shared_from_this();
+        auto completion = [pThis, callback](std::string &result) {
+            if (callback) {
+                pThis->queueCallback(Callback{callback, std::move(result)});
+            }
+        };
+
+        // Authenticate if we are disconnected (Not auth-ed or auth-ing)
+        if (m_state == State::Disconnected && m_autoAuth) {
+            authenticateWithCompletion(completion, false);
+        }
+
+        queueRawMessage(json, completion);
     }
 
     std::string S2SContext_internal::requestSync(const std::string &json) {
-        std::string ret;
-        bool processed = false;
+        // This call shouldn't be that long
+        S2SRequestOptions options;
+        options.timeoutMS = 60 * 1000;
+        return requestSync(json, options);
+    }
 
-        request(json, [&](const std::string &result) {
-            ret = result;
-            processed = true;
+    std::string S2SContext_internal::requestSync(const std::string &json,
+                                                 const S2SRequestOptions &options) {
+        auto promise = std::make_shared<std::promise<std::string>>();
+        auto future = promise->get_future();
+        requestWithOptions(json, options, [promise](std::string &result) {
+            promise->set_value(std::move(result));
         });
 
-        // Timeout after 60sec. This call shouldn't be that long
-        auto startTime = std::chrono::steady_clock::now();
-        while (!processed &&
-               std::chrono::steady_clock::now() <
-               startTime + std::chrono::seconds(60)) {
-            runCallbacks();
-            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        try {
+            return future.get();
+        } catch (const std::future_error &) {
+            return "{\"status\":900,\"message\":\"Request dropped on disconnect\"}";
+        }
+    }
+
+    void S2SContext_internal::request(const std::string &json,
+                                      const S2SRequestOptions &options,
+                                      const S2SCallback &callback) {
+        auto pThis = shared_from_this();
+        requestWithOptions(json, options, [pThis, callback](std::string &result) {
+            if (callback) {
+                pThis->queueCallback(Callback{callback, std::move(result)});
+            }
+        });
+    }
+
+    bool S2SContext_internal::RequestState::claim() {
+        if (done.exchange(true)) return false;
+        if (cancelToken) {
+            cancelToken->removeListener(listenerId);
+        }
+        uint64_t timer = deadlineTimer.exchange(0);
+        if (timer != 0) {
+            reactor->cancel(timer);
+        }
+        return true;
+    }
+
+    void S2SContext_internal::requestWithOptions(const std::string &json,
+                                                 const S2SRequestOptions &options,
+                                                 const ResultCallback &completion) {
+        if (options.timeoutMS == 0 && !options.cancelToken && !options.idempotent) {
+            requestWithCompletion(json, completion);
+            return;
+        }
+
+        auto state = std::make_shared<RequestState>();
+        state->completion = completion;
+        state->cancelToken = options.cancelToken;
+        state->idempotent = options.idempotent;
+
+        // The queue owns the state. The deadline and the cancel token only
+        // hold weak references, so a request dropped on disconnect goes away.
+        std::weak_ptr<S2SContext_internal> weakThis = shared_from_this();
+        std::weak_ptr<RequestState> weakState = state;
+
+        if (options.cancelToken) {
+            state->listenerId = options.cancelToken->addListener([weakThis, weakState]() {
+                auto pThis = weakThis.lock();
+                auto state = weakState.lock();
+                if (pThis && state) {
+                    pThis->giveUp(state, "{\"status\":900,\"reason_code\":" +
+                                         std::to_string(S2S_REASON_REQUEST_CANCELLED) +
+                                         ",\"message\":\"Request cancelled\"}");
+                }
+            });
+            if (state->done) {
+                // The token was already cancelled
+                return;
+            }
+        }
+
+        if (options.timeoutMS > 0) {
+            state->reactor = m_reactor;
+            state->deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(options.timeoutMS);
+            state->deadlineTimer = m_reactor->schedule(
+                    state->deadline,
+                    [weakThis, weakState]() {
+                        auto pThis = weakThis.lock();
+                        auto state = weakState.lock();
+                        if (pThis && state) {
+                            pThis->giveUp(state, "{\"status\":900,\"reason_code\":" +
+                                                 std::to_string(S2S_REASON_REQUEST_TIMEOUT) +
+                                                 ",\"message\":\"Request timeout\"}");
+                        }
+                    });
+        }
+
+        auto claimed = [state](std::string &result) {
+            if (state->claim()) {
+                state->completion(result);
+            }
+        };
+
+        // Authenticate if we are disconnected (Not auth-ed or auth-ing)
+        if (m_state == State::Disconnected && m_autoAuth) {
+            authenticateWithCompletion(claimed, false);
+        }
+
+        queueRequest(json, claimed, state);
+    }
+
+    // Completes a request with a deadline or a cancel token before its
+    // response came back, and drops the work left for it.
+    void S2SContext_internal::giveUp(const std::shared_ptr<RequestState> &state,
+                                     std::string result) {
+        if (!state->claim()) return;
+
+        IS2STransport::TransferId abortId = 0;
+        {
+            std::unique_lock <std::mutex> lock(m_requestsMutex);
+
+            // Not sent yet
+            m_requestQueue.erase(
+                    std::remove_if(m_requestQueue.begin(), m_requestQueue.end(),
+                                   [&state](const Request &request) {
+                                       return request.state == state;
+                                   }),
+                    m_requestQueue.end());
+
+            // In flight: stop the transfer once no request of its batch
+            // waits for the response anymore
+            if (state->batch) {
+                auto it = m_inFlightTransfers.find(state->batch);
+                if (it != m_inFlightTransfers.end() && isAbandoned(*state->batch)) {
+                    abortId = it->second;
+                }
+            }
         }
 
-        if (!processed) {
-            ret = "{\"status\":900,\"message\":\"Request timeout\"}";
+        if (abortId != 0) {
+            m_transport->abort(abortId);
         }
 
-        return std::move(ret);
+        state->completion(result);
     }
 
+    // m_requestsMutex must be held for the heartbeat functions
     void S2SContext_internal::startHeartbeat() {
         stopHeartbeat();
+        scheduleHeartbeat(std::chrono::steady_clock::now() + m_heartbeatInterval);
+    }
+
+    void S2SContext_internal::scheduleHeartbeat(std::chrono::steady_clock::time_point when) {
+        // The timer doesn't keep the context alive
+        std::weak_ptr<S2SContext_internal> weakThis = shared_from_this();
+        uint64_t generation = m_heartbeatGeneration;
+        m_heartbeatTimer = m_reactor->schedule(when, [weakThis, generation]() {
+            auto pThis = weakThis.lock();
+            if (pThis) {
+                pThis->onHeartbeatTimer(generation);
+            }
+        });
+    }
+
+    // Called on the I/O thread
+    void S2SContext_internal::onHeartbeatTimer(uint64_t generation) {
+        {
+            std::unique_lock <std::mutex> lock(m_requestsMutex);
+            if (generation != m_heartbeatGeneration || m_state != State::Authenticated) return;
+
+            // Other responses kept the session alive: wait a whole interval
+            // after the last one
+            auto now = std::chrono::steady_clock::now();
+            if (now - m_lastServerResponse < m_heartbeatInterval) {
+                m_heartbeatSkippedCount++;
+                scheduleHeartbeat(m_lastServerResponse + m_heartbeatInterval);
+                return;
+            }
+
+            // Too late for a heartbeat to keep the session (the timer ran
+            // late): renew it now rather than at the next send. The
+            // authentication restarts the heartbeat.
+            if (m_packetsInFlight == 0 && isSessionNearExpiry(now)) {
+                reauthenticate();
+                sendQueuedPackets();
+                return;
+            }
+            scheduleHeartbeat(now + m_heartbeatInterval);
+        }
 
-        m_heartbeatStartTime = std::chrono::system_clock::now();
+        m_heartbeatCount++;
+        sendHeartbeat();
     }
 
     void S2SContext_internal::stopHeartbeat() {
+        m_heartbeatGeneration++;
+        if (m_heartbeatTimer != 0) {
+            m_reactor->cancel(m_heartbeatTimer);
+            m_heartbeatTimer = 0;
+        }
     }
 
     void S2SContext_internal::disconnect() {
-        stopHeartbeat();
-
         m_requestsMutex.lock();
+        stopHeartbeat();
         m_requestQueue.clear();
+        m_packetsInFlight = 0;
+        m_exclusiveInFlight = false;
+        m_queueGeneration++;
+        m_packetId = 0; // Super important!
+        m_sessionId = "";
         m_requestsMutex.unlock();
 
         m_globalFileV3->disconnect();
 
         m_state = State::Disconnected;
-        int m_packetId = 0; // Super important!
-        std::string m_sessionId = "";
     }
 
-    void S2SContext_internal::queueCallback(const Callback &callback) {
-        std::unique_lock <std::mutex> lock(m_callbacksMutex);
-        if (m_logEnabled) {
+    // A queued callback that times itself for the trace of the response it
+    // answers
+    struct TracedCallback {
+        S2SContext_internal *context;
+        std::shared_ptr<S2SContext_internal::TraceRecord> record;
+        S2SContext_internal::Completion callback;
+
+        void operator()() {
+            record->trace.callbackInvoked = std::chrono::steady_clock::now();
+            callback();
+            context->finishTrace(record);
+        }
+    };
+
+    void S2SContext_internal::queueCallback(Completion &&callback) {
+        // The first callback queued while a traced response is delivered is
+        // the one answering it
+        if (t_deliveringContext == this && !(*t_deliveringTrace)->callbackQueued) {
+            auto record = *t_deliveringTrace;
+            record->callbackQueued = true;
+            record->trace.callbackQueued = std::chrono::steady_clock::now();
+            queueCallback(TracedCallback{this, record, std::move(callback)});
+            return;
+        }
+
+        if (m_logEnabled && s2s_should_log(S2SLogChannel::S2SRecv, S2SLogLevel::Verbose)) {
             fprintf(stderr, "[S2S queue] queueCallback: pushing callback, queue size before push=%zu\n",
                     m_callbacks.size());
             fflush(stderr);
         }
-        m_callbacks.push(callback);
-        m_callbacksCond.notify_all();
+        m_callbacks.push(std::move(callback));
     }
 
     void S2SContext_internal::sendHeartbeat() {
@@ -693,7 +2054,7 @@ namespace BrainCloud {
         queueRequest("{ \
         \"service\":\"heartbeat\", \
         \"operation\":\"HEARTBEAT\" \
-    }", [pThis](const std::string &result) {
+    }", [pThis](std::string &result) {
             Json::Value data;
             Json::Reader reader;
             bool parsingSuccessful = reader.parse(result.c_str(), data);
@@ -706,69 +2067,188 @@ namespace BrainCloud {
         });
     }
 
-    void S2SContext_internal::processCallbacks() {
-        m_callbacksMutex.lock();
-        if (m_logEnabled && !m_callbacks.empty()) {
-            fprintf(stderr, "[S2S process] processCallbacks: %zu callback(s) pending\n",
-                    m_callbacks.size());
-            fflush(stderr);
-        }
-        while (!m_callbacks.empty()) {
-            auto callback = m_callbacks.front();
-            m_callbacks.pop();
+    uint64_t S2SContext_internal::scheduleCallback(uint64_t delayMS, const std::function<void()> &callback) {
+        std::unique_lock <std::mutex> lock(m_scheduledCallbacksMutex);
+        uint64_t id = m_nextScheduledCallbackId++;
+
+        // The timer only queues the call; it is dropped from the queue if
+        // cancelled in between
+        std::weak_ptr<S2SContext_internal> weakThis = shared_from_this();
+        m_scheduledCallbacks[id] = m_reactor->schedule(
+                std::chrono::steady_clock::now() + std::chrono::milliseconds(delayMS),
+                [weakThis, id, callback]() {
+                    auto pThis = weakThis.lock();
+                    if (!pThis) return;
+                    pThis->queueCallback([weakThis, id, callback]() {
+                        auto pThis = weakThis.lock();
+                        if (!pThis) return;
+                        {
+                            std::unique_lock <std::mutex> lock(pThis->m_scheduledCallbacksMutex);
+                            if (pThis->m_scheduledCallbacks.erase(id) == 0) return;
+                        }
+                        callback();
+                    });
+                });
+        return id;
+    }
 
-            if (callback.callback) {
-                m_callbacksMutex.unlock();
-                if (m_logEnabled) {
-                    fprintf(stderr, "[S2S process] invoking callback...\n");
-                    fflush(stderr);
-                }
-                callback.callback(callback.data);
-                if (m_logEnabled) {
-                    fprintf(stderr, "[S2S process] callback returned\n");
-                    fflush(stderr);
-                }
-                m_callbacksMutex.lock();
+    bool S2SContext_internal::cancelScheduledCallback(uint64_t id) {
+        std::unique_lock <std::mutex> lock(m_scheduledCallbacksMutex);
+        auto it = m_scheduledCallbacks.find(id);
+        if (it == m_scheduledCallbacks.end()) return false;
+        m_reactor->cancel(it->second);
+        m_scheduledCallbacks.erase(it);
+        return true;
+    }
+
+    // Calls the oldest S2S callback. Whole batches are taken out of the
+    // queue, not one callback per lock.
+    bool S2SContext_internal::runCallback() {
+        Completion callback;
+        if (!m_callbacks.pop(callback)) return false;
+
+        if (callback) {
+            bool logCallback = m_logEnabled && s2s_should_log(S2SLogChannel::S2SRecv, S2SLogLevel::Verbose);
+            if (logCallback) {
+                fprintf(stderr, "[S2S process] invoking callback...\n");
+                fflush(stderr);
+            }
+            callback();
+            if (logCallback) {
+                fprintf(stderr, "[S2S process] callback returned\n");
+                fflush(stderr);
             }
         }
-        m_callbacksMutex.unlock();
+        return true;
+    }
+
+    // Without taking a lock
+    bool S2SContext_internal::hasPendingCallbacks() const {
+        return !m_callbacks.empty() ||
+               m_rttComms->hasPendingCallbacks() ||
+               m_globalFileV3->hasPendingCallbacks();
+    }
+
+    size_t S2SContext_internal::getPendingCallbackCount() const {
+        return m_callbacks.size() +
+               m_rttComms->getPendingCallbackCount() +
+               m_globalFileV3->getPendingCallbackCount();
     }
 
     void S2SContext_internal::runCallbacks(uint64_t timeoutMS) {
-        // Send heartbeat if we have to
-        if (m_state == State::Authenticated) {
-            auto now = std::chrono::system_clock::now();
-            auto timeDiff = now - m_heartbeatStartTime;
-            if (timeDiff >= std::chrono::milliseconds(m_heartbeatInverval)) {
-                sendHeartbeat();
-                m_heartbeatStartTime = now;
+        runCallbacks(S2SCallbackBudget(), timeoutMS);
+    }
+
+    void S2SContext_internal::setCallbackSignal(const std::shared_ptr<S2SCallbackSignal> &signal) {
+        m_callbacks.setSignal(signal);
+        m_rttComms->setCallbackSignal(signal);
+        m_globalFileV3->setCallbackSignal(signal);
+    }
+
+    size_t S2SContext_internal::runCallbacks(const S2SCallbackBudget &budget, uint64_t timeoutMS) {
+        // The heartbeat runs on the I/O thread: just wait for the specified timeout
+        if (timeoutMS > 0 && !hasPendingCallbacks()) {
+            m_callbacks.wait(std::chrono::milliseconds(timeoutMS));
+        }
+        if (!hasPendingCallbacks()) return 0;
+
+        if (!m_callbacks.empty() && m_logEnabled && s2s_should_log(S2SLogChannel::S2SRecv, S2SLogLevel::Verbose)) {
+            fprintf(stderr, "[S2S process] runCallbacks: %zu callback(s) pending\n",
+                    m_callbacks.size());
+            fflush(stderr);
+        }
+
+        const int SOURCE_COUNT = 3;
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::microseconds(budget.maxMicroseconds);
+        size_t called = 0;
+        bool budgetSpent = false;
+
+        // One callback from each source in turn, until they're all empty
+        int source = m_nextCallbackSource;
+        int emptySources = 0;
+        while (emptySources < SOURCE_COUNT) {
+            if ((budget.maxCallbacks > 0 && called >= budget.maxCallbacks) ||
+                (budget.maxMicroseconds > 0 && called > 0 && std::chrono::steady_clock::now() >= deadline)) {
+                budgetSpent = true;
+                break;
             }
 
-            // Just wait for the specified timeout
-            if (timeoutMS > 0) {
-                auto hbIntervalDuration = std::chrono::milliseconds(m_heartbeatInverval) -
-                    std::chrono::duration_cast<std::chrono::milliseconds>(timeDiff);
-                auto timeoutDuration = std::chrono::milliseconds(timeoutMS);
-                auto waitTime = timeoutDuration < hbIntervalDuration ? timeoutDuration : hbIntervalDuration;
-                std::unique_lock <std::mutex> lock(m_callbacksMutex);
-                m_callbacksCond.wait_for(lock, waitTime, [this]() { return !m_callbacks.empty(); });
+            bool ran = false;
+            switch (source) {
+                case 0:
+                    ran = runCallback();
+                    break;
+                case 1:
+                    ran = m_rttComms->runCallback();
+                    break;
+                default:
+                    ran = m_globalFileV3->runCallback();
+                    break;
+            }
+            source = (source + 1) % SOURCE_COUNT;
+
+            if (ran) {
+                called++;
+                emptySources = 0;
+            } else {
+                emptySources++;
             }
-        } else if (timeoutMS > 0) {
-            // Just wait for the specified timeout
-            std::unique_lock <std::mutex> lock(m_callbacksMutex);
-            m_callbacksCond.wait_for(lock, std::chrono::milliseconds(timeoutMS),
-                                     [this]() { return !m_callbacks.empty(); });
         }
+        m_nextCallbackSource = source;
 
-        processCallbacks();
+        if (!budgetSpent) return 0;
 
-        m_rttComms->runCallbacks();
-        m_globalFileV3->runCallbacks();
+        size_t deferred = getPendingCallbackCount();
+        m_callbacksDeferred += deferred;
+        return deferred;
     }
 
     
     void logToFile(const std::string& path)
     {
         g_logFilePath = path;
+        S2SLogger::getDefault().setFilePath(path);
+    }
+
+    void setLogOverflowPolicy(S2SLogOverflow policy)
+    {
+        S2SLogger::getDefault().setOverflowPolicy(policy);
+    }
+
+    void setLogChannelOptions(S2SLogChannel channel, const S2SLogChannelOptions& options)
+    {
+        S2SLogger::getDefault().setChannelOptions(channel, options);
+    }
+
+    S2SLogChannelOptions getLogChannelOptions(S2SLogChannel channel)
+    {
+        return S2SLogger::getDefault().getChannelOptions(channel);
+    }
+
+    void flushLogs()
+    {
+        S2SLogger::getDefault().flush();
+    }
+
+    uint64_t getDroppedLogCount()
+    {
+        return S2SLogger::getDefault().getDroppedCount();
+    }
+
+    void setIOThreadMode(S2SIOThreadMode mode)
+    {
+        g_ioThreadMode = mode;
+    }
+
+    void setTransportFactory(const S2STransportFactory& factory)
+    {
+        std::unique_lock<std::mutex> lock(g_transportMutex);
+        g_transportFactory = factory;
+    }
+
+    void setRTTSocketFactory(const S2SRTTSocketFactory& factory)
+    {
+        std::unique_lock<std::mutex> lock(g_transportMutex);
+        g_rttSocketFactory = factory;
     }
 }
\ No newline at end of file
@@ -0,0 +1,70 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+//
+// Replaces the global operator new to count the heap allocations of each
+// thread, so a test can check what a call allocates on its own thread
+// whatever the I/O thread does meanwhile.
+
+#include "allocations.h"
+
+#include <cstdlib>
+#include <new>
+
+namespace
+{
+    thread_local uint64_t t_allocationCount = 0;
+
+    void* allocate(size_t size)
+    {
+        t_allocationCount++;
+        return malloc(size > 0 ? size : 1);
+    }
+}
+
+uint64_t getThreadAllocationCount()
+{
+    return t_allocationCount;
+}
+
+void* operator new(size_t size)
+{
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new[](size_t size)
+{
+    void* p = allocate(size);
+    if (!p) throw std::bad_alloc();
+    return p;
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept
+{
+    return allocate(size);
+}
+
+void operator delete(void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+    free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+    free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+    free(p);
+}
@@ -0,0 +1,7 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <cstdint>
+
+/** Heap allocations made by the calling thread so far. */
+uint64_t getThreadAllocationCount();
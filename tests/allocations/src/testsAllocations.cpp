@@ -0,0 +1,143 @@
+#define CATCH_CONFIG_NO_POSIX_SIGNALS
+#include "catch.hpp"
+#include "allocations.h"
+#include "S2SCompletionQueue.h"
+#include "S2SLoopbackTransport.h"
+#include "S2SUniqueFunction.h"
+#include <brainclouds2s.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace BrainCloud;
+
+///////////////////////////////////////////////////////////////////////////////
+// Allocations
+//
+// Doesn't need a brainCloud server. This binary's operator new counts the
+// allocations of each thread, to check that handing completions over
+// doesn't allocate once the queues have grown.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    using Completion = S2SUniqueFunction<void()>;
+
+    // Same as what a context queues for a request: the user's callback and
+    // the response text
+    struct Callback
+    {
+        S2SCallback callback;
+        std::string data;
+
+        void operator()()
+        {
+            if (callback)
+            {
+                callback(data);
+            }
+        }
+    };
+}
+
+TEST_CASE("Completion queue allocations", "[S2S][completions]")
+{
+    S2SCompletionQueue<Completion> queue;
+    const int BATCH = 64;
+    size_t total = 0;
+    S2SCallback callback = [&total](const std::string& data) { total += data.size(); };
+
+    // Responses are made before counting: only the handover is measured
+    std::vector<std::string> responses;
+    auto makeResponses = [&responses]()
+    {
+        responses.assign(BATCH, "{\"status\":200,\"data\":{\"entityId\":\"" + std::string(1024, 'x') + "\"}}");
+    };
+
+    auto runBatch = [&]()
+    {
+        for (auto& response : responses)
+        {
+            queue.push(Callback{callback, std::move(response)});
+        }
+        Completion completion;
+        while (queue.pop(completion))
+        {
+            completion();
+        }
+    };
+
+    // Grows the queue's two vectors, which take turns
+    for (int i = 0; i < 2; ++i)
+    {
+        makeResponses();
+        runBatch();
+    }
+
+    makeResponses();
+    size_t expected = BATCH * responses[0].size();
+    total = 0;
+    uint64_t before = getThreadAllocationCount();
+    runBatch();
+    uint64_t allocations = getThreadAllocationCount() - before;
+
+    REQUIRE(total == expected);
+    REQUIRE(allocations == 0);
+}
+
+TEST_CASE("Context callback allocations", "[S2S][completions][loopback]")
+{
+    // Responses come from the loopback transport on the I/O thread and are
+    // queued for runCallbacks, like the server's would be
+    setTransportFactory(S2SLoopbackTransport::factory());
+    auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", false);
+    setTransportFactory(nullptr);
+    REQUIRE(pContext->authenticateSync().find("\"status\":200") != std::string::npos);
+
+    const size_t BATCH = 64;
+    const std::string request = "{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{\"entityId\":\"" +
+                                std::string(256, 'x') + "\"}}";
+    size_t answered = 0;
+    size_t total = 0;
+    S2SCallback callback = [&answered, &total](const std::string& data)
+    {
+        answered++;
+        total += data.size();
+    };
+
+    // Sends a batch and waits until all its callbacks are queued, so only
+    // runCallbacks runs on this thread while counting
+    auto queueBatch = [&]()
+    {
+        for (size_t i = 0; i < BATCH; ++i)
+        {
+            pContext->request(request, callback);
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (pContext->getStats().callbackQueueDepth < BATCH && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return pContext->getStats().callbackQueueDepth == BATCH;
+    };
+
+    // Grows the callback queue's two vectors, which take turns
+    for (int i = 0; i < 2; ++i)
+    {
+        REQUIRE(queueBatch());
+        pContext->runCallbacks();
+    }
+
+    REQUIRE(queueBatch());
+    answered = 0;
+    total = 0;
+    uint64_t before = getThreadAllocationCount();
+    pContext->runCallbacks();
+    uint64_t allocations = getThreadAllocationCount() - before;
+
+    REQUIRE(answered == BATCH);
+    REQUIRE(total > BATCH * 256);
+    REQUIRE(allocations == 0);
+}
@@ -0,0 +1,1349 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#include "S2SMockServer.h"
+
+#include <json/json.h>
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cerrno>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+#if defined(_WIN32)
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace BrainCloud
+{
+    namespace
+    {
+        using Clock = std::chrono::steady_clock;
+
+        static const int SERVER_SESSION_EXPIRED = 40365;
+        static const int INVALID_CREDENTIALS = 40307;
+        static const int INJECTED_ERROR = 50000;
+
+#if defined(_WIN32)
+        using SocketHandle = SOCKET;
+        static const SocketHandle NO_SOCKET = INVALID_SOCKET;
+        static const int SEND_FLAGS = 0;
+
+        void closeSocket(SocketHandle socket) { closesocket(socket); }
+        int pollSockets(WSAPOLLFD* fds, size_t count, int timeoutMS) { return WSAPoll(fds, (ULONG)count, timeoutMS); }
+        using PollFd = WSAPOLLFD;
+
+        bool setNonBlocking(SocketHandle socket)
+        {
+            u_long nonBlocking = 1;
+            return ioctlsocket(socket, FIONBIO, &nonBlocking) == 0;
+        }
+
+        bool wouldBlock()
+        {
+            return WSAGetLastError() == WSAEWOULDBLOCK;
+        }
+#else
+        using SocketHandle = int;
+        static const SocketHandle NO_SOCKET = -1;
+#if defined(MSG_NOSIGNAL)
+        static const int SEND_FLAGS = MSG_NOSIGNAL;
+#else
+        static const int SEND_FLAGS = 0;
+#endif
+
+        void closeSocket(SocketHandle socket) { ::close(socket); }
+        int pollSockets(pollfd* fds, size_t count, int timeoutMS) { return ::poll(fds, (nfds_t)count, timeoutMS); }
+        using PollFd = pollfd;
+
+        bool setNonBlocking(SocketHandle socket)
+        {
+            int flags = fcntl(socket, F_GETFL, 0);
+            return flags >= 0 && fcntl(socket, F_SETFL, flags | O_NONBLOCK) == 0;
+        }
+
+        bool wouldBlock()
+        {
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        }
+#endif
+
+        // Binds a socket on 127.0.0.1, port 0 for any free one
+        SocketHandle openSocket(int type, int port)
+        {
+            SocketHandle socket = ::socket(AF_INET, type, 0);
+            if (socket == NO_SOCKET) return NO_SOCKET;
+
+#if !defined(_WIN32)
+            // Lets a fixed port be reused right after a restart. On Windows
+            // it would let two servers share the port.
+            int reuse = 1;
+            setsockopt(socket, SOL_SOCKET, SO_REUSEADDR, (const char*)&reuse, sizeof(reuse));
+#endif
+
+            sockaddr_in address;
+            memset(&address, 0, sizeof(address));
+            address.sin_family = AF_INET;
+            address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+            address.sin_port = htons((uint16_t)port);
+            if (bind(socket, (const sockaddr*)&address, sizeof(address)) != 0 ||
+                (type == SOCK_STREAM && listen(socket, 128) != 0) ||
+                !setNonBlocking(socket))
+            {
+                closeSocket(socket);
+                return NO_SOCKET;
+            }
+            return socket;
+        }
+
+        int getPort(SocketHandle socket)
+        {
+            sockaddr_in address;
+            socklen_t size = sizeof(address);
+            if (getsockname(socket, (sockaddr*)&address, &size) != 0) return 0;
+            return ntohs(address.sin_port);
+        }
+
+        std::string toLower(std::string value)
+        {
+            std::transform(value.begin(), value.end(), value.begin(), [](unsigned char c) { return (char)tolower(c); });
+            return value;
+        }
+
+        std::string trim(const std::string& value)
+        {
+            size_t begin = value.find_first_not_of(" \t");
+            if (begin == std::string::npos) return "";
+            size_t end = value.find_last_not_of(" \t");
+            return value.substr(begin, end - begin + 1);
+        }
+
+        std::string writeJson(const Json::Value& value)
+        {
+            Json::FastWriter writer;
+            std::string json = writer.write(value);
+            if (!json.empty() && json.back() == '\n') json.pop_back();
+            return json;
+        }
+
+        // SHA-1 and base64, only for the WebSocket handshake's accept key
+        std::string sha1(const std::string& message)
+        {
+            uint32_t h[5] = {0x67452301, 0xEFCDAB89, 0x98BADCFE, 0x10325476, 0xC3D2E1F0};
+            std::string data = message;
+            uint64_t bitLength = (uint64_t)message.size() * 8;
+            data += (char)0x80;
+            while (data.size() % 64 != 56) data += (char)0;
+            for (int i = 7; i >= 0; --i) data += (char)((bitLength >> (i * 8)) & 0xFF);
+
+            auto rotate = [](uint32_t value, int bits) { return (value << bits) | (value >> (32 - bits)); };
+            for (size_t chunk = 0; chunk < data.size(); chunk += 64)
+            {
+                uint32_t w[80];
+                for (int i = 0; i < 16; ++i)
+                {
+                    const unsigned char* p = (const unsigned char*)&data[chunk + i * 4];
+                    w[i] = ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) | ((uint32_t)p[2] << 8) | p[3];
+                }
+                for (int i = 16; i < 80; ++i) w[i] = rotate(w[i - 3] ^ w[i - 8] ^ w[i - 14] ^ w[i - 16], 1);
+
+                uint32_t a = h[0], b = h[1], c = h[2], d = h[3], e = h[4];
+                for (int i = 0; i < 80; ++i)
+                {
+                    uint32_t f, k;
+                    if (i < 20) { f = (b & c) | (~b & d); k = 0x5A827999; }
+                    else if (i < 40) { f = b ^ c ^ d; k = 0x6ED9EBA1; }
+                    else if (i < 60) { f = (b & c) | (b & d) | (c & d); k = 0x8F1BBCDC; }
+                    else { f = b ^ c ^ d; k = 0xCA62C1D6; }
+                    uint32_t temp = rotate(a, 5) + f + e + k + w[i];
+                    e = d; d = c; c = rotate(b, 30); b = a; a = temp;
+                }
+                h[0] += a; h[1] += b; h[2] += c; h[3] += d; h[4] += e;
+            }
+
+            std::string digest;
+            for (int i = 0; i < 5; ++i)
+            {
+                for (int j = 3; j >= 0; --j) digest += (char)((h[i] >> (j * 8)) & 0xFF);
+            }
+            return digest;
+        }
+
+        std::string base64(const std::string& data)
+        {
+            static const char* ALPHABET = "ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz0123456789+/";
+            std::string encoded;
+            for (size_t i = 0; i < data.size(); i += 3)
+            {
+                uint32_t value = (uint32_t)(unsigned char)data[i] << 16;
+                if (i + 1 < data.size()) value |= (uint32_t)(unsigned char)data[i + 1] << 8;
+                if (i + 2 < data.size()) value |= (uint32_t)(unsigned char)data[i + 2];
+                encoded += ALPHABET[(value >> 18) & 63];
+                encoded += ALPHABET[(value >> 12) & 63];
+                encoded += i + 1 < data.size() ? ALPHABET[(value >> 6) & 63] : '=';
+                encoded += i + 2 < data.size() ? ALPHABET[value & 63] : '=';
+            }
+            return encoded;
+        }
+
+        std::string webSocketFrame(const std::string& payload, int opcode = 1)
+        {
+            std::string frame;
+            frame += (char)(0x80 | opcode);
+            if (payload.size() < 126)
+            {
+                frame += (char)payload.size();
+            }
+            else if (payload.size() <= 0xFFFF)
+            {
+                frame += (char)126;
+                frame += (char)((payload.size() >> 8) & 0xFF);
+                frame += (char)(payload.size() & 0xFF);
+            }
+            else
+            {
+                frame += (char)127;
+                for (int i = 7; i >= 0; --i) frame += (char)(((uint64_t)payload.size() >> (i * 8)) & 0xFF);
+            }
+            return frame + payload;
+        }
+
+        std::string lengthPrefixedFrame(const std::string& payload)
+        {
+            uint32_t size = (uint32_t)payload.size();
+            std::string frame;
+            frame += (char)((size >> 24) & 0xFF);
+            frame += (char)((size >> 16) & 0xFF);
+            frame += (char)((size >> 8) & 0xFF);
+            frame += (char)(size & 0xFF);
+            return frame + payload;
+        }
+
+        std::string httpResponse(int status, const std::string& body, bool close = false,
+                                 const std::string& contentType = "application/json")
+        {
+            const char* reason = status == 200 ? "OK" : status == 400 ? "Bad Request" :
+                                 status == 404 ? "Not Found" : "Error";
+            std::string response = "HTTP/1.1 " + std::to_string(status) + " " + reason + "\r\n"
+                                   "Content-Type: " + contentType + "\r\n"
+                                   "Content-Length: " + std::to_string(body.size()) + "\r\n";
+            if (close) response += "Connection: close\r\n";
+            return response + "\r\n" + body;
+        }
+
+        std::string getQueryParameter(const std::string& path, const std::string& name)
+        {
+            size_t query = path.find('?');
+            if (query == std::string::npos) return "";
+            std::string key = name + "=";
+            size_t pos = query;
+            while (pos != std::string::npos && pos < path.size())
+            {
+                ++pos;
+                if (path.compare(pos, key.size(), key) == 0)
+                {
+                    size_t end = path.find('&', pos);
+                    return path.substr(pos + key.size(), end == std::string::npos ? std::string::npos : end - pos - key.size());
+                }
+                pos = path.find('&', pos);
+            }
+            return "";
+        }
+
+        // Contents of the multipart part named name, or false if there's none
+        bool getMultipartPart(const std::string& body, const std::string& contentType,
+                              const std::string& name, std::string& contents)
+        {
+            size_t boundaryPos = contentType.find("boundary=");
+            if (boundaryPos == std::string::npos) return false;
+            std::string boundary = contentType.substr(boundaryPos + 9);
+            if (!boundary.empty() && boundary.front() == '"') boundary = boundary.substr(1, boundary.find('"', 1) - 1);
+            std::string delimiter = "--" + boundary;
+
+            size_t pos = body.find(delimiter);
+            while (pos != std::string::npos)
+            {
+                size_t headersBegin = pos + delimiter.size() + 2;
+                size_t headersEnd = body.find("\r\n\r\n", headersBegin);
+                if (headersEnd == std::string::npos) return false;
+                size_t next = body.find("\r\n" + delimiter, headersEnd + 4);
+                if (next == std::string::npos) return false;
+
+                std::string headers = body.substr(headersBegin, headersEnd - headersBegin);
+                if (headers.find("name=\"" + name + "\"") != std::string::npos)
+                {
+                    contents = body.substr(headersEnd + 4, next - headersEnd - 4);
+                    return true;
+                }
+                pos = next + 2;
+            }
+            return false;
+        }
+
+        enum class Protocol
+        {
+            Http,
+            WebSocket,
+            Tcp
+        };
+
+        struct Connection
+        {
+            SocketHandle socket = NO_SOCKET;
+            Protocol protocol = Protocol::Http;
+
+            std::string input;
+            std::string output;
+            size_t outputOffset = 0;
+            bool closeAfterOutput = false;
+            bool closed = false;
+
+            // Http: the response being held for latency. The next request is
+            // read once it's sent.
+            bool waiting = false;
+            Clock::time_point respondAt;
+            std::string response;
+            bool closeAfterResponse = false;
+            bool continueSent = false;
+
+            // Throttling
+            double writeCredit = 0;
+            Clock::time_point lastRefill;
+
+            // RTT
+            std::string sessionId;
+            bool rttConnected = false;
+            std::string fragments;
+        };
+
+        struct Session
+        {
+            Clock::time_point lastSeen;
+            std::string rttSecret;
+        };
+
+        struct Upload
+        {
+            std::string treeId;
+            std::string fileName;
+        };
+
+        struct Counters
+        {
+            std::atomic<uint64_t> httpConnections{0};
+            std::atomic<uint64_t> packets{0};
+            std::atomic<uint64_t> messages{0};
+            std::atomic<uint64_t> authentications{0};
+            std::atomic<uint64_t> heartbeats{0};
+            std::atomic<uint64_t> uploads{0};
+            std::atomic<uint64_t> uploadBytes{0};
+            std::atomic<uint64_t> rttConnections{0};
+            std::atomic<uint64_t> rttHeartbeats{0};
+            std::atomic<uint64_t> rttEventsSent{0};
+            std::atomic<uint64_t> injectedErrors{0};
+            std::atomic<uint64_t> injectedDisconnects{0};
+            std::atomic<uint64_t> bytesReceived{0};
+            std::atomic<uint64_t> bytesSent{0};
+            std::atomic<uint64_t> maxHeldPackets{0};
+        };
+
+        struct PendingEvent
+        {
+            std::string sessionId; // Empty for every RTT connection
+            std::string message;
+        };
+    }
+
+    struct S2SMockServer::Impl
+    {
+        mutable std::mutex mutex;
+        Config config;
+        bool configChanged = false;
+        std::vector<PendingEvent> pendingEvents;
+
+        Counters counters;
+
+        std::thread thread;
+        std::atomic<bool> running{false};
+        SocketHandle httpListener = NO_SOCKET;
+        SocketHandle tcpListener = NO_SOCKET;
+        SocketHandle wakeSocket = NO_SOCKET;
+        int httpPort = 0;
+        int tcpPort = 0;
+
+        // Only touched by the server thread
+        Config loopConfig;
+        std::mt19937 random;
+        std::vector<std::unique_ptr<Connection>> connections;
+        std::map<std::string, Session> sessions;
+        std::map<std::string, Upload> uploads;
+        uint64_t nextId = 1;
+        double eventCredit = 0;
+        Clock::time_point lastEventTick;
+
+        void wake()
+        {
+            if (wakeSocket != NO_SOCKET) send(wakeSocket, "w", 1, SEND_FLAGS);
+        }
+
+        double roll()
+        {
+            return std::uniform_real_distribution<double>(0.0, 1.0)(random);
+        }
+
+        std::string newId(const char* prefix)
+        {
+            return prefix + std::to_string(nextId++);
+        }
+
+        void run()
+        {
+            lastEventTick = Clock::now();
+            std::vector<PollFd> fds;
+            std::vector<char> buffer(64 * 1024);
+            while (running)
+            {
+                auto now = Clock::now();
+                generateRttEvents(now);
+                int timeoutMS = loopConfig.rttEventsPerSecond > 0 ? 10 : 1000;
+
+                fds.clear();
+                fds.push_back({wakeSocket, POLLIN, 0});
+                fds.push_back({httpListener, POLLIN, 0});
+                fds.push_back({tcpListener, POLLIN, 0});
+                for (auto& connection : connections)
+                {
+                    short events = 0;
+                    if (!connection->waiting && !connection->closeAfterOutput) events |= POLLIN;
+                    if (connection->waiting)
+                    {
+                        auto wait = std::chrono::duration_cast<std::chrono::milliseconds>(connection->respondAt - now).count();
+                        timeoutMS = std::min(timeoutMS, (int)std::max<int64_t>(0, wait + 1));
+                    }
+                    if (connection->outputOffset < connection->output.size())
+                    {
+                        refillCredit(*connection, now);
+                        if (loopConfig.bytesPerSecond == 0 || connection->writeCredit >= 1) events |= POLLOUT;
+                        else timeoutMS = std::min(timeoutMS, 5);
+                    }
+                    fds.push_back({connection->socket, events, 0});
+                }
+
+                if (pollSockets(fds.data(), fds.size(), timeoutMS) < 0) continue;
+                now = Clock::now();
+
+                if (fds[0].revents & POLLIN)
+                {
+                    while (recv(wakeSocket, buffer.data(), (int)buffer.size(), 0) > 0) {}
+                }
+
+                // After the poll, so a request sent after setConfig() returned
+                // sees the new config
+                {
+                    std::unique_lock<std::mutex> lock(mutex);
+                    if (configChanged)
+                    {
+                        loopConfig = config;
+                        configChanged = false;
+                    }
+                    for (auto& event : pendingEvents) sendRttEvent(event.sessionId, event.message);
+                    pendingEvents.clear();
+                }
+                if (fds[1].revents & POLLIN) accept(httpListener, Protocol::Http);
+                if (fds[2].revents & POLLIN) accept(tcpListener, Protocol::Tcp);
+
+                // Accepted connections weren't polled yet
+                for (size_t i = 3; i < fds.size(); ++i)
+                {
+                    Connection& connection = *connections[i - 3];
+                    if (fds[i].revents & (POLLIN | POLLHUP | POLLERR)) read(connection, buffer, now);
+                    if (!connection.closed && (fds[i].revents & POLLOUT)) write(connection, now);
+                }
+                for (auto& connection : connections)
+                {
+                    if (connection->closed) continue;
+                    if (connection->waiting && connection->respondAt <= now)
+                    {
+                        connection->waiting = false;
+                        connection->output += connection->response;
+                        connection->response.clear();
+                        connection->closeAfterOutput = connection->closeAfterResponse;
+                        write(*connection, now);
+
+                        // Requests that came while waiting
+                        if (!connection->closed && !connection->input.empty()) process(*connection, now);
+                    }
+                }
+
+                connections.erase(std::remove_if(connections.begin(), connections.end(),
+                    [](const std::unique_ptr<Connection>& connection)
+                    {
+                        if (connection->closed) closeSocket(connection->socket);
+                        return connection->closed;
+                    }), connections.end());
+            }
+
+            for (auto& connection : connections) closeSocket(connection->socket);
+            connections.clear();
+        }
+
+        void accept(SocketHandle listener, Protocol protocol)
+        {
+            while (true)
+            {
+                SocketHandle socket = ::accept(listener, nullptr, nullptr);
+                if (socket == NO_SOCKET) return;
+                int noDelay = 1;
+                setsockopt(socket, IPPROTO_TCP, TCP_NODELAY, (const char*)&noDelay, sizeof(noDelay));
+#if defined(SO_NOSIGPIPE)
+                setsockopt(socket, SOL_SOCKET, SO_NOSIGPIPE, (const char*)&noDelay, sizeof(noDelay));
+#endif
+                setNonBlocking(socket);
+
+                std::unique_ptr<Connection> connection(new Connection());
+                connection->socket = socket;
+                connection->protocol = protocol;
+                connection->lastRefill = Clock::now();
+                if (protocol == Protocol::Http) counters.httpConnections++;
+                connections.push_back(std::move(connection));
+            }
+        }
+
+        void read(Connection& connection, std::vector<char>& buffer, Clock::time_point now)
+        {
+            while (true)
+            {
+                int received = (int)recv(connection.socket, buffer.data(), (int)buffer.size(), 0);
+                if (received > 0)
+                {
+                    counters.bytesReceived += received;
+                    connection.input.append(buffer.data(), received);
+                    continue;
+                }
+                if (received == 0 || !wouldBlock()) connection.closed = true;
+                break;
+            }
+            if (!connection.closed && !connection.waiting) process(connection, now);
+        }
+
+        void refillCredit(Connection& connection, Clock::time_point now)
+        {
+            if (loopConfig.bytesPerSecond == 0) return;
+            double elapsed = std::chrono::duration<double>(now - connection.lastRefill).count();
+            connection.lastRefill = now;
+            double burst = std::max(1460.0, (double)loopConfig.bytesPerSecond / 20.0);
+            connection.writeCredit = std::min(burst, connection.writeCredit + elapsed * (double)loopConfig.bytesPerSecond);
+        }
+
+        void write(Connection& connection, Clock::time_point now)
+        {
+            while (connection.outputOffset < connection.output.size())
+            {
+                size_t size = connection.output.size() - connection.outputOffset;
+                if (loopConfig.bytesPerSecond > 0)
+                {
+                    refillCredit(connection, now);
+                    size = std::min(size, (size_t)connection.writeCredit);
+                    if (size == 0) return;
+                }
+
+                int sent = (int)send(connection.socket, connection.output.data() + connection.outputOffset, (int)size, SEND_FLAGS);
+                if (sent <= 0)
+                {
+                    if (sent < 0 && !wouldBlock()) connection.closed = true;
+                    return;
+                }
+                counters.bytesSent += sent;
+                connection.outputOffset += sent;
+                if (loopConfig.bytesPerSecond > 0) connection.writeCredit -= sent;
+            }
+
+            connection.output.clear();
+            connection.outputOffset = 0;
+            if (connection.closeAfterOutput) connection.closed = true;
+        }
+
+        void queueOutput(Connection& connection, const std::string& data, Clock::time_point now)
+        {
+            connection.output += data;
+            write(connection, now);
+        }
+
+        void process(Connection& connection, Clock::time_point now)
+        {
+            switch (connection.protocol)
+            {
+                case Protocol::Http: processHttp(connection, now); break;
+                case Protocol::WebSocket: processWebSocket(connection, now); break;
+                case Protocol::Tcp: processTcp(connection, now); break;
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // Http
+        ///////////////////////////////////////////////////////////////////////
+
+        // Decodes a chunked body starting at begin. False until all of it came.
+        static bool decodeChunked(const std::string& input, size_t begin, std::string& body, size_t& end)
+        {
+            body.clear();
+            size_t pos = begin;
+            while (true)
+            {
+                size_t lineEnd = input.find("\r\n", pos);
+                if (lineEnd == std::string::npos) return false;
+                size_t size = strtoul(input.substr(pos, lineEnd - pos).c_str(), nullptr, 16);
+                pos = lineEnd + 2;
+                if (size == 0)
+                {
+                    // Trailers, then an empty line
+                    size_t trailersEnd = input.find("\r\n", pos);
+                    while (trailersEnd != std::string::npos && trailersEnd != pos)
+                    {
+                        pos = trailersEnd + 2;
+                        trailersEnd = input.find("\r\n", pos);
+                    }
+                    if (trailersEnd == std::string::npos) return false;
+                    end = trailersEnd + 2;
+                    return true;
+                }
+                if (input.size() < pos + size + 2) return false;
+                body.append(input, pos, size);
+                pos += size + 2;
+            }
+        }
+
+        void processHttp(Connection& connection, Clock::time_point now)
+        {
+            while (!connection.waiting && !connection.closed && !connection.closeAfterOutput)
+            {
+                size_t headersEnd = connection.input.find("\r\n\r\n");
+                if (headersEnd == std::string::npos) return;
+
+                std::string method, path;
+                std::map<std::string, std::string> headers;
+                size_t lineEnd = connection.input.find("\r\n");
+                {
+                    std::string requestLine = connection.input.substr(0, lineEnd);
+                    size_t methodEnd = requestLine.find(' ');
+                    size_t pathEnd = requestLine.find(' ', methodEnd + 1);
+                    if (methodEnd == std::string::npos || pathEnd == std::string::npos)
+                    {
+                        connection.input.clear();
+                        connection.closeAfterOutput = true;
+                        queueOutput(connection, httpResponse(400, "{}", true), now);
+                        return;
+                    }
+                    method = requestLine.substr(0, methodEnd);
+                    path = requestLine.substr(methodEnd + 1, pathEnd - methodEnd - 1);
+                }
+                while (lineEnd < headersEnd)
+                {
+                    size_t next = connection.input.find("\r\n", lineEnd + 2);
+                    std::string line = connection.input.substr(lineEnd + 2, next - lineEnd - 2);
+                    size_t colon = line.find(':');
+                    if (colon != std::string::npos)
+                    {
+                        headers[toLower(line.substr(0, colon))] = trim(line.substr(colon + 1));
+                    }
+                    lineEnd = next;
+                }
+
+                if (toLower(headers["upgrade"]) == "websocket")
+                {
+                    connection.input.erase(0, headersEnd + 4);
+                    upgradeToWebSocket(connection, headers["sec-websocket-key"], now);
+                    return;
+                }
+
+                std::string body;
+                size_t requestEnd = headersEnd + 4;
+                if (toLower(headers["transfer-encoding"]).find("chunked") != std::string::npos)
+                {
+                    if (!decodeChunked(connection.input, headersEnd + 4, body, requestEnd))
+                    {
+                        sendContinue(connection, headers, now);
+                        return;
+                    }
+                }
+                else
+                {
+                    size_t contentLength = strtoul(headers["content-length"].c_str(), nullptr, 10);
+                    if (connection.input.size() < headersEnd + 4 + contentLength)
+                    {
+                        sendContinue(connection, headers, now);
+                        return;
+                    }
+                    body = connection.input.substr(headersEnd + 4, contentLength);
+                    requestEnd = headersEnd + 4 + contentLength;
+                }
+                connection.input.erase(0, requestEnd);
+                connection.continueSent = false;
+
+                bool close = toLower(headers["connection"]) == "close";
+                handleHttpRequest(connection, method, path, headers, body, close, now);
+            }
+        }
+
+        void sendContinue(Connection& connection, std::map<std::string, std::string>& headers, Clock::time_point now)
+        {
+            if (!connection.continueSent && toLower(headers["expect"]) == "100-continue")
+            {
+                connection.continueSent = true;
+                queueOutput(connection, "HTTP/1.1 100 Continue\r\n\r\n", now);
+            }
+        }
+
+        void respond(Connection& connection, const std::string& response, bool close,
+                     uint64_t delayMS, Clock::time_point now)
+        {
+            if (delayMS == 0)
+            {
+                connection.closeAfterOutput = close;
+                queueOutput(connection, response, now);
+                return;
+            }
+            connection.waiting = true;
+            connection.respondAt = now + std::chrono::milliseconds(delayMS);
+            connection.response = response;
+            connection.closeAfterResponse = close;
+        }
+
+        uint64_t getLatency()
+        {
+            uint64_t latency = loopConfig.latencyMS;
+            if (loopConfig.latencyJitterMS > 0)
+            {
+                latency += std::uniform_int_distribution<uint64_t>(0, loopConfig.latencyJitterMS)(random);
+            }
+            return latency;
+        }
+
+        void handleHttpRequest(Connection& connection, const std::string& method, const std::string& path,
+                               std::map<std::string, std::string>& headers, const std::string& body,
+                               bool close, Clock::time_point now)
+        {
+            if (method == "GET" && path == "/stats")
+            {
+                respond(connection, httpResponse(200, writeJson(statsToJson()), close), close, 0, now);
+            }
+            else if (method == "POST" && path.compare(0, 14, "/s2sdispatcher") == 0)
+            {
+                uint64_t delayMS = getLatency();
+                std::string response;
+                if (!handlePacket(body, response, delayMS, now))
+                {
+                    // Dropped: the client sees the connection close
+                    counters.injectedDisconnects++;
+                    connection.input.clear();
+                    connection.closed = true;
+                    return;
+                }
+                respond(connection, httpResponse(200, response, close), close, delayMS, now);
+
+                uint64_t held = (uint64_t)std::count_if(connections.begin(), connections.end(),
+                                                        [](const std::unique_ptr<Connection>& other)
+                                                        {
+                                                            return other->waiting;
+                                                        });
+                if (held > counters.maxHeldPackets) counters.maxHeldPackets = held;
+            }
+            else if (method == "POST" && path.compare(0, 12, "/s2suploader") == 0)
+            {
+                std::string response = handleUpload(path, headers["content-type"], body);
+                respond(connection, httpResponse(200, response, close), close, getLatency(), now);
+            }
+            else
+            {
+                respond(connection, httpResponse(404, "{\"status\":404}", close), close, 0, now);
+            }
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // Dispatcher
+        ///////////////////////////////////////////////////////////////////////
+
+        static Json::Value errorResponse(int status, int reasonCode, const std::string& message)
+        {
+            Json::Value response(Json::objectValue);
+            response["status"] = status;
+            response["reason_code"] = reasonCode;
+            response["status_message"] = message;
+            response["severity"] = "ERROR";
+            return response;
+        }
+
+        static Json::Value successResponse(const Json::Value& data = Json::Value(Json::objectValue))
+        {
+            Json::Value response(Json::objectValue);
+            response["status"] = 200;
+            response["data"] = data.isNull() ? Json::Value(Json::objectValue) : data;
+            return response;
+        }
+
+        bool isSessionValid(const std::string& sessionId, Clock::time_point now)
+        {
+            auto it = sessions.find(sessionId);
+            if (it == sessions.end()) return false;
+            if (loopConfig.sessionTimeoutSeconds > 0 &&
+                now - it->second.lastSeen > std::chrono::seconds(loopConfig.sessionTimeoutSeconds))
+            {
+                sessions.erase(it);
+                return false;
+            }
+            it->second.lastSeen = now;
+            return true;
+        }
+
+        // False if the packet is to be dropped without an answer
+        bool handlePacket(const std::string& body, std::string& response, uint64_t& delayMS, Clock::time_point now)
+        {
+            counters.packets++;
+            if (loopConfig.disconnectRate > 0 && roll() < loopConfig.disconnectRate) return false;
+
+            Json::Value packet;
+            Json::Reader reader;
+            if (!reader.parse(body, packet) || !packet.isObject())
+            {
+                Json::Value result = errorResponse(400, 40001, "Malformed packet");
+                response = writeJson(result);
+                return true;
+            }
+
+            std::string sessionId = packet["sessionId"].asString();
+            Json::Value responses(Json::arrayValue);
+            const Json::Value& messages = packet["messages"];
+            for (Json::ArrayIndex i = 0; i < messages.size(); ++i)
+            {
+                counters.messages++;
+                Json::Value result = handleMessage(messages[i], sessionId, delayMS, now);
+                if (loopConfig.responsePadding > 0 && messages[i]["service"].asString() != "authenticationV2")
+                {
+                    result["padding"] = std::string(loopConfig.responsePadding, 'x');
+                }
+                responses.append(result);
+            }
+
+            Json::Value result(Json::objectValue);
+            result["packetId"] = packet["packetId"];
+            result["messageResponses"] = responses;
+            response = writeJson(result);
+            return true;
+        }
+
+        Json::Value handleMessage(const Json::Value& message, const std::string& sessionId,
+                                  uint64_t& delayMS, Clock::time_point now)
+        {
+            std::string service = message["service"].asString();
+            std::string operation = message["operation"].asString();
+            const Json::Value& data = message["data"];
+
+            if (service == "authenticationV2" && operation == "AUTHENTICATE")
+            {
+                if (data["appId"].asString() != loopConfig.appId ||
+                    data["serverName"].asString() != loopConfig.serverName ||
+                    (!loopConfig.serverSecret.empty() && data["serverSecret"].asString() != loopConfig.serverSecret))
+                {
+                    return errorResponse(403, INVALID_CREDENTIALS, "Invalid server credentials");
+                }
+
+                counters.authentications++;
+                std::string newSessionId = newId("mocksession");
+                Session& session = sessions[newSessionId];
+                session.lastSeen = now;
+                session.rttSecret = newId("rttsecret");
+
+                Json::Value result(Json::objectValue);
+                result["sessionId"] = newSessionId;
+                result["heartbeatSeconds"] = loopConfig.heartbeatSeconds;
+                result["server_time"] = (Json::UInt64)std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                return successResponse(result);
+            }
+
+            if (!isSessionValid(sessionId, now))
+            {
+                return errorResponse(403, SERVER_SESSION_EXPIRED, "Session expired");
+            }
+
+            if (loopConfig.errorRate > 0 && roll() < loopConfig.errorRate)
+            {
+                counters.injectedErrors++;
+                return errorResponse(500, INJECTED_ERROR, "Injected error");
+            }
+
+            if (service == "heartbeat")
+            {
+                counters.heartbeats++;
+                return successResponse();
+            }
+            if (service == "time" && operation == "READ")
+            {
+                Json::Value result(Json::objectValue);
+                result["server_time"] = (Json::UInt64)std::chrono::duration_cast<std::chrono::milliseconds>(
+                    std::chrono::system_clock::now().time_since_epoch()).count();
+                return successResponse(result);
+            }
+            if (service == "rttRegistration" && operation == "REQUEST_SYSTEM_CONNECTION")
+            {
+                Json::Value result(Json::objectValue);
+                Json::Value& endpoints = result["endpoints"];
+                endpoints = Json::Value(Json::arrayValue);
+                Json::Value endpoint(Json::objectValue);
+                endpoint["host"] = "127.0.0.1";
+                endpoint["ssl"] = false;
+                endpoint["protocol"] = "ws";
+                endpoint["port"] = httpPort;
+                endpoints.append(endpoint);
+                endpoint["protocol"] = "tcp";
+                endpoint["port"] = tcpPort;
+                endpoints.append(endpoint);
+                result["auth"]["X-RTT-SECRET"] = sessions[sessionId].rttSecret;
+                return successResponse(result);
+            }
+            if (service == "globalFileV3" && operation == "SYS_PREPARE_UPLOAD")
+            {
+                std::string uploadId = newId("mockupload");
+                Upload& upload = uploads[uploadId];
+                upload.treeId = data["treeId"].asString();
+                upload.fileName = data["fileName"].asString();
+
+                Json::Value result(Json::objectValue);
+                result["fileDetails"]["uploadId"] = uploadId;
+                result["fileDetails"]["treeId"] = upload.treeId;
+                result["fileDetails"]["fileName"] = upload.fileName;
+                return successResponse(result);
+            }
+            if (service == "mock")
+            {
+                if (operation == "SLEEP")
+                {
+                    delayMS += data["ms"].asUInt64();
+                    return successResponse();
+                }
+                if (operation == "ERROR")
+                {
+                    return errorResponse(data.get("status", 500).asInt(), data.get("reason_code", INJECTED_ERROR).asInt(),
+                                         data.get("status_message", "Mock error").asString());
+                }
+                if (operation == "PUSH")
+                {
+                    Json::Value event(Json::objectValue);
+                    event["service"] = data.get("service", loopConfig.rttEventService);
+                    event["operation"] = data.get("operation", "MOCK");
+                    event["data"] = data["data"];
+                    sendRttEvent(sessionId, writeJson(event));
+                    return successResponse();
+                }
+                if (operation == "EXPIRE")
+                {
+                    sessions.erase(sessionId);
+                    return successResponse();
+                }
+            }
+
+            // ECHO and everything else
+            return successResponse(data);
+        }
+
+        std::string handleUpload(const std::string& path, const std::string& contentType, const std::string& body)
+        {
+            auto it = uploads.find(getQueryParameter(path, "uploadId"));
+            if (it == uploads.end())
+            {
+                return writeJson(errorResponse(400, 40001, "Unknown uploadId"));
+            }
+
+            std::string contents;
+            if (!getMultipartPart(body, contentType, "file", contents))
+            {
+                return writeJson(errorResponse(400, 40001, "Missing file part"));
+            }
+            counters.uploads++;
+            counters.uploadBytes += contents.size();
+
+            // Shaped like the uploader's answer, which nests the file's details
+            Json::Value result(Json::objectValue);
+            result["fileDetails"]["uploadId"] = it->first;
+            Json::Value& fileDetails = result["fileDetails"]["fileDetails"];
+            fileDetails["fileId"] = newId("mockfile");
+            fileDetails["version"] = 1;
+            fileDetails["treeId"] = it->second.treeId;
+            fileDetails["fileName"] = it->second.fileName;
+            fileDetails["fileSize"] = (Json::UInt64)contents.size();
+            uploads.erase(it);
+            return writeJson(successResponse(result));
+        }
+
+        ///////////////////////////////////////////////////////////////////////
+        // RTT
+        ///////////////////////////////////////////////////////////////////////
+
+        void upgradeToWebSocket(Connection& connection, const std::string& key, Clock::time_point now)
+        {
+            if (key.empty())
+            {
+                connection.closeAfterOutput = true;
+                queueOutput(connection, httpResponse(400, "{}", true), now);
+                return;
+            }
+            connection.protocol = Protocol::WebSocket;
+            std::string accept = base64(sha1(key + "258EAFA5-E914-47DA-95CA-C5AB0DC85B11"));
+            queueOutput(connection, "HTTP/1.1 101 Switching Protocols\r\n"
+                                    "Upgrade: websocket\r\n"
+                                    "Connection: Upgrade\r\n"
+                                    "Sec-WebSocket-Accept: " + accept + "\r\n\r\n", now);
+            processWebSocket(connection, now);
+        }
+
+        void sendRttMessage(Connection& connection, const std::string& message, Clock::time_point now)
+        {
+            if (connection.protocol == Protocol::WebSocket) queueOutput(connection, webSocketFrame(message), now);
+            else queueOutput(connection, lengthPrefixedFrame(message), now);
+        }
+
+        void processWebSocket(Connection& connection, Clock::time_point now)
+        {
+            std::string& input = connection.input;
+            while (!connection.closed && input.size() >= 2)
+            {
+                const unsigned char* bytes = (const unsigned char*)input.data();
+                bool final = (bytes[0] & 0x80) != 0;
+                int opcode = bytes[0] & 0x0F;
+                bool masked = (bytes[1] & 0x80) != 0;
+                uint64_t size = bytes[1] & 0x7F;
+                size_t headerSize = 2;
+                if (size == 126)
+                {
+                    if (input.size() < 4) return;
+                    size = ((uint64_t)bytes[2] << 8) | bytes[3];
+                    headerSize = 4;
+                }
+                else if (size == 127)
+                {
+                    if (input.size() < 10) return;
+                    size = 0;
+                    for (int i = 0; i < 8; ++i) size = (size << 8) | bytes[2 + i];
+                    headerSize = 10;
+                }
+                size_t maskOffset = headerSize;
+                if (masked) headerSize += 4;
+                if (input.size() < headerSize + size) return;
+
+                std::string payload = input.substr(headerSize, (size_t)size);
+                if (masked)
+                {
+                    for (size_t i = 0; i < payload.size(); ++i) payload[i] ^= input[maskOffset + (i % 4)];
+                }
+                input.erase(0, headerSize + (size_t)size);
+
+                switch (opcode)
+                {
+                    case 0x0: // Continuation
+                    case 0x1: // Text
+                    case 0x2: // Binary
+                        connection.fragments += payload;
+                        if (final)
+                        {
+                            std::string message;
+                            message.swap(connection.fragments);
+                            handleRttMessage(connection, message, now);
+                        }
+                        break;
+                    case 0x8: // Close
+                        connection.closeAfterOutput = true;
+                        queueOutput(connection, webSocketFrame(payload.substr(0, 2), 0x8), now);
+                        return;
+                    case 0x9: // Ping
+                        queueOutput(connection, webSocketFrame(payload, 0xA), now);
+                        break;
+                    default:
+                        break;
+                }
+            }
+        }
+
+        void processTcp(Connection& connection, Clock::time_point now)
+        {
+            std::string& input = connection.input;
+            while (!connection.closed && input.size() >= 4)
+            {
+                const unsigned char* bytes = (const unsigned char*)input.data();
+                size_t size = ((size_t)bytes[0] << 24) | ((size_t)bytes[1] << 16) | ((size_t)bytes[2] << 8) | bytes[3];
+                if (input.size() < 4 + size) return;
+                std::string message = input.substr(4, size);
+                input.erase(0, 4 + size);
+                handleRttMessage(connection, message, now);
+            }
+        }
+
+        void handleRttMessage(Connection& connection, const std::string& message, Clock::time_point now)
+        {
+            Json::Value json;
+            Json::Reader reader;
+            if (!reader.parse(message, json) || json["service"].asString() != "rtt") return;
+
+            std::string operation = json["operation"].asString();
+            if (operation == "CONNECT")
+            {
+                const Json::Value& data = json["data"];
+                std::string sessionId = data["sessionId"].asString();
+                auto it = sessions.find(sessionId);
+                if (it == sessions.end() || !isSessionValid(sessionId, now) ||
+                    data["auth"]["X-RTT-SECRET"].asString() != it->second.rttSecret)
+                {
+                    Json::Value disconnect(Json::objectValue);
+                    disconnect["service"] = "rtt";
+                    disconnect["operation"] = "DISCONNECT";
+                    disconnect["data"]["reason"] = "Invalid session";
+                    disconnect["data"]["reasonCode"] = SERVER_SESSION_EXPIRED;
+                    sendRttMessage(connection, writeJson(disconnect), now);
+                    connection.closeAfterOutput = true;
+                    if (connection.output.empty()) connection.closed = true;
+                    return;
+                }
+
+                counters.rttConnections++;
+                connection.sessionId = sessionId;
+                connection.rttConnected = true;
+
+                Json::Value connected(Json::objectValue);
+                connected["service"] = "rtt";
+                connected["operation"] = "CONNECT";
+                connected["data"]["cxId"] = newId("mockcx");
+                connected["data"]["heartbeatSeconds"] = loopConfig.rttHeartbeatSeconds;
+                sendRttMessage(connection, writeJson(connected), now);
+            }
+            else if (operation == "HEARTBEAT")
+            {
+                counters.rttHeartbeats++;
+            }
+        }
+
+        // To the RTT connections of a session, or of every session
+        void sendRttEvent(const std::string& sessionId, const std::string& message)
+        {
+            auto now = Clock::now();
+            for (auto& connection : connections)
+            {
+                if (connection->closed || !connection->rttConnected) continue;
+                if (!sessionId.empty() && connection->sessionId != sessionId) continue;
+                counters.rttEventsSent++;
+                sendRttMessage(*connection, message, now);
+            }
+        }
+
+        void generateRttEvents(Clock::time_point now)
+        {
+            double elapsed = std::chrono::duration<double>(now - lastEventTick).count();
+            lastEventTick = now;
+            if (loopConfig.rttEventsPerSecond <= 0)
+            {
+                eventCredit = 0;
+                return;
+            }
+
+            eventCredit = std::min(eventCredit + elapsed * loopConfig.rttEventsPerSecond,
+                                   std::max(1.0, loopConfig.rttEventsPerSecond));
+            if (eventCredit < 1) return;
+
+            Json::Value event(Json::objectValue);
+            event["service"] = loopConfig.rttEventService;
+            event["operation"] = "MOCK";
+            event["data"]["payload"] = std::string(loopConfig.rttEventSize, 'x');
+            std::string message = writeJson(event);
+            for (; eventCredit >= 1; eventCredit -= 1) sendRttEvent("", message);
+        }
+
+        Json::Value statsToJson() const
+        {
+            Json::Value json(Json::objectValue);
+            json["httpConnections"] = (Json::UInt64)counters.httpConnections;
+            json["packets"] = (Json::UInt64)counters.packets;
+            json["messages"] = (Json::UInt64)counters.messages;
+            json["authentications"] = (Json::UInt64)counters.authentications;
+            json["heartbeats"] = (Json::UInt64)counters.heartbeats;
+            json["uploads"] = (Json::UInt64)counters.uploads;
+            json["uploadBytes"] = (Json::UInt64)counters.uploadBytes;
+            json["rttConnections"] = (Json::UInt64)counters.rttConnections;
+            json["rttHeartbeats"] = (Json::UInt64)counters.rttHeartbeats;
+            json["rttEventsSent"] = (Json::UInt64)counters.rttEventsSent;
+            json["injectedErrors"] = (Json::UInt64)counters.injectedErrors;
+            json["injectedDisconnects"] = (Json::UInt64)counters.injectedDisconnects;
+            json["bytesReceived"] = (Json::UInt64)counters.bytesReceived;
+            json["bytesSent"] = (Json::UInt64)counters.bytesSent;
+            json["maxHeldPackets"] = (Json::UInt64)counters.maxHeldPackets;
+            return json;
+        }
+    };
+
+    S2SMockServer::S2SMockServer()
+        : m_impl(new Impl())
+    {
+    }
+
+    S2SMockServer::S2SMockServer(const Config& config)
+        : m_impl(new Impl())
+    {
+        m_impl->config = config;
+    }
+
+    S2SMockServer::~S2SMockServer()
+    {
+        stop();
+    }
+
+    bool S2SMockServer::start(int httpPort, int tcpPort)
+    {
+        Impl& impl = *m_impl;
+        if (impl.running) return true;
+
+#if defined(_WIN32)
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) return false;
+#endif
+
+        impl.httpListener = openSocket(SOCK_STREAM, httpPort);
+        impl.tcpListener = openSocket(SOCK_STREAM, tcpPort);
+
+        // A datagram socket connected to itself wakes the poll() up
+        impl.wakeSocket = openSocket(SOCK_DGRAM, 0);
+        if (impl.wakeSocket != NO_SOCKET)
+        {
+            sockaddr_in address;
+            socklen_t size = sizeof(address);
+            if (getsockname(impl.wakeSocket, (sockaddr*)&address, &size) != 0 ||
+                connect(impl.wakeSocket, (const sockaddr*)&address, size) != 0)
+            {
+                closeSocket(impl.wakeSocket);
+                impl.wakeSocket = NO_SOCKET;
+            }
+        }
+
+        if (impl.httpListener == NO_SOCKET || impl.tcpListener == NO_SOCKET || impl.wakeSocket == NO_SOCKET)
+        {
+            if (impl.httpListener != NO_SOCKET) closeSocket(impl.httpListener);
+            if (impl.tcpListener != NO_SOCKET) closeSocket(impl.tcpListener);
+            if (impl.wakeSocket != NO_SOCKET) closeSocket(impl.wakeSocket);
+            impl.httpListener = impl.tcpListener = impl.wakeSocket = NO_SOCKET;
+            return false;
+        }
+
+        impl.httpPort = getPort(impl.httpListener);
+        impl.tcpPort = getPort(impl.tcpListener);
+        {
+            std::unique_lock<std::mutex> lock(impl.mutex);
+            impl.loopConfig = impl.config;
+            impl.configChanged = false;
+        }
+        impl.random.seed(impl.loopConfig.seed);
+        impl.running = true;
+        impl.thread = std::thread([&impl]() { impl.run(); });
+        return true;
+    }
+
+    void S2SMockServer::stop()
+    {
+        Impl& impl = *m_impl;
+        if (!impl.running) return;
+
+        impl.running = false;
+        impl.wake();
+        impl.thread.join();
+
+        closeSocket(impl.httpListener);
+        closeSocket(impl.tcpListener);
+        closeSocket(impl.wakeSocket);
+        impl.httpListener = impl.tcpListener = impl.wakeSocket = NO_SOCKET;
+        impl.sessions.clear();
+        impl.uploads.clear();
+#if defined(_WIN32)
+        WSACleanup();
+#endif
+    }
+
+    int S2SMockServer::getHttpPort() const
+    {
+        return m_impl->httpPort;
+    }
+
+    int S2SMockServer::getTcpPort() const
+    {
+        return m_impl->tcpPort;
+    }
+
+    std::string S2SMockServer::getDispatcherUrl() const
+    {
+        return "http://127.0.0.1:" + std::to_string(m_impl->httpPort) + "/s2sdispatcher";
+    }
+
+    void S2SMockServer::setConfig(const Config& config)
+    {
+        {
+            std::unique_lock<std::mutex> lock(m_impl->mutex);
+            m_impl->config = config;
+            m_impl->configChanged = true;
+        }
+        m_impl->wake();
+    }
+
+    S2SMockServer::Config S2SMockServer::getConfig() const
+    {
+        std::unique_lock<std::mutex> lock(m_impl->mutex);
+        return m_impl->config;
+    }
+
+    S2SMockServer::Stats S2SMockServer::getStats() const
+    {
+        const Counters& counters = m_impl->counters;
+        Stats stats;
+        stats.httpConnections = counters.httpConnections;
+        stats.packets = counters.packets;
+        stats.messages = counters.messages;
+        stats.authentications = counters.authentications;
+        stats.heartbeats = counters.heartbeats;
+        stats.uploads = counters.uploads;
+        stats.uploadBytes = counters.uploadBytes;
+        stats.rttConnections = counters.rttConnections;
+        stats.rttHeartbeats = counters.rttHeartbeats;
+        stats.rttEventsSent = counters.rttEventsSent;
+        stats.injectedErrors = counters.injectedErrors;
+        stats.injectedDisconnects = counters.injectedDisconnects;
+        stats.bytesReceived = counters.bytesReceived;
+        stats.bytesSent = counters.bytesSent;
+        stats.maxHeldPackets = counters.maxHeldPackets;
+        return stats;
+    }
+
+    void S2SMockServer::pushRttEvent(const std::string& service, const std::string& operation,
+                                     const std::string& dataJson)
+    {
+        Json::Value data;
+        Json::Reader reader;
+        if (!reader.parse(dataJson, data)) data = Json::Value(Json::objectValue);
+
+        Json::Value event(Json::objectValue);
+        event["service"] = service;
+        event["operation"] = operation;
+        event["data"] = data;
+        {
+            std::unique_lock<std::mutex> lock(m_impl->mutex);
+            m_impl->pendingEvents.push_back({"", writeJson(event)});
+        }
+        m_impl->wake();
+    }
+};
@@ -0,0 +1,131 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace BrainCloud
+{
+    /**
+     * Loopback stand-in for the brainCloud servers, so tests, benchmarks and
+     * load tests can run without a network or a brainCloud app. One thread
+     * serves, on ports picked by the system:
+     *  - the S2S dispatcher, POST /s2sdispatcher: authenticationV2,
+     *    heartbeat, rttRegistration, time, globalFileV3 and the mock service
+     *    below. Any other message is answered with its own data.
+     *  - the uploader, POST /s2suploader/...
+     *  - RTT over WebSocket (an upgrade on the http port) and over
+     *    length-prefixed TCP
+     *  - its stats as json, GET /stats
+     *
+     * The "mock" service steers single requests:
+     *  - ECHO: answers with the message's data
+     *  - SLEEP {"ms"}: holds the packet's response that much longer
+     *  - ERROR {"status", "reason_code"}: answers with that error
+     *  - PUSH {"service", "operation", "data"}: sends that RTT event to the
+     *    session's RTT connections
+     *  - EXPIRE: drops the session. Later messages get session expired.
+     */
+    class S2SMockServer
+    {
+    public:
+        struct Config
+        {
+            // Credentials authenticationV2 accepts. An empty secret accepts any.
+            std::string appId = "mockapp";
+            std::string serverName = "mockserver";
+            std::string serverSecret = "mocksecret";
+
+            // Handed to clients on authentication and on RTT connect
+            int heartbeatSeconds = 1800;
+            int rttHeartbeatSeconds = 30;
+            // Sessions the server heard nothing from for that long expire. 0 never.
+            int sessionTimeoutSeconds = 0;
+
+            // Every packet's response is held latencyMS, plus up to
+            // latencyJitterMS more
+            uint64_t latencyMS = 0;
+            uint64_t latencyJitterMS = 0;
+
+            // Share of messages answered with status 500, and of packets
+            // whose connection is closed without an answer. 0 to 1.
+            double errorRate = 0;
+            double disconnectRate = 0;
+
+            // Bytes written per second on each connection. 0 doesn't limit.
+            uint64_t bytesPerSecond = 0;
+            // Padding added to each echoed response
+            size_t responsePadding = 0;
+
+            // RTT events sent to every connected RTT client, per second, and
+            // the service they're for. PUSH defaults to that service too.
+            double rttEventsPerSecond = 0;
+            std::string rttEventService = "chat";
+            size_t rttEventSize = 64;
+
+            // Seed of the error injection and jitter, for repeatable runs
+            uint32_t seed = 1;
+        };
+
+        struct Stats
+        {
+            uint64_t httpConnections = 0;
+            uint64_t packets = 0;
+            uint64_t messages = 0;
+            uint64_t authentications = 0;
+            uint64_t heartbeats = 0;
+            uint64_t uploads = 0;
+            uint64_t uploadBytes = 0;
+            uint64_t rttConnections = 0;
+            uint64_t rttHeartbeats = 0;
+            uint64_t rttEventsSent = 0;
+            uint64_t injectedErrors = 0;
+            uint64_t injectedDisconnects = 0;
+            uint64_t bytesReceived = 0;
+            uint64_t bytesSent = 0;
+            // Most dispatcher packets held for their latency at once: how
+            // many a client had in flight
+            uint64_t maxHeldPackets = 0;
+        };
+
+        S2SMockServer();
+        explicit S2SMockServer(const Config& config);
+
+        /** Stops the server, closing every connection. */
+        ~S2SMockServer();
+
+        S2SMockServer(const S2SMockServer&) = delete;
+        S2SMockServer& operator=(const S2SMockServer&) = delete;
+
+        /**
+         * Listens on 127.0.0.1 and starts serving.
+         * @param httpPort, tcpPort Ports to listen on, 0 for any free one
+         * @return false if a port can't be opened
+         */
+        bool start(int httpPort = 0, int tcpPort = 0);
+
+        void stop();
+
+        int getHttpPort() const;
+        int getTcpPort() const;
+
+        /** e.g. "http://127.0.0.1:41234/s2sdispatcher" */
+        std::string getDispatcherUrl() const;
+
+        /** Changes the knobs of a running server. Applies to new packets. */
+        void setConfig(const Config& config);
+        Config getConfig() const;
+
+        Stats getStats() const;
+
+        /** Sends an RTT event to every connected RTT client. Thread safe. */
+        void pushRttEvent(const std::string& service, const std::string& operation,
+                          const std::string& dataJson);
+
+    private:
+        struct Impl;
+        std::unique_ptr<Impl> m_impl;
+    };
+};
@@ -0,0 +1,138 @@
+// Copyright 2026 bitHeads, Inc. All Rights Reserved.
+//
+// Runs the loopback mock brainCloud server on its own, e.g. to point the
+// test suite, bcs2s_loadgen or an app at it.
+//
+// Usage: bcs2s_mock [--port <n>] [--tcp-port <n>] [--app-id <id>]
+//                   [--server-name <name>] [--server-secret <secret>]
+//                   [--heartbeat-seconds <s>] [--session-timeout-seconds <s>]
+//                   [--latency-ms <ms>] [--jitter-ms <ms>]
+//                   [--error-rate <0-1>] [--disconnect-rate <0-1>]
+//                   [--bytes-per-second <n>] [--padding <bytes>]
+//                   [--rtt-events-per-second <n>] [--rtt-event-size <bytes>]
+//                   [--seed <n>] [--ids <path>]
+//
+// --ids writes an ids.txt the tests can load. The stats are printed when
+// the server is stopped with Ctrl+C, and served at GET /stats meanwhile.
+
+#include "S2SMockServer.h"
+
+#include <atomic>
+#include <chrono>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+
+using namespace BrainCloud;
+
+namespace
+{
+    std::atomic<bool> g_stop(false);
+
+    void onSignal(int)
+    {
+        g_stop = true;
+    }
+
+    void usage()
+    {
+        fprintf(stderr, "Usage: bcs2s_mock [--port <n>] [--tcp-port <n>] [--app-id <id>]\n"
+                        "                  [--server-name <name>] [--server-secret <secret>]\n"
+                        "                  [--heartbeat-seconds <s>] [--session-timeout-seconds <s>]\n"
+                        "                  [--latency-ms <ms>] [--jitter-ms <ms>]\n"
+                        "                  [--error-rate <0-1>] [--disconnect-rate <0-1>]\n"
+                        "                  [--bytes-per-second <n>] [--padding <bytes>]\n"
+                        "                  [--rtt-events-per-second <n>] [--rtt-event-size <bytes>]\n"
+                        "                  [--seed <n>] [--ids <path>]\n");
+    }
+}
+
+int main(int argc, char** argv)
+{
+    S2SMockServer::Config config;
+    int port = 0;
+    int tcpPort = 0;
+    std::string idsPath;
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string arg = argv[i];
+        if (i + 1 >= argc)
+        {
+            usage();
+            return 1;
+        }
+        const char* value = argv[++i];
+        if (arg == "--port") port = atoi(value);
+        else if (arg == "--tcp-port") tcpPort = atoi(value);
+        else if (arg == "--app-id") config.appId = value;
+        else if (arg == "--server-name") config.serverName = value;
+        else if (arg == "--server-secret") config.serverSecret = value;
+        else if (arg == "--heartbeat-seconds") config.heartbeatSeconds = atoi(value);
+        else if (arg == "--session-timeout-seconds") config.sessionTimeoutSeconds = atoi(value);
+        else if (arg == "--latency-ms") config.latencyMS = strtoull(value, NULL, 10);
+        else if (arg == "--jitter-ms") config.latencyJitterMS = strtoull(value, NULL, 10);
+        else if (arg == "--error-rate") config.errorRate = atof(value);
+        else if (arg == "--disconnect-rate") config.disconnectRate = atof(value);
+        else if (arg == "--bytes-per-second") config.bytesPerSecond = strtoull(value, NULL, 10);
+        else if (arg == "--padding") config.responsePadding = (size_t)strtoull(value, NULL, 10);
+        else if (arg == "--rtt-events-per-second") config.rttEventsPerSecond = atof(value);
+        else if (arg == "--rtt-event-size") config.rttEventSize = (size_t)strtoull(value, NULL, 10);
+        else if (arg == "--seed") config.seed = (uint32_t)strtoul(value, NULL, 10);
+        else if (arg == "--ids") idsPath = value;
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    S2SMockServer server(config);
+    if (!server.start(port, tcpPort))
+    {
+        fprintf(stderr, "Failed to listen on 127.0.0.1\n");
+        return 1;
+    }
+
+    printf("Dispatcher: %s\n", server.getDispatcherUrl().c_str());
+    printf("RTT: ws 127.0.0.1:%d, tcp 127.0.0.1:%d\n", server.getHttpPort(), server.getTcpPort());
+    printf("Credentials: appId %s, serverName %s, serverSecret %s\n",
+           config.appId.c_str(), config.serverName.c_str(), config.serverSecret.c_str());
+    fflush(stdout);
+
+    if (!idsPath.empty())
+    {
+        FILE* file = fopen(idsPath.c_str(), "w");
+        if (!file)
+        {
+            fprintf(stderr, "Failed to write %s\n", idsPath.c_str());
+            return 1;
+        }
+        fprintf(file, "appId=%s\nserverName=%s\nserverSecret=%s\ns2sUrl=%s\n",
+                config.appId.c_str(), config.serverName.c_str(), config.serverSecret.c_str(),
+                server.getDispatcherUrl().c_str());
+        fclose(file);
+    }
+
+    signal(SIGINT, onSignal);
+    signal(SIGTERM, onSignal);
+    while (!g_stop)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    }
+    server.stop();
+
+    auto stats = server.getStats();
+    printf("\npackets %llu, messages %llu, authentications %llu, heartbeats %llu\n"
+           "uploads %llu (%llu bytes), rtt connections %llu, rtt events %llu\n"
+           "injected errors %llu, injected disconnects %llu\n"
+           "received %llu bytes, sent %llu bytes\n",
+           (unsigned long long)stats.packets, (unsigned long long)stats.messages,
+           (unsigned long long)stats.authentications, (unsigned long long)stats.heartbeats,
+           (unsigned long long)stats.uploads, (unsigned long long)stats.uploadBytes,
+           (unsigned long long)stats.rttConnections, (unsigned long long)stats.rttEventsSent,
+           (unsigned long long)stats.injectedErrors, (unsigned long long)stats.injectedDisconnects,
+           (unsigned long long)stats.bytesReceived, (unsigned long long)stats.bytesSent);
+    return 0;
+}
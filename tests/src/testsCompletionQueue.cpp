@@ -0,0 +1,150 @@
+#include "tests.h"
+#include "catch.hpp"
+#include "S2SCompletionQueue.h"
+#include "S2SUniqueFunction.h"
+
+#include <memory>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// Completion queue
+//
+// Doesn't need a brainCloud server. What they allocate is checked by
+// testbcs2s_allocations, see tests/allocations.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    using Completion = S2SUniqueFunction<void()>;
+
+    // Same as what a context queues for a request: the user's callback and
+    // the response text
+    struct Callback
+    {
+        S2SCallback callback;
+        std::string data;
+
+        void operator()()
+        {
+            if (callback)
+            {
+                callback(data);
+            }
+        }
+    };
+}
+
+TEST_CASE("Unique function", "[S2S][completions]")
+{
+    SECTION("Small callables are stored inline")
+    {
+        int calls = 0;
+        Completion function([&calls]() { calls++; });
+        REQUIRE(function);
+        REQUIRE_FALSE(function.isOnHeap());
+
+        Completion moved(std::move(function));
+        REQUIRE_FALSE(function);
+        moved();
+        REQUIRE(calls == 1);
+
+        Completion callback = Callback{[&calls](const std::string& data) { calls += (int)data.size(); }, "abc"};
+        REQUIRE_FALSE(callback.isOnHeap());
+        callback();
+        REQUIRE(calls == 4);
+    }
+
+    SECTION("Large callables go on the heap")
+    {
+        char large[Completion::INLINE_SIZE + 1] = {};
+        large[Completion::INLINE_SIZE] = 42;
+        S2SUniqueFunction<int()> function([large]() { return (int)large[Completion::INLINE_SIZE]; });
+        REQUIRE(function.isOnHeap());
+
+        S2SUniqueFunction<int()> moved;
+        moved = std::move(function);
+        REQUIRE(moved() == 42);
+    }
+
+    SECTION("Move-only state, destroyed once")
+    {
+        auto state = std::make_shared<int>(7);
+        std::unique_ptr<std::shared_ptr<int>> owned(new std::shared_ptr<int>(state));
+        struct Holder
+        {
+            std::unique_ptr<std::shared_ptr<int>> owned;
+            int operator()(int add) { return **owned + add; }
+        };
+
+        {
+            S2SUniqueFunction<int(int)> function(Holder{std::move(owned)});
+            REQUIRE(state.use_count() == 2);
+            S2SUniqueFunction<int(int)> moved(std::move(function));
+            REQUIRE(moved(3) == 10);
+            REQUIRE(state.use_count() == 2);
+            moved = nullptr;
+            REQUIRE(state.use_count() == 1);
+        }
+        REQUIRE(state.use_count() == 1);
+    }
+}
+
+TEST_CASE("Completion queue", "[S2S][completions]")
+{
+    S2SCompletionQueue<Completion> queue;
+
+    SECTION("In order, completions queued while popping come last")
+    {
+        std::vector<int> order;
+        queue.push([&order]() { order.push_back(1); });
+        queue.push([&order, &queue]()
+        {
+            order.push_back(2);
+            queue.push([&order]() { order.push_back(4); });
+        });
+        queue.push([&order]() { order.push_back(3); });
+        REQUIRE(queue.size() == 3);
+
+        Completion completion;
+        while (queue.pop(completion))
+        {
+            completion();
+        }
+        REQUIRE(order == std::vector<int>({1, 2, 3, 4}));
+        REQUIRE(queue.empty());
+        REQUIRE(queue.getHighWater() == 3);
+    }
+
+    SECTION("Pushed from another thread")
+    {
+        const int COUNT = 10000;
+        std::vector<int> received;
+        std::thread producer([&queue, &received]()
+        {
+            for (int i = 0; i < COUNT; ++i)
+            {
+                queue.push([&received, i]() { received.push_back(i); });
+            }
+        });
+
+        Completion completion;
+        while (received.size() < COUNT)
+        {
+            queue.wait(std::chrono::milliseconds(10));
+            while (queue.pop(completion))
+            {
+                completion();
+            }
+        }
+        producer.join();
+
+        REQUIRE(queue.empty());
+        bool ordered = true;
+        for (int i = 0; i < COUNT; ++i)
+        {
+            ordered = ordered && received[i] == i;
+        }
+        REQUIRE(ordered);
+    }
+}
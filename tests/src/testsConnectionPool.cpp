@@ -0,0 +1,132 @@
+#include "tests.h"
+#include "catch.hpp"
+#include "S2SMockServer.h"
+#include <cstdlib>
+#include <cstdio>
+
+///////////////////////////////////////////////////////////////////////////////
+// Connection pool benchmark
+//
+// Hidden by default, run with: testbcs2s "[bench]"
+// Set BC_S2S_BENCH_URL to point the benchmark at a local HTTPS stand-in
+// instead of the s2sUrl from ids.txt. Only it measures TLS session reuse:
+// the mock server version below, which needs no brainCloud app, is plain
+// HTTP and only counts connections.
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Connection pool reuse", "[.][bench]")
+{
+    const int REQUEST_COUNT = 1000;
+
+    loadIdsIfNot();
+    const char* benchUrl = std::getenv("BC_S2S_BENCH_URL");
+    auto pContext = S2SContext::create(
+        BRAINCLOUD_APP_ID,
+        BRAINCLOUD_SERVER_NAME,
+        BRAINCLOUD_SERVER_SECRET,
+        benchUrl ? std::string(benchUrl) : BRAINCLOUD_SERVER_URL,
+        false
+    );
+
+    auto authRet = runAuth(pContext);
+    REQUIRE(authRet);
+
+    auto request = "{ \
+        \"service\": \"time\", \
+        \"operation\": \"READ\", \
+        \"data\": {} \
+    }";
+
+    S2SConnectionStats before = pContext->getConnectionStats();
+
+    int processed_count = 0;
+    int success_count = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < REQUEST_COUNT; ++i)
+    {
+        pContext->request(request, [&](const std::string& result)
+        {
+            Json::Value data;
+            Json::Reader reader;
+            if (reader.parse(result.c_str(), data) && data["status"].asInt() == 200)
+            {
+                success_count++;
+            }
+            processed_count++;
+        });
+    }
+    while (processed_count < REQUEST_COUNT)
+    {
+        pContext->runCallbacks(100);
+        if (std::chrono::steady_clock::now() - start_time > std::chrono::seconds(20))
+        {
+            printf("Timeout");
+            break;
+        }
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start_time;
+
+    S2SConnectionStats after = pContext->getConnectionStats();
+    uint64_t requests = after.requests - before.requests;
+    uint64_t connects = after.newConnections - before.newConnections;
+    double elapsedMs = (double)std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count() / 1000.0;
+
+    printf("\n[bench] %llu requests, %llu new connections (%.1f per 1000), %.3f ms/request\n",
+           (unsigned long long)requests,
+           (unsigned long long)connects,
+           requests ? (double)connects * 1000.0 / (double)requests : 0.0,
+           elapsedMs / (double)REQUEST_COUNT);
+
+    REQUIRE(success_count == REQUEST_COUNT);
+    // Requests queued together can share a packet, one HTTP request
+    REQUIRE(requests > 0);
+    REQUIRE(requests <= (uint64_t)REQUEST_COUNT);
+
+    // Steady state must reuse the pooled keep-alive connection
+    REQUIRE(connects < requests / 10 + 1);
+}
+
+TEST_CASE("Connection pool reuse on the mock server", "[S2S][mock]")
+{
+    const int REQUEST_COUNT = 200;
+
+    S2SMockServer server;
+    REQUIRE(server.start());
+    auto pContext = S2SContext::create("mockapp", "mockserver", "mocksecret", server.getDispatcherUrl(), true);
+
+    auto request = "{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{}}";
+
+    int processed_count = 0;
+    int success_count = 0;
+    auto start_time = std::chrono::steady_clock::now();
+    for (int i = 0; i < REQUEST_COUNT; ++i)
+    {
+        pContext->request(request, [&](const std::string& result)
+        {
+            Json::Value data;
+            Json::Reader reader;
+            if (reader.parse(result.c_str(), data) && data["status"].asInt() == 200)
+            {
+                success_count++;
+            }
+            processed_count++;
+        });
+    }
+    while (processed_count < REQUEST_COUNT)
+    {
+        pContext->runCallbacks(100);
+        if (std::chrono::steady_clock::now() - start_time > std::chrono::seconds(20))
+        {
+            printf("Timeout");
+            break;
+        }
+    }
+
+    REQUIRE(success_count == REQUEST_COUNT);
+
+    // Authentication and the requests share the pooled connection
+    S2SConnectionStats stats = pContext->getConnectionStats();
+    REQUIRE(stats.requests >= (uint64_t)REQUEST_COUNT);
+    REQUIRE(stats.newConnections < 5);
+    REQUIRE(server.getStats().httpConnections < 5);
+}
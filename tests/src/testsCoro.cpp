@@ -0,0 +1,133 @@
+#include "tests.h"
+#include "catch.hpp"
+#include <brainclouds2s-coro.h>
+#include <S2SLoopbackTransport.h>
+#include <atomic>
+
+#if defined(__cpp_impl_coroutine) && __has_include(<coroutine>)
+
+///////////////////////////////////////////////////////////////////////////////
+// Coroutine helpers (C++20 only)
+///////////////////////////////////////////////////////////////////////////////
+
+using namespace BrainCloud::Coro;
+
+namespace
+{
+    Task<int> readTimeTwice(S2SContextRef pContext)
+    {
+        auto request = "{\"service\":\"time\",\"operation\":\"READ\",\"data\":{}}";
+
+        auto first = co_await requestCo(pContext, request);
+        auto [second, third] = co_await whenAll(requestCo(pContext, request),
+                                                requestCo(pContext, request));
+
+        co_return (first["status"].asInt() == 200) +
+                  (second["status"].asInt() == 200) +
+                  (third["status"].asInt() == 200);
+    }
+
+    Task<int> fail(const char* message)
+    {
+        throw std::runtime_error(message);
+        co_return 0;
+    }
+
+    Task<void> runFailingWhenAll(std::string& error)
+    {
+        try
+        {
+            co_await whenAll(fail("first"), fail("second"));
+        }
+        catch (const std::runtime_error& e)
+        {
+            error = e.what();
+        }
+    }
+
+    Task<void> connectTwice(S2SContextRef pContext, std::vector<RTTConnectResult>& results)
+    {
+        results.push_back(co_await enableRTTCo(pContext));
+        // Already connected: resumes right away
+        results.push_back(co_await enableRTTCo(pContext));
+    }
+
+    Task<void> runTest(S2SContextRef pContext, int& successCount, bool& done)
+    {
+        successCount = co_await readTimeTwice(pContext);
+        done = true;
+    }
+}
+
+TEST_CASE("Coroutine requests", "[S2SCoro]")
+{
+    loadIdsIfNot();
+    auto pContext = S2SContext::create(
+        BRAINCLOUD_APP_ID,
+        BRAINCLOUD_SERVER_NAME,
+        BRAINCLOUD_SERVER_SECRET,
+        BRAINCLOUD_SERVER_URL,
+        true
+    );
+
+    int success_count = 0;
+    bool done = false;
+    spawn(runTest(pContext, success_count, done));
+
+    auto start_time = std::chrono::system_clock::now();
+    while (!done)
+    {
+        pContext->runCallbacks(100);
+        if (std::chrono::system_clock::now() - start_time > std::chrono::seconds(20))
+        {
+            printf("Timeout");
+            break;
+        }
+    }
+
+    REQUIRE(done);
+    REQUIRE(success_count == 3);
+}
+
+TEST_CASE("Coroutine whenAll errors", "[S2SCoro]")
+{
+    // The first task to fail gives the exception, the others' are dropped
+    std::string error;
+    spawn(runFailingWhenAll(error));
+    REQUIRE(error == "first");
+}
+
+TEST_CASE("Coroutine RTT connect", "[S2SCoro][loopback]")
+{
+    std::atomic<S2SLoopbackSocket*> pSocket(nullptr);
+    setTransportFactory(S2SLoopbackTransport::factory());
+    setRTTSocketFactory(S2SLoopbackSocket::factory(nullptr, [&pSocket](S2SLoopbackSocket* socket) { pSocket = socket; }));
+    auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", false);
+    setTransportFactory(nullptr);
+    setRTTSocketFactory(nullptr);
+    REQUIRE(runAuth(pContext));
+
+    std::vector<RTTConnectResult> results;
+    spawn(connectTwice(pContext, results));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (results.size() < 2 && std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(results.size() == 2);
+    REQUIRE(results[0].connected);
+    REQUIRE(results[1].connected);
+
+    // Reported to the connect callback after the coroutine is done with it
+    REQUIRE(pSocket != nullptr);
+    pSocket.load()->push("not json");
+    deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(200);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(results.size() == 2);
+}
+
+#endif
@@ -0,0 +1,114 @@
+#include "tests.h"
+#include "catch.hpp"
+#include <algorithm>
+#include <vector>
+
+#if defined(__linux__)
+#include <dirent.h>
+#endif
+
+///////////////////////////////////////////////////////////////////////////////
+// I/O thread stress test
+//
+// Doesn't need a brainCloud server: every request goes to a local port that
+// refuses connections and completes with a status 900 error.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Number of threads in this process, -1 if it can't be read
+    static int getThreadCount()
+    {
+#if defined(__linux__)
+        DIR* dir = opendir("/proc/self/task");
+        if (!dir) return -1;
+        int count = 0;
+        while (struct dirent* entry = readdir(dir))
+        {
+            if (entry->d_name[0] != '.') count++;
+        }
+        closedir(dir);
+        return count;
+#else
+        return -1;
+#endif
+    }
+}
+
+TEST_CASE("IO thread count stays flat", "[S2S][stress]")
+{
+    const int CONTEXT_COUNT = 100;
+    const int REQUESTS_PER_CONTEXT = 100;
+    const int REQUEST_COUNT = CONTEXT_COUNT * REQUESTS_PER_CONTEXT;
+
+    int baseThreadCount = getThreadCount();
+    if (baseThreadCount < 0)
+    {
+        WARN("Thread count not available on this platform, skipping");
+        return;
+    }
+
+    std::vector<S2SContextRef> contexts;
+    for (int i = 0; i < CONTEXT_COUNT; ++i)
+    {
+        contexts.push_back(S2SContext::create(
+            "00000",
+            "stress",
+            "stress",
+            "http://127.0.0.1:1/s2sdispatcher",
+            false
+        ));
+    }
+
+    auto request = "{ \
+        \"service\": \"time\", \
+        \"operation\": \"READ\", \
+        \"data\": {} \
+    }";
+
+    int processed_count = 0;
+    int error_count = 0;
+    auto callback = [&](const std::string& result)
+    {
+        Json::Value data;
+        Json::Reader reader;
+        if (reader.parse(result.c_str(), data) && data["status"].asInt() == 900)
+        {
+            error_count++;
+        }
+        processed_count++;
+    };
+
+    for (int i = 0; i < REQUESTS_PER_CONTEXT; ++i)
+    {
+        for (auto& pContext : contexts)
+        {
+            pContext->request(request, callback);
+        }
+    }
+
+    int maxThreadCount = getThreadCount();
+    auto start_time = std::chrono::steady_clock::now();
+    while (processed_count < REQUEST_COUNT)
+    {
+        for (auto& pContext : contexts)
+        {
+            pContext->runCallbacks();
+        }
+        maxThreadCount = std::max(maxThreadCount, getThreadCount());
+        if (std::chrono::steady_clock::now() - start_time > std::chrono::seconds(60))
+        {
+            printf("Timeout");
+            break;
+        }
+    }
+
+    printf("\n[stress] %d requests on %d contexts, threads: %d before, %d max\n",
+           REQUEST_COUNT, CONTEXT_COUNT, baseThreadCount, maxThreadCount);
+
+    REQUIRE(processed_count == REQUEST_COUNT);
+    REQUIRE(error_count == REQUEST_COUNT);
+
+    // Only the shared I/O thread may have been added
+    REQUIRE(maxThreadCount <= baseThreadCount + 1);
+}
@@ -1,5 +1,10 @@
 #include "tests.h"
 #include "catch.hpp"
+#include <S2SLoopbackTransport.h>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include <vector>
 
 
 ///////////////////////////////////////////////////////////////////////////////
@@ -101,4 +106,211 @@ TEST_CASE("Secret Obfuscation", "Logging")
         auto retAuth = runAuth(pContext);
         REQUIRE(retAuth);
     }
-}
\ No newline at end of file
+}
+TEST_CASE("Logs background writer", "Logging")
+{
+    std::string logPath = getExecutableDir() + "/testLogWriter.log";
+    std::remove(logPath.c_str());
+    logToFile(logPath);
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; ++t)
+    {
+        threads.emplace_back([t]()
+        {
+            for (int i = 0; i < 1000; ++i)
+            {
+                s2s_log("[writer ", t, "] line ", i);
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    s2s_log("[writer] ", std::string("{\"serverSecret\":\"hunter2\"}"));
+    flushLogs();
+    logToFile("");
+
+    std::ifstream file(logPath);
+    REQUIRE(file);
+    std::vector<int> lines(4, 0);
+    bool redacted = false;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        REQUIRE(line.find("hunter2") == std::string::npos);
+        if (line.find("[REDACTED]") != std::string::npos) redacted = true;
+
+        int t = 0;
+        int i = 0;
+        if (sscanf(line.c_str(), "[%*[^]]] [writer %d] line %d", &t, &i) == 2)
+        {
+            // Each thread's lines stay in order
+            REQUIRE(i == lines[t]);
+            lines[t]++;
+        }
+    }
+    REQUIRE(lines == std::vector<int>({1000, 1000, 1000, 1000}));
+    REQUIRE(redacted);
+    std::remove(logPath.c_str());
+}
+
+TEST_CASE("Secret redaction", "Logging")
+{
+    SECTION("String values of sensitive keys")
+    {
+        REQUIRE(redactSecretKeys("{\"serverSecret\":\"abc\",\"appId\":\"20001\"}") ==
+                "{\"serverSecret\":\"[REDACTED]\",\"appId\":\"20001\"}");
+        REQUIRE(redactSecretKeys("{\"token\" : \"a\",\"X-RTT-SECRET\":\n\"b\",\"secretKey\":\"\"}") ==
+                "{\"token\" : \"[REDACTED]\",\"X-RTT-SECRET\":\n\"[REDACTED]\",\"secretKey\":\"[REDACTED]\"}");
+    }
+
+    SECTION("Escaped quotes stay inside the value")
+    {
+        REQUIRE(redactSecretKeys("{\"secret\":\"a\\\"b\\\\\",\"x\":\"y\"}") ==
+                "{\"secret\":\"[REDACTED]\",\"x\":\"y\"}");
+    }
+
+    SECTION("Keys only match as member names")
+    {
+        const std::string json = "{\"type\":\"token\",\"tokens\":\"a\",\"secret\":12,\"name\":\"secret\"}";
+        REQUIRE(redactSecretKeys(json) == json);
+    }
+
+    SECTION("Unterminated values are redacted to the end")
+    {
+        REQUIRE(redactSecretKeys("{\"ApiKey\":\"abcdef") == "{\"ApiKey\":\"[REDACTED]");
+    }
+
+    SECTION("Long payloads")
+    {
+        std::string json = "{\"messages\":[";
+        std::string expected = json;
+        for (int i = 0; i < 100; ++i)
+        {
+            std::string prefix = "{\"service\":\"entity\",\"data\":{\"n\":" + std::to_string(i) + ",\"token\":\"";
+            json += prefix + "t" + std::to_string(i * 7919) + "\"}},";
+            expected += prefix + "[REDACTED]\"}},";
+        }
+        json += "{}]}";
+        expected += "{}]}";
+        REQUIRE(redactSecretKeys(json) == expected);
+    }
+
+    SECTION("Log lines")
+    {
+        showSecretLogs(false);
+        REQUIRE(buildLogMessage("[S2S SEND] ", std::string("{\"secret\":\"abc\"}")).find("{\"secret\":\"[REDACTED]\"}") !=
+                std::string::npos);
+        showSecretLogs(true);
+        REQUIRE(buildLogMessage("[S2S SEND] ", std::string("{\"secret\":\"abc\"}")).find("{\"secret\":\"abc\"}") !=
+                std::string::npos);
+        showSecretLogs(false);
+    }
+}
+
+TEST_CASE("Log channels", "Logging")
+{
+    SECTION("Levels and sampling")
+    {
+        S2SLogger logger;
+        S2SLogChannelOptions options;
+        options.level = S2SLogLevel::Info;
+        options.sampleEvery = 4;
+        logger.setChannelOptions(S2SLogChannel::S2SSend, options);
+
+        int logged = 0;
+        for (int i = 0; i < 100; ++i)
+        {
+            if (logger.shouldLog(S2SLogChannel::S2SSend, S2SLogLevel::Info)) logged++;
+            REQUIRE(logger.shouldLog(S2SLogChannel::S2SSend, S2SLogLevel::Error));
+            REQUIRE_FALSE(logger.shouldLog(S2SLogChannel::S2SSend, S2SLogLevel::Verbose));
+        }
+        REQUIRE(logged == 25);
+
+        // The other channels keep logging everything
+        REQUIRE(logger.shouldLog(S2SLogChannel::S2SRecv, S2SLogLevel::Verbose));
+
+        options.level = S2SLogLevel::Off;
+        logger.setChannelOptions(S2SLogChannel::S2SSend, options);
+        REQUIRE_FALSE(logger.shouldLog(S2SLogChannel::S2SSend, S2SLogLevel::Error));
+    }
+
+    SECTION("Payload truncation")
+    {
+        auto previous = getLogChannelOptions(S2SLogChannel::S2SSend);
+        S2SLogChannelOptions options;
+        options.maxPayloadBytes = 16;
+        setLogChannelOptions(S2SLogChannel::S2SSend, options);
+
+        const std::string packet = "{\"messages\":[],\"secret\":\"abcdefgh\"}";
+        std::string line = buildLogMessage("[S2S SEND] ", S2SLogPayload(S2SLogChannel::S2SSend, packet));
+        REQUIRE(line.find("] [S2S SEND] {\"messages\":[],\"... (" + std::to_string(packet.size()) + " bytes)") !=
+                std::string::npos);
+
+        // A secret cut in the middle is still redacted
+        options.maxPayloadBytes = packet.size() - 4;
+        setLogChannelOptions(S2SLogChannel::S2SSend, options);
+        line = buildLogMessage(S2SLogPayload(S2SLogChannel::S2SSend, packet));
+        REQUIRE(line.find("abcd") == std::string::npos);
+        REQUIRE(line.find("\"secret\":\"[REDACTED]...") != std::string::npos);
+
+        setLogChannelOptions(S2SLogChannel::S2SSend, previous);
+    }
+
+    SECTION("Errors only: message statuses")
+    {
+        auto previous = getLogChannelOptions(S2SLogChannel::S2SRecv);
+        S2SLogChannelOptions options;
+        options.level = S2SLogLevel::Error;
+        setLogChannelOptions(S2SLogChannel::S2SRecv, options);
+
+        std::string logPath = getExecutableDir() + "/testLogChannels.log";
+        std::remove(logPath.c_str());
+        logToFile(logPath);
+
+        // Echoes the data back with status 200, except for FAIL which gets
+        // 2001 with tabs around the colon
+        setTransportFactory(S2SLoopbackTransport::factory([](const std::string& body)
+        {
+            std::string answer = S2SLoopbackTransport::answerPacket(body);
+            if (body.find("\"FAIL\"") != std::string::npos)
+            {
+                size_t pos = answer.find("\"status\":200");
+                if (pos != std::string::npos) answer.replace(pos, 12, "\"status\"\t:\t2001");
+            }
+            return answer;
+        }));
+        auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", true);
+        setTransportFactory(nullptr);
+        pContext->setLogEnabled(true);
+
+        // User data with "status" members of its own is not an error
+        REQUIRE(pContext->requestSync("{\"service\":\"entity\",\"operation\":\"READ\","
+                                      "\"data\":{\"status\":\"active\",\"match\":{\"status\":404}}}")
+                .find("active") != std::string::npos);
+        pContext->requestSync("{\"service\":\"entity\",\"operation\":\"FAIL\",\"data\":{}}");
+        // Packets go one at a time: this one is sent once the response
+        // before it was logged
+        pContext->requestSync("{\"service\":\"entity\",\"operation\":\"READ\",\"data\":{}}");
+        flushLogs();
+        logToFile("");
+        setLogChannelOptions(S2SLogChannel::S2SRecv, previous);
+
+        std::ifstream file(logPath);
+        REQUIRE(file);
+        int received = 0;
+        bool failLogged = false;
+        std::string line;
+        while (std::getline(file, line))
+        {
+            if (line.find("[S2S RECV") == std::string::npos) continue;
+            received++;
+            if (line.find("2001") != std::string::npos) failLogged = true;
+        }
+        REQUIRE(received == 1);
+        REQUIRE(failLogged);
+        std::remove(logPath.c_str());
+    }
+}
@@ -0,0 +1,405 @@
+#include "tests.h"
+#include "catch.hpp"
+#include <S2SLoopbackTransport.h>
+#include <json/json.h>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// Loopback transport
+//
+// Contexts whose packets and RTT messages are answered in process, see
+// setTransportFactory and setRTTSocketFactory.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    // Contexts created while it lives go through the loopback transport
+    struct LoopbackScope
+    {
+        explicit LoopbackScope(const S2SLoopbackTransport::Handler& handler = nullptr,
+                               const std::function<void(S2SLoopbackSocket*)>& onOpen = nullptr)
+        {
+            setTransportFactory(S2SLoopbackTransport::factory(handler));
+            setRTTSocketFactory(S2SLoopbackSocket::factory(nullptr, onOpen));
+        }
+
+        ~LoopbackScope()
+        {
+            setTransportFactory(nullptr);
+            setRTTSocketFactory(nullptr);
+        }
+    };
+
+    static Json::Value requestLoopback(S2SContextRef pContext, const std::string& json)
+    {
+        bool done = false;
+        std::string result;
+        pContext->request(json, [&](const std::string& r)
+        {
+            result = r;
+            done = true;
+        });
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!done && std::chrono::steady_clock::now() < deadline)
+        {
+            pContext->runCallbacks(10);
+        }
+
+        Json::Value data;
+        Json::Reader reader;
+        reader.parse(result, data);
+        return data;
+    }
+}
+
+TEST_CASE("Loopback transport", "[S2S][loopback]")
+{
+    SECTION("Dispatcher answers")
+    {
+        LoopbackScope scope;
+        auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", true);
+
+        auto result = requestLoopback(pContext, "{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{\"value\":42}}");
+        REQUIRE(result["status"].asInt() == 200);
+        REQUIRE(result["data"]["value"].asInt() == 42);
+        REQUIRE(pContext->getSessionId() == "loopbacksession");
+        REQUIRE(pContext->getConnectionStats().newConnections == 0);
+    }
+
+    SECTION("Batched messages")
+    {
+        LoopbackScope scope;
+        auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", true);
+        pContext->setBatching(8);
+
+        std::vector<int> values;
+        for (int i = 0; i < 8; ++i)
+        {
+            pContext->request("{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{\"value\":" + std::to_string(i) + "}}",
+                              [&values](const std::string& result)
+            {
+                Json::Value data;
+                Json::Reader reader;
+                reader.parse(result, data);
+                values.push_back(data["data"]["value"].asInt());
+            });
+        }
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (values.size() < 8 && std::chrono::steady_clock::now() < deadline)
+        {
+            pContext->runCallbacks(10);
+        }
+        REQUIRE(values == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7}));
+    }
+
+    SECTION("Messages that aren't service calls are sent as is")
+    {
+        std::mutex mutex;
+        std::string bodies;
+        LoopbackScope scope([&](const std::string& body)
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            bodies += body;
+            return S2SLoopbackTransport::answerPacket(body);
+        });
+        auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", true);
+
+        int processed = 0;
+        for (auto message : {"[]", "5", "\"x\"", "{\"service\":\"time\"}"})
+        {
+            REQUIRE_NOTHROW(pContext->request(message, [&processed](const std::string&) { processed++; }));
+        }
+        Json::Value json(Json::ValueType::objectValue);
+        json["data"] = 1;
+        REQUIRE_NOTHROW(pContext->requestJson(json, [&processed](const Json::Value&) { processed++; }));
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (processed < 5 && std::chrono::steady_clock::now() < deadline)
+        {
+            pContext->runCallbacks(10);
+        }
+        REQUIRE(processed == 5);
+
+        // Nothing was added to the messages
+        std::unique_lock<std::mutex> lock(mutex);
+        REQUIRE(bodies.find("null") == std::string::npos);
+    }
+
+    SECTION("Refused packets")
+    {
+        std::atomic<int> posts(0);
+        LoopbackScope scope([&posts](const std::string& body)
+        {
+            // Authenticates, then refuses everything
+            return posts++ == 0 ? S2SLoopbackTransport::answerPacket(body) : std::string();
+        });
+        auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", true);
+
+        auto result = requestLoopback(pContext, "{\"service\":\"time\",\"operation\":\"READ\",\"data\":{}}");
+        REQUIRE(result["status"].asInt() == 900);
+        REQUIRE(posts == 2);
+    }
+}
+
+TEST_CASE("Loopback RTT socket", "[RTT][loopback]")
+{
+    std::atomic<S2SLoopbackSocket*> pSocket(nullptr);
+    LoopbackScope scope(nullptr, [&pSocket](S2SLoopbackSocket* socket) { pSocket = socket; });
+    auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", false);
+    REQUIRE(runAuth(pContext));
+
+    class LoopbackConnectCallback final : public IRTTConnectCallback
+    {
+    public:
+        bool processed = false;
+        std::string error;
+        void rttConnectSuccess() override { processed = true; }
+        void rttConnectFailure(const std::string& errorMessage) override
+        {
+            processed = true;
+            error = errorMessage;
+        }
+    } connectCallback;
+
+    class LoopbackRTTCallback final : public IRTTCallback
+    {
+    public:
+        std::vector<Json::Value> events;
+        void rttCallback(const std::string& jsonData) override
+        {
+            Json::Value event;
+            Json::Reader reader;
+            reader.parse(jsonData, event);
+            events.push_back(event);
+        }
+    } rttCallback;
+
+    BrainCloudRTT* rttService = pContext->getRTTService();
+    rttService->registerRTTCallback(ServiceName::Chat, &rttCallback);
+    rttService->enableRTT(&connectCallback, false);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!connectCallback.processed && std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(connectCallback.processed);
+    REQUIRE(connectCallback.error.empty());
+    REQUIRE(rttService->getRTTConnectionId() == "loopbackcx");
+    REQUIRE(pSocket != nullptr);
+
+    pSocket.load()->push("{\"service\":\"chat\",\"operation\":\"INCOMING\",\"data\":{\"n\":1}}");
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (rttCallback.events.empty() && std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(rttCallback.events.size() == 1);
+    REQUIRE(rttCallback.events[0]["data"]["n"].asInt() == 1);
+
+    rttService->disableRTT();
+}
+
+TEST_CASE("Callback budget", "[S2S][loopback]")
+{
+    std::atomic<S2SLoopbackSocket*> pSocket(nullptr);
+    LoopbackScope scope(nullptr, [&pSocket](S2SLoopbackSocket* socket) { pSocket = socket; });
+    auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", false);
+    REQUIRE(runAuth(pContext));
+
+    // What was called, in order: "s" and "r" for S2S and RTT, with their number
+    std::vector<std::string> called;
+
+    class BudgetRTTCallback final : public IRTTCallback
+    {
+    public:
+        std::vector<std::string>* called = nullptr;
+        void rttCallback(const std::string& jsonData) override
+        {
+            Json::Value event;
+            Json::Reader reader;
+            reader.parse(jsonData, event);
+            called->push_back("r" + std::to_string(event["data"]["n"].asInt()));
+        }
+    } rttCallback;
+    rttCallback.called = &called;
+
+    class BudgetConnectCallback final : public IRTTConnectCallback
+    {
+    public:
+        bool processed = false;
+        void rttConnectSuccess() override { processed = true; }
+        void rttConnectFailure(const std::string&) override { processed = true; }
+    } connectCallback;
+
+    BrainCloudRTT* rttService = pContext->getRTTService();
+    rttService->registerRTTCallback(ServiceName::Chat, &rttCallback);
+    rttService->enableRTT(&connectCallback, false);
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!connectCallback.processed && std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(pSocket != nullptr);
+
+    // Nothing pending
+    S2SCallbackBudget budget;
+    budget.maxCallbacks = 4;
+    REQUIRE(pContext->runCallbacks(budget) == 0);
+
+    // Waits until count callbacks are waiting for runCallbacks
+    auto waitForPending = [&pContext](size_t count)
+    {
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (pContext->getStats().callbackQueueDepth < count && std::chrono::steady_clock::now() < deadline)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        }
+        return pContext->getStats().callbackQueueDepth == count;
+    };
+
+    SECTION("Sources take turns and the rest carries over")
+    {
+        for (int i = 0; i < 6; ++i)
+        {
+            pContext->request("{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{}}", [&called, i](const std::string&)
+            {
+                called.push_back("s" + std::to_string(i));
+            });
+            pSocket.load()->push("{\"service\":\"chat\",\"operation\":\"INCOMING\",\"data\":{\"n\":" + std::to_string(i) + "}}");
+        }
+        REQUIRE(waitForPending(12));
+
+        REQUIRE(pContext->runCallbacks(budget) == 8);
+        REQUIRE(called.size() == 4);
+        REQUIRE(std::count_if(called.begin(), called.end(), [](const std::string& c) { return c[0] == 's'; }) == 2);
+
+        REQUIRE(pContext->runCallbacks(budget) == 4);
+        REQUIRE(pContext->runCallbacks(budget) == 0);
+        REQUIRE(called.size() == 12);
+        REQUIRE(pContext->getStats().callbacksDeferred == 12);
+
+        // Each source kept its order, and they alternated throughout
+        std::vector<std::string> s2s, rtt;
+        for (size_t i = 0; i < called.size(); ++i)
+        {
+            (called[i][0] == 's' ? s2s : rtt).push_back(called[i]);
+            if (i > 0) REQUIRE(called[i][0] != called[i - 1][0]);
+        }
+        REQUIRE(s2s == std::vector<std::string>({"s0", "s1", "s2", "s3", "s4", "s5"}));
+        REQUIRE(rtt == std::vector<std::string>({"r0", "r1", "r2", "r3", "r4", "r5"}));
+    }
+
+    SECTION("Time budget")
+    {
+        for (int i = 0; i < 3; ++i)
+        {
+            pContext->request("{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{}}", [&called](const std::string&)
+            {
+                std::this_thread::sleep_for(std::chrono::milliseconds(2));
+                called.push_back("s");
+            });
+        }
+        REQUIRE(waitForPending(3));
+
+        S2SCallbackBudget timeBudget;
+        timeBudget.maxMicroseconds = 1000;
+        // The first callback is always called
+        REQUIRE(pContext->runCallbacks(timeBudget) == 2);
+        REQUIRE(called.size() == 1);
+
+        // No limit
+        pContext->runCallbacks();
+        REQUIRE(called.size() == 3);
+    }
+
+    rttService->disableRTT();
+}
+
+TEST_CASE("Transfer timeouts", "[S2S][loopback]")
+{
+    // Records the timeout of each post, answered by the loopback transport
+    class RecordingTransport final : public IS2STransport
+    {
+    public:
+        explicit RecordingTransport(const IS2STransportRef& transport) : m_transport(transport) {}
+
+        TransferId post(const std::string& body, uint64_t timeoutMS,
+                        const DataCallback& onData, const Completion& completion) override
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                timeouts.push_back(timeoutMS);
+            }
+            return m_transport->post(body, timeoutMS, onData, completion);
+        }
+
+        void abort(TransferId id) override { m_transport->abort(id); }
+
+        uint64_t lastTimeout()
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            return timeouts.back();
+        }
+
+        std::mutex mutex;
+        std::vector<uint64_t> timeouts;
+
+    private:
+        IS2STransportRef m_transport;
+    };
+
+    std::shared_ptr<RecordingTransport> pTransport;
+    setTransportFactory([&pTransport](const std::string&, const std::shared_ptr<S2SHttpReactor>& reactor)
+    {
+        pTransport = std::make_shared<RecordingTransport>(S2SLoopbackTransport::create(reactor));
+        return pTransport;
+    });
+    auto pContext = S2SContext::create("loopbackapp", "loopbackserver", "secret", "http://unused", false);
+    setTransportFactory(nullptr);
+    REQUIRE(runAuth(pContext));
+
+    // Sends one request alone in its packet and waits for its answer
+    auto requestWith = [&pContext](const S2SRequestOptions& options)
+    {
+        bool done = false;
+        pContext->request("{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{}}", options,
+                          [&done](const std::string&) { done = true; });
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!done && std::chrono::steady_clock::now() < deadline)
+        {
+            pContext->runCallbacks(10);
+        }
+        return done;
+    };
+
+    SECTION("Without options")
+    {
+        REQUIRE(requestWith(S2SRequestOptions()));
+        REQUIRE(pTransport->lastTimeout() == 30000);
+    }
+
+    SECTION("Until the deadline")
+    {
+        S2SRequestOptions options;
+        options.timeoutMS = 45000;
+        REQUIRE(requestWith(options));
+        REQUIRE(pTransport->lastTimeout() > 30000);
+        REQUIRE(pTransport->lastTimeout() <= 45000);
+    }
+
+    SECTION("No limit with only a cancel token")
+    {
+        S2SRequestOptions options;
+        options.cancelToken = S2SCancelToken::create();
+        REQUIRE(requestWith(options));
+        REQUIRE(pTransport->lastTimeout() == 0);
+    }
+}
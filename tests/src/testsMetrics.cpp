@@ -0,0 +1,110 @@
+#include "tests.h"
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+///////////////////////////////////////////////////////////////////////////////
+// Metrics
+//
+// Doesn't need a brainCloud server: histograms and the exporter are fed by
+// hand, and context requests go to a local port that refuses connections.
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Latency histogram", "[S2S][metrics]")
+{
+    S2SLatencyHistogram histogram;
+    REQUIRE(histogram.getCount() == 0);
+    REQUIRE(histogram.getValueAtPercentile(50) == 0);
+
+    // 1 to 10000 us, once each
+    for (uint64_t value = 1; value <= 10000; ++value)
+    {
+        histogram.record(value);
+    }
+
+    REQUIRE(histogram.getCount() == 10000);
+    REQUIRE(histogram.getMin() == 1);
+    REQUIRE(histogram.getMax() == 10000);
+    REQUIRE(histogram.getMean() == Approx(5000.5));
+
+    // Within the 1/16 bucket precision
+    REQUIRE(histogram.getValueAtPercentile(50) == Approx(5000).epsilon(1.0 / 16));
+    REQUIRE(histogram.getValueAtPercentile(99) == Approx(9900).epsilon(1.0 / 16));
+    REQUIRE(histogram.getValueAtPercentile(100) == 10000);
+
+    // Small values are exact, huge ones don't overflow
+    S2SLatencyHistogram small;
+    small.record(3);
+    REQUIRE(small.getValueAtPercentile(50) == 3);
+    small.record(UINT64_MAX / 2);
+    REQUIRE(small.getValueAtPercentile(100) == UINT64_MAX / 2);
+}
+
+TEST_CASE("Prometheus exporter", "[S2S][metrics]")
+{
+    S2SStats stats;
+    stats.latency["time.READ"].record(2000);
+    stats.latency["odd\"name"].record(1000);
+    stats.requestQueueHighWater = 7;
+    stats.bytesSent = 1234;
+    stats.heartbeats = 2;
+
+    std::string text = formatPrometheus(stats, "test");
+    REQUIRE(text.find("# TYPE test_request_latency_seconds summary\n") != std::string::npos);
+    REQUIRE(text.find("test_request_latency_seconds{operation=\"time.READ\",quantile=\"0.5\"} 0.002000\n") != std::string::npos);
+    REQUIRE(text.find("test_request_latency_seconds_count{operation=\"time.READ\"} 1\n") != std::string::npos);
+    REQUIRE(text.find("operation=\"odd\\\"name\"") != std::string::npos);
+    REQUIRE(text.find("test_request_queue_high_water 7\n") != std::string::npos);
+    REQUIRE(text.find("test_sent_bytes_total 1234\n") != std::string::npos);
+    REQUIRE(text.find("test_heartbeats_total 2\n") != std::string::npos);
+
+    std::string path = "metrics_test.prom";
+    REQUIRE(writePrometheus(stats, path, "test"));
+    std::ifstream file(path);
+    std::stringstream written;
+    written << file.rdbuf();
+    REQUIRE(written.str() == text);
+    file.close();
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Context stats", "[S2S][metrics]")
+{
+    auto pContext = S2SContext::create(
+        "00000",
+        "metrics",
+        "metrics",
+        "http://127.0.0.1:1/s2sdispatcher",
+        false
+    );
+
+    const int REQUEST_COUNT = 5;
+    int done = 0;
+    for (int i = 0; i < REQUEST_COUNT; ++i)
+    {
+        pContext->request("{\"service\":\"time\",\"operation\":\"READ\"}", [&done](const std::string&)
+        {
+            done++;
+        });
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (done < REQUEST_COUNT && std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(done == REQUEST_COUNT);
+
+    auto stats = pContext->getStats();
+    REQUIRE(stats.requestQueueHighWater >= 1);
+    REQUIRE(stats.requestQueueDepth == 0);
+    REQUIRE(stats.callbackQueueHighWater >= 1);
+    REQUIRE(stats.callbackQueueDepth == 0);
+
+    // Nothing reached a server
+    REQUIRE(stats.latency.empty());
+    REQUIRE(stats.bytesReceived == 0);
+    REQUIRE(stats.authentications == 0);
+}
@@ -0,0 +1,356 @@
+#include "tests.h"
+#include "catch.hpp"
+#include "S2SMockServer.h"
+#include <brainclouds2s-globalfilev3.h>
+#include <brainclouds2s-pool.h>
+#include <S2SHttpReactor.h>
+#include <json/json.h>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// Loopback mock server
+//
+// The library against tests/mock's S2SMockServer, no brainCloud app needed.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    static S2SContextRef createMockContext(const S2SMockServer& server, bool autoAuth = true,
+                                           const std::string& serverSecret = "mocksecret")
+    {
+        return S2SContext::create("mockapp", "mockserver", serverSecret, server.getDispatcherUrl(), autoAuth);
+    }
+
+    // Runs one call through runCallbacks, its parsed result or null after 10s
+    static Json::Value runMock(S2SContextRef pContext, std::function<void(S2SCallback)> call)
+    {
+        bool done = false;
+        std::string result;
+        call([&](const std::string& r)
+        {
+            result = r;
+            done = true;
+        });
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (!done && std::chrono::steady_clock::now() < deadline)
+        {
+            pContext->runCallbacks(10);
+        }
+
+        Json::Value data;
+        Json::Reader reader;
+        reader.parse(result, data);
+        return data;
+    }
+
+    static Json::Value requestMock(S2SContextRef pContext, const std::string& json)
+    {
+        return runMock(pContext, [&](S2SCallback callback) { pContext->request(json, callback); });
+    }
+
+    // request() turns errors into a status 900, the raw message keeps the server's
+    static Json::Value requestMockRaw(S2SContextRef pContext, const std::string& json)
+    {
+        return runMock(pContext, [&](S2SCallback callback) { pContext->requestRaw(json, callback); });
+    }
+}
+
+TEST_CASE("Mock server dispatcher", "[S2S][mock]")
+{
+    S2SMockServer server;
+    REQUIRE(server.start());
+    auto pContext = createMockContext(server);
+
+    SECTION("Echo")
+    {
+        auto result = requestMock(pContext, "{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{\"value\":42}}");
+        REQUIRE(result["status"].asInt() == 200);
+        REQUIRE(result["data"]["value"].asInt() == 42);
+        REQUIRE(server.getStats().authentications == 1);
+    }
+
+    SECTION("Errors")
+    {
+        auto result = requestMockRaw(pContext, "{\"service\":\"mock\",\"operation\":\"ERROR\","
+                                               "\"data\":{\"status\":400,\"reason_code\":40123}}");
+        REQUIRE(result["status"].asInt() == 400);
+        REQUIRE(result["reason_code"].asInt() == 40123);
+
+        auto config = server.getConfig();
+        config.errorRate = 1;
+        server.setConfig(config);
+        result = requestMockRaw(pContext, "{\"service\":\"time\",\"operation\":\"READ\"}");
+        REQUIRE(result["status"].asInt() == 500);
+        REQUIRE(server.getStats().injectedErrors == 1);
+    }
+
+    SECTION("Latency")
+    {
+        auto start = std::chrono::steady_clock::now();
+        auto result = requestMock(pContext, "{\"service\":\"mock\",\"operation\":\"SLEEP\",\"data\":{\"ms\":200}}");
+        REQUIRE(result["status"].asInt() == 200);
+        REQUIRE(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(200));
+    }
+
+    SECTION("Pipelined packets")
+    {
+        REQUIRE(requestMock(pContext, "{\"service\":\"mock\",\"operation\":\"ECHO\"}")["status"].asInt() == 200);
+
+        // One message per packet, each held 200 ms: sent one at a time
+        // they'd take 1.6 s
+        const int REQUEST_COUNT = 8;
+        pContext->setMaxPacketsInFlight(4);
+        pContext->setBatching(1);
+        auto config = server.getConfig();
+        config.latencyMS = 200;
+        server.setConfig(config);
+
+        int answered = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < REQUEST_COUNT; ++i)
+        {
+            pContext->request("{\"service\":\"mock\",\"operation\":\"ECHO\"}", [&answered](const std::string&)
+            {
+                answered++;
+            });
+        }
+        auto deadline = start + std::chrono::seconds(10);
+        while (answered < REQUEST_COUNT && std::chrono::steady_clock::now() < deadline)
+        {
+            pContext->runCallbacks(10);
+        }
+        REQUIRE(answered == REQUEST_COUNT);
+        REQUIRE(std::chrono::steady_clock::now() - start < std::chrono::milliseconds(REQUEST_COUNT * 200));
+
+        // The server held several at once, never more than the window
+        auto stats = server.getStats();
+        REQUIRE(stats.maxHeldPackets > 1);
+        REQUIRE(stats.maxHeldPackets <= 4);
+    }
+
+    SECTION("Session expiry")
+    {
+        REQUIRE(requestMock(pContext, "{\"service\":\"mock\",\"operation\":\"EXPIRE\"}")["status"].asInt() == 200);
+
+        // Authenticates again and resends
+        auto result = requestMock(pContext, "{\"service\":\"time\",\"operation\":\"READ\"}");
+        REQUIRE(result["status"].asInt() == 200);
+        REQUIRE(server.getStats().authentications == 2);
+    }
+
+    SECTION("Session expiry with packets in flight")
+    {
+        REQUIRE(requestMock(pContext, "{\"service\":\"mock\",\"operation\":\"EXPIRE\"}")["status"].asInt() == 200);
+
+        // The first packets go out one by one, the rest wait in the queue.
+        // They all come back expired and are sent again, in their order,
+        // once the session is renewed.
+        const int REQUEST_COUNT = 8;
+        pContext->setMaxPacketsInFlight(4);
+        pContext->setBatching(REQUEST_COUNT);
+        auto config = server.getConfig();
+        config.latencyMS = 100;
+        config.latencyJitterMS = 50;
+        server.setConfig(config);
+
+        std::vector<int> answered;
+        for (int i = 0; i < REQUEST_COUNT; ++i)
+        {
+            pContext->request("{\"service\":\"mock\",\"operation\":\"ECHO\",\"data\":{\"i\":" + std::to_string(i) + "}}",
+                              [&answered](const std::string& result)
+            {
+                Json::Value data;
+                Json::Reader reader;
+                reader.parse(result, data);
+                answered.push_back(data["status"].asInt() == 200 ? data["data"]["i"].asInt() : -1);
+            });
+        }
+
+        auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+        while (answered.size() < REQUEST_COUNT && std::chrono::steady_clock::now() < deadline)
+        {
+            pContext->runCallbacks(10);
+        }
+        REQUIRE(answered == std::vector<int>({0, 1, 2, 3, 4, 5, 6, 7}));
+        REQUIRE(server.getStats().authentications == 2);
+    }
+
+    SECTION("Retrying messages that aren't service calls")
+    {
+        REQUIRE(requestMock(pContext, "{\"service\":\"mock\",\"operation\":\"ECHO\"}")["status"].asInt() == 200);
+
+        // Connections close once the packets are sent, so whether to resend
+        // depends on the operations
+        S2SRetryPolicy policy;
+        policy.maxRetries = 1;
+        policy.initialBackoffMS = 10;
+        policy.idempotentOperations.insert("time.READ");
+        pContext->setRetryPolicy(policy);
+        auto config = server.getConfig();
+        config.disconnectRate = 1;
+        server.setConfig(config);
+
+        REQUIRE(requestMock(pContext, "[]")["status"].asInt() == 900);
+        REQUIRE(pContext->getRetryStats().retries == 0);
+    }
+
+    SECTION("Bad credentials")
+    {
+        auto pBadContext = createMockContext(server, false, "wrong");
+        REQUIRE_FALSE(runAuth(pBadContext));
+        REQUIRE(server.getStats().authentications == 0);
+    }
+}
+
+TEST_CASE("Mock server session renewal", "[S2S][mock]")
+{
+    S2SMockServer::Config config;
+    config.heartbeatSeconds = 1;
+    S2SMockServer server(config);
+    REQUIRE(server.start());
+    auto pContext = createMockContext(server, false);
+    REQUIRE(runAuth(pContext));
+
+    // Holds the I/O thread, like a suspended process would, past the
+    // heartbeat: the server may drop the session after 2 s of silence,
+    // so the late heartbeat timer renews it instead
+    S2SHttpReactor::getShared()->post([]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1700));
+    });
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (server.getStats().authentications < 2 && std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    pContext->runCallbacks(200);
+
+    // Once, without a request or a heartbeat to trigger it
+    auto stats = server.getStats();
+    REQUIRE(stats.authentications == 2);
+    REQUIRE(stats.heartbeats == 0);
+    REQUIRE(stats.packets == 2);
+}
+
+TEST_CASE("Mock server explicit authentication on auto auth", "[S2S][mock]")
+{
+    S2SMockServer server;
+    REQUIRE(server.start());
+
+    SECTION("Context")
+    {
+        auto pContext = createMockContext(server);
+        Json::Value data;
+        Json::Reader reader;
+        REQUIRE(reader.parse(pContext->authenticateSync(), data));
+        REQUIRE(data["status"].asInt() == 200);
+        REQUIRE_FALSE(pContext->getSessionId().empty());
+    }
+
+    SECTION("Session pool")
+    {
+        auto pPool = S2SSessionPool::create("mockapp", "mockserver", "mocksecret", server.getDispatcherUrl(), 3, true);
+        REQUIRE(pPool);
+        Json::Value data;
+        Json::Reader reader;
+        REQUIRE(reader.parse(pPool->authenticateSync(), data));
+        REQUIRE(data["status"].asInt() == 200);
+        REQUIRE(server.getStats().authentications == 3);
+    }
+}
+
+TEST_CASE("Mock server GlobalFileV3 upload", "[GFV3][mock]")
+{
+    S2SMockServer server;
+    REQUIRE(server.start());
+    auto pContext = createMockContext(server);
+
+    std::vector<uint8_t> fileData(100 * 1024);
+    for (size_t i = 0; i < fileData.size(); ++i) fileData[i] = (uint8_t)i;
+
+    auto gfv3 = pContext->getGlobalFileV3();
+    auto result = runMock(pContext, [&](S2SCallback callback)
+    {
+        gfv3->uploadGlobalFile("mocktree", "mock.bin", true, fileData, callback);
+    });
+    REQUIRE(result["status"].asInt() == 200);
+
+    const Json::Value& fileDetails = result["data"]["fileDetails"]["fileDetails"];
+    REQUIRE_FALSE(fileDetails["fileId"].asString().empty());
+    REQUIRE(fileDetails["fileSize"].asUInt64() == fileData.size());
+
+    auto stats = server.getStats();
+    REQUIRE(stats.uploads == 1);
+    REQUIRE(stats.uploadBytes == fileData.size());
+}
+
+#if defined(USE_TCP)
+TEST_CASE("Mock server RTT over TCP", "[S2S][mock]")
+{
+    S2SMockServer server;
+    REQUIRE(server.start());
+    auto pContext = createMockContext(server, false);
+    REQUIRE(runAuth(pContext));
+
+    class MockConnectCallback final : public IRTTConnectCallback
+    {
+    public:
+        bool processed = false;
+        std::string error;
+        void rttConnectSuccess() override { processed = true; }
+        void rttConnectFailure(const std::string& errorMessage) override
+        {
+            processed = true;
+            error = errorMessage;
+        }
+    } connectCallback;
+
+    class MockRTTCallback final : public IRTTCallback
+    {
+    public:
+        std::vector<Json::Value> events;
+        void rttCallback(const std::string& jsonData) override
+        {
+            Json::Value event;
+            Json::Reader reader;
+            reader.parse(jsonData, event);
+            events.push_back(event);
+        }
+    } rttCallback;
+
+    BrainCloudRTT* rttService = pContext->getRTTService();
+    rttService->registerRTTCallback(ServiceName::Chat, &rttCallback);
+    rttService->enableRTT(&connectCallback, false);
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (!connectCallback.processed && std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(connectCallback.processed);
+    REQUIRE(connectCallback.error.empty());
+    REQUIRE(server.getStats().rttConnections == 1);
+
+    // One through the dispatcher, one from the server's side
+    REQUIRE(requestMock(pContext, "{\"service\":\"mock\",\"operation\":\"PUSH\","
+                                  "\"data\":{\"data\":{\"n\":1}}}")["status"].asInt() == 200);
+    server.pushRttEvent("chat", "MOCK", "{\"n\":2}");
+
+    deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while (rttCallback.events.size() < 2 && std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(rttCallback.events.size() == 2);
+    REQUIRE(rttCallback.events[0]["data"]["n"].asInt() == 1);
+    REQUIRE(rttCallback.events[1]["service"].asString() == "chat");
+    REQUIRE(rttCallback.events[1]["data"]["n"].asInt() == 2);
+
+    rttService->disableRTT();
+}
+#endif
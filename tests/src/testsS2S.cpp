@@ -106,6 +106,268 @@ TEST_CASE("Valid Context", "[S2S]")
         REQUIRE(success_count == 6);
     }
 
+    SECTION("Batched calls")
+    {
+        auto authRet = runAuth(pContext);
+        REQUIRE(authRet);
+
+        pContext->setBatching(10);
+
+        const int REQUEST_COUNT = 25;
+        int processed_count = 0;
+        int success_count = 0;
+        int out_of_order_count = 0;
+
+        auto request = "{ \
+            \"service\": \"time\", \
+            \"operation\": \"READ\", \
+            \"data\": {} \
+        }";
+
+        // Each request gets its own callback, in the order they were queued
+        for (int i = 0; i < REQUEST_COUNT; ++i)
+        {
+            pContext->request(request, [&, i](const std::string& result)
+            {
+                Json::Value data;
+                Json::Reader reader;
+                bool parsingSuccessful = reader.parse(result.c_str(), data);
+                if (parsingSuccessful && data["status"].asInt() == 200)
+                {
+                    success_count++;
+                }
+                if (processed_count != i)
+                {
+                    out_of_order_count++;
+                }
+                processed_count++;
+            });
+        }
+
+        auto start_time = std::chrono::system_clock::now();
+        while (processed_count < REQUEST_COUNT)
+        {
+            pContext->runCallbacks(100);
+            if (std::chrono::system_clock::now() - start_time > std::chrono::seconds(20))
+            {
+                printf("Timeout");
+                break;
+            }
+        }
+
+        REQUIRE(success_count == REQUEST_COUNT);
+        REQUIRE(out_of_order_count == 0);
+    }
+
+    SECTION("Pipelined calls")
+    {
+        auto authRet = runAuth(pContext);
+        REQUIRE(authRet);
+
+        pContext->setMaxPacketsInFlight(4);
+
+        const int REQUEST_COUNT = 25;
+        int processed_count = 0;
+        int success_count = 0;
+
+        auto request = "{ \
+            \"service\": \"time\", \
+            \"operation\": \"READ\", \
+            \"data\": {} \
+        }";
+
+        // Responses can come back in any order, but each request gets one.
+        // That the packets overlap is checked against the mock server, see
+        // "Pipelined packets" in testsMockServer.cpp
+        for (int i = 0; i < REQUEST_COUNT; ++i)
+        {
+            pContext->request(request, [&](const std::string& result)
+            {
+                Json::Value data;
+                Json::Reader reader;
+                bool parsingSuccessful = reader.parse(result.c_str(), data);
+                if (parsingSuccessful && data["status"].asInt() == 200)
+                {
+                    success_count++;
+                }
+                processed_count++;
+            });
+        }
+
+        auto start_time = std::chrono::system_clock::now();
+        while (processed_count < REQUEST_COUNT)
+        {
+            pContext->runCallbacks(100);
+            if (std::chrono::system_clock::now() - start_time > std::chrono::seconds(20))
+            {
+                printf("Timeout");
+                break;
+            }
+        }
+
+        REQUIRE(processed_count == REQUEST_COUNT);
+        REQUIRE(success_count == REQUEST_COUNT);
+    }
+
+    SECTION("Async call")
+    {
+        auto authRet = runAuth(pContext);
+        REQUIRE(authRet);
+
+        auto request = "{ \
+            \"service\": \"time\", \
+            \"operation\": \"READ\", \
+            \"data\": {} \
+        }";
+
+        // No runCallbacks needed, the future completes on its own
+        auto future = pContext->requestAsync(request);
+        REQUIRE(future.wait_for(std::chrono::seconds(20)) == std::future_status::ready);
+
+        Json::Value data;
+        Json::Reader reader;
+        REQUIRE(reader.parse(future.get(), data));
+        REQUIRE(data["status"].asInt() == 200);
+    }
+
+    SECTION("Json call")
+    {
+        auto authRet = runAuth(pContext);
+        REQUIRE(authRet);
+
+        Json::Value request;
+        request["service"] = "time";
+        request["operation"] = "READ";
+        request["data"] = Json::Value(Json::objectValue);
+
+        bool processed = false;
+        int status = 0;
+        pContext->requestJson(std::move(request), [&](const Json::Value& message)
+        {
+            status = message["status"].asInt();
+            processed = true;
+        });
+
+        auto start_time = std::chrono::system_clock::now();
+        while (!processed)
+        {
+            pContext->runCallbacks(100);
+            if (std::chrono::system_clock::now() - start_time > std::chrono::seconds(20))
+            {
+                printf("Timeout");
+                break;
+            }
+        }
+
+        REQUIRE(processed);
+        REQUIRE(status == 200);
+    }
+
+    SECTION("Raw call")
+    {
+        auto authRet = runAuth(pContext);
+        REQUIRE(authRet);
+
+        // Raw and parsed requests share packets
+        pContext->setBatching(10);
+
+        const int REQUEST_COUNT = 6;
+        int processed_count = 0;
+        int success_count = 0;
+        for (int i = 0; i < REQUEST_COUNT; ++i)
+        {
+            auto callback = [&](const std::string& result)
+            {
+                Json::Value data;
+                Json::Reader reader;
+                if (reader.parse(result.c_str(), data) && data["status"].asInt() == 200)
+                {
+                    success_count++;
+                }
+                processed_count++;
+            };
+
+            auto request = "{\"service\":\"time\",\"operation\":\"READ\",\"data\":{}}";
+            if (i % 2 == 0) pContext->requestRaw(request, callback);
+            else pContext->request(request, callback);
+        }
+
+        auto start_time = std::chrono::system_clock::now();
+        while (processed_count < REQUEST_COUNT)
+        {
+            pContext->runCallbacks(100);
+            if (std::chrono::system_clock::now() - start_time > std::chrono::seconds(20))
+            {
+                printf("Timeout");
+                break;
+            }
+        }
+
+        REQUIRE(success_count == REQUEST_COUNT);
+    }
+
+    SECTION("Deadline and cancel")
+    {
+        auto authRet = runAuth(pContext);
+        REQUIRE(authRet);
+
+        auto request = "{\"service\":\"time\",\"operation\":\"READ\",\"data\":{}}";
+
+        int processed_count = 0;
+        int timeout_count = 0;
+        int cancelled_count = 0;
+        int success_count = 0;
+        auto callback = [&](const std::string& result)
+        {
+            Json::Value data;
+            Json::Reader reader;
+            REQUIRE(reader.parse(result.c_str(), data));
+            if (data["status"].asInt() == 200) success_count++;
+            else if (data["reason_code"].asInt() == S2S_REASON_REQUEST_TIMEOUT) timeout_count++;
+            else if (data["reason_code"].asInt() == S2S_REASON_REQUEST_CANCELLED) cancelled_count++;
+            processed_count++;
+        };
+
+        // Queued one behind the other, they can't all make it in 1 ms
+        const int SHORT_COUNT = 10;
+        S2SRequestOptions shortDeadline;
+        shortDeadline.timeoutMS = 1;
+        for (int i = 0; i < SHORT_COUNT; ++i)
+        {
+            pContext->request(request, shortDeadline, callback);
+        }
+
+        // Cancelled while queued or in flight
+        S2SRequestOptions cancellable;
+        cancellable.cancelToken = S2SCancelToken::create();
+        pContext->request(request, cancellable, callback);
+        cancellable.cancelToken->cancel();
+
+        // Answered in time: the deadline doesn't fire after the response
+        S2SRequestOptions longDeadline;
+        longDeadline.timeoutMS = 20000;
+        pContext->request(request, longDeadline, callback);
+
+        auto start_time = std::chrono::system_clock::now();
+        while (processed_count < SHORT_COUNT + 2)
+        {
+            pContext->runCallbacks(100);
+            if (std::chrono::system_clock::now() - start_time > std::chrono::seconds(20))
+            {
+                printf("Timeout");
+                break;
+            }
+        }
+
+        REQUIRE(timeout_count >= 1);
+        REQUIRE(cancelled_count == 1);
+        REQUIRE(timeout_count + success_count == SHORT_COUNT + 1);
+
+        // Each callback is called once
+        pContext->runCallbacks(100);
+        REQUIRE(processed_count == SHORT_COUNT + 2);
+    }
+
     SECTION("Bad Request Json")
     {
         auto authRet = runAuth(pContext);
@@ -571,3 +833,55 @@ TEST_CASE("Bad Requests", "[S2S]")
         REQUIRE(success_count == 5);
     }
 }
+
+TEST_CASE("Retry policy", "[S2S]")
+{
+    loadIdsIfNot();
+
+    // Nothing listens there: the packets never go out, so they are always
+    // safe to resend
+    auto pContext = S2SContext::create(
+        BRAINCLOUD_APP_ID,
+        BRAINCLOUD_SERVER_NAME,
+        BRAINCLOUD_SERVER_SECRET,
+        "http://127.0.0.1:1/s2sdispatcher",
+        false
+    );
+    pContext->setLogEnabled(true);
+
+    auto request = "{\"service\":\"time\",\"operation\":\"READ\",\"data\":{}}";
+
+    S2SRetryPolicy policy;
+    policy.maxRetries = 2;
+    policy.initialBackoffMS = 10;
+
+    SECTION("Unreachable server")
+    {
+        pContext->setRetryPolicy(policy);
+
+        Json::Value data;
+        Json::Reader reader;
+        REQUIRE(reader.parse(pContext->requestSync(request), data));
+        REQUIRE(data["status"].asInt() == 900);
+
+        auto stats = pContext->getRetryStats();
+        REQUIRE(stats.retries == 2);
+        REQUIRE(stats.giveUps == 1);
+        REQUIRE(stats.budgetExhausted == 0);
+    }
+
+    SECTION("Retry budget")
+    {
+        policy.budgetMaxTokens = 1;
+        pContext->setRetryPolicy(policy);
+
+        pContext->requestSync(request);
+        pContext->requestSync(request);
+
+        // Only one resend was in the budget
+        auto stats = pContext->getRetryStats();
+        REQUIRE(stats.retries == 1);
+        REQUIRE(stats.giveUps == 2);
+        REQUIRE(stats.budgetExhausted == 2);
+    }
+}
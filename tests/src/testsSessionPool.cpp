@@ -0,0 +1,131 @@
+#include "tests.h"
+#include "catch.hpp"
+#include <brainclouds2s-pool.h>
+
+///////////////////////////////////////////////////////////////////////////////
+// Session pool
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Session pool", "[S2SPool]")
+{
+    loadIdsIfNot();
+    auto pPool = S2SSessionPool::create(
+        BRAINCLOUD_APP_ID,
+        BRAINCLOUD_SERVER_NAME,
+        BRAINCLOUD_SERVER_SECRET,
+        BRAINCLOUD_SERVER_URL,
+        3
+    );
+    REQUIRE(pPool);
+    REQUIRE(pPool->getSessionCount() == 3);
+
+    Json::Value authData;
+    Json::Reader reader;
+    REQUIRE(reader.parse(pPool->authenticateSync(), authData));
+    REQUIRE(authData["status"].asInt() == 200);
+
+    // Every session has its own brainCloud session
+    REQUIRE_FALSE(pPool->getContext(0)->getSessionId().empty());
+    REQUIRE(pPool->getContext(0)->getSessionId() != pPool->getContext(1)->getSessionId());
+
+    auto request = "{ \
+        \"service\": \"time\", \
+        \"operation\": \"READ\", \
+        \"data\": {} \
+    }";
+
+    SECTION("Spread requests")
+    {
+        const int REQUEST_COUNT = 30;
+        int processed_count = 0;
+        int success_count = 0;
+
+        for (int i = 0; i < REQUEST_COUNT; ++i)
+        {
+            pPool->request(request, [&](const std::string& result)
+            {
+                Json::Value data;
+                Json::Reader reader;
+                if (reader.parse(result.c_str(), data) && data["status"].asInt() == 200)
+                {
+                    success_count++;
+                }
+                processed_count++;
+            });
+        }
+
+        auto start_time = std::chrono::system_clock::now();
+        while (processed_count < REQUEST_COUNT)
+        {
+            pPool->runCallbacks(100);
+            if (std::chrono::system_clock::now() - start_time > std::chrono::seconds(20))
+            {
+                printf("Timeout");
+                break;
+            }
+        }
+
+        REQUIRE(success_count == REQUEST_COUNT);
+        REQUIRE(pPool->getOutstandingCount() == 0);
+    }
+
+    SECTION("Affinity keeps order")
+    {
+        const int REQUEST_COUNT = 10;
+        int processed_count = 0;
+        int out_of_order_count = 0;
+
+        for (int i = 0; i < REQUEST_COUNT; ++i)
+        {
+            pPool->request(request, "lobby", [&, i](const std::string& result)
+            {
+                if (processed_count != i)
+                {
+                    out_of_order_count++;
+                }
+                processed_count++;
+            });
+        }
+
+        auto start_time = std::chrono::system_clock::now();
+        while (processed_count < REQUEST_COUNT)
+        {
+            pPool->runCallbacks(100);
+            if (std::chrono::system_clock::now() - start_time > std::chrono::seconds(20))
+            {
+                printf("Timeout");
+                break;
+            }
+        }
+
+        REQUIRE(processed_count == REQUEST_COUNT);
+        REQUIRE(out_of_order_count == 0);
+    }
+
+    SECTION("Wakes on callbacks of a session's context")
+    {
+        bool processed = false;
+        pPool->getContext(1)->request(request, [&](const std::string& result)
+        {
+            processed = true;
+        });
+
+        // Returns as soon as the response is in, not at the timeout
+        auto start_time = std::chrono::steady_clock::now();
+        while (!processed &&
+               std::chrono::steady_clock::now() - start_time < std::chrono::seconds(20))
+        {
+            pPool->runCallbacks(60000);
+        }
+
+        REQUIRE(processed);
+        REQUIRE(std::chrono::steady_clock::now() - start_time < std::chrono::seconds(20));
+    }
+
+    SECTION("Sync")
+    {
+        Json::Value data;
+        REQUIRE(reader.parse(pPool->requestSync(request), data));
+        REQUIRE(data["status"].asInt() == 200);
+    }
+}
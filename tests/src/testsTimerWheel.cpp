@@ -0,0 +1,132 @@
+#include "tests.h"
+#include "catch.hpp"
+#include "S2STimerWheel.h"
+
+#include <algorithm>
+#include <vector>
+
+///////////////////////////////////////////////////////////////////////////////
+// Timer wheel and scheduled callbacks
+//
+// Doesn't need a brainCloud server: the wheel is driven with made up times,
+// and scheduled callbacks only go through the I/O thread.
+///////////////////////////////////////////////////////////////////////////////
+
+namespace
+{
+    using Clock = S2STimerWheel::Clock;
+
+    // Advances the wheel and runs the timers that are due
+    static void advanceTo(S2STimerWheel& wheel, Clock::time_point start, int64_t ms)
+    {
+        std::vector<std::function<void()>> due;
+        wheel.advance(start + std::chrono::milliseconds(ms), due);
+        for (auto& function : due)
+        {
+            function();
+        }
+    }
+}
+
+TEST_CASE("Timer wheel", "[S2S][timers]")
+{
+    auto start = Clock::now();
+    S2STimerWheel wheel(start);
+    std::vector<int64_t> fired;
+
+    auto add = [&](int64_t ms)
+    {
+        return wheel.add(start + std::chrono::milliseconds(ms), [&fired, ms]()
+        {
+            fired.push_back(ms);
+        });
+    };
+
+    SECTION("Timers fire when due, across every level")
+    {
+        // One per level, plus one further than the top level reaches
+        std::vector<int64_t> times = {5, 63, 64, 1000, 5000, 300000, 20000000, 90000000};
+        for (auto ms : times) add(ms);
+        REQUIRE(wheel.size() == times.size());
+
+        for (auto ms : times)
+        {
+            advanceTo(wheel, start, ms - 1);
+            REQUIRE(std::find(fired.begin(), fired.end(), ms) == fired.end());
+            advanceTo(wheel, start, ms);
+            REQUIRE(fired.back() == ms);
+        }
+        REQUIRE(fired == times);
+        REQUIRE(wheel.size() == 0);
+    }
+
+    SECTION("Jumping ahead fires everything due")
+    {
+        add(10);
+        add(70000);
+        add(4000);
+        advanceTo(wheel, start, 100000);
+        REQUIRE(fired.size() == 3);
+    }
+
+    SECTION("Cancel")
+    {
+        auto id = add(100);
+        add(200);
+        REQUIRE(wheel.cancel(id));
+        REQUIRE_FALSE(wheel.cancel(id));
+
+        advanceTo(wheel, start, 1000);
+        REQUIRE(fired == std::vector<int64_t>{200});
+
+        // The node is reused, the old id doesn't match it
+        add(1500);
+        REQUIRE_FALSE(wheel.cancel(id));
+        REQUIRE(wheel.size() == 1);
+    }
+
+    SECTION("A time in the past is due on the next advance")
+    {
+        advanceTo(wheel, start, 1000);
+        add(500);
+        advanceTo(wheel, start, 1000);
+        REQUIRE(fired == std::vector<int64_t>{500});
+    }
+
+    SECTION("Wait time")
+    {
+        auto maxWait = std::chrono::milliseconds(1000);
+        REQUIRE(wheel.getWaitTime(start, maxWait) == maxWait);
+
+        add(30);
+        REQUIRE(wheel.getWaitTime(start, maxWait) == std::chrono::milliseconds(30));
+        REQUIRE(wheel.getWaitTime(start + std::chrono::milliseconds(40), maxWait) == Clock::duration::zero());
+    }
+}
+
+TEST_CASE("Scheduled callbacks", "[S2S][timers]")
+{
+    auto pContext = S2SContext::create(
+        "00000",
+        "timers",
+        "timers",
+        "http://127.0.0.1:1/s2sdispatcher",
+        false
+    );
+
+    int calls = 0;
+    auto kept = pContext->scheduleCallback(50, [&calls]() { calls++; });
+    auto cancelled = pContext->scheduleCallback(50, [&calls]() { calls += 100; });
+    REQUIRE(kept != 0);
+    REQUIRE(pContext->cancelScheduledCallback(cancelled));
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (calls == 0 && std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(calls == 1);
+
+    // Already called
+    REQUIRE_FALSE(pContext->cancelScheduledCallback(kept));
+}
@@ -0,0 +1,115 @@
+#include "tests.h"
+#include "catch.hpp"
+
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+///////////////////////////////////////////////////////////////////////////////
+// Request tracing
+//
+// Doesn't need a brainCloud server: the exporter is fed by hand, and context
+// requests go to a local port that refuses connections.
+///////////////////////////////////////////////////////////////////////////////
+
+TEST_CASE("Chrome trace export", "[S2S][trace]")
+{
+    auto start = S2SRequestTrace::Clock::now();
+    auto at = [start](int ms) { return start + std::chrono::milliseconds(ms); };
+
+    S2SRequestTrace trace;
+    trace.id = 7;
+    trace.operation = "time.\"READ\"";
+    trace.packetId = 3;
+    trace.batchSize = 2;
+    trace.enqueued = at(0);
+    trace.sent = at(5);
+    trace.transferStarted = at(6);
+    trace.dnsDone = at(6);
+    trace.connectDone = at(8);
+    trace.firstByte = at(20);
+    trace.completed = at(22);
+    trace.delivered = at(21);
+    trace.callbackQueued = at(21);
+    trace.callbackInvoked = at(30);
+    REQUIRE(trace.getTotalTime() == std::chrono::milliseconds(30));
+
+    std::string json = formatChromeTrace({trace});
+    REQUIRE(json.find("{\"name\":\"time.\\\"READ\\\"\",\"cat\":\"request\",\"ph\":\"X\",\"pid\":1,\"tid\":7,\"ts\":0,\"dur\":30000,"
+                      "\"args\":{\"packetId\":3,\"batchSize\":2,\"retries\":0}}") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"queued\",\"cat\":\"queue\",\"ph\":\"X\",\"pid\":1,\"tid\":7,\"ts\":0,\"dur\":5000}") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"server\",\"cat\":\"network\",\"ph\":\"X\",\"pid\":1,\"tid\":7,\"ts\":8000,\"dur\":12000}") != std::string::npos);
+    REQUIRE(json.find("\"name\":\"callback wait\",\"cat\":\"callback\",\"ph\":\"X\",\"pid\":1,\"tid\":7,\"ts\":21000,\"dur\":9000}") != std::string::npos);
+
+    // Phases that took no time or didn't happen are left out
+    REQUIRE(json.find("\"dns\"") == std::string::npos);
+    REQUIRE(json.find("\"tls\"") == std::string::npos);
+
+    std::string path = "trace_test.json";
+    REQUIRE(writeChromeTrace({trace}, path));
+    std::ifstream file(path);
+    std::stringstream written;
+    written << file.rdbuf();
+    REQUIRE(written.str() == json);
+    file.close();
+    std::remove(path.c_str());
+}
+
+TEST_CASE("Context traces", "[S2S][trace]")
+{
+    auto pContext = S2SContext::create(
+        "00000",
+        "trace",
+        "trace",
+        "http://127.0.0.1:1/s2sdispatcher",
+        false
+    );
+
+    std::vector<S2SRequestTrace> slow;
+    S2STraceOptions options;
+    options.enabled = true;
+    options.maxTraces = 2;
+    options.onSlowRequest = [&slow](const S2SRequestTrace& trace)
+    {
+        slow.push_back(trace);
+    };
+    pContext->setTracing(options);
+
+    const int REQUEST_COUNT = 3;
+    int done = 0;
+    for (int i = 0; i < REQUEST_COUNT; ++i)
+    {
+        pContext->request("{\"service\":\"time\",\"operation\":\"READ\"}", [&done](const std::string&)
+        {
+            done++;
+        });
+    }
+
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    while ((done < REQUEST_COUNT || (int)slow.size() < REQUEST_COUNT) &&
+           std::chrono::steady_clock::now() < deadline)
+    {
+        pContext->runCallbacks(10);
+    }
+    REQUIRE(done == REQUEST_COUNT);
+
+    // Every request was slower than the 0 ms threshold
+    REQUIRE(slow.size() == REQUEST_COUNT);
+
+    // Only the last ones are kept
+    auto traces = pContext->getTraces();
+    REQUIRE(traces.size() == 2);
+    for (const auto& trace : traces)
+    {
+        REQUIRE(trace.operation == "time.READ");
+        REQUIRE(trace.enqueued <= trace.sent);
+        REQUIRE(trace.sent <= trace.completed);
+        REQUIRE(trace.completed <= trace.delivered);
+        REQUIRE(trace.callbackQueued <= trace.callbackInvoked);
+        REQUIRE(trace.callbackInvoked != S2SRequestTrace::Clock::time_point());
+    }
+    REQUIRE(traces[0].id < traces[1].id);
+
+    pContext->setTracing(S2STraceOptions());
+    REQUIRE(pContext->getTraces().empty());
+}